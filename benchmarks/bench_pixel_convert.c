@@ -0,0 +1,194 @@
+// Pixel conversion benchmark: checks every supported kernel against the scalar
+// reference and reports throughput for a 480x480 frame. The diff kernels behind
+// the compare command and the CRC-32C kernels behind frame_hash are checked and
+// timed the same way.
+//
+// Build with: cmake -DBUILD_BENCHMARKS=ON .. && make bench_pixel_convert
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "test_harness.h"
+
+#define BENCH_WIDTH 480
+#define BENCH_HEIGHT 480
+#define BENCH_ITERATIONS 200
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double bench_kernel(pixel_convert_fn fn, const uint8_t *src, uint8_t *dst, size_t pixels) {
+    fn(src, dst, pixels); // warm up caches
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(src, dst, pixels);
+    }
+    double elapsed = now_seconds() - start;
+
+    return (double)pixels * BENCH_ITERATIONS / elapsed / 1e6;
+}
+
+// Odd pixel counts exercise each kernel's scalar tail
+static int verify_kernel(pixel_convert_fn fn, pixel_convert_fn ref, const uint8_t *src, size_t pixels) {
+    static const size_t lengths[] = { 0, 1, 7, 15, 16, 17, 31, 33, 63, 100, 479 };
+    uint8_t *expected = malloc(pixels * 3 + 64);
+    uint8_t *actual = malloc(pixels * 3 + 64);
+    int ok = expected && actual;
+
+    for (size_t i = 0; ok && i < sizeof(lengths) / sizeof(lengths[0]) + 1; i++) {
+        size_t n = i < sizeof(lengths) / sizeof(lengths[0]) ? lengths[i] : pixels;
+        memset(expected, 0xAA, n * 3 + 64);
+        memset(actual, 0xAA, n * 3 + 64);
+        ref(src, expected, n);
+        fn(src, actual, n);
+        // Compare the guard bytes too so out-of-bounds writes are caught
+        if (memcmp(expected, actual, n * 3 + 64) != 0) {
+            printf("  mismatch at %zu pixels\n", n);
+            ok = 0;
+        }
+    }
+
+    free(expected);
+    free(actual);
+    return ok;
+}
+
+static double bench_diff(pixel_diff_fn fn, const uint8_t *a, const uint8_t *b, size_t pixels) {
+    uint8_t max_delta = 0;
+    volatile uint32_t sink = fn(a, b, pixels, 0xFF040404u, &max_delta);
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += fn(a, b, pixels, 0xFF040404u, &max_delta);
+    }
+    double elapsed = now_seconds() - start;
+    (void)sink;
+
+    return (double)pixels * BENCH_ITERATIONS / elapsed / 1e6;
+}
+
+static int verify_diff(pixel_diff_fn fn, pixel_diff_fn ref, const uint8_t *a, const uint8_t *b, size_t pixels) {
+    static const size_t lengths[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 17, 100, 479 };
+    static const uint32_t tolerances[] = { 0xFF000000u, 0xFF040404u, 0xFF102030u, 0x00000000u, 0xFFFFFFFFu };
+
+    for (size_t t = 0; t < sizeof(tolerances) / sizeof(tolerances[0]); t++) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]) + 1; i++) {
+            size_t n = i < sizeof(lengths) / sizeof(lengths[0]) ? lengths[i] : pixels;
+            uint8_t expected_max = 0, actual_max = 0;
+            uint32_t expected = ref(a, b, n, tolerances[t], &expected_max);
+            uint32_t actual = fn(a, b, n, tolerances[t], &actual_max);
+            if (expected != actual || expected_max != actual_max) {
+                printf("  diff mismatch at %zu pixels, tolerance %08x: %u/%u vs %u/%u\n",
+                       n, tolerances[t], actual, actual_max, expected, expected_max);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static double bench_crc(pixel_crc_fn fn, const uint8_t *data, size_t len) {
+    volatile uint32_t sink = fn(0, data, len);
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        sink += fn(0, data, len);
+    }
+    double elapsed = now_seconds() - start;
+    (void)sink;
+
+    return (double)len * BENCH_ITERATIONS / elapsed / 1e6;
+}
+
+// Misaligned starts and lengths around the kernels' block sizes, plus chaining across a split
+static int verify_crc(pixel_crc_fn fn, pixel_crc_fn ref, const uint8_t *data, size_t len) {
+    static const size_t lengths[] = { 0, 1, 7, 8, 9, 767, 768, 769, 2000, 24575, 24576, 24577, 100000 };
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]) + 1; i++) {
+            size_t n = i < sizeof(lengths) / sizeof(lengths[0]) ? lengths[i] : len - offset;
+            if (n > len - offset) {
+                continue;
+            }
+            uint32_t expected = ref(0, data + offset, n);
+            uint32_t actual = fn(0, data + offset, n);
+            uint32_t chained = fn(fn(0, data + offset, n / 3), data + offset + n / 3, n - n / 3);
+            if (expected != actual || expected != chained) {
+                printf("  crc32c mismatch at %zu bytes, offset %zu: %08x/%08x vs %08x\n",
+                       n, offset, actual, chained, expected);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    size_t pixels = (size_t)BENCH_WIDTH * BENCH_HEIGHT;
+    uint8_t *argb = malloc(pixels * 4);
+    uint8_t *rgb565 = malloc(pixels * 2);
+    uint8_t *rgb = malloc(pixels * 3);
+    uint8_t *argb_near = malloc(pixels * 4);
+
+    if (!argb || !rgb565 || !rgb || !argb_near) {
+        printf("Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+
+    srand(1234);
+    for (size_t i = 0; i < pixels * 4; i++) argb[i] = (uint8_t)rand();
+    for (size_t i = 0; i < pixels * 2; i++) rgb565[i] = (uint8_t)rand();
+    // Mostly small channel deltas, like anti-aliasing noise against a baseline
+    for (size_t i = 0; i < pixels * 4; i++) {
+        argb_near[i] = (uint8_t)(argb[i] + (rand() % 16 == 0 ? rand() : rand() % 7 - 3));
+    }
+
+    pixel_convert_init();
+
+    const pixel_kernel_t *kernels;
+    size_t count = pixel_convert_get_kernels(&kernels);
+    const pixel_kernel_t *scalar = &kernels[count - 1];
+
+    printf("Frame %dx%d, %d iterations, dispatch picks '%s'\n\n",
+           BENCH_WIDTH, BENCH_HEIGHT, BENCH_ITERATIONS, pixel_convert_kernel_name());
+    printf("%-8s %20s %20s %20s %20s\n", "kernel", "ARGB8888 (MPix/s)", "RGB565 (MPix/s)", "diff (MPix/s)",
+           "crc32c (MB/s)");
+
+    int failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        const pixel_kernel_t *k = &kernels[i];
+        if (!k->supported) {
+            printf("%-8s %20s %20s %20s %20s\n", k->name, "unsupported", "unsupported", "unsupported",
+                   "unsupported");
+            continue;
+        }
+
+        if (!verify_kernel(k->argb8888_to_rgb24, scalar->argb8888_to_rgb24, argb, pixels) ||
+            !verify_kernel(k->rgb565_to_rgb24, scalar->rgb565_to_rgb24, rgb565, pixels) ||
+            !verify_diff(k->argb8888_diff, scalar->argb8888_diff, argb, argb_near, pixels) ||
+            !verify_crc(k->crc32c, scalar->crc32c, argb, pixels * 4)) {
+            printf("%-8s FAILED verification against scalar\n", k->name);
+            failures++;
+            continue;
+        }
+
+        double argb_rate = bench_kernel(k->argb8888_to_rgb24, argb, rgb, pixels);
+        double rgb565_rate = bench_kernel(k->rgb565_to_rgb24, rgb565, rgb, pixels);
+        double diff_rate = bench_diff(k->argb8888_diff, argb, argb_near, pixels);
+        double crc_rate = bench_crc(k->crc32c, argb, pixels * 4);
+        printf("%-8s %20.1f %20.1f %20.1f %20.1f\n", k->name, argb_rate, rgb565_rate, diff_rate, crc_rate);
+    }
+
+    free(argb);
+    free(rgb565);
+    free(rgb);
+    free(argb_near);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+// Screenshot encoder benchmark: encode time and size per PNG compression level, filter mode
+// and band count on a synthetic UI frame, against stb_image_write's default and QOI.
+//
+// Build with: cmake -DBUILD_BENCHMARKS=ON .. && make bench_png_encoder
+// Usage: bench_png_encoder [width height [output_dir]]
+// With output_dir set, every variant is also written out as a PNG for inspection.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "test_harness.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb/stb_image_write.h"
+
+#define BENCH_ITERATIONS 10
+#define BENCH_ARENA_SIZE (64 * 1024 * 1024)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Minimal bump allocator standing in for the screenshot arena
+static struct {
+    uint8_t *base;
+    size_t used;
+} bench_arena;
+
+static void *bench_alloc(void *ctx, size_t size) {
+    (void)ctx;
+    size = (size + 15) & ~(size_t)15;
+    if (bench_arena.used + size > BENCH_ARENA_SIZE) {
+        return NULL;
+    }
+    void *ptr = bench_arena.base + bench_arena.used;
+    bench_arena.used += size;
+    return ptr;
+}
+
+// Flat panels, a gradient, bordered buttons and dense glyph-like detail - roughly what a
+// watch or dashboard UI puts on screen
+static void fill_ui_frame(uint8_t *rgb, uint32_t width, uint32_t height) {
+    srand(42);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t *p = rgb + ((size_t)y * width + x) * 3;
+            p[0] = 0x20; p[1] = 0x24; p[2] = 0x30;
+
+            if (y < height / 8) {
+                p[0] = (uint8_t)(40 + x * 120 / width);
+                p[1] = (uint8_t)(60 + y * 200 / (height / 8 + 1));
+                p[2] = 160;
+            } else if ((x / 80) % 2 == 0 && (y / 60) % 2 == 1) {
+                int border = x % 80 < 2 || x % 80 > 77 || y % 60 < 2 || y % 60 > 57;
+                p[0] = border ? 0xE0 : 0x3A;
+                p[1] = border ? 0xE0 : 0x6E;
+                p[2] = border ? 0xE0 : 0xA5;
+            }
+
+            // Text rows: short antialiased strokes
+            if (y % 24 >= 6 && y % 24 < 18 && (x / 7) % 5 != 4 && rand() % 3 == 0) {
+                uint8_t level = (uint8_t)(128 + rand() % 128);
+                p[0] = p[1] = p[2] = level;
+            }
+        }
+    }
+}
+
+static void write_file(const char *dir, const char *name, const uint8_t *data, size_t len) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.png", dir, name);
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        fwrite(data, 1, len, f);
+        fclose(f);
+    }
+}
+
+static int bench_variant(const char *name, const uint8_t *rgb, uint32_t width, uint32_t height,
+                         int level, int filter, int bands, const char *out_dir) {
+    png_encode_options_t options = { level, filter, bands };
+    uint8_t *png = NULL;
+    size_t png_len = 0;
+    double best = 1e9;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bench_arena.used = 0;
+        double start = now_seconds();
+        int result = png_encode_rgb24(rgb, width, height, &options, bench_alloc, NULL, &png, &png_len);
+        double elapsed = now_seconds() - start;
+        if (result != TEST_OK) {
+            printf("%-24s FAILED (%d)\n", name, result);
+            return 1;
+        }
+        if (elapsed < best) best = elapsed;
+    }
+
+    printf("%-24s %10.2f %12zu %10.1f\n", name, best * 1000.0, png_len,
+           (double)width * height * 3 / best / 1e6);
+    if (out_dir) {
+        write_file(out_dir, name, png, png_len);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t width = argc >= 3 ? (uint32_t)atoi(argv[1]) : 480;
+    uint32_t height = argc >= 3 ? (uint32_t)atoi(argv[2]) : 480;
+    const char *out_dir = argc >= 4 ? argv[3] : NULL;
+
+    uint8_t *rgb = malloc((size_t)width * height * 3);
+    bench_arena.base = malloc(BENCH_ARENA_SIZE);
+    if (!rgb || !bench_arena.base || width == 0 || height == 0) {
+        printf("Failed to allocate benchmark buffers\n");
+        return 1;
+    }
+    fill_ui_frame(rgb, width, height);
+
+    worker_pool_init(0);
+    printf("Frame %ux%u, best of %d, %d threads available\n\n", width, height, BENCH_ITERATIONS, worker_pool_size());
+    printf("%-24s %10s %12s %10s\n", "variant", "ms", "bytes", "MB/s");
+
+    // Baseline: stb_image_write's default (level 8, all five filters per row, one core)
+    double best = 1e9;
+    int stb_len = 0;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        double start = now_seconds();
+        unsigned char *png = stbi_write_png_to_mem(rgb, (int)width * 3, (int)width, (int)height, 3, &stb_len);
+        double elapsed = now_seconds() - start;
+        if (elapsed < best) best = elapsed;
+        if (out_dir && i == 0) write_file(out_dir, "stb", png, (size_t)stb_len);
+        STBIW_FREE(png);
+    }
+    printf("%-24s %10.2f %12d %10.1f\n\n", "stb_image_write", best * 1000.0, stb_len,
+           (double)width * height * 3 / best / 1e6);
+
+    // QOI, checked by decoding it again
+    uint8_t *decoded = malloc((size_t)width * height * 3);
+    size_t qoi_cap = qoi_encode_bound(width, height, 3);
+    uint8_t *qoi = malloc(qoi_cap);
+    size_t qoi_len = 0;
+    best = 1e9;
+    for (int i = 0; qoi && i < BENCH_ITERATIONS; i++) {
+        double start = now_seconds();
+        qoi_len = qoi_encode(rgb, width, height, 3, qoi, qoi_cap);
+        double elapsed = now_seconds() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    if (!qoi || !decoded || qoi_len == 0 ||
+        qoi_decode(qoi, qoi_len, 3, decoded, (size_t)width * height * 3) != TEST_OK ||
+        memcmp(decoded, rgb, (size_t)width * height * 3) != 0) {
+        printf("%-24s FAILED round trip\n", "qoi");
+        return 1;
+    }
+    printf("%-24s %10.2f %12zu %10.1f\n\n", "qoi", best * 1000.0, qoi_len,
+           (double)width * height * 3 / best / 1e6);
+    free(decoded);
+    free(qoi);
+
+    static const char *filter_names[] = { "none", "sub", "up", "avg", "paeth" };
+    char name[64];
+    int failures = 0;
+
+    for (int level = 0; level <= 9; level++) {
+        snprintf(name, sizeof(name), "level%d-adaptive", level);
+        failures += bench_variant(name, rgb, width, height, level, PNG_FILTER_ADAPTIVE, 1, out_dir);
+    }
+    printf("\n");
+    for (int filter = 0; filter < 5; filter++) {
+        snprintf(name, sizeof(name), "level4-%s", filter_names[filter]);
+        failures += bench_variant(name, rgb, width, height, 4, filter, 1, out_dir);
+    }
+    printf("\n");
+    for (int bands = 1; bands <= 16; bands *= 2) {
+        snprintf(name, sizeof(name), "default-%dband%s", bands, bands > 1 ? "s" : "");
+        failures += bench_variant(name, rgb, width, height, PNG_LEVEL_DEFAULT, PNG_FILTER_ADAPTIVE, bands, out_dir);
+    }
+
+    worker_pool_cleanup();
+    free(bench_arena.base);
+    free(rgb);
+    return failures ? 1 : 0;
+}
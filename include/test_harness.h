@@ -16,9 +16,20 @@ extern "C" {
     typedef void* lv_obj_t;
 #endif
 
+// Widget handles: slot index in the low 8 bits, registry generation above it.
+// A handle goes stale as soon as its slot is re-registered or the registry is cleaned.
+typedef uint32_t widget_handle_t;
+#define WIDGET_HANDLE_INVALID 0
+#define MAX_ID_LEN 32
+
 // Widget registry functions
 int reg_widget(const char *id, lv_obj_t *obj);
 lv_obj_t *find_widget(const char *id);
+widget_handle_t resolve_widget(const char *id);
+int lookup_widget_handle(widget_handle_t handle, const char **id, lv_obj_t **obj);
+int find_widget_ref(widget_handle_t handle, const char *id, const char **found_id, lv_obj_t **obj);
+const char *find_widget_id(lv_obj_t *obj);
+int registry_entry(int slot, const char **id, lv_obj_t **obj);
 void cleanup_registry(void);
 void print_registry(void);
 
@@ -29,6 +40,12 @@ int test_swipe(int x1, int y1, int x2, int y2);
 int test_key_event(int code);
 char* test_get_text(const char *id);
 int test_set_text(const char *id, const char *text);
+
+// Same on an already resolved widget (id is only used for logging and fallback text)
+int test_click_obj(lv_obj_t *obj, const char *id);
+int test_longpress_obj(lv_obj_t *obj, const char *id, uint32_t ms);
+char* test_get_text_obj(lv_obj_t *obj, const char *id);
+int test_set_text_obj(lv_obj_t *obj, const char *id, const char *text);
 int test_screenshot(uint8_t **png_data, size_t *png_len);
 void test_wait(uint32_t ms);
 
@@ -51,18 +68,314 @@ void test_harness_cleanup(void);
 int tcp_server_init(int port);
 void tcp_server_cleanup(void);
 int tcp_server_start(void);
+int tcp_server_zygote(volatile int *running);   // returns 1 in each forked child
+
+// UI tree snapshot functions. Dumps walk the live objects, so they run on the LVGL thread
+// while the caller waits.
+typedef struct ui_tree_request ui_tree_request_t;
+
+int ui_tree_dump(uint32_t since, char **json, size_t *json_len);
+void ui_tree_run(ui_tree_request_t *request);
+void ui_tree_reset(int session);
+void ui_tree_cleanup(void);
+
+// Sessions: each client connection drives its own display with its own copy of the UI,
+// widget registry and tree snapshot state. Session 0 is the main display; the others are
+// headless displays at the same resolution, rendered by the same LVGL thread. The selected
+// session is per thread: a client's thread selects its own, and the LVGL thread selects each
+// queued command's.
+#define MAX_SESSIONS 16
+
+int session_open(void);
+void session_close(int session);
+void session_select(int session);
+int session_current(void);
+int session_count(void);
+uint32_t session_frame_version(int session);
+int session_reset(int reseed, uint32_t seed, uint32_t *elapsed_us);
+void session_start(int session);      // LVGL thread halves of session_open/session_close/session_reset
+void session_stop(int session);
+void session_rebuild(int session, int reseed, uint32_t seed);
+void session_cleanup(void);
+#ifdef HAVE_LVGL
+lv_display_t *session_get_display(int session);
+lv_group_t *session_get_group(int session);
+int session_send_key(int session, uint32_t key);
+lv_display_t *headless_display_create(int32_t width, int32_t height, uint8_t **framebuffer);
+#endif
 
 // Screenshot functions
+typedef struct {
+    uint32_t captures;        // screenshots encoded so far
+    uint32_t allocs_total;    // heap allocations made by the screenshot path
+    uint32_t allocs_last;     // heap allocations made by the most recent capture
+    size_t arena_bytes;       // current PNG arena capacity
+    uint32_t frame_version;   // display frame the most recent capture shows
+    uint32_t cache_hits;      // captures served from the cached PNG
+    int cache_hit;            // most recent capture was served from the cache
+    uint32_t encode_us;       // time the most recent capture spent converting and encoding
+    uint32_t render_us;       // time LVGL spent rendering and flushing the most recent frame
+} screenshot_stats_t;
+
+// Part of the screen to capture: a rectangle in screen coordinates, or a single widget
+typedef struct {
+    int x, y, w, h;
+    lv_obj_t *obj;            // when set, the widget is rendered on its own and x/y/w/h are ignored
+    widget_handle_t handle;   // or a widget reference (handle, else id), looked up by the LVGL
+    char id[MAX_ID_LEN];      // thread when the capture runs
+} screenshot_region_t;
+
+// Output encodings: PNG or QOI images, or raw pixels (optionally LZ4-compressed) for fast local links
+typedef enum {
+    SCREENSHOT_FORMAT_PNG = 0,
+    SCREENSHOT_FORMAT_RGB24,
+    SCREENSHOT_FORMAT_ARGB8888,   // B,G,R,A byte order
+    SCREENSHOT_FORMAT_RGB565,     // little-endian, the display's native format
+    SCREENSHOT_FORMAT_QOI         // lossless, far cheaper to encode than PNG
+} screenshot_format_t;
+
+// PNG encoder settings; negative level/filter and zero bands pick the defaults
+#define PNG_LEVEL_DEFAULT -1
+#define PNG_FILTER_ADAPTIVE -1    // per row, the filter with the smallest sum of absolute differences
+
+typedef struct {
+    int level;                // 0 = stored only, 1 = fastest ... 9 = smallest
+    int filter;               // PNG_FILTER_ADAPTIVE, or a fixed filter 0..4 (none/sub/up/avg/paeth)
+    int bands;                // row bands deflated in parallel; 0 = one per worker pool thread
+} png_encode_options_t;
+
+typedef struct {
+    screenshot_format_t format;
+    int compress;             // raw formats only: LZ4 block compression
+    png_encode_options_t png; // PNG format only
+    int delta;                // whole screen, asynchronous only: just the areas changed since the last delta
+} screenshot_options_t;
+
+// Delta captures diff against the previous delta frame in square tiles and merge changed tiles
+// into rectangles; beyond MAX_DELTA_RECTS (or half the screen) a full keyframe is sent instead
+#define SCREENSHOT_DELTA_TILE 32
+#define MAX_DELTA_RECTS 64
+
+typedef struct {
+    int x, y, w, h;
+    size_t len;               // encoded bytes for this rectangle
+    size_t raw_len;           // uncompressed pixel bytes for raw formats
+} screenshot_rect_t;
+
+int screenshot_diff_tiles(const uint8_t *frame, const uint8_t *reference, uint32_t stride, uint32_t width,
+                          uint32_t height, uint32_t bpp, screenshot_rect_t *rects, int max_rects);
+
+// Encoded capture; data is owned by the screenshot module and valid until the next capture
+typedef struct {
+    uint8_t *data;
+    size_t len;               // bytes at data (compressed size when compressed)
+    size_t raw_len;           // uncompressed pixel bytes for raw formats
+    uint32_t width;
+    uint32_t height;
+    screenshot_format_t format;
+    int compressed;
+    
+    // Delta captures: data holds each rectangle's encoding back to back, in this order
+    const screenshot_rect_t *rects;
+    int rect_count;
+    int keyframe;             // the rectangles cover the whole frame
+} screenshot_image_t;
+
 int screenshot_init(void);
 void screenshot_cleanup(void);
 int capture_screenshot(uint8_t **png_data, size_t *png_len);
+int capture_screenshot_region(const screenshot_region_t *region, const screenshot_options_t *options,
+                              screenshot_image_t *image);
+void screenshot_get_stats(screenshot_stats_t *stats);
+uint32_t screenshot_frame_version(void);
+int screenshot_display_size(uint32_t *width, uint32_t *height);
+
+// Asynchronous capture in two stages: the LVGL thread only copies the region's pixels into a
+// pooled buffer (via the command queue), conversion and encoding run on the worker pool.
+// Jobs submitted back to back are grabbed in the same main loop pass, so they show one frame.
+typedef struct screenshot_job screenshot_job_t;
+
+int screenshot_submit(const screenshot_region_t *region, const screenshot_options_t *options,
+                      screenshot_job_t **job);
+void screenshot_job_grab(screenshot_job_t *job);
+int screenshot_job_wait(screenshot_job_t *job, screenshot_image_t *image, screenshot_stats_t *stats);
+void screenshot_job_release(screenshot_job_t *job);
+void screenshot_delta_reset(int session);
+
+// Frame/region hashes for cheap equality checks: grabbed like a capture, hashed instead of encoded
+typedef enum {
+    FRAME_HASH_XXH64 = 0,     // exact: any pixel change alters it
+    FRAME_HASH_DHASH,         // perceptual: compare by Hamming distance
+    FRAME_HASH_CRC32C         // exact, 32 bits: hardware CRC-32C where the CPU has it
+} frame_hash_algo_t;
+
+int screenshot_hash_region(const screenshot_region_t *region, frame_hash_algo_t algo, uint64_t *hash,
+                           uint32_t *width, uint32_t *height);
+
+// Pixel probes and region statistics: points are sampled by the grab stage, regions are grabbed
+// and measured on the worker pool, neither is encoded
+#define MAX_PROBE_POINTS 64
+#define PROBE_HIST_BINS 16        // per channel, each bin 256 / PROBE_HIST_BINS levels wide
+
+typedef struct {
+    int x, y;                 // screen coordinates
+    int valid;                // 0 when the point lies off screen
+    uint8_t rgb[3];
+} probe_point_t;
+
+typedef struct {
+    uint32_t width, height;
+    uint8_t min[3], max[3];
+    float mean[3];
+    uint32_t hist[3][PROBE_HIST_BINS];
+    uint32_t matches;         // pixels within tolerance of the requested color, if any
+} probe_stats_t;
+
+int screenshot_probe_points(probe_point_t *points, int count);
+int screenshot_probe_region(const screenshot_region_t *region, const uint8_t *color, const uint8_t tolerance[3],
+                            probe_stats_t *stats);
+
+// Pixel conversion, diff and CRC-32C kernels (scalar / SSSE3 / SSE4.2 / AVX2 / NEON, picked at runtime)
+typedef void (*pixel_convert_fn)(const uint8_t *src, uint8_t *dst, size_t pixels);
+typedef uint32_t (*pixel_diff_fn)(const uint8_t *a, const uint8_t *b, size_t pixels, uint32_t tolerance,
+                                  uint8_t *max_delta);
+typedef uint32_t (*pixel_crc_fn)(uint32_t crc, const uint8_t *data, size_t len);
+
+typedef struct {
+    const char *name;
+    pixel_convert_fn argb8888_to_rgb24;
+    pixel_convert_fn rgb565_to_rgb24;
+    pixel_diff_fn argb8888_diff;
+    pixel_crc_fn crc32c;      // hardware crc32 instruction where the kernel's CPU level has one
+    int supported;            // set by pixel_convert_init() from CPU feature detection
+} pixel_kernel_t;
+
+int pixel_convert_init(void);
+const char *pixel_convert_kernel_name(void);
+size_t pixel_convert_get_kernels(const pixel_kernel_t **kernels);
+void convert_argb8888_to_rgb24(const uint8_t *src, uint8_t *dst, size_t pixels);
+void convert_rgb565_to_rgb24(const uint8_t *src, uint8_t *dst, size_t pixels);
+void convert_argb8888_to_rgb565(const uint8_t *src, uint8_t *dst, size_t pixels);
+void convert_rgb565_to_argb8888(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+// Count ARGB8888 pixels differing by more than tolerance (per-channel bytes in B,G,R,A order;
+// alpha 0xFF ignores alpha) and raise *max_delta to the largest color channel difference
+uint32_t pixel_diff_argb8888(const uint8_t *a, const uint8_t *b, size_t pixels, uint32_t tolerance,
+                             uint8_t *max_delta);
+
+// LZ4 block compression for raw screenshots
+size_t lz4_compress_bound(size_t len);
+size_t lz4_compress_block(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap);
+
+// PNG encoder with parallel deflate; memory comes from the caller's allocator and is never freed
+typedef void *(*png_alloc_fn)(void *ctx, size_t size);
+int png_encode_rgb24(const uint8_t *rgb, uint32_t width, uint32_t height, const png_encode_options_t *options,
+                     png_alloc_fn alloc, void *alloc_ctx, uint8_t **png, size_t *png_len);
+
+// QOI image encoder/decoder (3 = RGB, 4 = RGBA channels)
+size_t qoi_encode_bound(uint32_t width, uint32_t height, int channels);
+size_t qoi_encode(const uint8_t *pixels, uint32_t width, uint32_t height, int channels,
+                  uint8_t *dst, size_t dst_cap);
+int qoi_read_header(const uint8_t *data, size_t len, uint32_t *width, uint32_t *height, int *channels);
+int qoi_decode(const uint8_t *data, size_t len, int channels, uint8_t *dst, size_t dst_cap);
+
+// Recording of a session's flushed frames into an indexed, delta-encoded .lvrec file
+typedef struct {
+    char path[512];
+    uint32_t frames;          // frames written
+    uint32_t dropped;         // frames skipped because the writer fell behind
+    uint64_t bytes;           // file size
+    uint32_t duration_ms;
+} recorder_stats_t;
+
+int recorder_start(int session, const char *name, uint32_t fps, char *path, size_t path_len);
+int recorder_stop(int session, recorder_stats_t *stats);
+int recorder_active(int session);
+void recorder_note_command(int session, const char *command, size_t len);
+void recorder_capture(int session, const uint8_t *pixels, uint32_t stride, uint32_t width, uint32_t height,
+                      screenshot_format_t format, uint32_t frame_version);
+void recorder_cleanup(void);
+
+// Flight recorder: the last few seconds of each session's frames kept in memory, fetched after a failure
+typedef struct {
+    uint32_t frames;          // frames returned
+    size_t used;              // bytes held in the ring
+    size_t budget;            // LVGL_HISTORY_MB in bytes (per session)
+    uint32_t evicted;         // frames dropped to stay within the budget
+    uint32_t coalesced;       // frames replaced by a newer one before they were encoded
+} history_stats_t;
+
+int history_init(void);
+int history_open(int session);        // LVGL thread, from session_start/session_stop
+void history_close(int session);
+int history_enabled(int session);
+void history_capture(int session, const uint8_t *pixels, uint32_t stride, uint32_t width, uint32_t height,
+                     screenshot_format_t format, uint32_t frame_version);
+int history_export(int session, uint32_t max_frames, int clear, uint8_t **data, size_t *len,
+                   history_stats_t *stats);
+void history_cleanup(void);
+
+// Golden image comparison against named baselines
+typedef struct {
+    uint32_t mismatches;      // pixels with any color channel beyond tolerance
+    uint8_t max_delta;        // largest color channel difference seen
+    int bbox_x, bbox_y;       // bounding box of mismatched pixels, region-relative
+    int bbox_w, bbox_h;       // zero when everything matched
+    uint32_t width;
+    uint32_t height;
+    uint8_t *mask;            // 1 bit per pixel when requested, owned by the compare module
+    size_t mask_len;
+    int recorded;             // record run: the baseline was missing and has been saved instead
+} compare_result_t;
+
+int baseline_name_valid(const char *name);
+int baseline_save(const char *name, const screenshot_region_t *region, uint32_t *width, uint32_t *height,
+                  uint64_t *hash);
+int compare_baseline(const char *name, const screenshot_region_t *region, const uint8_t tolerance[3],
+                     int want_mask, compare_result_t *result);
+void compare_cleanup(void);
+
+// Content-addressed, memory-mapped baseline frames (ARGB8888) under LVGL_BASELINE_DIR
+int baseline_store_init(void);
+void baseline_store_cleanup(void);
+int baseline_store_get(const char *name, const uint8_t **pixels, uint32_t *width, uint32_t *height);
+int baseline_store_put(const char *name, const uint8_t *pixels, uint32_t width, uint32_t height, uint64_t *hash);
+
+// 64-bit XXH64 hash
+uint64_t hash_xxh64(const void *data, size_t len, uint64_t seed);
+
+// CRC-32C of data appended to crc (0 to start), on the pixel kernels' dispatch
+uint32_t hash_crc32c(uint32_t crc, const void *data, size_t len);
+
+// 64-bit perceptual difference hash (dHash) over RGB24 rows
+#define DHASH_COLS 9
+#define DHASH_ROWS 8
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint64_t sums[DHASH_ROWS * DHASH_COLS];
+    uint32_t counts[DHASH_ROWS * DHASH_COLS];
+} dhash_state_t;
+
+void dhash_init(dhash_state_t *state, uint32_t width, uint32_t height);
+void dhash_add_row(dhash_state_t *state, const uint8_t *rgb, uint32_t y);
+uint64_t dhash_finish(const dhash_state_t *state);
+
+// Worker pool for data-parallel jobs
+typedef void (*worker_task_fn)(void *arg, int index);
+int worker_pool_init(int threads);
+void worker_pool_cleanup(void);
+int worker_pool_size(void);
+void worker_pool_run(worker_task_fn fn, void *arg, int count);
+void worker_pool_submit(worker_task_fn fn, void *arg);
 
 // Constants
 #define MAX_WIDGETS 64
-#define MAX_ID_LEN 32
 #define DEFAULT_PORT 12345
 #define MAX_COMMAND_LEN 1024
 #define MAX_COMMAND_QUEUE 32
+#define MAX_SCREENSHOT_REGIONS 16
 
 // Error codes
 #define TEST_OK 0
@@ -74,10 +387,49 @@ int capture_screenshot(uint8_t **png_data, size_t *png_len);
 #define TEST_ERROR_QUEUE_FULL -6
 #define TEST_ERROR_INVALID_WIDGET -7
 #define TEST_ERROR_EVENT_FAILED -8
+#define TEST_ERROR_STALE_HANDLE -9
+#define TEST_ERROR_SIZE_MISMATCH -10
+#define TEST_ERROR_BUSY -11
+#define TEST_ERROR_IO -12
 
-// UI functions
+// UI functions (act on the current session's copy of the UI)
 void ui_watch_create(void);
 void ui_watch_update(void);
+void ui_watch_destroy(void);
+void ui_watch_seed(uint32_t seed);
+int ui_watch_click(lv_obj_t *obj);
+int ui_watch_longpress(lv_obj_t *obj);
+
+// The watch UI's data model, as kept in checkpoints
+typedef struct {
+    int32_t screen;
+    int32_t heart_rate;
+    int32_t steps;
+    int32_t calories;
+    int32_t battery_percent;
+    int32_t is_measuring_heart;
+    int32_t measuring_s;        // how long the measurement has been running
+    int32_t step_counter;
+} watch_model_t;
+
+void ui_watch_get_model(watch_model_t *model);
+int ui_watch_set_model(const watch_model_t *model);
+
+// Checkpoints: named snapshots of the data model and of every registered widget's content,
+// restored onto the existing objects. Any session can load a checkpoint another one saved.
+// Saving and loading run on the LVGL thread, the callers wait for them.
+typedef struct checkpoint_request checkpoint_request_t;
+
+typedef struct {
+    uint32_t bytes;             // size of the snapshot
+    uint32_t widgets;           // widgets saved or restored
+    uint32_t elapsed_us;        // time the LVGL thread spent on it
+} checkpoint_stats_t;
+
+int checkpoint_save(const char *name, checkpoint_stats_t *stats);
+int checkpoint_load(const char *name, checkpoint_stats_t *stats);
+void checkpoint_run(checkpoint_request_t *request);
+void checkpoint_cleanup(void);
 
 // Command queue structures
 typedef enum {
@@ -88,18 +440,34 @@ typedef enum {
     CMD_GET_TEXT,
     CMD_SET_TEXT,
     CMD_SCREENSHOT,
-    CMD_WAIT
+    CMD_WAIT,
+    CMD_TREE_DUMP,
+    CMD_CAPTURE,
+    CMD_SESSION_OPEN,
+    CMD_SESSION_CLOSE,
+    CMD_SESSION_RESET,
+    CMD_CHECKPOINT,
+    CMD_CLICK_AT,
+    CMD_DRAG
 } command_type_t;
 
-typedef struct {
+typedef struct command {
     command_type_t type;
+    int session;              // selected on the LVGL thread while the command runs
     char widget_id[MAX_ID_LEN];
+    widget_handle_t handle;   // target from resolve; WIDGET_HANDLE_INVALID looks widget_id up instead
     union {
         struct { uint32_t ms; } longpress;
         struct { int x1, y1, x2, y2; } swipe;
         struct { int code; } key;
         struct { char text[MAX_COMMAND_LEN]; } set_text;
         struct { uint32_t ms; } wait;
+        struct { ui_tree_request_t *request; } tree;
+        struct { screenshot_job_t *job; } capture;
+        struct { int index; int reseed; uint32_t seed; } session;
+        struct { checkpoint_request_t *request; } checkpoint;
+        struct { int x, y; } click_at;
+        struct { int x1, y1, x2, y2; } drag;
     } params;
     
     // Response fields
@@ -108,12 +476,14 @@ typedef struct {
     size_t response_len;
     int result;
     volatile int completed;
+    struct command *reply;    // command_queue_run's caller, handed the response fields back
 } command_t;
 
 // Command queue functions
 int command_queue_init(void);
 void command_queue_cleanup(void);
 int command_queue_push(command_t *cmd);
+void command_queue_run(command_t *cmd);
 int command_queue_process_all(void);
 
 #ifdef __cplusplus
@@ -40,7 +40,9 @@
  * - LV_STDLIB_RTTHREAD:    RT-Thread implementation
  * - LV_STDLIB_CUSTOM:      Implement the functions externally
  */
-#define LV_USE_STDLIB_MALLOC    LV_STDLIB_BUILTIN
+/* The system allocator: offscreen snapshot buffers grow with --resolution (up to 4096x4096),
+ * which a fixed LV_MEM_SIZE pool cannot hold */
+#define LV_USE_STDLIB_MALLOC    LV_STDLIB_CLIB
 
 /** Possible values
  * - LV_STDLIB_BUILTIN:     LVGL's built in implementation
@@ -1220,8 +1222,11 @@
  * DEVICES
  *==================*/
 
-/** Use SDL to open window on PC and handle mouse and keyboard. */
-#define LV_USE_SDL              1
+/** Use SDL to open window on PC and handle mouse and keyboard.
+ *  Headless-only builds (-DLVGL_HEADLESS_ONLY=ON) define it to 0 on the command line. */
+#ifndef LV_USE_SDL
+    #define LV_USE_SDL          1
+#endif
 #if LV_USE_SDL
     #define LV_SDL_INCLUDE_PATH     <SDL.h>
     #define LV_SDL_RENDER_MODE      LV_DISPLAY_RENDER_MODE_DIRECT   /**< LV_DISPLAY_RENDER_MODE_DIRECT is recommended for best performance */
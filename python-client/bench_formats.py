@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Screenshot format benchmark: PNG vs QOI on the three smartwatch screens.
+
+For each screen (main, heart rate, activity) the running simulator encodes the
+frame repeatedly as PNG (default and fastest level) and as QOI. The table shows
+the server-side encode time reported in each reply (encode_us), the payload size
+and the client-side decode time.
+
+Usage: python bench_formats.py [iterations]
+"""
+
+import io
+import sys
+import time
+from statistics import median
+
+from PIL import Image
+
+from lvgl_client import LVGLTestClient, qoi_decode
+
+VARIANTS = [
+    ("png", {}),
+    ("png level 1", {"level": 1}),
+    ("png level 1 up", {"level": 1, "filter": "up"}),
+    ("qoi", {"format": "qoi"}),
+]
+
+
+def capture(client: LVGLTestClient, options: dict):
+    """One uncached full-screen capture; returns (encode_us, payload)."""
+    # A full-screen rect bypasses the frame cache so every request is really encoded
+    command = {"cmd": "screenshot", "rect": [0, 0, 10000, 10000], **options}
+    response = client._send_command(command)
+    if response.get("status") != "ok":
+        raise RuntimeError(f"Screenshot failed: {response}")
+    return response.get("encode_us", 0), client._recv_exact(response["len"])
+
+
+def decode(payload: bytes):
+    if payload[:4] == b"qoif":
+        return qoi_decode(payload)
+    return Image.open(io.BytesIO(payload)).convert("RGB")
+
+
+def bench_screen(client: LVGLTestClient, name: str, iterations: int):
+    print(f"\n{name}")
+    print(f"  {'variant':<16} {'encode ms':>10} {'bytes':>10} {'decode ms':>10}")
+    for label, options in VARIANTS:
+        encode_times = []
+        decode_times = []
+        size = 0
+        for _ in range(iterations):
+            encode_us, payload = capture(client, options)
+            start = time.perf_counter()
+            decode(payload)
+            decode_times.append((time.perf_counter() - start) * 1000.0)
+            encode_times.append(encode_us / 1000.0)
+            size = len(payload)
+        print(f"  {label:<16} {median(encode_times):>10.2f} {size:>10} {median(decode_times):>10.2f}")
+
+
+def main():
+    iterations = int(sys.argv[1]) if len(sys.argv) > 1 else 10
+
+    with LVGLTestClient() as client:
+        bench_screen(client, "Main screen", iterations)
+
+        client.click("btn_heart")
+        time.sleep(0.5)
+        bench_screen(client, "Heart rate screen", iterations)
+
+        client.click("hr_screen")
+        time.sleep(0.5)
+        client.swipe(400, 240, 80, 240)
+        time.sleep(0.5)
+        bench_screen(client, "Activity screen", iterations)
+
+        client.swipe(80, 240, 400, 240)  # back to main
+
+
+if __name__ == "__main__":
+    main()
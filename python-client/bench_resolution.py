@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Resolution matrix benchmark: frame time and screenshot cost per display size.
+
+For each resolution a headless simulator is started with --resolution, the UI
+is switched between the main and heart rate screens to force full redraws, and
+the server-side render time of each frame (render_us from display_info) is
+collected. Full-screen captures are then timed as PNG, QOI and raw RGB565
+(server encode_us plus the client round trip), along with a PNG of the hidden
+heart rate screen, which is rendered offscreen into a snapshot buffer of the
+full display size. The ns/px columns show how the cost scales with the pixel
+count.
+
+Usage: python bench_resolution.py <simulator executable> [iterations] [sizes...]
+"""
+
+import sys
+import time
+from statistics import median
+
+from lvgl_client import LVGLTestClient, SimulatorProcess
+
+SIZES = [240, 390, 480, 1080]
+
+# A full-screen rect bypasses the frame cache so every request is really encoded
+FULL_SCREEN = [0, 0, 10000, 10000]
+
+CAPTURES = [
+    ("png", {"rect": FULL_SCREEN}),
+    ("qoi", {"rect": FULL_SCREEN, "format": "qoi"}),
+    ("rgb565", {"rect": FULL_SCREEN, "format": "rgb565"}),
+    ("hidden", {"id": "hr_screen"}),
+]
+
+
+def wait_for_frame(client: LVGLTestClient, after: int, timeout: float = 2.0):
+    """display_info once a frame newer than `after` has been rendered."""
+    deadline = time.perf_counter() + timeout
+    while time.perf_counter() < deadline:
+        info = client.display_info()
+        if info and info["frame_version"] > after:
+            return info
+        time.sleep(0.005)
+    raise RuntimeError("No new frame rendered")
+
+
+def frame_times(client: LVGLTestClient, iterations: int):
+    """Render time (ms) of the frames produced by switching screens."""
+    times = []
+    for i in range(iterations):
+        before = client.display_info()["frame_version"]
+        client.click("btn_heart" if i % 2 == 0 else "hr_screen")
+        times.append(wait_for_frame(client, before)["render_us"] / 1000.0)
+    if iterations % 2:
+        client.click("hr_screen")  # back to main
+    return times
+
+
+def capture(client: LVGLTestClient, options: dict):
+    """One uncached capture; returns (encode ms, round trip ms)."""
+    command = {"cmd": "screenshot", **options}
+    start = time.perf_counter()
+    response = client._send_command(command)
+    if response.get("status") != "ok":
+        raise RuntimeError(f"Screenshot failed: {response}")
+    client._recv_exact(response["len"])
+    return response.get("encode_us", 0) / 1000.0, (time.perf_counter() - start) * 1000.0
+
+
+def bench_size(executable: str, size: int, iterations: int):
+    with SimulatorProcess(executable, headless=True, resolution=size) as simulator:
+        if not simulator.is_running():
+            raise RuntimeError(f"Simulator failed to start at {size}x{size}")
+
+        with LVGLTestClient() as client:
+            info = client.display_info()
+            pixels = info["width"] * info["height"]
+
+            render = median(frame_times(client, iterations))
+            row = [f"{info['width']}x{info['height']}", f"{render:.2f}", f"{render * 1e6 / pixels:.1f}"]
+            for _, options in CAPTURES:
+                results = [capture(client, options) for _ in range(iterations)]
+                encode = median(r[0] for r in results)
+                total = median(r[1] for r in results)
+                row += [f"{encode:.2f}", f"{total:.2f}", f"{encode * 1e6 / pixels:.1f}"]
+            return row
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    executable = sys.argv[1]
+    iterations = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+    sizes = [int(s) for s in sys.argv[3:]] or SIZES
+
+    header = ["size", "frame ms", "ns/px"]
+    for label, _ in CAPTURES:
+        header += [f"{label} ms", f"{label} rtt", "ns/px"]
+    rows = [header] + [bench_size(executable, size, iterations) for size in sizes]
+
+    widths = [max(len(row[i]) for row in rows) for i in range(len(header))]
+    for row in rows:
+        print("  ".join(cell.rjust(width) for cell, width in zip(row, widths)))
+
+
+if __name__ == "__main__":
+    main()
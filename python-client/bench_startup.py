@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Startup benchmark: cold simulator start versus a zygote spawn.
+
+A cold start launches a headless simulator process and waits until its port
+accepts connections and the first display_info is answered. A zygote spawn
+asks an already initialized zygote (--zygote) for a forked child and connects
+to it; LVGL and the watch UI are inherited instead of being built again.
+
+Usage: python bench_startup.py <simulator executable> [iterations]
+"""
+
+import sys
+import time
+from statistics import median
+
+from lvgl_client import LVGLTestClient, SimulatorProcess
+
+
+def cold_start(executable: str) -> float:
+    """ms from process launch to the first answered command."""
+    start = time.perf_counter()
+    with SimulatorProcess(executable, headless=True) as simulator:
+        if not simulator.is_running():
+            raise RuntimeError("Simulator failed to start")
+        with LVGLTestClient() as client:
+            if not client.display_info():
+                raise RuntimeError("No display_info from the simulator")
+            return (time.perf_counter() - start) * 1000.0
+
+
+def zygote_spawn(zygote: SimulatorProcess) -> float:
+    """ms from the spawn request to the first answered command."""
+    start = time.perf_counter()
+    client = zygote.spawn_client()
+    if not client:
+        raise RuntimeError("Spawn failed")
+    try:
+        if not client.display_info():
+            raise RuntimeError("No display_info from the spawned simulator")
+        return (time.perf_counter() - start) * 1000.0
+    finally:
+        client.disconnect()  # the child exits with its client
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    executable = sys.argv[1]
+    iterations = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+
+    cold = [cold_start(executable) for _ in range(iterations)]
+    with SimulatorProcess(executable, zygote=True) as zygote:
+        if not zygote.is_running():
+            raise RuntimeError("Zygote failed to start")
+        spawned = [zygote_spawn(zygote) for _ in range(iterations)]
+
+    print(f"cold start:   median {median(cold):8.1f} ms  min {min(cold):8.1f} ms")
+    print(f"zygote spawn: median {median(spawned):8.1f} ms  min {min(spawned):8.1f} ms")
+    print(f"speedup:      {median(cold) / median(spawned):.1f}x")
+
+
+if __name__ == "__main__":
+    main()
@@ -11,15 +11,156 @@ import time
 import subprocess
 import os
 import sys
-from typing import Optional, Tuple, Dict, Any
+from typing import Optional, Tuple, Dict, Any, Union, List
 from pathlib import Path
 
 from PIL import Image
 import numpy as np
 
+try:
+    import lz4.block as _lz4_block
+except ImportError:
+    _lz4_block = None
+
+try:
+    import qoi as _qoi
+except ImportError:
+    _qoi = None
+
+
+# A widget can be addressed by its registry ID or by a numeric handle from resolve()
+WidgetRef = Union[str, int]
+
+
+def lz4_block_decompress(data: bytes, uncompressed_size: int) -> bytes:
+    """Decode an LZ4 block (no frame header), using the lz4 package when installed."""
+    if _lz4_block is not None:
+        return _lz4_block.decompress(data, uncompressed_size=uncompressed_size)
+    
+    out = bytearray()
+    pos = 0
+    end = len(data)
+    while pos < end:
+        token = data[pos]
+        pos += 1
+        
+        literal_len = token >> 4
+        if literal_len == 15:
+            while True:
+                extra = data[pos]
+                pos += 1
+                literal_len += extra
+                if extra != 255:
+                    break
+        out += data[pos:pos + literal_len]
+        pos += literal_len
+        if pos >= end:
+            break  # last sequence carries literals only
+        
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        match_len = token & 15
+        if match_len == 15:
+            while True:
+                extra = data[pos]
+                pos += 1
+                match_len += extra
+                if extra != 255:
+                    break
+        match_len += 4
+        
+        start = len(out) - offset
+        if offset >= match_len:
+            out += out[start:start + match_len]
+        else:
+            # Overlapping copy repeats the last 'offset' bytes
+            pattern = bytes(out[start:])
+            out += (pattern * (match_len // offset + 1))[:match_len]
+    
+    if len(out) != uncompressed_size:
+        raise ValueError(f"LZ4 block decoded to {len(out)} bytes, expected {uncompressed_size}")
+    return bytes(out)
+
+
+def qoi_decode(data: bytes) -> np.ndarray:
+    """Decode a QOI image to an RGB or RGBA array, using the qoi package when installed."""
+    if len(data) < 22 or data[:4] != b"qoif":
+        raise ValueError("Not a QOI image")
+    width = int.from_bytes(data[4:8], "big")
+    height = int.from_bytes(data[8:12], "big")
+    channels = data[12]
+    
+    if _qoi is not None:
+        return _qoi.decode(data)
+    
+    out = bytearray(width * height * 4)
+    index = [(0, 0, 0, 0)] * 64
+    r, g, b, a = 0, 0, 0, 255
+    pos = 14
+    end = len(data) - 8
+    run = 0
+    for px in range(0, len(out), 4):
+        if run > 0:
+            run -= 1
+        elif pos < end:
+            b1 = data[pos]
+            pos += 1
+            if b1 == 0xFE:
+                r, g, b = data[pos], data[pos + 1], data[pos + 2]
+                pos += 3
+            elif b1 == 0xFF:
+                r, g, b, a = data[pos], data[pos + 1], data[pos + 2], data[pos + 3]
+                pos += 4
+            elif b1 < 0x40:
+                r, g, b, a = index[b1]
+            elif b1 < 0x80:
+                r = (r + ((b1 >> 4) & 3) - 2) & 0xFF
+                g = (g + ((b1 >> 2) & 3) - 2) & 0xFF
+                b = (b + (b1 & 3) - 2) & 0xFF
+            elif b1 < 0xC0:
+                b2 = data[pos]
+                pos += 1
+                vg = (b1 & 0x3F) - 32
+                r = (r + vg - 8 + (b2 >> 4)) & 0xFF
+                g = (g + vg) & 0xFF
+                b = (b + vg - 8 + (b2 & 0x0F)) & 0xFF
+            else:
+                run = b1 & 0x3F
+            index[(r * 3 + g * 5 + b * 7 + a * 11) % 64] = (r, g, b, a)
+        out[px:px + 4] = bytes((r, g, b, a))
+    
+    pixels = np.frombuffer(bytes(out), dtype=np.uint8).reshape(height, width, 4)
+    return pixels if channels == 4 else pixels[..., :3]
+
+
+def raw_to_array(data: bytes, width: int, height: int, fmt: str) -> np.ndarray:
+    """Convert raw screenshot pixels to an RGB (or RGBA for argb8888) array of shape (h, w, c)."""
+    fmt = fmt.lower()
+    if fmt in ("rgb24", "rgb"):
+        return np.frombuffer(data, dtype=np.uint8).reshape(height, width, 3)
+    if fmt == "rgba":
+        return np.frombuffer(data, dtype=np.uint8).reshape(height, width, 4)
+    if fmt == "argb8888":
+        # Stored B,G,R,A in memory
+        return np.frombuffer(data, dtype=np.uint8).reshape(height, width, 4)[..., [2, 1, 0, 3]]
+    if fmt == "rgb565":
+        px = np.frombuffer(data, dtype="<u2").reshape(height, width)
+        r = (px >> 11) & 0x1F
+        g = (px >> 5) & 0x3F
+        b = px & 0x1F
+        rgb = np.empty((height, width, 3), dtype=np.uint8)
+        rgb[..., 0] = (r << 3) | (r >> 2)
+        rgb[..., 1] = (g << 2) | (g >> 4)
+        rgb[..., 2] = (b << 3) | (b >> 2)
+        return rgb
+    raise ValueError(f"Unsupported raw format: {fmt}")
+
 
 class LVGLTestClient:
     """Client for communicating with LVGL test simulator."""
+
+    # Screen containers of the watch demo; show_screen() hides all but one
+    WATCH_SCREENS = ("main_screen", "hr_screen", "activity_screen")
     
     def __init__(self, host: str = "127.0.0.1", port: int = 12345, timeout: float = 30.0):
         self.host = host
@@ -27,11 +168,21 @@ class LVGLTestClient:
         self.timeout = timeout
         self.socket: Optional[socket.socket] = None
         self.connected = False
+        # Local mirror of the server's UI tree, kept current by tree()
+        self._tree_nodes: Dict[int, Dict[str, Any]] = {}
+        self._tree_version = 0
+        # Frame version of the last screenshot received, and its bytes
+        self.last_frame_version: Optional[int] = None
+        self._last_screenshot: Optional[bytes] = None
+        # Frame rebuilt from delta captures, and the format it was requested in
+        self._delta_frame: Optional[np.ndarray] = None
+        self._delta_fmt: Optional[str] = None
         
     def connect(self) -> bool:
         """Connect to the LVGL simulator."""
         try:
             self.socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            self._delta_frame = None
             self.socket.settimeout(self.timeout)
             self.socket.connect((self.host, self.port))
             self.connected = True
@@ -97,21 +248,39 @@ class LVGLTestClient:
             buffer += chunk
         return buffer
     
-    def click(self, widget_id: str) -> bool:
-        """Click a widget by ID."""
+    @staticmethod
+    def _widget_ref(widget: WidgetRef) -> Dict[str, Any]:
+        """Build the command field addressing a widget by handle or ID."""
+        if isinstance(widget, int):
+            return {"h": widget}
+        return {"id": widget}
+    
+    def resolve(self, widget_id: str) -> Optional[int]:
+        """Resolve a widget ID into a numeric handle for repeated commands."""
+        try:
+            response = self._send_command({"cmd": "resolve", "id": widget_id})
+            if response.get("status") == "ok":
+                return response.get("h")
+            return None
+        except Exception as e:
+            print(f"Resolve failed: {e}")
+            return None
+    
+    def click(self, widget_id: WidgetRef) -> bool:
+        """Click a widget by ID or handle."""
         try:
-            response = self._send_command({"cmd": "click", "id": widget_id})
+            response = self._send_command({"cmd": "click", **self._widget_ref(widget_id)})
             return response.get("status") == "ok"
         except Exception as e:
             print(f"Click failed: {e}")
             return False
     
-    def longpress(self, widget_id: str, duration_ms: int = 1000) -> bool:
-        """Long press a widget by ID."""
+    def longpress(self, widget_id: WidgetRef, duration_ms: int = 1000) -> bool:
+        """Long press a widget by ID or handle."""
         try:
             response = self._send_command({
                 "cmd": "longpress", 
-                "id": widget_id, 
+                **self._widget_ref(widget_id), 
                 "ms": duration_ms
             })
             return response.get("status") == "ok"
@@ -141,10 +310,10 @@ class LVGLTestClient:
             print(f"Key event failed: {e}")
             return False
     
-    def get_state(self, widget_id: str) -> Optional[str]:
-        """Get widget state (text content)."""
+    def get_state(self, widget_id: WidgetRef) -> Optional[str]:
+        """Get widget state (text content) by ID or handle."""
         try:
-            response = self._send_command({"cmd": "get_state", "id": widget_id})
+            response = self._send_command({"cmd": "get_state", **self._widget_ref(widget_id)})
             if response.get("status") == "ok":
                 return response.get("text")
             return None
@@ -152,12 +321,12 @@ class LVGLTestClient:
             print(f"Get state failed: {e}")
             return None
     
-    def set_text(self, widget_id: str, text: str) -> bool:
-        """Set widget text content."""
+    def set_text(self, widget_id: WidgetRef, text: str) -> bool:
+        """Set widget text content by ID or handle."""
         try:
             response = self._send_command({
                 "cmd": "set_text", 
-                "id": widget_id, 
+                **self._widget_ref(widget_id), 
                 "text": text
             })
             return response.get("status") == "ok"
@@ -165,6 +334,32 @@ class LVGLTestClient:
             print(f"Set text failed: {e}")
             return False
     
+    def dump_tree(self, since: int = 0) -> Optional[Dict[str, Any]]:
+        """Dump the active object tree; with since > 0 only nodes changed after that version."""
+        try:
+            response = self._send_command({"cmd": "dump_tree", "since": since})
+            if response.get("status") == "ok":
+                return response
+            return None
+        except Exception as e:
+            print(f"Dump tree failed: {e}")
+            return None
+    
+    def tree(self) -> Dict[int, Dict[str, Any]]:
+        """Return the full UI tree keyed by node key, fetching only changes since the last call."""
+        response = self.dump_tree(self._tree_version)
+        if response is None:
+            return self._tree_nodes
+        
+        if response.get("full"):
+            self._tree_nodes = {}
+        for key in response.get("removed", []):
+            self._tree_nodes.pop(key, None)
+        for node in response.get("nodes", []):
+            self._tree_nodes[node["k"]] = node
+        self._tree_version = response.get("version", self._tree_version)
+        return self._tree_nodes
+    
     def wait(self, duration_ms: int = 100) -> bool:
         """Wait for specified duration."""
         try:
@@ -202,32 +397,205 @@ class LVGLTestClient:
             print(f"Drag from ({x1}, {y1}) to ({x2}, {y2}) failed: {e}")
             return False
     
-    def screenshot(self, save_path: Optional[str] = None) -> Optional[bytes]:
-        """Take a screenshot and optionally save to file."""
+    @staticmethod
+    def _region_ref(region: Union[WidgetRef, Tuple[int, int, int, int]]) -> Dict[str, Any]:
+        """Build the command fields for a capture region: (x, y, w, h) or a widget ref."""
+        if isinstance(region, (tuple, list)):
+            return {"rect": list(region)}
+        return LVGLTestClient._widget_ref(region)
+    
+    def screenshot(self, save_path: Optional[str] = None, skip_unchanged: bool = False,
+                   region: Optional[Union[WidgetRef, Tuple[int, int, int, int]]] = None,
+                   level: Optional[int] = None, filter: Optional[str] = None,
+                   threads: Optional[int] = None, format: str = "png") -> Optional[bytes]:
+        """Take a screenshot and optionally save to file.
+        
+        region limits the capture to a rectangle (x, y, w, h) in screen coordinates,
+        or to a single widget given by ID or handle.
+        With skip_unchanged=True the server only sends pixels if the display has
+        flushed since the previous screenshot; otherwise the last image is reused.
+        level (0 = store only, 1 = fastest ... 9 = smallest), filter ("adaptive",
+        "none", "sub", "up", "avg", "paeth") and threads (parallel deflate bands)
+        tune the PNG encoder; the server picks its defaults when they are omitted.
+        format="qoi" returns a QOI image instead (see qoi_decode()).
+        """
         try:
-            response = self._send_command({"cmd": "screenshot"})
+            command: Dict[str, Any] = {"cmd": "screenshot"}
+            if format != "png":
+                command["format"] = format
+            if level is not None:
+                command["level"] = level
+            if filter is not None:
+                command["filter"] = filter
+            if threads is not None:
+                command["threads"] = threads
+            if region is not None:
+                command.update(self._region_ref(region))
+            elif skip_unchanged and format == "png" and self.last_frame_version is not None and self._last_screenshot:
+                command["if_version"] = self.last_frame_version
+            response = self._send_command(command)
             
             if response.get("status") != "ok":
                 print(f"Screenshot command failed: {response}")
                 return None
             
-            # Check if it's raw framebuffer data
-            if response.get("type") == "screenshot_raw":
-                return self._handle_raw_screenshot(response, save_path)
-            elif response.get("type") == "screenshot":
-                # Legacy PNG handling
-                return self._handle_png_screenshot(response, save_path)
-            else:
-                print(f"Unexpected response type: {response.get('type')}")
-                return None
+            if response.get("unchanged"):
+                print(f"Screenshot unchanged (frame {response.get('frame_version')})")
+                if save_path:
+                    with open(save_path, 'wb') as f:
+                        f.write(self._last_screenshot)
+                return self._last_screenshot
+            
+            data = self._receive_screenshot(response, save_path)
+            if data is not None and region is None and format == "png":
+                self.last_frame_version = response.get("frame_version")
+                self._last_screenshot = data
+            return data
             
         except Exception as e:
             print(f"Screenshot failed: {e}")
             return None
     
-    def _handle_raw_screenshot(self, response: Dict[str, Any], save_path: Optional[str] = None) -> Optional[bytes]:
-        """Handle raw framebuffer screenshot data."""
-        # Get format information
+    def screenshot_regions(self, regions: List[Union[WidgetRef, Tuple[int, int, int, int]]]) -> List[Optional[bytes]]:
+        """Capture several rectangles and/or widgets in one round trip.
+        
+        Returns one PNG per region, in order; None for regions that failed.
+        """
+        try:
+            response = self._send_command({"cmd": "screenshot",
+                                           "regions": [self._region_ref(r) for r in regions]})
+            if response.get("status") != "ok" or response.get("type") != "screenshot_multi":
+                print(f"Multi-region screenshot failed: {response}")
+                return [None] * len(regions)
+            
+            images: List[Optional[bytes]] = []
+            for _ in range(response.get("count", 0)):
+                part = json.loads(self._recv_line())
+                if part.get("status") != "ok":
+                    print(f"Region {part.get('index')} failed: {part.get('error')}")
+                    images.append(None)
+                else:
+                    images.append(self._receive_screenshot(part))
+            return images
+            
+        except Exception as e:
+            print(f"Multi-region screenshot failed: {e}")
+            return [None] * len(regions)
+    
+    def capture_screens(self, screens: Tuple[str, ...] = WATCH_SCREENS,
+                        save_dir: Optional[str] = None) -> Dict[str, Optional[bytes]]:
+        """Capture each screen container as a PNG in one round trip, without navigating.
+
+        Hidden screens render offscreen, so the visible screen is left as it is.
+        save_dir (optional) also writes <screen>.png files there.
+        """
+        images = dict(zip(screens, self.screenshot_regions(list(screens))))
+        if save_dir:
+            os.makedirs(save_dir, exist_ok=True)
+            for screen, png in images.items():
+                if png is not None:
+                    with open(os.path.join(save_dir, f"{screen}.png"), 'wb') as f:
+                        f.write(png)
+        return images
+
+    def _receive_screenshot(self, response: Dict[str, Any], save_path: Optional[str] = None) -> Optional[bytes]:
+        """Read the payload that follows a screenshot header."""
+        # Check if it's raw framebuffer data
+        if response.get("type") == "screenshot_raw":
+            return self._handle_raw_screenshot(response, save_path)
+        elif response.get("type") == "screenshot":
+            # Legacy PNG handling
+            return self._handle_png_screenshot(response, save_path)
+        print(f"Unexpected response type: {response.get('type')}")
+        return None
+    
+    def capture_pixels(self, region: Optional[Union[WidgetRef, Tuple[int, int, int, int]]] = None,
+                       fmt: str = "rgb565", compress: bool = False) -> Optional[np.ndarray]:
+        """Capture raw pixels without PNG encoding on either side.
+        
+        fmt is rgb24, argb8888 or the display-native rgb565 (half the bytes), or qoi
+        for a losslessly compressed frame that is cheap to encode.
+        compress=True LZ4-compresses raw payloads, worthwhile on non-local links.
+        Returns an RGB (RGBA for argb8888) array of shape (height, width, channels).
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "screenshot", "format": fmt}
+            if compress:
+                command["compress"] = "lz4"
+            if region is not None:
+                command.update(self._region_ref(region))
+            response = self._send_command(command)
+            
+            expected = "screenshot" if fmt == "qoi" else "screenshot_raw"
+            if response.get("status") != "ok" or response.get("type") != expected:
+                print(f"Raw capture failed: {response}")
+                return None
+            
+            self.last_frame_version = response.get("frame_version", self.last_frame_version)
+            if fmt == "qoi":
+                return qoi_decode(self._recv_exact(response.get("len", 0)))
+            return self._receive_raw_pixels(response)
+            
+        except Exception as e:
+            print(f"Raw capture failed: {e}")
+            return None
+    
+    def capture_delta(self, fmt: str = "png", compress: bool = False,
+                      keyframe: bool = False) -> Optional[np.ndarray]:
+        """Capture the screen as a delta against the previous capture_delta() call.
+        
+        The server sends only the rectangles that changed since the last delta frame on
+        this connection, each encoded on its own (fmt: png, qoi, rgb24, argb8888, rgb565),
+        and they are pasted into a locally kept copy of the frame. The first call, a
+        format change or keyframe=True fetch a full frame.
+        Returns the rebuilt frame as an RGB (RGBA for argb8888) array; treat it as read-only.
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "screenshot", "delta": True}
+            if fmt != "png":
+                command["format"] = fmt
+            if compress:
+                command["compress"] = "lz4"
+            if keyframe or self._delta_frame is None or fmt != self._delta_fmt:
+                command["keyframe"] = True
+            response = self._send_command(command)
+            
+            if response.get("status") != "ok" or response.get("type") != "screenshot_delta":
+                print(f"Delta capture failed: {response}")
+                return None
+            
+            payload = self._recv_exact(response.get("len", 0))
+            self.last_frame_version = response.get("frame_version", self.last_frame_version)
+            
+            if response.get("keyframe"):
+                channels = 4 if fmt == "argb8888" else 3
+                self._delta_frame = np.zeros((response["height"], response["width"], channels), dtype=np.uint8)
+                self._delta_fmt = fmt
+            
+            offset = 0
+            for x, y, w, h, length, raw_len in response.get("rects", []):
+                data = payload[offset:offset + length]
+                offset += length
+                if fmt == "png":
+                    import io
+                    pixels = np.asarray(Image.open(io.BytesIO(data)).convert("RGB"))
+                elif fmt == "qoi":
+                    pixels = qoi_decode(data)
+                else:
+                    if response.get("compression") == "lz4":
+                        data = lz4_block_decompress(data, raw_len)
+                    pixels = raw_to_array(data, w, h, fmt)
+                self._delta_frame[y:y + h, x:x + w] = pixels
+            
+            return self._delta_frame
+            
+        except Exception as e:
+            print(f"Delta capture failed: {e}")
+            self._delta_frame = None
+            return None
+    
+    def _receive_raw_pixels(self, response: Dict[str, Any]) -> Optional[np.ndarray]:
+        """Read a screenshot_raw payload and decode it to an array."""
         width = response.get("width", 0)
         height = response.get("height", 0)
         format_str = response.get("format", "RGB")
@@ -245,20 +613,21 @@ class LVGLTestClient:
             print(f"Incomplete raw data received: {len(raw_data)}/{raw_len} bytes")
             return None
         
-        # Convert raw data to PNG using PIL
+        if response.get("compression") == "lz4":
+            raw_data = lz4_block_decompress(raw_data, response.get("raw_len", 0))
+        
+        return raw_to_array(raw_data, width, height, format_str)
+    
+    def _handle_raw_screenshot(self, response: Dict[str, Any], save_path: Optional[str] = None) -> Optional[bytes]:
+        """Handle raw framebuffer screenshot data, converting it to PNG bytes."""
         try:
-            from PIL import Image
-            import io
-            
-            # Create PIL Image from raw bytes
-            if format_str == "RGB":
-                img = Image.frombytes("RGB", (width, height), raw_data)
-            elif format_str == "RGBA":
-                img = Image.frombytes("RGBA", (width, height), raw_data)
-            else:
-                print(f"Unsupported format: {format_str}")
+            pixels = self._receive_raw_pixels(response)
+            if pixels is None:
                 return None
             
+            import io
+            img = Image.fromarray(pixels, "RGBA" if pixels.shape[2] == 4 else "RGB")
+            
             # Convert to PNG bytes
             png_buffer = io.BytesIO()
             img.save(png_buffer, format='PNG')
@@ -274,22 +643,19 @@ class LVGLTestClient:
             
             return png_data
             
-        except ImportError:
-            print("PIL (Pillow) is required for raw screenshot conversion")
-            return None
         except Exception as e:
             print(f"Failed to convert raw data to PNG: {e}")
             return None
     
     def _handle_png_screenshot(self, response: Dict[str, Any], save_path: Optional[str] = None) -> Optional[bytes]:
-        """Handle legacy PNG screenshot data."""
+        """Handle encoded (PNG or QOI) screenshot data."""
         png_len = response.get("len", 0)
         if png_len <= 0:
             print("Invalid PNG length")
             return None
         
         png_data = self._recv_exact(png_len)
-        print(f"Received PNG screenshot: {len(png_data)} bytes")
+        print(f"Received {response.get('format', 'PNG')} screenshot: {len(png_data)} bytes")
         
         # Save to file if requested
         if save_path:
@@ -298,7 +664,278 @@ class LVGLTestClient:
             print(f"Screenshot saved to {save_path}")
         
         return png_data
-    
+
+    def frame_hash(self, region: Optional[Union[WidgetRef, Tuple[int, int, int, int]]] = None,
+                   algo: str = "xxh64") -> Optional[str]:
+        """Return a 64-bit hash (16 hex digits) of the screen or a region, without any image transfer.
+
+        algo="xxh64" changes with any pixel; algo="crc32c" is exact too, 32 bits wide and
+        hardware-accelerated on most CPUs; algo="dhash" is perceptual and is compared
+        with hash_distance() against a small threshold instead of for equality.
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "frame_hash", "algo": algo}
+            if region is not None:
+                command.update(self._region_ref(region))
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Frame hash failed: {response}")
+                return None
+            self.last_frame_version = response.get("frame_version", self.last_frame_version)
+            return response.get("hash")
+
+        except Exception as e:
+            print(f"Frame hash failed: {e}")
+            return None
+
+    def frame_hashes(self, regions: List[Union[WidgetRef, Tuple[int, int, int, int]]],
+                     algo: str = "xxh64") -> List[Optional[str]]:
+        """Hash several rectangles and/or widgets in one round trip; None for regions that failed."""
+        try:
+            response = self._send_command({"cmd": "frame_hash", "algo": algo,
+                                           "regions": [self._region_ref(r) for r in regions]})
+            if response.get("status") != "ok":
+                print(f"Frame hash failed: {response}")
+                return [None] * len(regions)
+            return response.get("hashes", [None] * len(regions))
+
+        except Exception as e:
+            print(f"Frame hash failed: {e}")
+            return [None] * len(regions)
+
+    def probe(self, points: Optional[List[Tuple[int, int]]] = None,
+              regions: Optional[List[Union[WidgetRef, Tuple[int, int, int, int], None]]] = None,
+              color: Optional[Tuple[int, int, int]] = None,
+              tolerance: Union[int, Tuple[int, int, int]] = 0) -> Optional[Dict[str, Any]]:
+        """Read pixel colors and region statistics straight from the frame, with no image transfer.
+
+        points are (x, y) screen coordinates; the reply's "points" holds an (r, g, b) tuple per
+        point, None for points off screen. regions are rectangles or widgets (None = whole screen);
+        each gets width, height, mean, min, max and "hist" (3 channels x 16 bins of 16 levels),
+        or "error". With color, each region also counts the pixels within tolerance in "matches".
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "probe"}
+            if points:
+                command["points"] = [list(p) for p in points]
+            if regions:
+                command["regions"] = [self._region_ref(r) if r is not None else {} for r in regions]
+            if color is not None:
+                command["color"] = list(color)
+                if tolerance:
+                    command["tolerance"] = list(tolerance) if isinstance(tolerance, (tuple, list)) else tolerance
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Probe failed: {response}")
+                return None
+            response["points"] = [tuple(p) if p is not None else None for p in response.get("points", [])]
+            return response
+
+        except Exception as e:
+            print(f"Probe failed: {e}")
+            return None
+
+    def pixel(self, x: int, y: int) -> Optional[Tuple[int, int, int]]:
+        """Color of one screen pixel as (r, g, b)."""
+        response = self.probe(points=[(x, y)])
+        return response["points"][0] if response else None
+
+    def display_info(self) -> Optional[Dict[str, Any]]:
+        """Display resolution, current frame_version and render_us, the time LVGL spent
+        rendering and flushing the most recent frame."""
+        try:
+            response = self._send_command({"cmd": "display_info"})
+            if response.get("status") != "ok":
+                print(f"Display info failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"Display info failed: {e}")
+            return None
+
+    def session(self) -> Optional[Dict[str, Any]]:
+        """Session this connection drives: 0 is the main display, others get a headless
+        display of their own. Also reports how many sessions are open."""
+        try:
+            response = self._send_command({"cmd": "session"})
+            if response.get("status") != "ok":
+                print(f"Session info failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"Session info failed: {e}")
+            return None
+
+    def reset(self, seed: Optional[int] = None) -> Optional[Dict[str, Any]]:
+        """Put this session's UI back to its startup state in-process: the data
+        model, all three screens and the widget registry are rebuilt, so handles
+        resolved before turn stale. With seed, later random readings repeat.
+        Returns the reply with reset_us, the server-side duration."""
+        try:
+            command: Dict[str, Any] = {"cmd": "reset"}
+            if seed is not None:
+                command["seed"] = seed
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Reset failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"Reset failed: {e}")
+            return None
+
+    def checkpoint_save(self, name: str) -> Optional[Dict[str, Any]]:
+        """Snapshot this session's UI state on the server under name: the data
+        model, the current screen and the content of every registered widget.
+        Returns the reply (widgets, bytes, elapsed_us) or None on failure."""
+        return self._checkpoint("checkpoint_save", name)
+
+    def checkpoint_load(self, name: str) -> Optional[Dict[str, Any]]:
+        """Restore a checkpoint onto this session's existing widgets; handles
+        stay valid. Any session can load a checkpoint another one saved."""
+        return self._checkpoint("checkpoint_load", name)
+
+    def _checkpoint(self, cmd: str, name: str) -> Optional[Dict[str, Any]]:
+        try:
+            response = self._send_command({"cmd": cmd, "name": name})
+            if response.get("status") != "ok":
+                print(f"{cmd} failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"{cmd} failed: {e}")
+            return None
+
+    @staticmethod
+    def hash_distance(a: str, b: str) -> int:
+        """Number of differing bits between two hashes (use with dhash)."""
+        return bin(int(a, 16) ^ int(b, 16)).count("1")
+
+    def save_baseline(self, name: str,
+                      region: Optional[Union[WidgetRef, Tuple[int, int, int, int]]] = None) -> Optional[Dict[str, Any]]:
+        """Capture the screen (or a region/widget) as a named golden image on the server.
+
+        Baselines go into the simulator's content-addressed store (LVGL_BASELINE_DIR),
+        so later runs can compare without saving again; identical frames share one file.
+        Returns the reply (width, height, hash) or None on failure.
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "baseline", "name": name}
+            if region is not None:
+                command.update(self._region_ref(region))
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Baseline failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"Baseline failed: {e}")
+            return None
+
+    def compare(self, name: str, region: Optional[Union[WidgetRef, Tuple[int, int, int, int]]] = None,
+                tolerance: Union[int, Tuple[int, int, int]] = 0, mask: bool = False) -> Optional[Dict[str, Any]]:
+        """Compare the current screen (or region) against a baseline on the server.
+
+        tolerance is the largest accepted per-channel difference, one value or (r, g, b).
+        The reply has match, mismatches, max_delta and bbox ([x, y, w, h] or None);
+        with mask=True, "mask" is a (height, width) bool array of the differing pixels.
+        In a record run (simulator started with LVGL_BASELINE_RECORD=1) a missing
+        baseline is saved instead and the reply has "recorded": True.
+        Returns None on failure (e.g. baseline_not_found, size_mismatch).
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "compare", "name": name}
+            if tolerance:
+                command["tolerance"] = list(tolerance) if isinstance(tolerance, (tuple, list)) else tolerance
+            if mask:
+                command["mask"] = True
+            if region is not None:
+                command.update(self._region_ref(region))
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Compare failed: {response}")
+                return None
+
+            mask_len = response.get("mask_len", 0)
+            if mask_len > 0:
+                width, height = response["width"], response["height"]
+                bits = np.frombuffer(self._recv_exact(mask_len), dtype=np.uint8).reshape(height, -1)
+                response["mask"] = np.unpackbits(bits, axis=1)[:, :width].astype(bool)
+            return response
+
+        except Exception as e:
+            print(f"Compare failed: {e}")
+            return None
+
+    def record_start(self, name: str, fps: int = 0) -> Optional[str]:
+        """Start recording the session on the server into <LVGL_RECORD_DIR>/<name>.lvrec.
+
+        Every refresh that flushes pixels becomes a frame (at most fps per second when
+        fps > 0), tagged with the last command received. Open the file with Recording.
+        Returns the recording's path on the server, or None on failure (e.g. already_recording).
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "record_start", "name": name}
+            if fps:
+                command["fps"] = fps
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Record start failed: {response}")
+                return None
+            return response.get("path")
+
+        except Exception as e:
+            print(f"Record start failed: {e}")
+            return None
+
+    def record_stop(self) -> Optional[Dict[str, Any]]:
+        """Stop recording; the reply has path, frames, dropped, bytes and duration_ms."""
+        try:
+            response = self._send_command({"cmd": "record_stop"})
+            if response.get("status") != "ok":
+                print(f"Record stop failed: {response}")
+                return None
+            return response
+
+        except Exception as e:
+            print(f"Record stop failed: {e}")
+            return None
+
+    def get_history(self, frames: int = 0, clear: bool = False,
+                    save_path: Optional[str] = None) -> Optional["Recording"]:
+        """Fetch the server's flight recorder: the most recent frames it kept in memory.
+
+        frames > 0 limits the reply to about that many of the latest frames (it always
+        starts at a keyframe); clear=True empties the history afterwards, e.g. at the start
+        of each test. save_path writes the frames as an .lvrec file.
+        Returns a Recording, or None on failure (e.g. history_disabled).
+        """
+        try:
+            command: Dict[str, Any] = {"cmd": "get_history"}
+            if frames:
+                command["frames"] = frames
+            if clear:
+                command["clear"] = True
+            response = self._send_command(command)
+            if response.get("status") != "ok":
+                print(f"Get history failed: {response}")
+                return None
+
+            data = self._recv_exact(response["len"])
+            if save_path:
+                with open(save_path, 'wb') as f:
+                    f.write(data)
+            return Recording(data)
+
+        except Exception as e:
+            print(f"Get history failed: {e}")
+            return None
+
     def __enter__(self):
         """Context manager entry."""
         self.connect()
@@ -309,40 +946,165 @@ class LVGLTestClient:
         self.disconnect()
 
 
+class Recording:
+    """Reader for .lvrec session recordings written by record_start/record_stop.
+
+    Also accepts the bytes returned by get_history. Uses the index written on stop;
+    a recording cut short (no trailer) is scanned frame by frame instead.
+    frame(i) rebuilds frame i from the nearest keyframe.
+    """
+
+    FILE_HEADER = 32
+    FRAME_HEADER = 40
+    RECT_HEADER = 16
+    KEYFRAME = 0x01
+    FORMATS = {2: "argb8888", 3: "rgb565"}
+
+    def __init__(self, source: Union[str, Path, bytes]):
+        if isinstance(source, (bytes, bytearray)):
+            self._data = bytes(source)
+        else:
+            with open(source, "rb") as f:
+                self._data = f.read()
+        data = self._data
+        if len(data) < self.FILE_HEADER or data[:4] != b"LVRC":
+            raise ValueError("Not a recording")
+        self.fps = int.from_bytes(data[8:12], "little")
+        self.keyframe_interval = int.from_bytes(data[12:16], "little")
+
+        # (offset, timestamp_us, flags, frame_version) per frame
+        self._frames: List[Tuple[int, int, int, int]] = []
+        if len(data) >= self.FILE_HEADER + 16 and data[-4:] == b"LVRE":
+            index_offset = int.from_bytes(data[-16:-8], "little")
+            count = int.from_bytes(data[-8:-4], "little")
+            pos = index_offset + 8
+            for _ in range(count):
+                entry = data[pos:pos + 24]
+                self._frames.append((int.from_bytes(entry[0:8], "little"), int.from_bytes(entry[8:16], "little"),
+                                     int.from_bytes(entry[16:20], "little"), int.from_bytes(entry[20:24], "little")))
+                pos += 24
+        else:
+            pos = self.FILE_HEADER
+            while pos + self.FRAME_HEADER <= len(data) and data[pos:pos + 4] == b"FRAM":
+                header = data[pos:pos + self.FRAME_HEADER]
+                payload_len = int.from_bytes(header[20:24], "little")
+                command_len = int.from_bytes(header[30:32], "little")
+                end = pos + self.FRAME_HEADER + command_len + payload_len
+                if end > len(data):
+                    break  # partially written frame
+                self._frames.append((pos, int.from_bytes(header[8:16], "little"), header[33],
+                                     int.from_bytes(header[16:20], "little")))
+                pos = end
+
+    def __len__(self) -> int:
+        return len(self._frames)
+
+    @property
+    def timestamps_ms(self) -> List[float]:
+        """Frame times in milliseconds since record_start."""
+        return [ts / 1000.0 for _, ts, _, _ in self._frames]
+
+    @property
+    def frame_versions(self) -> List[int]:
+        return [version for _, _, _, version in self._frames]
+
+    def command(self, index: int) -> str:
+        """The last command the server received before frame index was captured."""
+        pos = self._frames[index][0]
+        command_len = int.from_bytes(self._data[pos + 30:pos + 32], "little")
+        start = pos + self.FRAME_HEADER
+        return self._data[start:start + command_len].decode("utf-8", "replace")
+
+    def frame(self, index: int) -> np.ndarray:
+        """Frame index as an RGB (rgb565 displays) or RGBA array of shape (h, w, c)."""
+        start = index
+        while start > 0 and not self._frames[start][2] & self.KEYFRAME:
+            start -= 1
+        image = None
+        for i in range(start, index + 1):
+            image = self._apply(i, image)
+        return image.copy()
+
+    def frames(self):
+        """Yield every frame in order, applying each delta once."""
+        image = None
+        for i in range(len(self._frames)):
+            image = self._apply(i, image)
+            yield image.copy()
+
+    def _apply(self, index: int, image: Optional[np.ndarray]) -> np.ndarray:
+        """Paste frame index's rectangles onto the previous frame (keyframes cover the screen)."""
+        pos = self._frames[index][0]
+        header = self._data[pos:pos + self.FRAME_HEADER]
+        width = int.from_bytes(header[24:26], "little")
+        height = int.from_bytes(header[26:28], "little")
+        rect_count = int.from_bytes(header[28:30], "little")
+        command_len = int.from_bytes(header[30:32], "little")
+        fmt = self.FORMATS[header[32]]
+        if image is None or image.shape[:2] != (height, width):
+            image = np.zeros((height, width, 4 if fmt == "argb8888" else 3), dtype=np.uint8)
+
+        rect_pos = pos + self.FRAME_HEADER + command_len
+        for _ in range(rect_count):
+            rect = self._data[rect_pos:rect_pos + self.RECT_HEADER]
+            x, y, w, h = (int.from_bytes(rect[k:k + 2], "little") for k in range(0, 8, 2))
+            length = int.from_bytes(rect[8:12], "little")
+            raw_len = int.from_bytes(rect[12:16], "little")
+            payload = self._data[rect_pos + self.RECT_HEADER:rect_pos + self.RECT_HEADER + length]
+            if length != raw_len:
+                payload = lz4_block_decompress(payload, raw_len)
+            image[y:y + h, x:x + w] = raw_to_array(payload, w, h, fmt)
+            rect_pos += self.RECT_HEADER + length
+        return image
+
+
 class SimulatorProcess:
     """Manages the LVGL simulator process."""
     
-    def __init__(self, executable_path: str):
+    def __init__(self, executable_path: str, headless: Optional[bool] = None,
+                 resolution: Optional[Union[int, Tuple[int, int]]] = None,
+                 zygote: bool = False, port: int = 12345):
         self.executable_path = Path(executable_path)
         self.process: Optional[subprocess.Popen] = None
+        # None follows LVGL_HEADLESS=1, which the simulator also reads itself
+        self.headless = os.getenv('LVGL_HEADLESS') == '1' if headless is None else headless
+        # None keeps the simulator's default (480x480, or LVGL_RESOLUTION)
+        self.resolution = (resolution, resolution) if isinstance(resolution, int) else resolution
+        # Zygote mode: initialize once, then spawn() a fresh forked copy per test
+        self.zygote = zygote
+        self.port = port
         
     def start(self, wait_for_ready: float = 5.0) -> bool:
-        """Start the simulator process."""
+        """Start the simulator process and wait up to wait_for_ready seconds
+        for its port to accept connections."""
         if not self.executable_path.exists():
             print(f"Simulator executable not found: {self.executable_path}")
             return False
         
         try:
-            # Set up environment
-            env = os.environ.copy()
-            # Allow GUI mode by default for UI testing
-            # Only use headless mode if explicitly requested via environment variable
-            if os.getenv('LVGL_HEADLESS') == '1':
-                env['SDL_VIDEODRIVER'] = 'dummy'  # Use dummy video driver for headless mode
-                env['SDL_AUDIODRIVER'] = 'dummy'  # Use dummy audio driver
+            # GUI mode by default for UI testing; headless runs on the in-memory
+            # display and never opens an SDL window
+            args = [str(self.executable_path)]
+            if self.headless:
+                args.append('--headless')
+            if self.resolution:
+                args += ['--resolution', f"{self.resolution[0]}x{self.resolution[1]}"]
+            if self.zygote:
+                args.append('--zygote')
             
             # Start the simulator process
             # For debugging, let's not capture output so we can see debug messages
-            self.process = subprocess.Popen(
-                [str(self.executable_path)],
-                env=env
-            )
+            self.process = subprocess.Popen(args, env=os.environ.copy())
             
             print(f"Started simulator process (PID: {self.process.pid})")
             
-            # Wait for the process to be ready
-            print(f"Waiting {wait_for_ready} seconds for simulator to initialize...")
-            time.sleep(wait_for_ready)
+            # The port opens once the UI is built, so poll it instead of sleeping
+            deadline = time.perf_counter() + wait_for_ready
+            while self.process.poll() is None and not self._port_open():
+                if time.perf_counter() >= deadline:
+                    print(f"Simulator not listening on port {self.port} after {wait_for_ready} seconds")
+                    return False
+                time.sleep(0.01)
             
             # Check if process is still running
             if self.process.poll() is not None:
@@ -361,6 +1123,45 @@ class SimulatorProcess:
             print(f"Failed to start simulator: {e}")
             return False
     
+    def _port_open(self) -> bool:
+        try:
+            with socket.create_connection(("127.0.0.1", self.port), timeout=0.1):
+                return True
+        except OSError:
+            return False
+    
+    def spawn(self) -> Optional[Dict[str, Any]]:
+        """Fork a fresh simulator from the zygote.
+        
+        Returns {"pid", "port"}; the child serves one client on that port and
+        exits when it disconnects (or if nobody connects within 30 seconds).
+        """
+        try:
+            with socket.create_connection(("127.0.0.1", self.port), timeout=5.0) as control:
+                control.sendall(b'{"cmd":"spawn"}\n')
+                response = b""
+                while not response.endswith(b"\n"):
+                    chunk = control.recv(256)
+                    if not chunk:
+                        break
+                    response += chunk
+            result = json.loads(response)
+        except (OSError, ValueError) as e:
+            print(f"Spawn failed: {e}")
+            return None
+        if result.get("status") != "ok":
+            print(f"Spawn failed: {result}")
+            return None
+        return {"pid": result["pid"], "port": result["port"]}
+    
+    def spawn_client(self) -> Optional["LVGLTestClient"]:
+        """Spawn a fresh simulator and return a client connected to it."""
+        child = self.spawn()
+        if not child:
+            return None
+        client = LVGLTestClient(port=child["port"])
+        return client if client.connect() else None
+    
     def stop(self):
         """Stop the simulator process."""
         if self.process:
@@ -13,7 +13,7 @@ import sys
 # Add parent directory to path for imports
 sys.path.insert(0, str(Path(__file__).parent.parent))
 
-from lvgl_client import LVGLTestClient
+from lvgl_client import LVGLTestClient, Recording
 
 
 class TestUIAutomation:
@@ -313,7 +313,511 @@ class TestUIAutomation:
         assert time_text is not None, "UI should remain responsive after errors"
         
         print("[PASS] Error handling validated - UI remains stable")
+    
+    def test_08_widget_handles(self, client):
+        """Test resolving widget IDs into handles and using them in commands."""
+        print("Testing widget handles...")
+        self.reset_to_main_screen(client)
+        
+        handle = client.resolve("lbl_time")
+        assert isinstance(handle, int) and handle > 0, f"Invalid handle: {handle}"
+        
+        # Handle and ID must address the same widget
+        by_handle = client.get_state(handle)
+        by_id = client.get_state("lbl_time")
+        assert by_handle is not None and ":" in by_handle, f"Invalid time via handle: {by_handle}"
+        assert by_handle[:2] == by_id[:2], f"Handle/ID mismatch: {by_handle} vs {by_id}"
+        
+        assert client.resolve("non_existent_widget") is None, "Unknown IDs must not resolve"
+        
+        # A handle whose generation does not match the registry must be rejected
+        stale = client._send_command({"cmd": "get_state", "h": handle + (1 << 8)})
+        assert stale.get("error") == "stale_handle", f"Stale handle accepted: {stale}"
+        
+        print(f"[PASS] Widget handles validated - lbl_time -> h={handle}")
+    
+    def test_09_tree_dump_and_diff(self, client):
+        """Test full tree dump and incremental diff after a text change."""
+        print("Testing UI tree dump...")
+        self.reset_to_main_screen(client)
+        
+        full = client.dump_tree()
+        assert full is not None and full["full"], f"Invalid tree dump: {full}"
+        ids = {node.get("id") for node in full["nodes"]}
+        assert "lbl_time" in ids and "heart_area" in ids, f"Registered widgets missing: {ids}"
+        
+        assert client.set_text("lbl_date", "TREE DIFF")
+        diff = client.dump_tree(full["version"])
+        assert diff is not None and not diff["full"], f"Invalid tree diff: {diff}"
+        changed = [node for node in diff["nodes"] if node.get("id") == "lbl_date"]
+        assert changed and changed[0]["text"] == "TREE DIFF", f"Text change missing from diff: {diff}"
+        assert len(diff["nodes"]) < len(full["nodes"]), "Diff should only carry changed nodes"
+        
+        print(f"[PASS] Tree dump validated - {len(full['nodes'])} nodes, diff {len(diff['nodes'])} nodes")
+
+    
+    def test_10_screenshot_frame_cache(self, client):
+        """Test that unchanged frames are served from the cache and skippable by version."""
+        print("Testing screenshot frame cache...")
+        self.reset_to_main_screen(client)
+        
+        first = client.screenshot()
+        assert first, "Initial screenshot failed"
+        version = client.last_frame_version
+        assert version is not None, "Screenshot reply missing frame_version"
+        
+        second = client.screenshot()
+        if client.last_frame_version == version:
+            assert second == first, "Same frame version must return identical bytes"
+        
+        skipped = client.screenshot(skip_unchanged=True)
+        assert skipped, "Skip-unchanged screenshot failed"
+        
+        assert client.set_text("lbl_date", "FRAME CACHE")
+        changed = client.screenshot()
+        assert changed and client.last_frame_version > version, "Text change should flush a new frame"
+        assert changed != first, "New frame should produce a different image"
+        
+        print(f"[PASS] Frame cache validated - frame {version} -> {client.last_frame_version}")
+
+    
+    def test_11_region_screenshots(self, client):
+        """Test rectangle, widget and multi-region captures."""
+        print("Testing region screenshots...")
+        self.reset_to_main_screen(client)
+        import io
+        from PIL import Image
+        
+        full = client.screenshot()
+        assert full, "Full screenshot failed"
+        full_img = Image.open(io.BytesIO(full))
+        
+        rect = client.screenshot(region=(10, 20, 100, 50))
+        assert rect, "Rectangle screenshot failed"
+        assert Image.open(io.BytesIO(rect)).size == (100, 50), "Rectangle size mismatch"
+        
+        clipped = client.screenshot(region=(full_img.width - 40, 0, 100, 30))
+        assert clipped and Image.open(io.BytesIO(clipped)).size == (40, 30), "Rectangle not clipped to screen"
+        
+        label = client.screenshot(region="lbl_time")
+        assert label and len(label) < len(full), "Widget capture should be smaller than the full frame"
+        
+        handle = client.resolve("lbl_time")
+        parts = client.screenshot_regions([(0, 0, 64, 64), "lbl_time", handle, "no_such_widget"])
+        assert len(parts) == 4, f"Expected 4 region replies, got {len(parts)}"
+        assert parts[0] and Image.open(io.BytesIO(parts[0])).size == (64, 64), "First region wrong"
+        assert parts[1] == parts[2], "ID and handle should capture the same widget"
+        assert parts[3] is None, "Unknown widget should fail on its own"
+        
+        print(f"[PASS] Region screenshots validated - widget {len(label)} bytes vs full {len(full)} bytes")
+
+    
+    def test_12_raw_screenshot_formats(self, client):
+        """Test raw rgb24/argb8888/rgb565 captures, with and without LZ4, against the PNG."""
+        print("Testing raw screenshot formats...")
+        self.reset_to_main_screen(client)
+        import io
+        import numpy as np
+        from PIL import Image
+        
+        png = client.screenshot()
+        assert png, "PNG screenshot failed"
+        reference = np.asarray(Image.open(io.BytesIO(png)).convert("RGB"))
+        
+        for fmt in ("rgb24", "argb8888", "rgb565"):
+            for compress in (False, True):
+                pixels = client.capture_pixels(fmt=fmt, compress=compress)
+                assert pixels is not None, f"Raw capture {fmt} compress={compress} failed"
+                assert pixels.shape[:2] == reference.shape[:2], f"{fmt} size mismatch: {pixels.shape}"
+                assert np.array_equal(pixels[..., :3], reference), f"{fmt} compress={compress} differs from PNG"
+        
+        label = client.capture_pixels(region="lbl_time", fmt="rgb565")
+        assert label is not None and label.shape[0] < reference.shape[0], "Raw widget capture failed"
+        
+        print(f"[PASS] Raw formats validated - {reference.shape[1]}x{reference.shape[0]}")
+
+    def test_13_png_encoder_settings(self, client):
+        """Test PNG compression levels, fixed filters and parallel bands decode to the same pixels."""
+        print("Testing PNG encoder settings...")
+        self.reset_to_main_screen(client)
+        import io
+        import numpy as np
+        from PIL import Image
+
+        reference = np.asarray(Image.open(io.BytesIO(client.screenshot())).convert("RGB"))
+
+        sizes = {}
+        for level, filter, threads in ((0, None, None), (1, None, None), (9, None, None),
+                                       (6, "none", None), (6, "paeth", None), (3, None, 1), (3, None, 8)):
+            png = client.screenshot(level=level, filter=filter, threads=threads)
+            assert png, f"Screenshot at level={level} filter={filter} threads={threads} failed"
+            pixels = np.asarray(Image.open(io.BytesIO(png)).convert("RGB"))
+            assert np.array_equal(pixels, reference), f"level={level} filter={filter} threads={threads} differs"
+            sizes[(level, filter, threads)] = len(png)
+
+        assert sizes[(0, None, None)] > sizes[(9, None, None)], "Stored PNG should be larger than level 9"
+
+        response = client._send_command({"cmd": "screenshot", "level": 12})
+        assert response.get("status") == "error", "Out-of-range level should be rejected"
+
+        print(f"[PASS] PNG settings validated - stored {sizes[(0, None, None)]} bytes, level 9 {sizes[(9, None, None)]} bytes")
+
+    def test_14_qoi_screenshots(self, client):
+        """Test QOI screenshots decode to the same pixels as the PNG."""
+        print("Testing QOI screenshots...")
+        self.reset_to_main_screen(client)
+        import io
+        import numpy as np
+        from PIL import Image
+        from lvgl_client import qoi_decode
+
+        reference = np.asarray(Image.open(io.BytesIO(client.screenshot())).convert("RGB"))
+
+        qoi = client.screenshot(format="qoi")
+        assert qoi and qoi[:4] == b"qoif", "QOI screenshot failed"
+        assert np.array_equal(qoi_decode(qoi), reference), "QOI screenshot differs from PNG"
+
+        label = client.capture_pixels(region="lbl_time", fmt="qoi")
+        assert label is not None and label.shape[2] == 3, "QOI widget capture failed"
+
+        print(f"[PASS] QOI validated - {len(qoi)} bytes for {reference.shape[1]}x{reference.shape[0]}")
+
+    def test_15_compare_baseline(self, client):
+        """Test server-side golden image comparison against saved baselines."""
+        print("Testing baseline comparison...")
+        self.reset_to_main_screen(client)
+
+        saved = client.save_baseline("test_heart_button", region="btn_heart")
+        assert saved and saved["width"] > 0, "Saving widget baseline failed"
+        result = client.compare("test_heart_button", region="btn_heart")
+        assert result and result["match"] and result["bbox"] is None, f"Unchanged widget should match: {result}"
+
+        assert client.save_baseline("test_main_screen"), "Saving screen baseline failed"
+        client.click("btn_heart")
+        time.sleep(0.5)
+        result = client.compare("test_main_screen", tolerance=(2, 2, 2), mask=True)
+        assert result and not result["match"], "Heart rate screen should differ from main screen"
+        assert result["max_delta"] > 2 and result["bbox"] is not None
+        assert result["mask"].shape == (result["height"], result["width"])
+        assert int(result["mask"].sum()) == result["mismatches"], "Mask should flag every mismatched pixel"
+
+        assert client.compare("test_missing_baseline") is None, "Unknown baseline should be rejected"
+        assert client.compare("test_heart_button") is None, "Size mismatch should be rejected"
+        response = client._send_command({"cmd": "baseline", "name": "../escape"})
+        assert response.get("error") == "invalid_name", "Path-like baseline names should be rejected"
+
+        print(f"[PASS] Baseline comparison validated - {result['mismatches']} pixels differ in {result['bbox']}")
+        self.reset_to_main_screen(client)
+
+    def test_16_baseline_store(self, client):
+        """Test baselines are content-addressed: identical frames share a hash, changed frames do not."""
+        print("Testing content-addressed baseline store...")
+        self.reset_to_main_screen(client)
+
+        first = client.save_baseline("test_store_a", region="btn_heart")
+        second = client.save_baseline("test_store_b", region="btn_heart")
+        assert first and second, "Saving baselines failed"
+        assert len(first["hash"]) == 16 and first["hash"] == second["hash"], "Identical frames should share one object"
+
+        screen = client.save_baseline("test_store_screen")
+        assert screen and screen["hash"] != first["hash"], "Different frames should have different hashes"
+
+        # Re-recording a name points it at the new content
+        client.save_baseline("test_store_b")
+        result = client.compare("test_store_b")
+        assert result and result["width"] == screen["width"], "Re-recorded baseline should replace the old one"
+        assert not result["recorded"], "Existing baselines are compared, not recorded"
+
+        print(f"[PASS] Baseline store validated - shared object {first['hash']}")
+
+    def test_17_frame_hash(self, client):
+        """Test frame hashes are stable for an unchanged frame and change with the screen."""
+        print("Testing frame hashes...")
+        self.reset_to_main_screen(client)
+
+        button = client.frame_hash(region="btn_heart")
+        assert button and len(button) == 16, f"Invalid widget hash: {button}"
+        assert client.frame_hash(region="btn_heart") == button, "Unchanged widget should hash the same"
+
+        crc = client.frame_hash(region="btn_heart", algo="crc32c")
+        assert crc and crc.startswith("00000000"), f"Invalid CRC32C hash: {crc}"
+        assert client.frame_hash(region="btn_heart", algo="crc32c") == crc, "Unchanged widget should keep its CRC"
+
+        perceptual = client.frame_hash(region="btn_heart", algo="dhash")
+        assert perceptual and client.hash_distance(perceptual, client.frame_hash(region="btn_heart", algo="dhash")) == 0
+
+        hashes = client.frame_hashes(["btn_heart", (0, 0, 100, 100), "no_such_widget"])
+        assert hashes[0] == button and hashes[1] is not None and hashes[2] is None, f"Unexpected region hashes: {hashes}"
+
+        main = client.frame_hash()
+        client.click("btn_heart")
+        time.sleep(0.5)
+        heart = client.frame_hash()
+        assert main and heart and main != heart, "Screen change should change the frame hash"
+
+        response = client._send_command({"cmd": "frame_hash", "algo": "md5"})
+        assert response.get("error") == "invalid_algo", "Unknown hash algorithm should be rejected"
+
+        print(f"[PASS] Frame hashes validated - main {main}, heart rate {heart}")
+        self.reset_to_main_screen(client)
+
+    def test_18_delta_frames(self, client):
+        """Test delta captures rebuild the same frame as a full capture from a few rectangles."""
+        print("Testing delta frames...")
+        self.reset_to_main_screen(client)
+        import numpy as np
+
+        keyframe = client.capture_delta(fmt="rgb24", keyframe=True)
+        assert keyframe is not None and keyframe.shape[2] == 3, "Delta keyframe failed"
+
+        response = client._send_command({"cmd": "screenshot", "delta": True, "format": "rgb24"})
+        assert response.get("type") == "screenshot_delta" and not response.get("keyframe")
+        client._recv_exact(response.get("len", 0))
+        client._delta_frame = None  # the raw reply above bypassed the local frame
+
+        response = client._send_command({"cmd": "screenshot", "delta": True, "rect": [0, 0, 10, 10]})
+        assert response.get("error") == "invalid_region", "Delta captures cover the whole screen"
+
+        client.capture_delta(fmt="rgb24")
+        client.click("btn_heart")
+        time.sleep(0.5)
+        rebuilt = client.capture_delta(fmt="rgb24")
+        version = client.last_frame_version
+        full = client.capture_pixels(fmt="rgb24")
+        assert rebuilt is not None and full is not None, "Delta capture after navigation failed"
+        if client.last_frame_version == version:
+            assert np.array_equal(rebuilt, full), "Rebuilt delta frame differs from a full capture"
+
+        print(f"[PASS] Delta frames validated - {rebuilt.shape[1]}x{rebuilt.shape[0]} rebuilt locally")
+        self.reset_to_main_screen(client)
+
+    def test_19_session_recording(self, client):
+        """Test a recording replays the navigation it captured, tagged with the commands."""
+        print("Testing session recording...")
+        self.reset_to_main_screen(client)
+
+        path = client.record_start("test_session")
+        assert path and path.endswith("test_session.lvrec"), f"Record start failed: {path}"
+        response = client._send_command({"cmd": "record_start", "name": "other"})
+        assert response.get("error") == "already_recording", "Only one recording at a time"
+
+        client.click("btn_heart")
+        time.sleep(0.5)
+        stats = client.record_stop()
+        assert stats and stats["frames"] > 0, f"Record stop failed: {stats}"
+        response = client._send_command({"cmd": "record_stop"})
+        assert response.get("error") == "not_recording", "Second stop should fail"
+
+        recording = Recording(stats["path"])
+        assert len(recording) == stats["frames"], "Index frame count differs from the reply"
+        assert recording.timestamps_ms == sorted(recording.timestamps_ms), "Frames out of order"
+        assert any("btn_heart" in recording.command(i) for i in range(len(recording))), \
+            "No frame tagged with the click"
+        last = recording.frame(len(recording) - 1)
+        assert last.shape[:2] == client.capture_pixels(fmt="rgb24").shape[:2], "Frame size differs from screen"
+
+        print(f"[PASS] Session recording validated - {stats['frames']} frames, {stats['bytes']} bytes")
+        self.reset_to_main_screen(client)
+
+    def test_20_flight_recorder(self, client):
+        """Test the in-memory history holds the frames leading up to the current screen."""
+        print("Testing flight recorder...")
+        self.reset_to_main_screen(client)
+
+        client.get_history(clear=True)
+        client.click("btn_heart")
+        time.sleep(0.5)
+        screen = client.capture_pixels(fmt="rgb24")
+        history = client.get_history()
+        assert history is not None and len(history) > 0, "History should hold the navigation frames"
+        assert any("btn_heart" in history.command(i) for i in range(len(history))), "No frame tagged with the click"
+        last = history.frame(len(history) - 1)
+        assert last.shape[:2] == screen.shape[:2], "History frame size differs from screen"
+
+        recent = client.get_history(frames=1, clear=True)
+        assert recent is not None and 0 < len(recent) <= len(history), "Limited history failed"
+
+        print(f"[PASS] Flight recorder validated - {len(history)} frames before the check")
+        self.reset_to_main_screen(client)
+
+    def test_21_offscreen_screens(self, client):
+        """Test hidden screens capture offscreen in one call without changing the visible screen."""
+        print("Testing offscreen screen capture...")
+        self.reset_to_main_screen(client)
+
+        button = client.frame_hash(region="btn_heart")
+        images = client.capture_screens()
+        assert all(images[screen] for screen in client.WATCH_SCREENS), f"Screen capture failed: {list(images)}"
+        assert images["hr_screen"] != images["main_screen"], "Hidden screen captured the visible one"
+        assert images["activity_screen"] != images["main_screen"], "Hidden screen captured the visible one"
+
+        assert client.frame_hash(region="btn_heart") == button, "Offscreen capture changed the visible screen"
+        assert client.get_state("lbl_time") is not None, "Main screen should still be shown"
+
+        print(f"[PASS] Offscreen capture validated - {', '.join(f'{k} {len(v)}B' for k, v in images.items())}")
+        self.reset_to_main_screen(client)
+
+    def test_22_pixel_probe(self, client):
+        """Test probe colors and region statistics agree with a full raw capture."""
+        print("Testing pixel probes...")
+        self.reset_to_main_screen(client)
+        import numpy as np
+
+        frame = client.capture_pixels(fmt="rgb24")
+        version = client.last_frame_version
+        height, width = frame.shape[:2]
+        points = [(0, 0), (width // 2, height // 2), (width - 1, height - 1), (width, 0)]
+        response = client.probe(points=points, regions=[None, (0, 0, 40, 30), "no_such_widget"],
+                                color=tuple(int(c) for c in frame[0, 0]), tolerance=0)
+        assert response is not None, "Probe failed"
+        assert response["points"][3] is None, "Point off screen should be null"
+
+        whole, rect, missing = response["regions"]
+        assert (whole["width"], whole["height"]) == (width, height), "Whole-screen probe size wrong"
+        assert (rect["width"], rect["height"]) == (40, 30), "Rectangle probe size wrong"
+        assert missing.get("error") == "widget_not_found", "Unknown widget should fail in its slot"
+        assert sum(whole["hist"][0]) == width * height, "Histogram should count every pixel"
+        assert whole["matches"] >= 1, "The probed color occurs at least at (0, 0)"
+
+        if response["frame_version"] == version:
+            for (x, y), rgb in zip(points[:3], response["points"][:3]):
+                assert rgb == tuple(int(c) for c in frame[y, x]), f"Pixel ({x}, {y}) differs from capture"
+            assert whole["min"] == frame.reshape(-1, 3).min(axis=0).tolist(), "Min differs from capture"
+            assert np.allclose(whole["mean"], frame.reshape(-1, 3).mean(axis=0), atol=0.01), "Mean differs"
+
+        assert client.pixel(0, 0) is not None, "Single pixel probe failed"
+        response = client._send_command({"cmd": "probe"})
+        assert response.get("error") == "invalid_probe", "Probe needs points or regions"
+
+        print(f"[PASS] Pixel probes validated - center {client.pixel(width // 2, height // 2)}")
+        self.reset_to_main_screen(client)
+
+    def test_23_display_info(self, client):
+        """Test display_info reports the resolution and the render time of new frames."""
+        print("Testing display info...")
+        self.reset_to_main_screen(client)
+
+        info = client.display_info()
+        assert info is not None, "display_info failed"
+        frame = client.capture_pixels(fmt="rgb24")
+        assert frame.shape[:2] == (info["height"], info["width"]), "Capture size differs from display"
+
+        client.click("btn_heart")
+        deadline = time.time() + 2.0
+        while time.time() < deadline:
+            after = client.display_info()
+            if after["frame_version"] > info["frame_version"]:
+                break
+            time.sleep(0.02)
+        assert after["frame_version"] > info["frame_version"], "Screen switch should render a frame"
+        assert after["render_us"] > 0, "Rendered frame should report its render time"
+
+        print(f"[PASS] Display {info['width']}x{info['height']}, last frame {after['render_us']} us")
+        self.reset_to_main_screen(client)
+
+    def test_24_sessions(self, client):
+        """Test a second connection gets its own display and UI, independent of the first."""
+        print("Testing parallel sessions...")
+        self.reset_to_main_screen(client)
+        import numpy as np
+
+        main = client.session()
+        assert main is not None and main["session"] == 0, "First connection should drive the main display"
+
+        with LVGLTestClient() as other:
+            other.get_history(clear=True)
+            info = other.session()
+            assert info is not None and info["session"] > 0, "Second connection should get its own session"
+            assert info["sessions"] == main["sessions"] + 1, "Session count should include the new one"
+            assert other.display_info()["width"] == client.display_info()["width"], "Sessions share the resolution"
+
+            assert other.click("btn_heart"), "Click in the second session failed"
+            time.sleep(0.2)
+            assert other.frame_hash() != client.frame_hash(), "Sessions should render independently"
+            assert client.get_state("lbl_time") is not None, "Main session should be unaffected"
+
+            rebuilt = other.capture_delta(fmt="rgb24", keyframe=True)
+            assert rebuilt is not None, "Delta capture in the second session failed"
+            assert np.array_equal(rebuilt, other.capture_pixels(fmt="rgb24")), "Delta frame shows another display"
+
+            path = other.record_start("test_session_other")
+            assert path and client.record_start("test_session_main"), "Each session records on its own"
+            other.click("btn_heart")
+            time.sleep(0.3)
+            assert other.record_stop()["frames"] > 0 and client.record_stop(), "Session recording failed"
+
+            history = other.get_history()
+            assert history is not None and len(history) > 0, "Second session should keep its own history"
+            assert any("btn_heart" in history.command(i) for i in range(len(history))), \
+                "Session history should be tagged with its own commands"
+
+            # A long wait on one connection must not hold up the other
+            import threading
+            waiter = threading.Thread(target=other._send_command, args=({"cmd": "wait", "ms": 1500},))
+            waiter.start()
+            time.sleep(0.1)
+            start = time.time()
+            assert client.get_state("lbl_time") is not None, "Main session failed during the other's wait"
+            elapsed = time.time() - start
+            waiter.join()
+            assert elapsed < 1.0, f"Main session waited {elapsed:.2f}s behind the other session's wait"
+
+        time.sleep(0.2)
+        assert client.session()["sessions"] == main["sessions"], "Closed session should be released"
+
+        print(f"[PASS] Session {info['session']} ran beside the main display")
+        self.reset_to_main_screen(client)
+
+
+    def test_25_reset(self, client):
+        """Test reset rebuilds the UI in-process and invalidates old handles."""
+        print("Testing in-process reset...")
+        self.reset_to_main_screen(client)
+
+        handle = client.resolve("lbl_steps_main")
+        assert handle is not None, "Failed to resolve lbl_steps_main"
+        assert client.longpress("btn_heart"), "Longpress failed"
+        assert client.get_state("lbl_steps_main") != "STEPS: 1254", "Longpress should change the steps label"
+
+        result = client.reset(seed=1)
+        assert result is not None, "Reset failed"
+        assert result["reset_us"] < 1_000_000, f"Reset took {result['reset_us']} us"
+
+        assert client.get_state("lbl_steps_main") == "STEPS: 1254", "Reset should restore the steps label"
+        assert client.get_state(handle) is None, "Handles from before the reset should be stale"
+        assert client.resolve("lbl_steps_main") is not None, "Widgets should be registered again"
+
+        print(f"[PASS] UI reset in {result['reset_us']} us")
+
+    def test_26_checkpoints(self, client):
+        """Test a checkpoint restores screen and widget contents onto the same objects."""
+        print("Testing UI checkpoints...")
+        self.reset_to_main_screen(client)
+
+        assert client.click("btn_heart"), "Click heart button failed"
+        assert client.longpress("hr_measure_area"), "Start measurement failed"
+        measuring = client.get_state("lbl_hr_value")
+        instruction = client.get_state("lbl_hr_instruction")
+
+        saved = client.checkpoint_save("test_hr_measuring")
+        assert saved is not None and saved["widgets"] > 0, "Checkpoint save failed"
+
+        client.reset()
+        assert client.get_state("lbl_hr_value") != measuring, "Reset should clear the measurement"
+        handle = client.resolve("lbl_hr_value")
+
+        loaded = client.checkpoint_load("test_hr_measuring")
+        assert loaded is not None and loaded["widgets"] == saved["widgets"], "Checkpoint load failed"
+        assert client.get_state("lbl_hr_value") == measuring, "Label text should be restored"
+        assert client.get_state(handle) == measuring, "Loading should keep the existing objects"
+        assert client.get_state("lbl_hr_instruction") == instruction, "All labels should be restored"
+
+        response = client._send_command({"cmd": "checkpoint_load", "name": "no_such_checkpoint"})
+        assert response.get("error") == "checkpoint_not_found", "Unknown checkpoints should be reported"
 
+        print(f"[PASS] Checkpoint of {saved['widgets']} widgets ({saved['bytes']} bytes) "
+              f"loaded in {loaded['elapsed_us']} us")
+        client.reset()
 
 if __name__ == "__main__":
     pytest.main([__file__, "-v", "-s"])  # Added -s for real-time output
\ No newline at end of file
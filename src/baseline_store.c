@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+    #include <direct.h>
+    #include <io.h>
+    typedef CRITICAL_SECTION store_mutex_t;
+    typedef CONDITION_VARIABLE store_cond_t;
+    typedef HANDLE store_thread_t;
+    #define STORE_MUTEX_INIT(m) InitializeCriticalSection(m)
+    #define STORE_MUTEX_DESTROY(m) DeleteCriticalSection(m)
+    #define STORE_LOCK(m) EnterCriticalSection(m)
+    #define STORE_UNLOCK(m) LeaveCriticalSection(m)
+    #define STORE_COND_INIT(c) InitializeConditionVariable(c)
+    #define STORE_COND_DESTROY(c) ((void)0)
+    #define STORE_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+    #define STORE_SIGNAL(c) WakeConditionVariable(c)
+    #define store_mkdir(dir) _mkdir(dir)
+    #define store_file_exists(path) (_access(path, 0) == 0)
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    typedef pthread_mutex_t store_mutex_t;
+    typedef pthread_cond_t store_cond_t;
+    typedef pthread_t store_thread_t;
+    #define STORE_MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+    #define STORE_MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+    #define STORE_LOCK(m) pthread_mutex_lock(m)
+    #define STORE_UNLOCK(m) pthread_mutex_unlock(m)
+    #define STORE_COND_INIT(c) pthread_cond_init(c, NULL)
+    #define STORE_COND_DESTROY(c) pthread_cond_destroy(c)
+    #define STORE_WAIT(c, m) pthread_cond_wait(c, m)
+    #define STORE_SIGNAL(c) pthread_cond_signal(c)
+    #define store_mkdir(dir) mkdir(dir, 0755)
+    #define store_file_exists(path) (access(path, F_OK) == 0)
+#endif
+
+#include "test_harness.h"
+
+// Content-addressed baseline store.
+//
+//   <dir>/objects/<hash>.frame   16-byte header + raw ARGB8888 pixels, named by XXH64 of the content
+//   <dir>/index                  "name hash width height" lines, appended; the last line for a name wins
+//
+// Opening the store only parses the index. Frames are memory-mapped the first time a compare
+// needs them and stay mapped, so thousands of baselines cost page faults rather than decoding.
+// Identical frames recorded under different names share one object file and one mapping.
+// Recording copies the pixels and returns; a writer thread puts them on disk.
+#define STORE_DIR_DEFAULT "baselines"
+#define STORE_PATH_MAX 512
+#define STORE_FRAME_MAGIC 0x4642564Cu   // "LVBF" little-endian
+#define STORE_HEADER_SIZE 16
+#define STORE_MAX_PENDING 64
+
+// On-disk object header; pixels follow at STORE_HEADER_SIZE
+typedef struct {
+    uint32_t magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;          // SCREENSHOT_FORMAT_ARGB8888
+} store_frame_header_t;
+
+typedef struct {
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+    const uint8_t *pixels;
+    void *map_base;           // mapping to release, or NULL
+    size_t map_len;
+    uint8_t *owned;           // heap copy for frames recorded in this run
+} store_object_t;
+
+typedef struct {
+    char name[MAX_ID_LEN];
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+    int object;               // index into objects once loaded, -1 before
+} store_entry_t;
+
+// Queued disk write; the object's pixels are immutable once recorded, so the writer reads them unlocked
+typedef struct {
+    char name[MAX_ID_LEN];
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+    const uint8_t *pixels;
+} store_job_t;
+
+static struct {
+    int initialized;
+    char dir[STORE_PATH_MAX];
+
+    store_entry_t *entries;
+    int entry_count;
+    int entry_cap;
+    int *slots;               // open-addressed name lookup into entries, -1 = empty
+    int slot_cap;             // power of two, at least twice entry_cap
+
+    store_object_t *objects;
+    int object_count;
+    int object_cap;
+    store_mutex_t index_lock;   // guards the lookup tables above; each client's thread reads and records
+
+    // Writer thread
+    store_thread_t writer;
+    int writer_running;
+    int shutdown;
+    store_mutex_t lock;
+    store_cond_t job_ready;
+    store_cond_t job_taken;
+    store_job_t jobs[STORE_MAX_PENDING];
+    int job_head;
+    int job_count;
+} store = {0};
+
+#define STORE_OBJECT_PATH_MAX (STORE_PATH_MAX + 32)
+
+static void store_object_path(uint64_t hash, char *path, size_t path_len) {
+    snprintf(path, path_len, "%s/objects/%016llx.frame", store.dir, (unsigned long long)hash);
+}
+
+static int *store_find_slot(const char *name) {
+    size_t mask = (size_t)store.slot_cap - 1;
+    size_t i = (size_t)hash_xxh64(name, strlen(name), 0) & mask;
+    while (store.slots[i] >= 0 && strcmp(store.entries[store.slots[i]].name, name) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &store.slots[i];
+}
+
+static store_entry_t *store_find_entry(const char *name) {
+    if (store.slot_cap == 0) {
+        return NULL;
+    }
+    int index = *store_find_slot(name);
+    return index >= 0 ? &store.entries[index] : NULL;
+}
+
+static int store_grow_entries(void) {
+    int new_cap = store.entry_cap ? store.entry_cap * 2 : 64;
+    store_entry_t *grown = realloc(store.entries, (size_t)new_cap * sizeof(*grown));
+    if (!grown) {
+        return TEST_ERROR_MEMORY;
+    }
+    store.entries = grown;
+    store.entry_cap = new_cap;
+
+    int *slots = malloc((size_t)new_cap * 2 * sizeof(*slots));
+    if (!slots) {
+        return TEST_ERROR_MEMORY;
+    }
+    free(store.slots);
+    store.slots = slots;
+    store.slot_cap = new_cap * 2;
+    memset(store.slots, 0xFF, (size_t)store.slot_cap * sizeof(*store.slots));
+    for (int i = 0; i < store.entry_count; i++) {
+        *store_find_slot(store.entries[i].name) = i;
+    }
+    return TEST_OK;
+}
+
+static int store_find_object(uint64_t hash, uint32_t width, uint32_t height) {
+    for (int i = 0; i < store.object_count; i++) {
+        const store_object_t *object = &store.objects[i];
+        if (object->hash == hash && object->width == width && object->height == height) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static store_entry_t *store_set_entry(const char *name, uint64_t hash, uint32_t width, uint32_t height) {
+    store_entry_t *entry = store_find_entry(name);
+    if (!entry) {
+        if (store.entry_count == store.entry_cap && store_grow_entries() != TEST_OK) {
+            return NULL;
+        }
+        entry = &store.entries[store.entry_count];
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->name, name, sizeof(entry->name) - 1);
+        *store_find_slot(entry->name) = store.entry_count++;
+    }
+
+    entry->hash = hash;
+    entry->width = width;
+    entry->height = height;
+    entry->object = store_find_object(hash, width, height);
+    return entry;
+}
+
+static store_object_t *store_add_object(void) {
+    if (store.object_count == store.object_cap) {
+        int new_cap = store.object_cap ? store.object_cap * 2 : 64;
+        store_object_t *grown = realloc(store.objects, (size_t)new_cap * sizeof(*grown));
+        if (!grown) {
+            return NULL;
+        }
+        store.objects = grown;
+        store.object_cap = new_cap;
+    }
+    store_object_t *object = &store.objects[store.object_count++];
+    memset(object, 0, sizeof(*object));
+    return object;
+}
+
+static void store_load_index(void) {
+    char path[STORE_PATH_MAX + 8];
+    snprintf(path, sizeof(path), "%s/index", store.dir);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return;
+    }
+
+    char line[160];
+    int loaded = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char name[MAX_ID_LEN];
+        unsigned long long hash;
+        unsigned width, height;
+        if (sscanf(line, "%31s %16llx %u %u", name, &hash, &width, &height) == 4 &&
+            baseline_name_valid(name) && width > 0 && height > 0) {
+            if (store_set_entry(name, hash, width, height)) {
+                loaded++;
+            }
+        }
+    }
+    fclose(file);
+    printf("Baseline store %s: %d index lines, %d baselines\n", store.dir, loaded, store.entry_count);
+}
+
+// Map an object file read-only; the header must agree with the index entry
+static int store_map_object(store_entry_t *entry) {
+    char path[STORE_OBJECT_PATH_MAX];
+    store_object_path(entry->hash, path, sizeof(path));
+    size_t expected = STORE_HEADER_SIZE + (size_t)entry->width * entry->height * 4;
+    void *base = NULL;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && (size_t)size.QuadPart == expected) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps the mapping alive
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == expected) {
+        base = mmap(NULL, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+        }
+    }
+    close(fd); // the mapping stays valid
+#endif
+
+    if (!base) {
+        printf("Baseline object %s has the wrong size or could not be mapped\n", path);
+        return TEST_ERROR_SCREENSHOT;
+    }
+
+    store_frame_header_t header;
+    memcpy(&header, base, sizeof(header));
+    store_object_t *object = NULL;
+    if (header.magic == STORE_FRAME_MAGIC && header.width == entry->width && header.height == entry->height &&
+        header.format == SCREENSHOT_FORMAT_ARGB8888) {
+        object = store_add_object();
+    }
+
+    if (!object) {
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(base, expected);
+#endif
+        printf("Baseline object %s is not a valid frame\n", path);
+        return TEST_ERROR_SCREENSHOT;
+    }
+
+    object->hash = entry->hash;
+    object->width = entry->width;
+    object->height = entry->height;
+    object->pixels = (const uint8_t*)base + STORE_HEADER_SIZE;
+    object->map_base = base;
+    object->map_len = expected;
+    entry->object = store.object_count - 1;
+
+    // Other names pointing at the same content reuse this mapping
+    for (int i = 0; i < store.entry_count; i++) {
+        store_entry_t *other = &store.entries[i];
+        if (other->object < 0 && other->hash == entry->hash &&
+            other->width == entry->width && other->height == entry->height) {
+            other->object = entry->object;
+        }
+    }
+    return TEST_OK;
+}
+
+static void store_write_job(const store_job_t *job) {
+    char path[STORE_OBJECT_PATH_MAX];
+    store_object_path(job->hash, path, sizeof(path));
+
+    // Content addressing: an existing object already holds these exact pixels
+    if (!store_file_exists(path)) {
+        char tmp_path[STORE_OBJECT_PATH_MAX + 8];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+        store_frame_header_t header = { STORE_FRAME_MAGIC, job->width, job->height, SCREENSHOT_FORMAT_ARGB8888 };
+        size_t bytes = (size_t)job->width * job->height * 4;
+
+        FILE *file = fopen(tmp_path, "wb");
+        int ok = file && fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(job->pixels, 1, bytes, file) == bytes;
+        if (file && fclose(file) != 0) {
+            ok = 0;
+        }
+        // Rename last so a crash never leaves a truncated object under its final name
+        if (!ok || rename(tmp_path, path) != 0) {
+            printf("Failed to write baseline object %s\n", path);
+            remove(tmp_path);
+            return;
+        }
+    }
+
+    char index_path[STORE_PATH_MAX + 8];
+    snprintf(index_path, sizeof(index_path), "%s/index", store.dir);
+    FILE *index = fopen(index_path, "a");
+    if (!index) {
+        printf("Failed to update baseline index %s\n", index_path);
+        return;
+    }
+    fprintf(index, "%s %016llx %u %u\n", job->name, (unsigned long long)job->hash, job->width, job->height);
+    fclose(index);
+}
+
+#ifdef _WIN32
+static unsigned __stdcall store_writer_thread(void *unused) {
+#else
+static void *store_writer_thread(void *unused) {
+#endif
+    (void)unused;
+
+    STORE_LOCK(&store.lock);
+    for (;;) {
+        while (store.job_count == 0 && !store.shutdown) {
+            STORE_WAIT(&store.job_ready, &store.lock);
+        }
+        if (store.job_count == 0) {
+            break; // shutdown with the queue drained
+        }
+
+        store_job_t job = store.jobs[store.job_head];
+        store.job_head = (store.job_head + 1) % STORE_MAX_PENDING;
+        store.job_count--;
+        STORE_SIGNAL(&store.job_taken);
+
+        STORE_UNLOCK(&store.lock);
+        store_write_job(&job);
+        STORE_LOCK(&store.lock);
+    }
+    STORE_UNLOCK(&store.lock);
+    return 0;
+}
+
+int baseline_store_init(void) {
+    if (store.initialized) {
+        return TEST_OK;
+    }
+
+    const char *dir = getenv("LVGL_BASELINE_DIR");
+    snprintf(store.dir, sizeof(store.dir), "%s", (dir && *dir) ? dir : STORE_DIR_DEFAULT);
+
+    char objects[STORE_PATH_MAX + 8];
+    snprintf(objects, sizeof(objects), "%s/objects", store.dir);
+    store_mkdir(store.dir);   // both fail harmlessly when they already exist
+    store_mkdir(objects);
+
+    STORE_MUTEX_INIT(&store.lock);
+    STORE_MUTEX_INIT(&store.index_lock);
+    STORE_COND_INIT(&store.job_ready);
+    STORE_COND_INIT(&store.job_taken);
+    store.shutdown = 0;
+
+#ifdef _WIN32
+    store.writer = (HANDLE)_beginthreadex(NULL, 0, store_writer_thread, NULL, 0, NULL);
+    store.writer_running = (store.writer != 0);
+#else
+    store.writer_running = (pthread_create(&store.writer, NULL, store_writer_thread, NULL) == 0);
+#endif
+    if (!store.writer_running) {
+        printf("Baseline writer thread unavailable, recording synchronously\n");
+    }
+
+    store.initialized = 1;
+    store_load_index();
+    return TEST_OK;
+}
+
+// Look up a baseline by name, mapping its frame on first use. pixels stay valid until cleanup.
+int baseline_store_get(const char *name, const uint8_t **pixels, uint32_t *width, uint32_t *height) {
+    if (!name || !pixels) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    baseline_store_init();
+
+    STORE_LOCK(&store.index_lock);
+    store_entry_t *entry = store_find_entry(name);
+    int result = entry ? TEST_OK : TEST_ERROR_NOT_FOUND;
+    if (entry && entry->object < 0) {
+        result = store_map_object(entry);
+    }
+    if (result == TEST_OK) {
+        const store_object_t *object = &store.objects[entry->object];
+        *pixels = object->pixels;
+        if (width) *width = object->width;
+        if (height) *height = object->height;
+    }
+    STORE_UNLOCK(&store.index_lock);
+    return result;
+}
+
+// Record ARGB8888 pixels under name. The frame is hashed and copied (unless identical content
+// is already loaded) and is usable immediately; the disk write happens on the writer thread.
+int baseline_store_put(const char *name, const uint8_t *pixels, uint32_t width, uint32_t height, uint64_t *hash) {
+    if (!baseline_name_valid(name) || !pixels || width == 0 || height == 0) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    baseline_store_init();
+
+    size_t bytes = (size_t)width * height * 4;
+    uint64_t content = hash_xxh64(pixels, bytes, ((uint64_t)width << 32) | height);
+
+    STORE_LOCK(&store.index_lock);
+    int index = store_find_object(content, width, height);
+    if (index < 0) {
+        uint8_t *copy = malloc(bytes);
+        store_object_t *object = copy ? store_add_object() : NULL;
+        if (!object) {
+            STORE_UNLOCK(&store.index_lock);
+            free(copy);
+            return TEST_ERROR_MEMORY;
+        }
+        memcpy(copy, pixels, bytes);
+        object->hash = content;
+        object->width = width;
+        object->height = height;
+        object->pixels = copy;
+        object->owned = copy;
+        index = store.object_count - 1;
+    }
+
+    if (!store_set_entry(name, content, width, height)) {
+        STORE_UNLOCK(&store.index_lock);
+        return TEST_ERROR_MEMORY;
+    }
+
+    store_job_t job;
+    memset(&job, 0, sizeof(job));
+    strncpy(job.name, name, sizeof(job.name) - 1);
+    job.hash = content;
+    job.width = width;
+    job.height = height;
+    job.pixels = store.objects[index].pixels;
+    STORE_UNLOCK(&store.index_lock);
+
+    if (!store.writer_running) {
+        store_write_job(&job);
+    } else {
+        // Only waits when the writer is STORE_MAX_PENDING frames behind
+        STORE_LOCK(&store.lock);
+        while (store.job_count == STORE_MAX_PENDING) {
+            STORE_WAIT(&store.job_taken, &store.lock);
+        }
+        store.jobs[(store.job_head + store.job_count) % STORE_MAX_PENDING] = job;
+        store.job_count++;
+        STORE_SIGNAL(&store.job_ready);
+        STORE_UNLOCK(&store.lock);
+    }
+
+    if (hash) *hash = content;
+    return TEST_OK;
+}
+
+// Flush pending writes, then release mappings and recorded frames
+void baseline_store_cleanup(void) {
+    if (!store.initialized) {
+        return;
+    }
+
+    if (store.writer_running) {
+        STORE_LOCK(&store.lock);
+        store.shutdown = 1;
+        STORE_SIGNAL(&store.job_ready);
+        STORE_UNLOCK(&store.lock);
+#ifdef _WIN32
+        WaitForSingleObject(store.writer, INFINITE);
+        CloseHandle(store.writer);
+#else
+        pthread_join(store.writer, NULL);
+#endif
+    }
+
+    for (int i = 0; i < store.object_count; i++) {
+        store_object_t *object = &store.objects[i];
+        if (object->map_base) {
+#ifdef _WIN32
+            UnmapViewOfFile(object->map_base);
+#else
+            munmap(object->map_base, object->map_len);
+#endif
+        }
+        free(object->owned);
+    }
+    free(store.objects);
+    free(store.entries);
+    free(store.slots);
+
+    STORE_COND_DESTROY(&store.job_ready);
+    STORE_COND_DESTROY(&store.job_taken);
+    STORE_MUTEX_DESTROY(&store.index_lock);
+    STORE_MUTEX_DESTROY(&store.lock);
+    memset(&store, 0, sizeof(store));
+}
@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <direct.h>
+    #define ckpt_mkdir(dir) _mkdir(dir)
+#else
+    #include <sys/stat.h>
+    #define ckpt_mkdir(dir) mkdir(dir, 0755)
+#endif
+
+// Check if we have LVGL available
+#ifdef HAVE_LVGL
+    #include "lvgl/lvgl.h"
+#endif
+
+#include "test_harness.h"
+
+// Checkpoint snapshot layout (native byte order, never leaves the machine):
+//
+//   ckpt_header_t, then per widget:
+//     u8 id length, id bytes, u8 kind, u8 flags, then by kind
+//       CKPT_LABEL: u16 text length, text bytes (at most CKPT_TEXT_MAX)
+//       CKPT_BAR:   i32 value
+//
+// Widgets are keyed by registry id rather than by object, so a snapshot taken in one session
+// restores onto the same UI in any other. With LVGL_CHECKPOINT_DIR set, snapshots are also
+// written to <dir>/<name>.lvck and read back from there when they are not in memory.
+#define CKPT_MAGIC 0x4B43564Cu      // "LVCK" little-endian
+#define CKPT_VERSION 1
+#define CKPT_PATH_MAX 512
+#define CKPT_TEXT_MAX 1024          // longer label texts are cut
+
+enum {
+    CKPT_OBJ = 0,                   // flags only
+    CKPT_LABEL,
+    CKPT_BAR
+};
+
+#define CKPT_FLAG_HIDDEN 0x01
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t widgets;
+    watch_model_t model;
+} ckpt_header_t;
+
+typedef struct {
+    char name[MAX_ID_LEN];
+    uint8_t *data;
+    size_t len;
+} ckpt_entry_t;
+
+// Save or load handed to the LVGL thread; lives on the waiting TCP thread's stack
+struct checkpoint_request {
+    int load;
+    char name[MAX_ID_LEN];
+    int result;
+    checkpoint_stats_t stats;
+};
+
+// Snapshots are only touched on the LVGL thread (and at shutdown, once it has stopped)
+static struct {
+    ckpt_entry_t *entries;
+    int count;
+    int cap;
+} checkpoints = {0};
+
+#ifdef HAVE_LVGL
+static uint64_t checkpoint_now_us(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Growable snapshot buffer
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} ckpt_buf_t;
+
+static void ckpt_put(ckpt_buf_t *buf, const void *bytes, size_t len) {
+    if (buf->failed) return;
+
+    if (buf->len + len > buf->cap) {
+        size_t new_cap = buf->cap ? buf->cap * 2 : 1024;
+        while (new_cap < buf->len + len) new_cap *= 2;
+        uint8_t *grown = realloc(buf->data, new_cap);
+        if (!grown) {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = grown;
+        buf->cap = new_cap;
+    }
+
+    memcpy(buf->data + buf->len, bytes, len);
+    buf->len += len;
+}
+
+// Reader over a snapshot; any read past the end marks it failed
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    int failed;
+} ckpt_reader_t;
+
+static const uint8_t *ckpt_get(ckpt_reader_t *reader, size_t len) {
+    if (reader->failed || len > reader->len - reader->pos) {
+        reader->failed = 1;
+        return NULL;
+    }
+    const uint8_t *bytes = reader->data + reader->pos;
+    reader->pos += len;
+    return bytes;
+}
+
+static int ckpt_kind(const lv_obj_t *obj) {
+    if (lv_obj_check_type(obj, &lv_label_class)) return CKPT_LABEL;
+    if (lv_obj_check_type(obj, &lv_bar_class)) return CKPT_BAR;
+    return CKPT_OBJ;
+}
+
+// Aliases register one object under several ids; it is saved under the first only
+static int ckpt_seen_before(int slot, lv_obj_t *obj) {
+    for (int i = 0; i < slot; i++) {
+        lv_obj_t *earlier = NULL;
+        if (registry_entry(i, NULL, &earlier) == TEST_OK && earlier == obj) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static ckpt_entry_t *checkpoint_find(const char *name) {
+    for (int i = 0; i < checkpoints.count; i++) {
+        if (strcmp(checkpoints.entries[i].name, name) == 0) {
+            return &checkpoints.entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Keep a snapshot under its name, replacing an older one; takes ownership of data
+static ckpt_entry_t *checkpoint_store(const char *name, uint8_t *data, size_t len) {
+    ckpt_entry_t *entry = checkpoint_find(name);
+    if (!entry) {
+        if (checkpoints.count == checkpoints.cap) {
+            int new_cap = checkpoints.cap ? checkpoints.cap * 2 : 16;
+            ckpt_entry_t *grown = realloc(checkpoints.entries, (size_t)new_cap * sizeof(*grown));
+            if (!grown) {
+                free(data);
+                return NULL;
+            }
+            checkpoints.entries = grown;
+            checkpoints.cap = new_cap;
+        }
+        entry = &checkpoints.entries[checkpoints.count++];
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->name, name, MAX_ID_LEN - 1);
+    }
+
+    free(entry->data);
+    entry->data = data;
+    entry->len = len;
+    return entry;
+}
+
+static int checkpoint_path(const char *name, char *path, size_t path_len) {
+    const char *dir = getenv("LVGL_CHECKPOINT_DIR");
+    if (!dir || !*dir) {
+        return 0;
+    }
+    ckpt_mkdir(dir);   // fails harmlessly when it already exists
+    snprintf(path, path_len, "%s/%s.lvck", dir, name);
+    return 1;
+}
+
+static void checkpoint_write_file(const char *name, const uint8_t *data, size_t len) {
+    char path[CKPT_PATH_MAX];
+    if (!checkpoint_path(name, path, sizeof(path))) {
+        return;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(data, 1, len, file) != len) {
+        printf("Failed to write checkpoint %s\n", path);
+    }
+    if (file) {
+        fclose(file);
+    }
+}
+
+// Snapshots saved by an earlier run (or another process) are read on first use
+static ckpt_entry_t *checkpoint_read_file(const char *name) {
+    char path[CKPT_PATH_MAX];
+    if (!checkpoint_path(name, path, sizeof(path))) {
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+    long len = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)len);
+        if (data && fread(data, 1, (size_t)len, file) != (size_t)len) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+
+    if (!data) {
+        printf("Failed to read checkpoint %s\n", path);
+        return NULL;
+    }
+    return checkpoint_store(name, data, (size_t)len);
+}
+
+static int checkpoint_do_save(const char *name, checkpoint_stats_t *stats) {
+    ckpt_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CKPT_MAGIC;
+    header.version = CKPT_VERSION;
+    ui_watch_get_model(&header.model);
+
+    ckpt_buf_t buf = {0};
+    ckpt_put(&buf, &header, sizeof(header));
+
+    uint16_t widgets = 0;
+    const char *id;
+    lv_obj_t *obj;
+    int found;
+    for (int slot = 0; (found = registry_entry(slot, &id, &obj)) != TEST_ERROR_INVALID_PARAM; slot++) {
+        if (found != TEST_OK || ckpt_seen_before(slot, obj)) {
+            continue;
+        }
+
+        uint8_t id_len = (uint8_t)strlen(id);
+        uint8_t kind = (uint8_t)ckpt_kind(obj);
+        uint8_t flags = lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) ? CKPT_FLAG_HIDDEN : 0;
+        ckpt_put(&buf, &id_len, 1);
+        ckpt_put(&buf, id, id_len);
+        ckpt_put(&buf, &kind, 1);
+        ckpt_put(&buf, &flags, 1);
+
+        if (kind == CKPT_LABEL) {
+            const char *text = lv_label_get_text(obj);
+            size_t text_len = text ? strlen(text) : 0;
+            uint16_t len = text_len > CKPT_TEXT_MAX ? CKPT_TEXT_MAX : (uint16_t)text_len;
+            ckpt_put(&buf, &len, sizeof(len));
+            ckpt_put(&buf, text, len);
+        } else if (kind == CKPT_BAR) {
+            int32_t value = lv_bar_get_value(obj);
+            ckpt_put(&buf, &value, sizeof(value));
+        }
+        widgets++;
+    }
+
+    if (buf.failed) {
+        free(buf.data);
+        return TEST_ERROR_MEMORY;
+    }
+    memcpy(buf.data + offsetof(ckpt_header_t, widgets), &widgets, sizeof(widgets));
+
+    if (!checkpoint_store(name, buf.data, buf.len)) {
+        return TEST_ERROR_MEMORY;
+    }
+    checkpoint_write_file(name, buf.data, buf.len);
+
+    stats->bytes = (uint32_t)buf.len;
+    stats->widgets = widgets;
+    return TEST_OK;
+}
+
+// Walk a snapshot's widgets. With apply unset it only checks that every widget still exists
+// with the same kind, so a load either restores everything or changes nothing.
+static int checkpoint_walk(const ckpt_entry_t *entry, int apply) {
+    ckpt_reader_t reader = { entry->data, entry->len, 0, 0 };
+    const ckpt_header_t *header = (const ckpt_header_t *)ckpt_get(&reader, sizeof(ckpt_header_t));
+    if (!header || header->magic != CKPT_MAGIC || header->version != CKPT_VERSION) {
+        return TEST_ERROR_IO;
+    }
+
+    for (int i = 0; i < header->widgets; i++) {
+        const uint8_t *id_len = ckpt_get(&reader, 1);
+        const uint8_t *id_bytes = id_len ? ckpt_get(&reader, *id_len) : NULL;
+        const uint8_t *kind_flags = ckpt_get(&reader, 2);
+        if (reader.failed || *id_len >= MAX_ID_LEN) {
+            return TEST_ERROR_IO;
+        }
+
+        char id[MAX_ID_LEN];
+        memcpy(id, id_bytes, *id_len);
+        id[*id_len] = '\0';
+        uint8_t kind = kind_flags[0];
+        uint8_t flags = kind_flags[1];
+
+        const uint8_t *payload = NULL;
+        uint16_t text_len = 0;
+        if (kind == CKPT_LABEL) {
+            const uint8_t *len_bytes = ckpt_get(&reader, sizeof(uint16_t));
+            if (len_bytes) {
+                memcpy(&text_len, len_bytes, sizeof(text_len));
+                payload = ckpt_get(&reader, text_len);
+            }
+        } else if (kind == CKPT_BAR) {
+            payload = ckpt_get(&reader, sizeof(int32_t));
+        }
+        if (reader.failed || text_len > CKPT_TEXT_MAX) {
+            return TEST_ERROR_IO;
+        }
+
+        lv_obj_t *obj = find_widget(id);
+        if (!obj || ckpt_kind(obj) != kind) {
+            printf("Checkpoint widget '%s' not found in this UI\n", id);
+            return TEST_ERROR_INVALID_WIDGET;
+        }
+        if (!apply) {
+            continue;
+        }
+
+        if (flags & CKPT_FLAG_HIDDEN) {
+            lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        }
+
+        if (kind == CKPT_LABEL) {
+            char text[CKPT_TEXT_MAX + 1];
+            memcpy(text, payload, text_len);
+            text[text_len] = '\0';
+            lv_label_set_text(obj, text);
+        } else if (kind == CKPT_BAR) {
+            int32_t value;
+            memcpy(&value, payload, sizeof(value));
+            lv_bar_set_value(obj, value, LV_ANIM_OFF);
+        }
+    }
+    return TEST_OK;
+}
+
+static int checkpoint_do_load(const char *name, checkpoint_stats_t *stats) {
+    ckpt_entry_t *entry = checkpoint_find(name);
+    if (!entry) {
+        entry = checkpoint_read_file(name);
+    }
+    if (!entry) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+
+    int result = checkpoint_walk(entry, 0);
+    if (result != TEST_OK) {
+        return result;
+    }
+
+    ckpt_header_t header;
+    memcpy(&header, entry->data, sizeof(header));
+    result = ui_watch_set_model(&header.model);
+    if (result != TEST_OK) {
+        return TEST_ERROR_IO;
+    }
+    checkpoint_walk(entry, 1);
+
+    // Show the restored frame before replying, as a command that changed the UI would
+    lv_refr_now(session_get_display(session_current()));
+
+    stats->bytes = (uint32_t)entry->len;
+    stats->widgets = header.widgets;
+    return TEST_OK;
+}
+#endif
+
+// LVGL thread: carry out a queued save or load
+void checkpoint_run(checkpoint_request_t *request) {
+#ifdef HAVE_LVGL
+    uint64_t start = checkpoint_now_us();
+    request->result = request->load ? checkpoint_do_load(request->name, &request->stats)
+                                    : checkpoint_do_save(request->name, &request->stats);
+    request->stats.elapsed_us = (uint32_t)(checkpoint_now_us() - start);
+    printf("Checkpoint '%s' %s in %u us (%u widgets, %u bytes)\n", request->name,
+           request->load ? "loaded" : "saved", (unsigned)request->stats.elapsed_us,
+           (unsigned)request->stats.widgets, (unsigned)request->stats.bytes);
+#else
+    request->result = TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// TCP thread: queue the request for the LVGL thread and wait for it
+static int checkpoint_submit(int load, const char *name, checkpoint_stats_t *stats) {
+#ifdef HAVE_LVGL
+    if (!baseline_name_valid(name)) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    checkpoint_request_t request;
+    memset(&request, 0, sizeof(request));
+    request.load = load;
+    strncpy(request.name, name, MAX_ID_LEN - 1);
+
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_CHECKPOINT;
+    cmd.session = session_current();
+    cmd.params.checkpoint.request = &request;
+    command_queue_run(&cmd);
+
+    if (stats) {
+        *stats = request.stats;
+    }
+    return request.result;
+#else
+    (void)load;
+    (void)name;
+    (void)stats;
+    printf("Checkpoints not available (no LVGL)\n");
+    return TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// Snapshot the current session's data model and registered widgets under name
+int checkpoint_save(const char *name, checkpoint_stats_t *stats) {
+    return checkpoint_submit(0, name, stats);
+}
+
+// Restore a snapshot onto the current session's existing objects. Returns TEST_ERROR_NOT_FOUND
+// for an unknown name, TEST_ERROR_INVALID_WIDGET when the UI no longer has one of its widgets
+// and TEST_ERROR_IO for a damaged snapshot file.
+int checkpoint_load(const char *name, checkpoint_stats_t *stats) {
+    return checkpoint_submit(1, name, stats);
+}
+
+void checkpoint_cleanup(void) {
+    for (int i = 0; i < checkpoints.count; i++) {
+        free(checkpoints.entries[i].data);
+    }
+    free(checkpoints.entries);
+    memset(&checkpoints, 0, sizeof(checkpoints));
+}
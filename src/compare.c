@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Check if we have LVGL available
+#ifdef HAVE_LVGL
+    #include "lvgl/lvgl.h"
+#endif
+
+#include "test_harness.h"
+
+// Golden image comparison against named baselines from the baseline store, so a capture is
+// checked on the server and only the verdict (plus an optional 1-bit mask) crosses the socket.
+// One mask per session, as sessions compare at the same time
+static struct {
+    uint8_t *mask;          // reused between the session's compares, valid until its next one
+    size_t mask_cap;
+} compare_state[MAX_SESSIONS] = {{0}};
+
+// Names become file names, so keep them to a safe character set
+int baseline_name_valid(const char *name) {
+    size_t len = name ? strlen(name) : 0;
+    if (len == 0 || len >= MAX_ID_LEN || name[0] == '.') {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '_' || c == '-' || c == '.')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Capture through the job pipeline (grabbed on the LVGL thread, converted on the worker pool).
+// image points into the job, which the caller releases once done with the pixels.
+static int capture_argb8888(const screenshot_region_t *region, screenshot_job_t **job, screenshot_image_t *image) {
+    screenshot_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.format = SCREENSHOT_FORMAT_ARGB8888;
+    int result = screenshot_submit(region, &options, job);
+    if (result != TEST_OK) {
+        return result;
+    }
+    result = screenshot_job_wait(*job, image, NULL);
+    if (result != TEST_OK) {
+        screenshot_job_release(*job);
+        *job = NULL;
+    }
+    return result;
+}
+
+// Record runs (LVGL_BASELINE_RECORD=1) store missing baselines instead of failing the compare
+static int compare_record_mode(void) {
+    const char *record = getenv("LVGL_BASELINE_RECORD");
+    return record && *record && strcmp(record, "0") != 0;
+}
+
+// Capture the region (NULL = whole screen) and record it as the named baseline
+int baseline_save(const char *name, const screenshot_region_t *region, uint32_t *width, uint32_t *height,
+                  uint64_t *hash) {
+    if (!baseline_name_valid(name)) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    screenshot_job_t *job;
+    screenshot_image_t image;
+    int result = capture_argb8888(region, &job, &image);
+    if (result != TEST_OK) {
+        return result;
+    }
+
+    result = baseline_store_put(name, image.data, image.width, image.height, hash);
+    screenshot_job_release(job);
+    if (result != TEST_OK) {
+        return result;
+    }
+
+    if (width) *width = image.width;
+    if (height) *height = image.height;
+    printf("Baseline %s recorded (%ux%u)\n", name, image.width, image.height);
+    return TEST_OK;
+}
+
+// Diff a captured ARGB8888 image against baseline pixels of the same size
+static void compare_pixels(const screenshot_image_t *image, const uint8_t *baseline, const uint8_t tolerance[3],
+                           int want_mask, compare_result_t *result) {
+    size_t row_bytes = (image->width + 7) / 8;
+
+    // Tolerance bytes line up with the B,G,R,A pixel bytes; alpha always passes
+    uint32_t tol = 0xFF000000u | ((uint32_t)tolerance[0] << 16) | ((uint32_t)tolerance[1] << 8) | tolerance[2];
+    int min_x = (int)image->width, max_x = -1, min_y = -1, max_y = -1;
+
+    // The vector kernel rejects clean rows; only rows with differences get a per-pixel pass
+    for (uint32_t y = 0; y < image->height; y++) {
+        const uint8_t *a = image->data + (size_t)y * image->width * 4;
+        const uint8_t *b = baseline + (size_t)y * image->width * 4;
+        uint32_t row_mismatches = pixel_diff_argb8888(a, b, image->width, tol, &result->max_delta);
+        if (row_mismatches == 0) {
+            continue;
+        }
+
+        result->mismatches += row_mismatches;
+        if (min_y < 0) min_y = (int)y;
+        max_y = (int)y;
+
+        uint8_t *mask_row = want_mask ? result->mask + y * row_bytes : NULL;
+        for (uint32_t x = 0; x < image->width; x++) {
+            const uint8_t *pa = a + x * 4;
+            const uint8_t *pb = b + x * 4;
+            int over = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = pa[c] > pb[c] ? pa[c] - pb[c] : pb[c] - pa[c];
+                if (d > (int)((tol >> (c * 8)) & 0xFF)) over = 1;
+            }
+            if (!over) {
+                continue;
+            }
+            if ((int)x < min_x) min_x = (int)x;
+            if ((int)x > max_x) max_x = (int)x;
+            if (mask_row) {
+                mask_row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+            }
+        }
+    }
+
+    if (result->mismatches > 0) {
+        result->bbox_x = min_x;
+        result->bbox_y = min_y;
+        result->bbox_w = max_x - min_x + 1;
+        result->bbox_h = max_y - min_y + 1;
+    }
+}
+
+// Compare the current region against a baseline. tolerance is the largest accepted per-channel
+// difference in R,G,B order; alpha is ignored. With want_mask, result->mask has one bit per
+// pixel (MSB first, rows padded to whole bytes) and stays valid until the session's next compare.
+int compare_baseline(const char *name, const screenshot_region_t *region, const uint8_t tolerance[3],
+                     int want_mask, compare_result_t *result) {
+    if (!result || !baseline_name_valid(name)) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    memset(result, 0, sizeof(*result));
+
+    const uint8_t *baseline = NULL;
+    uint32_t baseline_width = 0, baseline_height = 0;
+    int status = baseline_store_get(name, &baseline, &baseline_width, &baseline_height);
+    if (status == TEST_ERROR_NOT_FOUND && compare_record_mode()) {
+        status = baseline_save(name, region, &result->width, &result->height, NULL);
+        result->recorded = (status == TEST_OK);
+        return status;
+    }
+    if (status != TEST_OK) {
+        return status;
+    }
+
+    screenshot_job_t *job;
+    screenshot_image_t image;
+    status = capture_argb8888(region, &job, &image);
+    if (status != TEST_OK) {
+        return status;
+    }
+
+    result->width = image.width;
+    result->height = image.height;
+    if (image.width != baseline_width || image.height != baseline_height) {
+        status = TEST_ERROR_SIZE_MISMATCH;
+    } else if (want_mask) {
+        size_t mask_len = (size_t)(image.width + 7) / 8 * image.height;
+        int session = session_current();
+        if (mask_len > compare_state[session].mask_cap) {
+            uint8_t *grown = realloc(compare_state[session].mask, mask_len);
+            if (grown) {
+                compare_state[session].mask = grown;
+                compare_state[session].mask_cap = mask_len;
+            } else {
+                status = TEST_ERROR_MEMORY;
+            }
+        }
+        if (status == TEST_OK) {
+            memset(compare_state[session].mask, 0, mask_len);
+            result->mask = compare_state[session].mask;
+            result->mask_len = mask_len;
+        }
+    }
+
+    if (status == TEST_OK) {
+        compare_pixels(&image, baseline, tolerance, want_mask, result);
+        printf("Compare %s: %u mismatched pixels, max delta %u\n", name, result->mismatches, result->max_delta);
+    }
+    screenshot_job_release(job);
+    return status;
+}
+
+void compare_cleanup(void) {
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        free(compare_state[i].mask);
+    }
+    memset(compare_state, 0, sizeof(compare_state));
+}
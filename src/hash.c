@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "test_harness.h"
+
+// XXH64, https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+// Four independent lanes keep the multiplier pipeline full, so hashing a frame runs at
+// several bytes per cycle without any SIMD-specific code.
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t xxh_rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Unaligned little-endian loads; memcpy compiles to a single mov
+static inline uint64_t xxh_read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t xxh_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = xxh_rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t hash_xxh64(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t*)data;
+    const uint8_t *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        const uint8_t *limit = end - 32;
+
+        do {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = xxh_rotl64(v1, 1) + xxh_rotl64(v2, 7) + xxh_rotl64(v3, 12) + xxh_rotl64(v4, 18);
+        h = xxh_merge_round(h, v1);
+        h = xxh_merge_round(h, v2);
+        h = xxh_merge_round(h, v3);
+        h = xxh_merge_round(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h = xxh_rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)xxh_read32(p) * XXH_PRIME64_1;
+        h = xxh_rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p++) * XXH_PRIME64_5;
+        h = xxh_rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// dHash: average luma over a 9x8 grid, then one bit per horizontally adjacent cell pair
+// (set when brightness increases to the right). Small, scattered changes barely move the cell
+// averages, so near-identical frames land within a few bits of each other.
+void dhash_init(dhash_state_t *state, uint32_t width, uint32_t height) {
+    memset(state, 0, sizeof(*state));
+    state->width = width;
+    state->height = height;
+}
+
+// Add one row of tightly packed RGB24 pixels; y is the row's index within the region
+void dhash_add_row(dhash_state_t *state, const uint8_t *rgb, uint32_t y) {
+    if (state->height == 0 || y >= state->height) {
+        return;
+    }
+
+    uint32_t cell_row = (uint32_t)((uint64_t)y * DHASH_ROWS / state->height);
+    uint64_t *sums = &state->sums[cell_row * DHASH_COLS];
+    uint32_t *counts = &state->counts[cell_row * DHASH_COLS];
+
+    for (uint32_t col = 0; col < DHASH_COLS; col++) {
+        uint32_t x0 = (uint32_t)((uint64_t)col * state->width / DHASH_COLS);
+        uint32_t x1 = (uint32_t)((uint64_t)(col + 1) * state->width / DHASH_COLS);
+        uint32_t sum = 0;
+        for (uint32_t x = x0; x < x1; x++) {
+            const uint8_t *p = rgb + (size_t)x * 3;
+            sum += (77u * p[0] + 150u * p[1] + 29u * p[2]) >> 8; // BT.601 luma
+        }
+        sums[col] += sum;
+        counts[col] += x1 - x0;
+    }
+}
+
+uint64_t dhash_finish(const dhash_state_t *state) {
+    uint64_t bits = 0;
+    for (int row = 0; row < DHASH_ROWS; row++) {
+        for (int col = 0; col < DHASH_COLS - 1; col++) {
+            int a = row * DHASH_COLS + col;
+            int b = a + 1;
+            // Compare averages without dividing: sum_a / n_a < sum_b / n_b
+            bits <<= 1;
+            if (state->sums[a] * state->counts[b] < state->sums[b] * state->counts[a]) {
+                bits |= 1;
+            }
+        }
+    }
+    return bits;
+}
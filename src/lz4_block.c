@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "test_harness.h"
+
+// LZ4 block format encoder (no frame header) - greedy single-probe matcher.
+// Output is decodable by any LZ4 block decoder, e.g. Python's lz4.block.decompress().
+#define LZ4_MIN_MATCH 4
+#define LZ4_HASH_LOG 12
+#define LZ4_LAST_LITERALS 5     // the last 5 bytes are always literals
+#define LZ4_MF_LIMIT 12         // no match may start within the last 12 bytes
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_SKIP_TRIGGER 6      // probe step grows every 2^6 misses on incompressible data
+
+static uint32_t lz4_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+static uint8_t *lz4_write_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t *lz4_write_sequence(uint8_t *op, const uint8_t *literals, size_t literal_len,
+                                   size_t offset, size_t match_len) {
+    uint8_t *token = op++;
+    *token = (uint8_t)((literal_len < 15 ? literal_len : 15) << 4);
+    if (literal_len >= 15) {
+        op = lz4_write_length(op, literal_len - 15);
+    }
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    if (match_len == 0) {
+        return op; // final literal-only sequence
+    }
+
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    size_t ml = match_len - LZ4_MIN_MATCH;
+    *token |= (uint8_t)(ml < 15 ? ml : 15);
+    if (ml >= 15) {
+        op = lz4_write_length(op, ml - 15);
+    }
+    return op;
+}
+
+size_t lz4_compress_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+// Compress len bytes into dst; returns the compressed size, or 0 if dst is smaller than the bound
+size_t lz4_compress_block(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    if (!src || !dst || dst_cap < lz4_compress_bound(len)) {
+        return 0;
+    }
+
+    uint32_t table[1 << LZ4_HASH_LOG];
+    memset(table, 0, sizeof(table));
+
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *end = src + len;
+    uint8_t *op = dst;
+
+    if (len > LZ4_MF_LIMIT) {
+        const uint8_t *match_limit = end - LZ4_MF_LIMIT;
+        const uint8_t *extend_limit = end - LZ4_LAST_LITERALS;
+        uint32_t misses = 0;
+
+        while (ip < match_limit) {
+            uint32_t sequence = lz4_read32(ip);
+            uint32_t h = lz4_hash(sequence);
+            const uint8_t *ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || (size_t)(ip - ref) > LZ4_MAX_OFFSET || lz4_read32(ref) != sequence) {
+                ip += 1 + (misses++ >> LZ4_SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards over literals, then forwards up to the last-literals boundary
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            size_t match_len = LZ4_MIN_MATCH;
+            while (ip + match_len < extend_limit && ip[match_len] == ref[match_len]) {
+                match_len++;
+            }
+
+            op = lz4_write_sequence(op, anchor, (size_t)(ip - anchor), (size_t)(ip - ref), match_len);
+            ip += match_len;
+            anchor = ip;
+
+            // Seed the table just behind the match so runs chain into the next one
+            if (ip < match_limit) {
+                table[lz4_hash(lz4_read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    op = lz4_write_sequence(op, anchor, (size_t)(end - anchor), 0, 0);
+    return (size_t)(op - dst);
+}
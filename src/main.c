@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #ifdef _WIN32
     #include <windows.h>
     #include <process.h>
@@ -13,9 +15,11 @@
 
 #ifdef HAVE_LVGL
     #include "lvgl/lvgl.h"
-    #include "lvgl/src/drivers/sdl/lv_sdl_window.h"
-    #include "lvgl/src/drivers/sdl/lv_sdl_mouse.h"
-    #include "lvgl/src/drivers/sdl/lv_sdl_keyboard.h"
+    #if LV_USE_SDL
+        #include "lvgl/src/drivers/sdl/lv_sdl_window.h"
+        #include "lvgl/src/drivers/sdl/lv_sdl_mouse.h"
+        #include "lvgl/src/drivers/sdl/lv_sdl_keyboard.h"
+    #endif
 #else
     // Fallback stubs for initial build without LVGL
     typedef void* lv_disp_t;
@@ -34,6 +38,11 @@
 
 #include "test_harness.h"
 
+// Display resolution: 480x480 unless --resolution / LVGL_RESOLUTION says otherwise
+#define DISPLAY_DEFAULT_SIZE 480
+#define DISPLAY_MIN_SIZE 64
+#define DISPLAY_MAX_SIZE 4096
+
 // Global variables
 static volatile int running = 1;
 static pthread_t tcp_server_thread;
@@ -55,22 +64,115 @@ void* tcp_server_thread_func(void* arg) {
         running = 0;
         return NULL;
     }
+    running = 0;  // a spawned child stops once its client is gone
     return NULL;
 }
 
+// Headless mode: --headless on the command line or LVGL_HEADLESS=1 in the environment
+static int headless_requested(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            return 1;
+        }
+    }
+    const char *env = getenv("LVGL_HEADLESS");
+    return env != NULL && env[0] != '\0' && strcmp(env, "0") != 0;
+}
+
+// Zygote mode: --zygote on the command line or LVGL_ZYGOTE=1 in the environment
+static int zygote_requested(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--zygote") == 0) {
+            return 1;
+        }
+    }
+    const char *env = getenv("LVGL_ZYGOTE");
+    return env != NULL && env[0] != '\0' && strcmp(env, "0") != 0;
+}
+
+// Parse "WxH", or "N" for a square display
+static int parse_resolution(const char *text, int32_t *width, int32_t *height) {
+    char *end;
+    long w = strtol(text, &end, 10);
+    long h = w;
+    if (*end == 'x' || *end == 'X') {
+        h = strtol(end + 1, &end, 10);
+    }
+    if (end == text || *end != '\0' ||
+        w < DISPLAY_MIN_SIZE || w > DISPLAY_MAX_SIZE || h < DISPLAY_MIN_SIZE || h > DISPLAY_MAX_SIZE) {
+        return -1;
+    }
+    *width = (int32_t)w;
+    *height = (int32_t)h;
+    return 0;
+}
+
+// Resolution: --resolution WxH (or --resolution=WxH) on the command line, else LVGL_RESOLUTION
+static int resolution_requested(int argc, char **argv, int32_t *width, int32_t *height) {
+    const char *text = getenv("LVGL_RESOLUTION");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            text = argv[++i];
+        } else if (strncmp(argv[i], "--resolution=", 13) == 0) {
+            text = argv[i] + 13;
+        }
+    }
+    
+    *width = DISPLAY_DEFAULT_SIZE;
+    *height = DISPLAY_DEFAULT_SIZE;
+    if (text == NULL || text[0] == '\0') {
+        return 0;
+    }
+    if (parse_resolution(text, width, height) != 0) {
+        printf("Invalid resolution '%s' (expected WxH or N, %d..%d)\n", text, DISPLAY_MIN_SIZE, DISPLAY_MAX_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
 #ifdef HAVE_LVGL
 // Use official LVGL SDL driver instead of our broken implementation
 static lv_display_t *display;
+#if LV_USE_SDL
 static lv_indev_t *mouse_indev;
+#endif
 // Removed keyboard - only mouse needed for click/longpress/swipe
 
-// Initialize LVGL with official SDL driver
-int lvgl_init(void) {
+// Headless display: LVGL renders straight into this buffer (DIRECT mode), no window, no SDL
+static uint8_t *headless_framebuffer;
+
+// Monotonic millisecond tick; the SDL driver installs SDL_GetTicks, headless needs its own
+static uint32_t headless_tick(void) {
+#ifdef _WIN32
+    return (uint32_t)GetTickCount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+#endif
+}
+
+// Initialize the in-memory display (shared with the extra sessions, see session.c). Input
+// comes only from the test input devices that init_test_system() attaches.
+static int lvgl_init_headless(int32_t width, int32_t height) {
+    lv_tick_set_cb(headless_tick);
+    
+    display = headless_display_create(width, height, &headless_framebuffer);
+    return display != NULL ? 0 : -1;
+}
+
+// Initialize LVGL with the official SDL driver, or the in-memory display when headless
+int lvgl_init(int headless, int32_t width, int32_t height) {
     // Initialize LVGL
     lv_init();
     
+#if LV_USE_SDL
+    if (headless) {
+        return lvgl_init_headless(width, height);
+    }
+    
     // Create SDL window using official LVGL driver
-    display = lv_sdl_window_create(480, 480);
+    display = lv_sdl_window_create(width, height);
     if (display == NULL) {
         printf("Failed to create SDL window with LVGL driver\n");
         return -1;
@@ -101,20 +203,36 @@ int lvgl_init(void) {
     printf("LVGL SDL mouse input device created\n");
     
     return 0;
+#else
+    (void)headless;  // built without SDL: the in-memory display is the only option
+    return lvgl_init_headless(width, height);
+#endif
 }
 
 // Official LVGL SDL driver handles all callbacks automatically
 
 #endif
 
-int main(void) {
+int main(int argc, char **argv) {
     printf("LVGL UI Automation Framework Starting...\n");
     printf("=========================================\n");
     
+    int headless = headless_requested(argc, argv);
+    int zygote = zygote_requested(argc, argv);
+    int32_t width, height;
+    if (resolution_requested(argc, argv, &width, &height) != 0) {
+        return 1;
+    }
+    
     // Set up signal handlers for clean shutdown (Unix only)
 #ifndef _WIN32
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+#else
+    if (zygote) {
+        printf("Zygote mode needs fork(), which Windows does not have - ignoring --zygote\n");
+        zygote = 0;
+    }
 #endif
     
     // Initialize test harness
@@ -124,8 +242,8 @@ int main(void) {
     }
     
 #if HAVE_LVGL
-    // Initialize LVGL
-    if (lvgl_init() != 0) {
+    // Initialize LVGL (a zygote is always headless: an SDL window cannot be forked)
+    if (lvgl_init(headless || zygote, width, height) != 0) {
         printf("Failed to initialize LVGL\n");
         test_harness_cleanup();
         return 1;
@@ -145,7 +263,28 @@ int main(void) {
     // Force initial screen refresh
     lv_obj_invalidate(lv_screen_active());
     lv_refr_now(NULL);
+    
+    // Zygote: keep this initialized state and fork a fresh copy per test. Everything below,
+    // threads included, only runs in the children.
+    if (zygote) {
+        if (tcp_server_init(DEFAULT_PORT) != TEST_OK) {
+            printf("Failed to initialize TCP server on port %d\n", DEFAULT_PORT);
+            return 1;
+        }
+        int forked = tcp_server_zygote(&running);
+        if (forked != 1) {
+            tcp_server_cleanup();
+            test_harness_cleanup();
+            lv_deinit();
+            free(headless_framebuffer);
+            return forked == 0 ? 0 : 1;
+        }
+    }
 #else
+    (void)headless;
+    (void)zygote;
+    (void)width;
+    (void)height;
     printf("Warning: LVGL not available, running in stub mode\n");
     printf("To enable LVGL:\n");
     printf("1. Clone LVGL: git submodule add https://github.com/lvgl/lvgl.git third_party/lvgl\n");
@@ -157,8 +296,12 @@ int main(void) {
         printf("Failed to initialize screenshot system\n");
     }
     
-    // Initialize and start TCP server
-    if (tcp_server_init(DEFAULT_PORT) != TEST_OK) {
+    // Open the baseline store (reads only its index; frames are mapped on demand)
+    baseline_store_init();
+    history_init();
+    
+    // Initialize and start TCP server (a spawned child already has its socket)
+    if (!zygote && tcp_server_init(DEFAULT_PORT) != TEST_OK) {
         printf("Failed to initialize TCP server on port %d\n", DEFAULT_PORT);
         return 1;
     }
@@ -177,7 +320,9 @@ int main(void) {
         return 1;
     }
     
-    printf("TCP server listening on port %d\n", DEFAULT_PORT);
+    if (!zygote) {
+        printf("TCP server listening on port %d\n", DEFAULT_PORT);
+    }
     printf("Ready for automation commands\n");
     printf("Press Ctrl+C to quit\n");
     
@@ -206,12 +351,19 @@ int main(void) {
 #endif
     
     tcp_server_cleanup();
+    session_cleanup();      // before LVGL and the registries go away
+    checkpoint_cleanup();
+    recorder_cleanup();
+    compare_cleanup();
+    baseline_store_cleanup();
     screenshot_cleanup();
+    history_cleanup();      // after the worker pool has stopped
     test_harness_cleanup();
     
 #ifdef HAVE_LVGL
     // LVGL cleanup (official driver handles SDL cleanup automatically)
     lv_deinit();
+    free(headless_framebuffer);  // NULL unless headless
 #endif
     
     printf("Cleanup complete. Goodbye!\n");
@@ -0,0 +1,715 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "test_harness.h"
+
+// Pick the SIMD flavours this compiler/target can build
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define PIXEL_CONVERT_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define TARGET_SSSE3
+        #define TARGET_AVX2
+        #define TARGET_SSE42
+    #else
+        #define TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+        #define TARGET_SSE42 __attribute__((target("sse4.2")))
+    #endif
+    // The 64-bit crc32 instruction needs x86-64
+    #if defined(__x86_64__) || defined(_M_X64)
+        #define PIXEL_CRC32C_X86 1
+    #endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define PIXEL_CONVERT_NEON 1
+    #include <arm_neon.h>
+    // The CRC32 extension is optional before ARMv8.1, so only when the target guarantees it
+    #if defined(__ARM_FEATURE_CRC32)
+        #define PIXEL_CRC32C_ARM 1
+        #include <arm_acle.h>
+    #endif
+#endif
+
+// Active kernels - selected once by pixel_convert_init()
+static const pixel_kernel_t *active_kernel = NULL;
+
+// Scalar reference kernels
+
+// ARGB8888 is stored B,G,R,A in memory (little-endian 0xAARRGGBB)
+static void argb8888_to_rgb24_scalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        dst[0] = src[2]; // Red
+        dst[1] = src[1]; // Green
+        dst[2] = src[0]; // Blue
+        src += 4;
+        dst += 3;
+    }
+}
+
+// RGB565 is a little-endian uint16 with red in the top 5 bits; expand by bit replication
+static void rgb565_to_rgb24_scalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    const uint16_t *px = (const uint16_t*)src;
+    for (size_t i = 0; i < pixels; i++) {
+        uint16_t c = px[i];
+        uint8_t r = (c >> 11) & 0x1F;
+        uint8_t g = (c >> 5) & 0x3F;
+        uint8_t b = c & 0x1F;
+        dst[0] = (uint8_t)((r << 3) | (r >> 2));
+        dst[1] = (uint8_t)((g << 2) | (g >> 4));
+        dst[2] = (uint8_t)((b << 3) | (b >> 2));
+        dst += 3;
+    }
+}
+
+// Compare two ARGB8888 rows: returns the number of pixels where any channel differs by more than
+// its byte in tolerance (B,G,R,A lanes; alpha is given 0xFF so it never counts) and raises
+// *max_delta to the largest color channel difference seen
+static uint32_t argb8888_diff_scalar(const uint8_t *a, const uint8_t *b, size_t pixels, uint32_t tolerance,
+                                     uint8_t *max_delta) {
+    const uint8_t tol[4] = { (uint8_t)tolerance, (uint8_t)(tolerance >> 8), (uint8_t)(tolerance >> 16),
+                             (uint8_t)(tolerance >> 24) };
+    uint32_t mismatches = 0;
+    uint8_t max = *max_delta;
+
+    for (size_t i = 0; i < pixels; i++) {
+        int over = 0;
+        for (int c = 0; c < 4; c++) {
+            uint8_t d = (uint8_t)(a[c] > b[c] ? a[c] - b[c] : b[c] - a[c]);
+            over |= d > tol[c];
+            if (c < 3 && d > max) max = d;
+        }
+        mismatches += (uint32_t)over;
+        a += 4;
+        b += 4;
+    }
+
+    *max_delta = max;
+    return mismatches;
+}
+
+// CRC-32C (Castagnoli, reflected). crc is the CRC of the data before, so chained calls give the
+// CRC of the concatenation. The scalar kernel looks up one byte at a time.
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t crc32c_table[256];
+
+static uint32_t crc32c_scalar(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc = crc32c_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#ifdef PIXEL_CONVERT_X86
+
+// Interleave 16 R, G and B bytes into 48 bytes of RGB24
+TARGET_SSSE3 static inline void store_rgb_planes_ssse3(__m128i r, __m128i g, __m128i b, uint8_t *dst) {
+    const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    __m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)), _mm_shuffle_epi8(b, b0));
+    __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)), _mm_shuffle_epi8(b, b1));
+    __m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)), _mm_shuffle_epi8(b, b2));
+
+    _mm_storeu_si128((__m128i*)(dst + 0), out0);
+    _mm_storeu_si128((__m128i*)(dst + 16), out1);
+    _mm_storeu_si128((__m128i*)(dst + 32), out2);
+}
+
+// 16 pixels per iteration: drop alpha and swap B/R with one shuffle per 4 pixels, then pack 4x12 bytes
+TARGET_SSSE3 static void argb8888_to_rgb24_ssse3(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    const __m128i shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 0)), shuf);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), shuf);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 32)), shuf);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 48)), shuf);
+
+        _mm_storeu_si128((__m128i*)(dst + 0), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128((__m128i*)(dst + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128((__m128i*)(dst + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+
+        src += 64;
+        dst += 48;
+    }
+
+    argb8888_to_rgb24_scalar(src, dst, pixels - i);
+}
+
+TARGET_SSSE3 static inline void rgb565_expand_sse(__m128i px, __m128i *r, __m128i *g, __m128i *b) {
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+
+    __m128i r5 = _mm_srli_epi16(px, 11);
+    __m128i g6 = _mm_and_si128(_mm_srli_epi16(px, 5), mask6);
+    __m128i b5 = _mm_and_si128(px, mask5);
+
+    *r = _mm_or_si128(_mm_slli_epi16(r5, 3), _mm_srli_epi16(r5, 2));
+    *g = _mm_or_si128(_mm_slli_epi16(g6, 2), _mm_srli_epi16(g6, 4));
+    *b = _mm_or_si128(_mm_slli_epi16(b5, 3), _mm_srli_epi16(b5, 2));
+}
+
+// 16 pixels per iteration: expand channels in 16-bit lanes, pack to planes, interleave
+TARGET_SSSE3 static void rgb565_to_rgb24_ssse3(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i ra, ga, ba, rb, gb, bb;
+        rgb565_expand_sse(_mm_loadu_si128((const __m128i*)(src + 0)), &ra, &ga, &ba);
+        rgb565_expand_sse(_mm_loadu_si128((const __m128i*)(src + 16)), &rb, &gb, &bb);
+
+        store_rgb_planes_ssse3(_mm_packus_epi16(ra, rb), _mm_packus_epi16(ga, gb), _mm_packus_epi16(ba, bb), dst);
+
+        src += 32;
+        dst += 48;
+    }
+
+    rgb565_to_rgb24_scalar(src, dst, pixels - i);
+}
+
+// 16 pixels per iteration: one shuffle per 8 pixels, then pack the four 12-byte lanes into 48 bytes
+TARGET_AVX2 static void argb8888_to_rgb24_avx2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    const __m256i shuf = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m256i lo = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + 0)), shuf);
+        __m256i hi = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + 32)), shuf);
+
+        __m128i a = _mm256_castsi256_si128(lo);
+        __m128i b = _mm256_extracti128_si256(lo, 1);
+        __m128i c = _mm256_castsi256_si128(hi);
+        __m128i d = _mm256_extracti128_si256(hi, 1);
+
+        _mm_storeu_si128((__m128i*)(dst + 0), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128((__m128i*)(dst + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128((__m128i*)(dst + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+
+        src += 64;
+        dst += 48;
+    }
+
+    argb8888_to_rgb24_scalar(src, dst, pixels - i);
+}
+
+// 32 pixels per iteration: expand in 256-bit lanes, then interleave each 128-bit half
+TARGET_AVX2 static void rgb565_to_rgb24_avx2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    const __m256i mask5 = _mm256_set1_epi16(0x1F);
+    const __m256i mask6 = _mm256_set1_epi16(0x3F);
+    size_t i = 0;
+
+    for (; i + 32 <= pixels; i += 32) {
+        __m256i pa = _mm256_loadu_si256((const __m256i*)(src + 0));
+        __m256i pb = _mm256_loadu_si256((const __m256i*)(src + 32));
+
+        __m256i ra = _mm256_srli_epi16(pa, 11);
+        __m256i ga = _mm256_and_si256(_mm256_srli_epi16(pa, 5), mask6);
+        __m256i ba = _mm256_and_si256(pa, mask5);
+        __m256i rb = _mm256_srli_epi16(pb, 11);
+        __m256i gb = _mm256_and_si256(_mm256_srli_epi16(pb, 5), mask6);
+        __m256i bb = _mm256_and_si256(pb, mask5);
+
+        ra = _mm256_or_si256(_mm256_slli_epi16(ra, 3), _mm256_srli_epi16(ra, 2));
+        ga = _mm256_or_si256(_mm256_slli_epi16(ga, 2), _mm256_srli_epi16(ga, 4));
+        ba = _mm256_or_si256(_mm256_slli_epi16(ba, 3), _mm256_srli_epi16(ba, 2));
+        rb = _mm256_or_si256(_mm256_slli_epi16(rb, 3), _mm256_srli_epi16(rb, 2));
+        gb = _mm256_or_si256(_mm256_slli_epi16(gb, 2), _mm256_srli_epi16(gb, 4));
+        bb = _mm256_or_si256(_mm256_slli_epi16(bb, 3), _mm256_srli_epi16(bb, 2));
+
+        // packus works per 128-bit lane; restore pixel order with a 64-bit permute
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(ra, rb), 0xD8);
+        __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(ga, gb), 0xD8);
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(ba, bb), 0xD8);
+
+        store_rgb_planes_ssse3(_mm256_castsi256_si128(r), _mm256_castsi256_si128(g),
+                               _mm256_castsi256_si128(b), dst);
+        store_rgb_planes_ssse3(_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1),
+                               _mm256_extracti128_si256(b, 1), dst + 48);
+
+        src += 64;
+        dst += 96;
+    }
+
+    rgb565_to_rgb24_ssse3(src, dst, pixels - i);
+}
+
+// Horizontal max of 16 bytes
+TARGET_SSSE3 static inline uint8_t max_epu8_sse(__m128i v) {
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return (uint8_t)_mm_cvtsi128_si32(v);
+}
+
+// 4 pixels per iteration: saturating differences both ways give |a-b| per byte, and subtracting
+// the tolerance leaves an all-zero lane exactly where a pixel matches. Matches count as -1 per lane.
+TARGET_SSSE3 static uint32_t argb8888_diff_ssse3(const uint8_t *a, const uint8_t *b, size_t pixels,
+                                                 uint32_t tolerance, uint8_t *max_delta) {
+    const __m128i tol = _mm_set1_epi32((int)tolerance);
+    const __m128i color = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i max = zero;
+    __m128i matches = zero;
+    size_t i = 0;
+
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i*)a);
+        __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        max = _mm_max_epu8(max, _mm_and_si128(d, color));
+        matches = _mm_sub_epi32(matches, _mm_cmpeq_epi32(_mm_subs_epu8(d, tol), zero));
+        a += 16;
+        b += 16;
+    }
+
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, matches);
+    uint32_t mismatches = (uint32_t)i - (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+
+    uint8_t m = max_epu8_sse(max);
+    if (m > *max_delta) *max_delta = m;
+    return mismatches + argb8888_diff_scalar(a, b, pixels - i, tolerance, max_delta);
+}
+
+// 8 pixels per iteration, same scheme as the SSE version
+TARGET_AVX2 static uint32_t argb8888_diff_avx2(const uint8_t *a, const uint8_t *b, size_t pixels,
+                                               uint32_t tolerance, uint8_t *max_delta) {
+    const __m256i tol = _mm256_set1_epi32((int)tolerance);
+    const __m256i color = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i max = zero;
+    __m256i matches = zero;
+    size_t i = 0;
+
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)a);
+        __m256i vb = _mm256_loadu_si256((const __m256i*)b);
+        __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        max = _mm256_max_epu8(max, _mm256_and_si256(d, color));
+        matches = _mm256_sub_epi32(matches, _mm256_cmpeq_epi32(_mm256_subs_epu8(d, tol), zero));
+        a += 32;
+        b += 32;
+    }
+
+    __m128i folded = _mm_add_epi32(_mm256_castsi256_si128(matches), _mm256_extracti128_si256(matches, 1));
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, folded);
+    uint32_t mismatches = (uint32_t)i - (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+
+    uint8_t m = max_epu8_sse(_mm_max_epu8(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1)));
+    if (m > *max_delta) *max_delta = m;
+    return mismatches + argb8888_diff_ssse3(a, b, pixels - i, tolerance, max_delta);
+}
+
+static int cpu_has_ssse3(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static int cpu_has_sse42(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+static int cpu_has_avx2(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    int osxsave = (info[2] & (1 << 27)) != 0;
+    int avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return 0;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // PIXEL_CONVERT_X86
+
+#ifdef PIXEL_CONVERT_NEON
+
+// 16 pixels per iteration: vld4 splits B,G,R,A planes, vst3 writes them back as R,G,B
+static void argb8888_to_rgb24_neon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t bgra = vld4q_u8(src);
+        uint8x16x3_t rgb;
+        rgb.val[0] = bgra.val[2];
+        rgb.val[1] = bgra.val[1];
+        rgb.val[2] = bgra.val[0];
+        vst3q_u8(dst, rgb);
+        src += 64;
+        dst += 48;
+    }
+
+    argb8888_to_rgb24_scalar(src, dst, pixels - i);
+}
+
+// 16 pixels per iteration: expand in 16-bit lanes, narrow to planes, store interleaved
+static void rgb565_to_rgb24_neon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        uint16x8_t pa = vld1q_u16((const uint16_t*)src);
+        uint16x8_t pb = vld1q_u16((const uint16_t*)(src + 16));
+
+        uint8x16_t r5 = vcombine_u8(vshrn_n_u16(pa, 11), vshrn_n_u16(pb, 11));
+        uint8x16_t g6 = vandq_u8(vcombine_u8(vshrn_n_u16(pa, 5), vshrn_n_u16(pb, 5)), vdupq_n_u8(0x3F));
+        uint8x16_t b5 = vandq_u8(vcombine_u8(vmovn_u16(pa), vmovn_u16(pb)), vdupq_n_u8(0x1F));
+
+        uint8x16x3_t rgb;
+        rgb.val[0] = vorrq_u8(vshlq_n_u8(r5, 3), vshrq_n_u8(r5, 2));
+        rgb.val[1] = vorrq_u8(vshlq_n_u8(g6, 2), vshrq_n_u8(g6, 4));
+        rgb.val[2] = vorrq_u8(vshlq_n_u8(b5, 3), vshrq_n_u8(b5, 2));
+        vst3q_u8(dst, rgb);
+
+        src += 32;
+        dst += 48;
+    }
+
+    rgb565_to_rgb24_scalar(src, dst, pixels - i);
+}
+
+// 4 pixels per iteration: vabd gives |a-b| directly, then the same tolerance/zero-lane test as x86
+static uint32_t argb8888_diff_neon(const uint8_t *a, const uint8_t *b, size_t pixels, uint32_t tolerance,
+                                   uint8_t *max_delta) {
+    const uint8x16_t tol = vreinterpretq_u8_u32(vdupq_n_u32(tolerance));
+    const uint8x16_t color = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFF));
+    uint8x16_t max = vdupq_n_u8(0);
+    uint32x4_t matches = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 4 <= pixels; i += 4) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a), vld1q_u8(b));
+        max = vmaxq_u8(max, vandq_u8(d, color));
+        uint32x4_t over = vreinterpretq_u32_u8(vqsubq_u8(d, tol));
+        matches = vsubq_u32(matches, vceqq_u32(over, vdupq_n_u32(0)));
+        a += 16;
+        b += 16;
+    }
+
+    uint32_t mismatches = (uint32_t)i - (vgetq_lane_u32(matches, 0) + vgetq_lane_u32(matches, 1) +
+                                         vgetq_lane_u32(matches, 2) + vgetq_lane_u32(matches, 3));
+    uint8_t lanes[16];
+    vst1q_u8(lanes, max);
+    for (int k = 0; k < 16; k++) {
+        if (lanes[k] > *max_delta) *max_delta = lanes[k];
+    }
+    return mismatches + argb8888_diff_scalar(a, b, pixels - i, tolerance, max_delta);
+}
+
+#endif // PIXEL_CONVERT_NEON
+
+#if defined(PIXEL_CRC32C_X86) || defined(PIXEL_CRC32C_ARM)
+
+// The crc32 instruction has a latency of about three cycles but issues every cycle, so the
+// hardware kernel runs three independent streams over adjacent blocks and merges them with
+// tables that append a block's worth of zero bytes to a CRC
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+static uint32_t crc32c_long[4][256];
+static uint32_t crc32c_short[4][256];
+
+#ifdef PIXEL_CRC32C_X86
+    #define CRC32C_HW_TARGET TARGET_SSE42
+    #define crc32c_hw_u64(crc, v) ((uint32_t)_mm_crc32_u64((crc), (v)))
+    #define crc32c_hw_u8(crc, v) _mm_crc32_u8((crc), (v))
+#else
+    #define CRC32C_HW_TARGET
+    #define crc32c_hw_u64(crc, v) __crc32cd((crc), (v))
+    #define crc32c_hw_u8(crc, v) __crc32cb((crc), (v))
+#endif
+
+// Multiply a GF(2) 32x32 matrix (one column per word) by a vector
+static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// Table that appends len zero bytes (a power of two) to a raw CRC register, one lookup per byte
+static void crc32c_zeros(uint32_t zeros[4][256], size_t len) {
+    uint32_t even[32], odd[32];
+    
+    // Operator for one zero bit, then square up to one zero byte and on to len of them
+    odd[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++) {
+        odd[n] = 1u << (n - 1);
+    }
+    gf2_matrix_square(even, odd);   // two zero bits
+    gf2_matrix_square(odd, even);   // four
+    uint32_t *op = odd;
+    do {
+        gf2_matrix_square(even, odd);
+        op = even;
+        len >>= 1;
+        if (len == 0) {
+            break;
+        }
+        gf2_matrix_square(odd, even);
+        op = odd;
+        len >>= 1;
+    } while (len);
+    
+    for (uint32_t n = 0; n < 256; n++) {
+        zeros[0][n] = gf2_matrix_times(op, n);
+        zeros[1][n] = gf2_matrix_times(op, n << 8);
+        zeros[2][n] = gf2_matrix_times(op, n << 16);
+        zeros[3][n] = gf2_matrix_times(op, n << 24);
+    }
+}
+
+static inline uint32_t crc32c_shift(const uint32_t zeros[4][256], uint32_t crc) {
+    return zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^ zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24];
+}
+
+static inline uint64_t crc32c_read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+CRC32C_HW_TARGET static uint32_t crc32c_hw(uint32_t crc, const uint8_t *data, size_t len) {
+    uint32_t crc0 = ~crc;
+    
+    while (len && ((uintptr_t)data & 7)) {
+        crc0 = crc32c_hw_u8(crc0, *data++);
+        len--;
+    }
+    
+    while (len >= CRC32C_LONG * 3) {
+        uint32_t crc1 = 0, crc2 = 0;
+        const uint8_t *end = data + CRC32C_LONG;
+        do {
+            crc0 = crc32c_hw_u64(crc0, crc32c_read64(data));
+            crc1 = crc32c_hw_u64(crc1, crc32c_read64(data + CRC32C_LONG));
+            crc2 = crc32c_hw_u64(crc2, crc32c_read64(data + 2 * CRC32C_LONG));
+            data += 8;
+        } while (data < end);
+        crc0 = crc32c_shift(crc32c_long, crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_long, crc0) ^ crc2;
+        data += 2 * CRC32C_LONG;
+        len -= 3 * CRC32C_LONG;
+    }
+    
+    while (len >= CRC32C_SHORT * 3) {
+        uint32_t crc1 = 0, crc2 = 0;
+        const uint8_t *end = data + CRC32C_SHORT;
+        do {
+            crc0 = crc32c_hw_u64(crc0, crc32c_read64(data));
+            crc1 = crc32c_hw_u64(crc1, crc32c_read64(data + CRC32C_SHORT));
+            crc2 = crc32c_hw_u64(crc2, crc32c_read64(data + 2 * CRC32C_SHORT));
+            data += 8;
+        } while (data < end);
+        crc0 = crc32c_shift(crc32c_short, crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_short, crc0) ^ crc2;
+        data += 2 * CRC32C_SHORT;
+        len -= 3 * CRC32C_SHORT;
+    }
+    
+    for (; len >= 8; len -= 8, data += 8) {
+        crc0 = crc32c_hw_u64(crc0, crc32c_read64(data));
+    }
+    while (len--) {
+        crc0 = crc32c_hw_u8(crc0, *data++);
+    }
+    return ~crc0;
+}
+
+#endif // PIXEL_CRC32C_X86 || PIXEL_CRC32C_ARM
+
+#ifdef PIXEL_CRC32C_X86
+    #define CRC32C_X86_KERNEL crc32c_hw
+#else
+    #define CRC32C_X86_KERNEL crc32c_scalar
+#endif
+#ifdef PIXEL_CRC32C_ARM
+    #define CRC32C_NEON_KERNEL crc32c_hw
+#else
+    #define CRC32C_NEON_KERNEL crc32c_scalar
+#endif
+
+static void crc32c_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+        }
+        crc32c_table[n] = crc;
+    }
+#if defined(PIXEL_CRC32C_X86) || defined(PIXEL_CRC32C_ARM)
+    crc32c_zeros(crc32c_long, CRC32C_LONG);
+    crc32c_zeros(crc32c_short, CRC32C_SHORT);
+#endif
+}
+
+// Kernel table, best first; 'supported' is filled in by pixel_convert_init()
+static pixel_kernel_t pixel_kernels[] = {
+#ifdef PIXEL_CONVERT_X86
+    { "avx2", argb8888_to_rgb24_avx2, rgb565_to_rgb24_avx2, argb8888_diff_avx2, CRC32C_X86_KERNEL, 0 },
+#ifdef PIXEL_CRC32C_X86
+    { "sse42", argb8888_to_rgb24_ssse3, rgb565_to_rgb24_ssse3, argb8888_diff_ssse3, crc32c_hw, 0 },
+#endif
+    { "ssse3", argb8888_to_rgb24_ssse3, rgb565_to_rgb24_ssse3, argb8888_diff_ssse3, crc32c_scalar, 0 },
+#endif
+#ifdef PIXEL_CONVERT_NEON
+    { "neon", argb8888_to_rgb24_neon, rgb565_to_rgb24_neon, argb8888_diff_neon, CRC32C_NEON_KERNEL, 0 },
+#endif
+    { "scalar", argb8888_to_rgb24_scalar, rgb565_to_rgb24_scalar, argb8888_diff_scalar, crc32c_scalar, 0 },
+};
+
+#define PIXEL_KERNEL_COUNT (sizeof(pixel_kernels) / sizeof(pixel_kernels[0]))
+
+// Detect CPU features once and pick the fastest supported kernels.
+// LVGL_PIXEL_KERNEL=<name> forces a specific (supported) kernel for debugging.
+int pixel_convert_init(void) {
+    if (active_kernel) {
+        return TEST_OK;
+    }
+
+    crc32c_init();
+    for (size_t i = 0; i < PIXEL_KERNEL_COUNT; i++) {
+        const char *name = pixel_kernels[i].name;
+#ifdef PIXEL_CONVERT_X86
+        if (strcmp(name, "avx2") == 0) {
+            // Every AVX2 CPU has SSE4.2 as well, checked anyway for the crc32 instruction
+            pixel_kernels[i].supported = cpu_has_avx2() && cpu_has_sse42();
+            continue;
+        }
+        if (strcmp(name, "sse42") == 0) {
+            pixel_kernels[i].supported = cpu_has_sse42() && cpu_has_ssse3();
+            continue;
+        }
+        if (strcmp(name, "ssse3") == 0) {
+            pixel_kernels[i].supported = cpu_has_ssse3();
+            continue;
+        }
+#endif
+        (void)name;
+        pixel_kernels[i].supported = 1; // NEON is baseline on the targets that define it
+    }
+
+    const char *forced = getenv("LVGL_PIXEL_KERNEL");
+    for (size_t i = 0; i < PIXEL_KERNEL_COUNT && forced; i++) {
+        if (pixel_kernels[i].supported && strcmp(pixel_kernels[i].name, forced) == 0) {
+            active_kernel = &pixel_kernels[i];
+        }
+    }
+
+    for (size_t i = 0; i < PIXEL_KERNEL_COUNT && !active_kernel; i++) {
+        if (pixel_kernels[i].supported) {
+            active_kernel = &pixel_kernels[i];
+        }
+    }
+
+    printf("Pixel conversion kernels: %s\n", active_kernel->name);
+    return TEST_OK;
+}
+
+const char *pixel_convert_kernel_name(void) {
+    pixel_convert_init();
+    return active_kernel->name;
+}
+
+size_t pixel_convert_get_kernels(const pixel_kernel_t **kernels) {
+    pixel_convert_init();
+    if (kernels) {
+        *kernels = pixel_kernels;
+    }
+    return PIXEL_KERNEL_COUNT;
+}
+
+void convert_argb8888_to_rgb24(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    if (!active_kernel) pixel_convert_init();
+    active_kernel->argb8888_to_rgb24(src, dst, pixels);
+}
+
+uint32_t hash_crc32c(uint32_t crc, const void *data, size_t len) {
+    if (!active_kernel) pixel_convert_init();
+    return active_kernel->crc32c(crc, (const uint8_t*)data, len);
+}
+
+void convert_rgb565_to_rgb24(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    if (!active_kernel) pixel_convert_init();
+    active_kernel->rgb565_to_rgb24(src, dst, pixels);
+}
+
+uint32_t pixel_diff_argb8888(const uint8_t *a, const uint8_t *b, size_t pixels, uint32_t tolerance,
+                             uint8_t *max_delta) {
+    if (!active_kernel) pixel_convert_init();
+    return active_kernel->argb8888_diff(a, b, pixels, tolerance, max_delta);
+}
+
+// Less common raw screenshot conversions - scalar only, they never sit on the PNG path
+
+// ARGB8888 (B,G,R,A in memory) to little-endian RGB565, truncating the low bits
+void convert_argb8888_to_rgb565(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        uint16_t c = (uint16_t)(((src[2] & 0xF8) << 8) | ((src[1] & 0xFC) << 3) | (src[0] >> 3));
+        dst[0] = (uint8_t)(c & 0xFF);
+        dst[1] = (uint8_t)(c >> 8);
+        src += 4;
+        dst += 2;
+    }
+}
+
+// RGB565 to opaque ARGB8888 (B,G,R,A in memory), expanding by bit replication
+void convert_rgb565_to_argb8888(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        uint16_t c = (uint16_t)(src[0] | (src[1] << 8));
+        uint8_t r = (c >> 11) & 0x1F;
+        uint8_t g = (c >> 5) & 0x3F;
+        uint8_t b = c & 0x1F;
+        dst[0] = (uint8_t)((b << 3) | (b >> 2));
+        dst[1] = (uint8_t)((g << 2) | (g >> 4));
+        dst[2] = (uint8_t)((r << 3) | (r >> 2));
+        dst[3] = 0xFF;
+        src += 2;
+        dst += 4;
+    }
+}
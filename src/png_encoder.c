@@ -0,0 +1,890 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "test_harness.h"
+
+// RGB24 PNG encoder with its own deflate implementation.
+//
+// The image is filtered row by row, then split into row bands that are deflated
+// independently on the worker pool. Each band may reference the previous band's
+// last 32 KB (the decoder has it in its window anyway), ends on a byte boundary with
+// an empty stored block (a zlib "sync flush"), and reports its Adler-32 so the
+// checksums can be combined. Concatenated, the bands form one valid zlib stream.
+
+#define DEFLATE_WINDOW 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_HASH_SIZE (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_BLOCK_SYMBOLS 16384
+#define DEFLATE_STORED_MAX 65535
+
+#define PNG_MIN_BAND_BYTES (64 * 1024)  // smaller bands cost more in headers than they gain
+#define PNG_MAX_BANDS 16
+#define PNG_FILTER_COUNT 5
+
+// Server defaults when a request does not specify its own
+#define PNG_DEFAULT_LEVEL 4
+#define PNG_DEFAULT_FILTER PNG_FILTER_ADAPTIVE
+
+// Per-level match finder settings
+static const struct {
+    uint16_t max_chain;     // hash chain entries probed per position
+    uint16_t nice_len;      // stop searching once a match is this long
+    uint8_t lazy;           // try the next position before committing to a match
+    uint8_t insert_limit;   // only hash positions inside matches up to this length
+} deflate_levels[10] = {
+    {    0,   0, 0,   0 },  // 0: stored
+    {    4,   8, 0,   4 },
+    {    8,  16, 0,   8 },
+    {   16,  32, 0,  16 },
+    {   16,  32, 1, 255 },
+    {   32,  64, 1, 255 },
+    {  128, 128, 1, 255 },
+    {  256, 128, 1, 255 },
+    { 1024, 258, 1, 255 },
+    { 4096, 258, 1, 255 },
+};
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t clen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// Lookup tables built once by png_encoder_tables_init()
+static struct {
+    int ready;
+    uint8_t length_code[DEFLATE_MAX_MATCH + 1];   // match length -> code index 0..28
+    uint8_t dist_code[512];                        // see deflate_dist_code()
+    uint8_t fixed_lit_len[288];
+    uint16_t fixed_lit_code[288];
+    uint8_t fixed_dist_len[30];
+    uint16_t fixed_dist_code[30];
+    uint32_t crc[256];
+} png_tables = {0};
+
+// Bit writer (LSB first, as deflate wants)
+typedef struct {
+    uint8_t *out;
+    size_t pos;
+    uint64_t bitbuf;
+    int bitcount;
+} bit_writer_t;
+
+static inline void bw_put(bit_writer_t *w, uint32_t bits, int count) {
+    w->bitbuf |= (uint64_t)bits << w->bitcount;
+    w->bitcount += count;
+    if (w->bitcount >= 32) {
+        w->out[w->pos++] = (uint8_t)w->bitbuf;
+        w->out[w->pos++] = (uint8_t)(w->bitbuf >> 8);
+        w->out[w->pos++] = (uint8_t)(w->bitbuf >> 16);
+        w->out[w->pos++] = (uint8_t)(w->bitbuf >> 24);
+        w->bitbuf >>= 32;
+        w->bitcount -= 32;
+    }
+}
+
+static void bw_align(bit_writer_t *w) {
+    while (w->bitcount > 0) {
+        w->out[w->pos++] = (uint8_t)w->bitbuf;
+        w->bitbuf >>= 8;
+        w->bitcount -= 8;
+    }
+    w->bitbuf = 0;
+    w->bitcount = 0;
+}
+
+// Everything one band needs; all memory is handed out by the caller before dispatch
+typedef struct {
+    // Input: filtered bytes [start, end) of the whole image, history reachable back to window_start
+    const uint8_t *data;
+    size_t start;
+    size_t end;
+    size_t window_start;
+    int level;
+    int final;
+
+    // Scratch
+    int32_t *head;          // DEFLATE_HASH_SIZE, last position + 1 per hash
+    int32_t *prev;          // DEFLATE_WINDOW, previous position + 1 per window slot
+    uint16_t *sym_value;    // literal byte or match length
+    uint16_t *sym_dist;     // 0 for literals
+
+    // Output
+    bit_writer_t writer;
+    size_t out_cap;
+    uint32_t adler;
+} deflate_band_t;
+
+static void crc_table_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        png_tables.crc[n] = c;
+    }
+}
+
+static uint32_t png_crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = png_tables.crc[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t len) {
+    uint32_t a = 1, b = 0;
+    while (len > 0) {
+        size_t chunk = len < 5552 ? len : 5552;   // largest run without 32-bit overflow
+        len -= chunk;
+        while (chunk--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+// Checksum of A||B from the checksums of A and B and the length of B (as in zlib)
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+    const uint32_t base = 65521;
+    uint64_t rem = len2 % base;
+    uint64_t sum1 = adler1 & 0xFFFF;
+    uint64_t sum2 = (rem * sum1) % base;
+    sum1 += (adler2 & 0xFFFF) + base - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + base - rem;
+    if (sum1 >= base) sum1 -= base;
+    if (sum1 >= base) sum1 -= base;
+    if (sum2 >= ((uint64_t)base << 1)) sum2 -= ((uint64_t)base << 1);
+    if (sum2 >= base) sum2 -= base;
+    return (uint32_t)(sum1 | (sum2 << 16));
+}
+
+static inline int deflate_dist_code(uint32_t dist) {
+    return dist <= 256 ? png_tables.dist_code[dist - 1] : png_tables.dist_code[256 + ((dist - 1) >> 7)];
+}
+
+// Canonical codes from code lengths, bit-reversed for the LSB-first writer
+static void huff_codes(const uint8_t *lens, int n, uint16_t *codes) {
+    uint16_t bl_count[16] = {0};
+    uint16_t next_code[16];
+
+    for (int i = 0; i < n; i++) bl_count[lens[i]]++;
+    bl_count[0] = 0;
+
+    uint16_t code = 0;
+    for (int bits = 1; bits < 16; bits++) {
+        code = (uint16_t)((code + bl_count[bits - 1]) << 1);
+        next_code[bits] = code;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int len = lens[i];
+        if (len == 0) {
+            codes[i] = 0;
+            continue;
+        }
+        uint16_t c = next_code[len]++;
+        uint16_t reversed = 0;
+        for (int b = 0; b < len; b++) {
+            reversed = (uint16_t)((reversed << 1) | ((c >> b) & 1));
+        }
+        codes[i] = reversed;
+    }
+}
+
+static int huff_key_compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Huffman code lengths limited to max_bits (deflate callers always pass two or more used symbols).
+// Over-long trees are rebuilt from halved frequencies until they fit.
+static void huff_lengths(const uint32_t *freq, int n, int max_bits, uint8_t *lens) {
+    uint32_t keys[288];
+    uint32_t weight[2 * 288];
+    int16_t parent[2 * 288];
+    uint8_t depth[2 * 288];
+    uint32_t scaled[288];
+
+    memcpy(scaled, freq, sizeof(uint32_t) * (size_t)n);
+    memset(lens, 0, (size_t)n);
+
+    for (;;) {
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            if (scaled[i]) keys[m++] = (scaled[i] << 9) | (uint32_t)i;
+        }
+        if (m < 2) {
+            if (m == 1) lens[keys[0] & 0x1FF] = 1;
+            return;
+        }
+        qsort(keys, (size_t)m, sizeof(uint32_t), huff_key_compare);
+
+        // Two-queue construction: leaves 0..m-1 in ascending order, internal nodes appended
+        for (int i = 0; i < m; i++) weight[i] = keys[i] >> 9;
+        int leaf = 0, node = m, next = m;
+        for (int k = 0; k < m - 1; k++) {
+            int pick[2];
+            for (int j = 0; j < 2; j++) {
+                if (leaf < m && (node >= next || weight[leaf] <= weight[node])) {
+                    pick[j] = leaf++;
+                } else {
+                    pick[j] = node++;
+                }
+            }
+            weight[next] = weight[pick[0]] + weight[pick[1]];
+            parent[pick[0]] = (int16_t)next;
+            parent[pick[1]] = (int16_t)next;
+            next++;
+        }
+
+        int root = next - 1;
+        int max_depth = 0;
+        depth[root] = 0;
+        for (int i = root - 1; i >= 0; i--) {
+            depth[i] = (uint8_t)(depth[parent[i]] + 1);
+            if (i < m && depth[i] > max_depth) max_depth = depth[i];
+        }
+
+        if (max_depth <= max_bits) {
+            for (int i = 0; i < m; i++) lens[keys[i] & 0x1FF] = depth[i];
+            return;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (scaled[i]) scaled[i] = (scaled[i] >> 1) | 1;
+        }
+    }
+}
+
+static void png_encoder_tables_init(void) {
+    if (png_tables.ready) {
+        return;
+    }
+
+    for (int code = 0; code < 29; code++) {
+        int span = 1 << length_extra[code];
+        for (int i = 0; i < span && length_base[code] + i <= DEFLATE_MAX_MATCH; i++) {
+            png_tables.length_code[length_base[code] + i] = (uint8_t)code;
+        }
+    }
+    png_tables.length_code[DEFLATE_MAX_MATCH] = 28;
+
+    // zlib's split table: distances 1..256 directly, larger ones in steps of 128
+    for (int code = 0; code < 30; code++) {
+        for (uint32_t d = dist_base[code]; d < (uint32_t)dist_base[code] + (1u << dist_extra[code]); d++) {
+            if (d <= 256) {
+                png_tables.dist_code[d - 1] = (uint8_t)code;
+            } else {
+                png_tables.dist_code[256 + ((d - 1) >> 7)] = (uint8_t)code;
+            }
+        }
+    }
+
+    for (int i = 0; i < 288; i++) {
+        png_tables.fixed_lit_len[i] = (uint8_t)(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+    }
+    for (int i = 0; i < 30; i++) {
+        png_tables.fixed_dist_len[i] = 5;
+    }
+    huff_codes(png_tables.fixed_lit_len, 288, png_tables.fixed_lit_code);
+    huff_codes(png_tables.fixed_dist_len, 30, png_tables.fixed_dist_code);
+
+    crc_table_init();
+    png_tables.ready = 1;
+}
+
+// Stored block(s) for raw bytes; the last chunk carries BFINAL when final is set
+static void deflate_write_stored(bit_writer_t *w, const uint8_t *data, size_t len, int final) {
+    do {
+        size_t chunk = len < DEFLATE_STORED_MAX ? len : DEFLATE_STORED_MAX;
+        len -= chunk;
+        bw_put(w, (final && len == 0) ? 1 : 0, 1);
+        bw_put(w, 0, 2);
+        bw_align(w);
+        w->out[w->pos++] = (uint8_t)(chunk & 0xFF);
+        w->out[w->pos++] = (uint8_t)(chunk >> 8);
+        w->out[w->pos++] = (uint8_t)(~chunk & 0xFF);
+        w->out[w->pos++] = (uint8_t)((~chunk >> 8) & 0xFF);
+        memcpy(w->out + w->pos, data, chunk);
+        w->pos += chunk;
+        data += chunk;
+    } while (len > 0);
+}
+
+static void deflate_write_symbols(bit_writer_t *w, const deflate_band_t *band, int count,
+                                  const uint8_t *lit_len, const uint16_t *lit_code,
+                                  const uint8_t *dist_len, const uint16_t *dist_code) {
+    for (int i = 0; i < count; i++) {
+        uint32_t dist = band->sym_dist[i];
+        uint32_t value = band->sym_value[i];
+        if (dist == 0) {
+            bw_put(w, lit_code[value], lit_len[value]);
+            continue;
+        }
+
+        int lc = png_tables.length_code[value];
+        bw_put(w, lit_code[257 + lc], lit_len[257 + lc]);
+        if (length_extra[lc]) bw_put(w, value - length_base[lc], length_extra[lc]);
+
+        int dc = deflate_dist_code(dist);
+        bw_put(w, dist_code[dc], dist_len[dc]);
+        if (dist_extra[dc]) bw_put(w, dist - dist_base[dc], dist_extra[dc]);
+    }
+    bw_put(w, lit_code[256], lit_len[256]);
+}
+
+// Emit the buffered symbols as whichever block type is smallest: dynamic, fixed or stored
+static void deflate_flush_block(deflate_band_t *band, int count, size_t raw_start, size_t raw_len, int final) {
+    uint32_t lit_freq[286] = {0};
+    uint32_t dist_freq[30] = {0};
+    uint64_t extra_bits = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (band->sym_dist[i] == 0) {
+            lit_freq[band->sym_value[i]]++;
+        } else {
+            int lc = png_tables.length_code[band->sym_value[i]];
+            int dc = deflate_dist_code(band->sym_dist[i]);
+            lit_freq[257 + lc]++;
+            dist_freq[dc]++;
+            extra_bits += length_extra[lc] + dist_extra[dc];
+        }
+    }
+    lit_freq[256] = 1;
+
+    // Both trees need two used symbols to be complete codes
+    int lit_used = 0, dist_used = 0;
+    for (int i = 0; i < 286; i++) lit_used += lit_freq[i] != 0;
+    for (int i = 0; i < 30; i++) dist_used += dist_freq[i] != 0;
+    if (lit_used < 2) lit_freq[lit_freq[0] ? 1 : 0]++;
+    if (dist_used < 2) {
+        if (!dist_freq[0]) dist_freq[0] = 1;
+        else dist_freq[1] = 1;
+        if (dist_used == 0) dist_freq[1] = 1;
+    }
+
+    uint8_t lit_len[286], dist_len[30];
+    huff_lengths(lit_freq, 286, 15, lit_len);
+    huff_lengths(dist_freq, 30, 15, dist_len);
+
+    int hlit = 286;
+    while (hlit > 257 && lit_len[hlit - 1] == 0) hlit--;
+    int hdist = 30;
+    while (hdist > 1 && dist_len[hdist - 1] == 0) hdist--;
+
+    // Run-length encode the combined code lengths with symbols 16/17/18
+    uint8_t all_len[286 + 30];
+    memcpy(all_len, lit_len, (size_t)hlit);
+    memcpy(all_len + hlit, dist_len, (size_t)hdist);
+    int total = hlit + hdist;
+
+    uint8_t cl_sym[286 + 30];
+    uint8_t cl_extra[286 + 30];
+    int cl_count = 0;
+    uint32_t cl_freq[19] = {0};
+
+    for (int i = 0; i < total;) {
+        uint8_t cur = all_len[i];
+        int run = 1;
+        while (i + run < total && all_len[i + run] == cur) run++;
+
+        if (cur == 0) {
+            int left = run;
+            while (left >= 11) {
+                int r = left < 138 ? left : 138;
+                cl_sym[cl_count] = 18; cl_extra[cl_count++] = (uint8_t)(r - 11);
+                left -= r;
+            }
+            if (left >= 3) {
+                cl_sym[cl_count] = 17; cl_extra[cl_count++] = (uint8_t)(left - 3);
+                left = 0;
+            }
+            while (left-- > 0) {
+                cl_sym[cl_count] = 0; cl_extra[cl_count++] = 0;
+            }
+        } else {
+            cl_sym[cl_count] = cur; cl_extra[cl_count++] = 0;
+            int left = run - 1;
+            while (left >= 3) {
+                int r = left < 6 ? left : 6;
+                cl_sym[cl_count] = 16; cl_extra[cl_count++] = (uint8_t)(r - 3);
+                left -= r;
+            }
+            while (left-- > 0) {
+                cl_sym[cl_count] = cur; cl_extra[cl_count++] = 0;
+            }
+        }
+        i += run;
+    }
+
+    for (int i = 0; i < cl_count; i++) cl_freq[cl_sym[i]]++;
+    int cl_used = 0;
+    for (int i = 0; i < 19; i++) cl_used += cl_freq[i] != 0;
+    if (cl_used < 2) cl_freq[cl_freq[0] ? 1 : 0]++;
+
+    uint8_t cl_len[19];
+    huff_lengths(cl_freq, 19, 7, cl_len);
+    int hclen = 19;
+    while (hclen > 4 && cl_len[clen_order[hclen - 1]] == 0) hclen--;
+
+    // Block sizes in bits
+    uint64_t dyn_bits = 3 + 5 + 5 + 4 + 3 * (uint64_t)hclen + extra_bits;
+    uint64_t fixed_bits = 3 + extra_bits;
+    for (int i = 0; i < cl_count; i++) {
+        dyn_bits += cl_len[cl_sym[i]] + (cl_sym[i] == 16 ? 2 : cl_sym[i] == 17 ? 3 : cl_sym[i] == 18 ? 7 : 0);
+    }
+    for (int i = 0; i < 286; i++) {
+        dyn_bits += (uint64_t)lit_freq[i] * lit_len[i];
+        fixed_bits += (uint64_t)lit_freq[i] * png_tables.fixed_lit_len[i];
+    }
+    for (int i = 0; i < 30; i++) {
+        dyn_bits += (uint64_t)dist_freq[i] * dist_len[i];
+        fixed_bits += (uint64_t)dist_freq[i] * png_tables.fixed_dist_len[i];
+    }
+    uint64_t stored_bits = (raw_len + 5 * (raw_len / DEFLATE_STORED_MAX + 1)) * 8 + 8;
+
+    bit_writer_t *w = &band->writer;
+
+    if (stored_bits <= dyn_bits && stored_bits <= fixed_bits) {
+        deflate_write_stored(w, band->data + raw_start, raw_len, final);
+        return;
+    }
+
+    bw_put(w, final ? 1 : 0, 1);
+
+    if (fixed_bits <= dyn_bits) {
+        bw_put(w, 1, 2);
+        deflate_write_symbols(w, band, count, png_tables.fixed_lit_len, png_tables.fixed_lit_code,
+                              png_tables.fixed_dist_len, png_tables.fixed_dist_code);
+        return;
+    }
+
+    uint16_t lit_code[286], dist_code[30], cl_code[19];
+    huff_codes(lit_len, 286, lit_code);
+    huff_codes(dist_len, 30, dist_code);
+    huff_codes(cl_len, 19, cl_code);
+
+    bw_put(w, 2, 2);
+    bw_put(w, (uint32_t)(hlit - 257), 5);
+    bw_put(w, (uint32_t)(hdist - 1), 5);
+    bw_put(w, (uint32_t)(hclen - 4), 4);
+    for (int i = 0; i < hclen; i++) {
+        bw_put(w, cl_len[clen_order[i]], 3);
+    }
+    for (int i = 0; i < cl_count; i++) {
+        uint8_t s = cl_sym[i];
+        bw_put(w, cl_code[s], cl_len[s]);
+        if (s == 16) bw_put(w, cl_extra[i], 2);
+        else if (s == 17) bw_put(w, cl_extra[i], 3);
+        else if (s == 18) bw_put(w, cl_extra[i], 7);
+    }
+    deflate_write_symbols(w, band, count, lit_len, lit_code, dist_len, dist_code);
+}
+
+static inline uint32_t deflate_hash(const uint8_t *p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+static inline void deflate_insert(deflate_band_t *band, size_t pos) {
+    uint32_t h = deflate_hash(band->data + pos);
+    band->prev[pos & (DEFLATE_WINDOW - 1)] = band->head[h];
+    band->head[h] = (int32_t)(pos + 1);
+}
+
+// Longest match for pos among the hash chain; returns its length (0 if below the minimum)
+static int deflate_find_match(const deflate_band_t *band, size_t pos, int max_len, int min_len,
+                              int max_chain, int nice_len, uint32_t *dist_out) {
+    const uint8_t *data = band->data;
+    const uint8_t *cur = data + pos;
+    int best_len = min_len - 1;
+    int32_t cand = band->head[deflate_hash(cur)] - 1;
+
+    while (cand >= (int32_t)band->window_start && (size_t)cand < pos && max_chain-- > 0) {
+        size_t dist = pos - (size_t)cand;
+        if (dist > DEFLATE_WINDOW) {
+            break;
+        }
+
+        const uint8_t *ref = data + cand;
+        if (ref[best_len] == cur[best_len] && ref[0] == cur[0] && ref[1] == cur[1]) {
+            int len = 2;
+            while (len < max_len && ref[len] == cur[len]) len++;
+            if (len > best_len) {
+                best_len = len;
+                *dist_out = (uint32_t)dist;
+                if (len >= nice_len || len >= max_len) {
+                    break;
+                }
+            }
+        }
+
+        int32_t next = band->prev[cand & (DEFLATE_WINDOW - 1)] - 1;
+        if (next >= cand) {
+            break;
+        }
+        cand = next;
+    }
+
+    return best_len >= DEFLATE_MIN_MATCH && best_len >= min_len ? best_len : 0;
+}
+
+// Compress one band; runs on a worker thread
+static void deflate_band(deflate_band_t *band) {
+    bit_writer_t *w = &band->writer;
+    w->pos = 0;
+    w->bitbuf = 0;
+    w->bitcount = 0;
+
+    size_t len = band->end - band->start;
+    band->adler = adler32(band->data + band->start, len);
+
+    if (band->level == 0) {
+        if (len > 0) {
+            deflate_write_stored(w, band->data + band->start, len, band->final);
+        }
+    } else {
+        int max_chain = deflate_levels[band->level].max_chain;
+        int nice_len = deflate_levels[band->level].nice_len;
+        int lazy = deflate_levels[band->level].lazy;
+        int insert_limit = deflate_levels[band->level].insert_limit;
+
+        memset(band->head, 0, sizeof(int32_t) * DEFLATE_HASH_SIZE);
+
+        // Prime the hash with the previous band's tail - the decoder's window already holds it
+        for (size_t p = band->window_start; p + 2 < band->start; p++) {
+            deflate_insert(band, p);
+        }
+
+        size_t pos = band->start;
+        size_t block_start = pos;
+        int count = 0;
+
+        while (pos < band->end) {
+            size_t remaining = band->end - pos;
+            int max_len = remaining < DEFLATE_MAX_MATCH ? (int)remaining : DEFLATE_MAX_MATCH;
+            uint32_t dist = 0;
+            int match = 0;
+
+            if (max_len >= DEFLATE_MIN_MATCH) {
+                match = deflate_find_match(band, pos, max_len, DEFLATE_MIN_MATCH, max_chain, nice_len, &dist);
+                deflate_insert(band, pos);
+
+                // Lazy evaluation: a longer match one byte later wins over this one
+                if (match && lazy && match < nice_len && remaining > (size_t)match + 1 && max_len > DEFLATE_MIN_MATCH) {
+                    uint32_t next_dist = 0;
+                    int next_max = (remaining - 1) < DEFLATE_MAX_MATCH ? (int)(remaining - 1) : DEFLATE_MAX_MATCH;
+                    int next = deflate_find_match(band, pos + 1, next_max, match + 1, max_chain >> 1, nice_len, &next_dist);
+                    if (next > match) {
+                        match = 0;
+                    }
+                }
+            }
+
+            if (match) {
+                band->sym_value[count] = (uint16_t)match;
+                band->sym_dist[count] = (uint16_t)dist;
+                count++;
+
+                if (match <= insert_limit) {
+                    size_t stop = pos + (size_t)match;
+                    for (size_t p = pos + 1; p < stop && p + 2 < band->end; p++) {
+                        deflate_insert(band, p);
+                    }
+                }
+                pos += (size_t)match;
+            } else {
+                band->sym_value[count] = band->data[pos];
+                band->sym_dist[count] = 0;
+                count++;
+                pos++;
+            }
+
+            if (count == DEFLATE_BLOCK_SYMBOLS) {
+                deflate_flush_block(band, count, block_start, pos - block_start, band->final && pos == band->end);
+                block_start = pos;
+                count = 0;
+            }
+        }
+
+        if (count > 0 || block_start == band->start) {
+            deflate_flush_block(band, count, block_start, pos - block_start, band->final);
+        } else if (band->final) {
+            deflate_write_stored(w, band->data, 0, 1);
+        }
+    }
+
+    if (!band->final) {
+        // Sync flush: empty stored block leaves the band byte-aligned for concatenation
+        deflate_write_stored(w, band->data, 0, 0);
+    } else if (band->level == 0 && len == 0) {
+        deflate_write_stored(w, band->data, 0, 1);
+    }
+    bw_align(w);
+}
+
+// Per-band worst case: stored blocks plus headers, alignment and the sync flush
+static size_t deflate_band_bound(size_t len) {
+    return len + 6 * (len / DEFLATE_STORED_MAX + len / DEFLATE_BLOCK_SYMBOLS + 2) + 32;
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Filter one row into out (without the filter-type byte)
+static void png_filter_row(int filter, const uint8_t *row, const uint8_t *prior, size_t row_bytes, uint8_t *out) {
+    const size_t bpp = 3;
+    switch (filter) {
+        case 0:
+            memcpy(out, row, row_bytes);
+            break;
+        case 1:
+            memcpy(out, row, bpp);
+            for (size_t i = bpp; i < row_bytes; i++) out[i] = (uint8_t)(row[i] - row[i - bpp]);
+            break;
+        case 2:
+            for (size_t i = 0; i < row_bytes; i++) out[i] = (uint8_t)(row[i] - prior[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < bpp; i++) out[i] = (uint8_t)(row[i] - (prior[i] >> 1));
+            for (size_t i = bpp; i < row_bytes; i++) out[i] = (uint8_t)(row[i] - ((row[i - bpp] + prior[i]) >> 1));
+            break;
+        default:
+            for (size_t i = 0; i < bpp; i++) out[i] = (uint8_t)(row[i] - prior[i]);
+            for (size_t i = bpp; i < row_bytes; i++) {
+                out[i] = (uint8_t)(row[i] - paeth(row[i - bpp], prior[i], prior[i - bpp]));
+            }
+            break;
+    }
+}
+
+// Minimum sum of absolute differences, the usual libpng/stb filter heuristic
+static uint32_t png_filter_cost(const uint8_t *out, size_t row_bytes) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < row_bytes; i++) {
+        sum += (uint32_t)abs((int8_t)out[i]);
+    }
+    return sum;
+}
+
+// Shared state for one encode; bands index into it from worker threads
+typedef struct {
+    const uint8_t *rgb;
+    uint32_t width;
+    uint32_t height;
+    size_t row_bytes;
+    int filter;
+    uint8_t *filtered;
+    uint8_t *zero_row;
+    uint8_t *trial_rows;        // PNG_FILTER_COUNT rows per band for the adaptive heuristic
+    uint32_t band_rows;
+    deflate_band_t bands[PNG_MAX_BANDS];
+} png_job_t;
+
+static void png_filter_band_task(void *arg, int index) {
+    png_job_t *job = (png_job_t*)arg;
+    uint32_t y0 = (uint32_t)index * job->band_rows;
+    uint32_t y1 = y0 + job->band_rows < job->height ? y0 + job->band_rows : job->height;
+    uint8_t *trial = job->trial_rows + (size_t)index * PNG_FILTER_COUNT * job->row_bytes;
+
+    for (uint32_t y = y0; y < y1; y++) {
+        const uint8_t *row = job->rgb + (size_t)y * job->row_bytes;
+        const uint8_t *prior = y > 0 ? row - job->row_bytes : job->zero_row;
+        uint8_t *out = job->filtered + (size_t)y * (job->row_bytes + 1);
+
+        if (job->filter != PNG_FILTER_ADAPTIVE) {
+            out[0] = (uint8_t)job->filter;
+            png_filter_row(job->filter, row, prior, job->row_bytes, out + 1);
+            continue;
+        }
+
+        int best = 0;
+        uint32_t best_cost = UINT32_MAX;
+        for (int f = 0; f < PNG_FILTER_COUNT; f++) {
+            uint8_t *candidate = trial + (size_t)f * job->row_bytes;
+            png_filter_row(f, row, prior, job->row_bytes, candidate);
+            uint32_t cost = png_filter_cost(candidate, job->row_bytes);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = f;
+            }
+        }
+        out[0] = (uint8_t)best;
+        memcpy(out + 1, trial + (size_t)best * job->row_bytes, job->row_bytes);
+    }
+}
+
+static void png_deflate_band_task(void *arg, int index) {
+    png_job_t *job = (png_job_t*)arg;
+    deflate_band(&job->bands[index]);
+}
+
+static uint8_t *png_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+    return p + 4;
+}
+
+// Encode tightly packed RGB24 pixels as PNG. All memory (scratch and the returned PNG)
+// comes from alloc, which the caller owns and releases wholesale.
+int png_encode_rgb24(const uint8_t *rgb, uint32_t width, uint32_t height, const png_encode_options_t *options,
+                     png_alloc_fn alloc, void *alloc_ctx, uint8_t **png, size_t *png_len) {
+    if (!rgb || !png || !png_len || !alloc || width == 0 || height == 0) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    png_encoder_tables_init();
+
+    int level = (options && options->level >= 0) ? options->level : PNG_DEFAULT_LEVEL;
+    int filter = (options && options->filter >= PNG_FILTER_ADAPTIVE) ? options->filter : PNG_DEFAULT_FILTER;
+    if (level > 9) level = 9;
+    if (filter > 4) filter = PNG_FILTER_ADAPTIVE;
+
+    png_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.rgb = rgb;
+    job.width = width;
+    job.height = height;
+    job.row_bytes = (size_t)width * 3;
+    job.filter = filter;
+
+    size_t filtered_len = (size_t)height * (job.row_bytes + 1);
+
+    // One band per available thread, but never bands so small their headers dominate
+    int band_count = (options && options->bands > 0) ? options->bands : worker_pool_size();
+    if ((size_t)band_count > filtered_len / PNG_MIN_BAND_BYTES) band_count = (int)(filtered_len / PNG_MIN_BAND_BYTES);
+    if (band_count > PNG_MAX_BANDS) band_count = PNG_MAX_BANDS;
+    if ((uint32_t)band_count > height) band_count = (int)height;
+    if (band_count < 1) band_count = 1;
+    job.band_rows = (height + (uint32_t)band_count - 1) / (uint32_t)band_count;
+    band_count = (int)((height + job.band_rows - 1) / job.band_rows);
+
+    // Hand out all memory up front - workers never allocate
+    job.filtered = alloc(alloc_ctx, filtered_len);
+    job.zero_row = alloc(alloc_ctx, job.row_bytes);
+    job.trial_rows = filter == PNG_FILTER_ADAPTIVE
+                   ? alloc(alloc_ctx, (size_t)band_count * PNG_FILTER_COUNT * job.row_bytes) : NULL;
+    if (!job.filtered || !job.zero_row || (filter == PNG_FILTER_ADAPTIVE && !job.trial_rows)) {
+        return TEST_ERROR_MEMORY;
+    }
+    memset(job.zero_row, 0, job.row_bytes);
+
+    for (int i = 0; i < band_count; i++) {
+        deflate_band_t *band = &job.bands[i];
+        uint32_t y0 = (uint32_t)i * job.band_rows;
+        uint32_t y1 = y0 + job.band_rows < height ? y0 + job.band_rows : height;
+
+        band->data = job.filtered;
+        band->start = (size_t)y0 * (job.row_bytes + 1);
+        band->end = (size_t)y1 * (job.row_bytes + 1);
+        band->window_start = band->start > DEFLATE_WINDOW ? band->start - DEFLATE_WINDOW : 0;
+        band->level = level;
+        band->final = (i == band_count - 1);
+        band->out_cap = deflate_band_bound(band->end - band->start);
+        band->writer.out = alloc(alloc_ctx, band->out_cap);
+
+        if (level > 0) {
+            band->head = alloc(alloc_ctx, sizeof(int32_t) * DEFLATE_HASH_SIZE);
+            band->prev = alloc(alloc_ctx, sizeof(int32_t) * DEFLATE_WINDOW);
+            band->sym_value = alloc(alloc_ctx, sizeof(uint16_t) * DEFLATE_BLOCK_SYMBOLS);
+            band->sym_dist = alloc(alloc_ctx, sizeof(uint16_t) * DEFLATE_BLOCK_SYMBOLS);
+            if (!band->head || !band->prev || !band->sym_value || !band->sym_dist) {
+                return TEST_ERROR_MEMORY;
+            }
+        }
+        if (!band->writer.out) {
+            return TEST_ERROR_MEMORY;
+        }
+    }
+
+    // Filtering must finish everywhere before deflate: bands read their predecessor's tail
+    worker_pool_run(png_filter_band_task, &job, band_count);
+    worker_pool_run(png_deflate_band_task, &job, band_count);
+
+    size_t idat_len = 2 + 4;
+    uint32_t adler = job.bands[0].adler;
+    for (int i = 0; i < band_count; i++) {
+        idat_len += job.bands[i].writer.pos;
+        if (i > 0) {
+            adler = adler32_combine(adler, job.bands[i].adler, job.bands[i].end - job.bands[i].start);
+        }
+    }
+
+    size_t total = 8 + (12 + 13) + (12 + idat_len) + 12;
+    uint8_t *out = alloc(alloc_ctx, total);
+    if (!out) {
+        return TEST_ERROR_MEMORY;
+    }
+
+    static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    uint8_t *p = out;
+    memcpy(p, signature, 8);
+    p += 8;
+
+    // IHDR: 8-bit truecolor, no interlace
+    p = png_put_u32(p, 13);
+    uint8_t *chunk = p;
+    memcpy(p, "IHDR", 4);
+    p += 4;
+    p = png_put_u32(p, width);
+    p = png_put_u32(p, height);
+    *p++ = 8;
+    *p++ = 2;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    p = png_put_u32(p, png_crc32(0, chunk, (size_t)(p - chunk)));
+
+    // IDAT: zlib header, concatenated bands, combined Adler-32
+    p = png_put_u32(p, (uint32_t)idat_len);
+    chunk = p;
+    memcpy(p, "IDAT", 4);
+    p += 4;
+    *p++ = 0x78;
+    *p++ = level == 0 ? 0x01 : level < 6 ? 0x5E : level == 6 ? 0x9C : 0xDA;
+    for (int i = 0; i < band_count; i++) {
+        memcpy(p, job.bands[i].writer.out, job.bands[i].writer.pos);
+        p += job.bands[i].writer.pos;
+    }
+    p = png_put_u32(p, adler);
+    p = png_put_u32(p, png_crc32(0, chunk, (size_t)(p - chunk)));
+
+    p = png_put_u32(p, 0);
+    chunk = p;
+    memcpy(p, "IEND", 4);
+    p += 4;
+    p = png_put_u32(p, png_crc32(0, chunk, 4));
+
+    *png = out;
+    *png_len = (size_t)(p - out);
+    return TEST_OK;
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "test_harness.h"
+
+// QOI ("Quite OK Image") encoder and decoder, https://qoiformat.org/qoi-specification.pdf
+// Single pass, no entropy coding: runs, a 64-entry color cache and small deltas to the
+// previous pixel. Flat UI content compresses close to PNG at a fraction of the cost.
+#define QOI_OP_INDEX 0x00   // 00xxxxxx
+#define QOI_OP_DIFF 0x40    // 01xxxxxx
+#define QOI_OP_LUMA 0x80    // 10xxxxxx
+#define QOI_OP_RUN 0xC0     // 11xxxxxx
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK_2 0xC0
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_MAX_RUN 62
+#define QOI_MAX_PIXELS 400000000u   // same guard as the reference implementation
+
+static const uint8_t qoi_padding[QOI_PADDING_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+typedef union {
+    struct { uint8_t r, g, b, a; } rgba;
+    uint32_t v;
+} qoi_rgba_t;
+
+static inline unsigned qoi_hash(qoi_rgba_t px) {
+    return (px.rgba.r * 3u + px.rgba.g * 5u + px.rgba.b * 7u + px.rgba.a * 11u) % 64u;
+}
+
+static uint8_t *qoi_write32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+    return p + 4;
+}
+
+static uint32_t qoi_read32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+size_t qoi_encode_bound(uint32_t width, uint32_t height, int channels) {
+    return (size_t)width * height * (size_t)(channels + 1) + QOI_HEADER_SIZE + QOI_PADDING_SIZE;
+}
+
+// Encode tightly packed RGB (channels 3) or RGBA (channels 4) pixels; returns the encoded
+// size, or 0 on bad parameters or if dst is smaller than qoi_encode_bound()
+size_t qoi_encode(const uint8_t *pixels, uint32_t width, uint32_t height, int channels,
+                  uint8_t *dst, size_t dst_cap) {
+    if (!pixels || !dst || width == 0 || height == 0 || (channels != 3 && channels != 4) ||
+        height >= QOI_MAX_PIXELS / width || dst_cap < qoi_encode_bound(width, height, channels)) {
+        return 0;
+    }
+
+    uint8_t *op = dst;
+    memcpy(op, "qoif", 4);
+    op = qoi_write32(op + 4, width);
+    op = qoi_write32(op, height);
+    *op++ = (uint8_t)channels;
+    *op++ = 0; // sRGB with linear alpha
+
+    qoi_rgba_t index[64];
+    memset(index, 0, sizeof(index));
+
+    qoi_rgba_t prev, px;
+    prev.v = 0;
+    prev.rgba.a = 255;
+    px = prev;
+
+    const size_t total = (size_t)width * height * (size_t)channels;
+    const size_t last = total - (size_t)channels;
+    int run = 0;
+
+    for (size_t pos = 0; pos < total; pos += (size_t)channels) {
+        px.rgba.r = pixels[pos];
+        px.rgba.g = pixels[pos + 1];
+        px.rgba.b = pixels[pos + 2];
+        if (channels == 4) {
+            px.rgba.a = pixels[pos + 3];
+        }
+
+        if (px.v == prev.v) {
+            if (++run == QOI_MAX_RUN || pos == last) {
+                *op++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0) {
+            *op++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        unsigned slot = qoi_hash(px);
+        if (index[slot].v == px.v) {
+            *op++ = (uint8_t)(QOI_OP_INDEX | slot);
+        } else {
+            index[slot] = px;
+
+            if (px.rgba.a == prev.rgba.a) {
+                int8_t vr = (int8_t)(px.rgba.r - prev.rgba.r);
+                int8_t vg = (int8_t)(px.rgba.g - prev.rgba.g);
+                int8_t vb = (int8_t)(px.rgba.b - prev.rgba.b);
+                int8_t vg_r = (int8_t)(vr - vg);
+                int8_t vg_b = (int8_t)(vb - vg);
+
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    *op++ = (uint8_t)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                    *op++ = (uint8_t)(QOI_OP_LUMA | (vg + 32));
+                    *op++ = (uint8_t)((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    *op++ = QOI_OP_RGB;
+                    *op++ = px.rgba.r;
+                    *op++ = px.rgba.g;
+                    *op++ = px.rgba.b;
+                }
+            } else {
+                *op++ = QOI_OP_RGBA;
+                *op++ = px.rgba.r;
+                *op++ = px.rgba.g;
+                *op++ = px.rgba.b;
+                *op++ = px.rgba.a;
+            }
+        }
+        prev = px;
+    }
+
+    memcpy(op, qoi_padding, QOI_PADDING_SIZE);
+    op += QOI_PADDING_SIZE;
+    return (size_t)(op - dst);
+}
+
+// Read width/height/channels from a QOI header without decoding
+int qoi_read_header(const uint8_t *data, size_t len, uint32_t *width, uint32_t *height, int *channels) {
+    if (!data || len < QOI_HEADER_SIZE + QOI_PADDING_SIZE || memcmp(data, "qoif", 4) != 0) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t w = qoi_read32(data + 4);
+    uint32_t h = qoi_read32(data + 8);
+    int ch = data[12];
+    if (w == 0 || h == 0 || (ch != 3 && ch != 4) || h >= QOI_MAX_PIXELS / w) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    if (width) *width = w;
+    if (height) *height = h;
+    if (channels) *channels = ch;
+    return TEST_OK;
+}
+
+// Decode into dst as RGB (channels 3) or RGBA (channels 4), independent of the file's own
+// channel count. dst must hold width * height * channels bytes.
+int qoi_decode(const uint8_t *data, size_t len, int channels, uint8_t *dst, size_t dst_cap) {
+    uint32_t width, height;
+    if (qoi_read_header(data, len, &width, &height, NULL) != TEST_OK || (channels != 3 && channels != 4)) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    const size_t total = (size_t)width * height * (size_t)channels;
+    if (!dst || dst_cap < total) {
+        return TEST_ERROR_MEMORY;
+    }
+
+    qoi_rgba_t index[64];
+    memset(index, 0, sizeof(index));
+
+    qoi_rgba_t px;
+    px.v = 0;
+    px.rgba.a = 255;
+
+    const uint8_t *ip = data + QOI_HEADER_SIZE;
+    const uint8_t *chunks_end = data + len - QOI_PADDING_SIZE;
+    int run = 0;
+
+    for (size_t pos = 0; pos < total; pos += (size_t)channels) {
+        if (run > 0) {
+            run--;
+        } else if (ip < chunks_end) {
+            uint8_t b1 = *ip++;
+
+            if (b1 == QOI_OP_RGB) {
+                if (chunks_end - ip < 3) return TEST_ERROR_INVALID_PARAM;
+                px.rgba.r = ip[0];
+                px.rgba.g = ip[1];
+                px.rgba.b = ip[2];
+                ip += 3;
+            } else if (b1 == QOI_OP_RGBA) {
+                if (chunks_end - ip < 4) return TEST_ERROR_INVALID_PARAM;
+                px.rgba.r = ip[0];
+                px.rgba.g = ip[1];
+                px.rgba.b = ip[2];
+                px.rgba.a = ip[3];
+                ip += 4;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                px = index[b1];
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                px.rgba.r = (uint8_t)(px.rgba.r + ((b1 >> 4) & 0x03) - 2);
+                px.rgba.g = (uint8_t)(px.rgba.g + ((b1 >> 2) & 0x03) - 2);
+                px.rgba.b = (uint8_t)(px.rgba.b + (b1 & 0x03) - 2);
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                if (ip >= chunks_end) return TEST_ERROR_INVALID_PARAM;
+                uint8_t b2 = *ip++;
+                int vg = (b1 & 0x3F) - 32;
+                px.rgba.r = (uint8_t)(px.rgba.r + vg - 8 + ((b2 >> 4) & 0x0F));
+                px.rgba.g = (uint8_t)(px.rgba.g + vg);
+                px.rgba.b = (uint8_t)(px.rgba.b + vg - 8 + (b2 & 0x0F));
+            } else {
+                run = b1 & 0x3F;
+            }
+
+            index[qoi_hash(px)] = px;
+        } else {
+            return TEST_ERROR_INVALID_PARAM; // truncated stream
+        }
+
+        dst[pos] = px.rgba.r;
+        dst[pos + 1] = px.rgba.g;
+        dst[pos + 2] = px.rgba.b;
+        if (channels == 4) {
+            dst[pos + 3] = px.rgba.a;
+        }
+    }
+
+    return TEST_OK;
+}
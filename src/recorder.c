@@ -0,0 +1,978 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+    #include <direct.h>
+    typedef CRITICAL_SECTION rec_mutex_t;
+    typedef CONDITION_VARIABLE rec_cond_t;
+    typedef HANDLE rec_thread_t;
+    #define REC_MUTEX_INIT(m) InitializeCriticalSection(m)
+    #define REC_MUTEX_DESTROY(m) DeleteCriticalSection(m)
+    #define REC_LOCK(m) EnterCriticalSection(m)
+    #define REC_UNLOCK(m) LeaveCriticalSection(m)
+    #define REC_COND_INIT(c) InitializeConditionVariable(c)
+    #define REC_COND_DESTROY(c) ((void)0)
+    #define REC_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+    #define REC_SIGNAL(c) WakeConditionVariable(c)
+    #define rec_mkdir(dir) _mkdir(dir)
+    #define rec_fullpath(path, out, len) (_fullpath(out, path, len) != NULL)
+#else
+    #include <pthread.h>
+    #include <limits.h>
+    #include <sys/stat.h>
+    typedef pthread_mutex_t rec_mutex_t;
+    typedef pthread_cond_t rec_cond_t;
+    typedef pthread_t rec_thread_t;
+    #define REC_MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+    #define REC_MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+    #define REC_LOCK(m) pthread_mutex_lock(m)
+    #define REC_UNLOCK(m) pthread_mutex_unlock(m)
+    #define REC_COND_INIT(c) pthread_cond_init(c, NULL)
+    #define REC_COND_DESTROY(c) pthread_cond_destroy(c)
+    #define REC_WAIT(c, m) pthread_cond_wait(c, m)
+    #define REC_SIGNAL(c) pthread_cond_signal(c)
+    #define rec_mkdir(dir) mkdir(dir, 0755)
+    static int rec_fullpath(const char *path, char *out, size_t len) {
+        char resolved[PATH_MAX];
+        return realpath(path, resolved) && (size_t)snprintf(out, len, "%s", resolved) < len;
+    }
+#endif
+
+#include "test_harness.h"
+
+// Session recordings (.lvrec), written front to back so a recording cut short by a crash can
+// still be read by scanning its frame records; all integers little-endian.
+//
+//   file header   32 bytes, rec_file_header_t
+//   frame record  rec_frame_header_t, the command text, then rect_count rectangles:
+//                 rec_rect_header_t + len bytes (LZ4 block of the rectangle's tightly packed
+//                 native pixels, or the pixels themselves when len == raw_len)
+//   index         "INDX", frame count, one rec_index_entry_t per frame     (written on stop)
+//   trailer       16 bytes, rec_trailer_t: where the index starts          (written on stop)
+//
+// Frames are copied off the LVGL thread right after each refresh that flushed pixels. A writer
+// thread diffs each frame against the previous one in tiles and stores only the changed
+// rectangles, with a full keyframe every REC_KEYFRAME_INTERVAL frames for seeking.
+#define REC_DIR_DEFAULT "recordings"
+#define REC_PATH_MAX 512
+#define REC_VERSION 1
+#define REC_MAX_PENDING 8
+#define REC_KEYFRAME_INTERVAL 60
+#define REC_COMMAND_MAX 256
+
+#define REC_FILE_MAGIC 0x4352564Cu      // "LVRC"
+#define REC_FRAME_MAGIC 0x4D415246u     // "FRAM"
+#define REC_INDEX_MAGIC 0x58444E49u     // "INDX"
+#define REC_TRAILER_MAGIC 0x4552564Cu   // "LVRE"
+#define REC_FLAG_KEYFRAME 0x01
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fps;                 // requested rate, 0 = every flushed frame
+    uint32_t keyframe_interval;
+    uint64_t start_unix_us;
+    uint64_t reserved;
+} rec_file_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t index;
+    uint64_t timestamp_us;        // since record_start
+    uint32_t frame_version;
+    uint32_t payload_len;         // rectangle headers and data after the command text
+    uint16_t width;
+    uint16_t height;
+    uint16_t rect_count;
+    uint16_t command_len;
+    uint8_t format;               // SCREENSHOT_FORMAT_RGB565 or SCREENSHOT_FORMAT_ARGB8888
+    uint8_t flags;
+    uint8_t reserved[6];
+} rec_frame_header_t;
+
+typedef struct {
+    uint16_t x, y, w, h;
+    uint32_t len;
+    uint32_t raw_len;
+} rec_rect_header_t;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t timestamp_us;
+    uint32_t flags;
+    uint32_t frame_version;
+} rec_index_entry_t;
+
+typedef struct {
+    uint64_t index_offset;
+    uint32_t frame_count;
+    uint32_t magic;
+} rec_trailer_t;
+
+// Frame copied on the LVGL thread, waiting for the writer. The buffer stays with the slot.
+typedef struct {
+    uint8_t *pixels;
+    size_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    screenshot_format_t format;
+    uint64_t timestamp_us;
+    uint32_t frame_version;
+    char command[REC_COMMAND_MAX];
+} rec_slot_t;
+
+// One recorder per session, recording that session's display
+typedef struct {
+    int initialized;
+    volatile int active;
+    rec_mutex_t lock;
+    rec_cond_t frame_ready;
+
+    // Recording in progress
+    char path[REC_PATH_MAX];
+    FILE *file;
+    uint32_t fps;
+    uint64_t start_us;
+    uint64_t last_capture_us;
+    uint32_t dropped;
+    char command[REC_COMMAND_MAX];    // last command received, guarded by lock
+
+    // Copied frames, oldest at head; the writer removes a slot only after encoding it
+    rec_slot_t slots[REC_MAX_PENDING];
+    int slot_head;
+    int slot_count;
+    int stopping;
+    rec_thread_t writer;
+    int writer_running;
+
+    // Writer-only state
+    uint8_t *previous;
+    size_t previous_size;
+    uint32_t previous_width;
+    uint32_t previous_height;
+    screenshot_format_t previous_format;
+    int have_previous;
+    uint32_t since_keyframe;
+    uint8_t *scratch;
+    size_t scratch_size;
+    uint8_t *payload;
+    size_t payload_size;
+    rec_index_entry_t *index;
+    uint32_t index_count;
+    uint32_t index_cap;
+    uint64_t offset;
+    int write_failed;
+    screenshot_rect_t rects[MAX_DELTA_RECTS];
+} rec_recorder_t;
+
+static rec_recorder_t recorders[MAX_SESSIONS];
+
+// Flight recorder: the most recent frames kept in memory, in the same frame record layout as
+// .lvrec files. Records live back to back in one ring buffer of LVGL_HISTORY_MB per session; the
+// oldest are evicted a whole keyframe group at a time, so the history always starts with a keyframe.
+#define HISTORY_BUDGET_MB_DEFAULT 8
+#define HISTORY_MAX_FRAMES 1024
+#define HISTORY_KEYFRAME_INTERVAL 30
+
+typedef struct {
+    size_t offset;
+    size_t size;
+    uint64_t unix_us;
+    int keyframe;
+} rec_history_entry_t;
+
+typedef struct {
+    size_t budget;                    // 0 = disabled or session not open
+    rec_mutex_t lock;
+    rec_cond_t idle;                  // signalled when encoding drops to 0
+
+    // Ring of frame records, oldest at first; guarded by lock
+    uint8_t *ring;
+    rec_history_entry_t entries[HISTORY_MAX_FRAMES];
+    uint32_t first;
+    uint32_t count;
+    uint32_t evicted;
+    uint32_t coalesced;
+
+    // A frame being encoded on the worker pool, and the newest frame waiting behind it.
+    // Frames arriving while one is waiting replace it; the latest frame is always kept.
+    int encoding;
+    rec_slot_t staging;
+    rec_slot_t pending;
+    int pending_valid;
+
+    // Encoder-only state
+    rec_slot_t reference;
+    int have_reference;
+    uint32_t since_keyframe;
+    uint8_t *scratch;
+    size_t scratch_size;
+    uint8_t *record;
+    size_t record_size;
+    screenshot_rect_t rects[MAX_DELTA_RECTS];
+} rec_history_t;
+
+static struct {
+    int initialized;
+    size_t budget;                    // LVGL_HISTORY_MB in bytes, 0 = disabled
+    rec_history_t sessions[MAX_SESSIONS];
+} histories = {0};
+
+static uint64_t recorder_now_us(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static int recorder_reserve(uint8_t **buffer, size_t *size, size_t needed) {
+    if (needed <= *size) {
+        return TEST_OK;
+    }
+    uint8_t *grown = realloc(*buffer, needed);
+    if (!grown) {
+        return TEST_ERROR_MEMORY;
+    }
+    *buffer = grown;
+    *size = needed;
+    return TEST_OK;
+}
+
+// Copy a frame's rows tightly packed into a slot, tagged with the last command the session received
+static int rec_copy_frame(rec_recorder_t *rec, rec_slot_t *slot, const uint8_t *pixels, uint32_t stride, uint32_t width, uint32_t height,
+                          screenshot_format_t format, uint64_t timestamp_us, uint32_t frame_version) {
+    uint32_t bpp = format == SCREENSHOT_FORMAT_RGB565 ? 2 : 4;
+    size_t row_bytes = (size_t)width * bpp;
+    if (recorder_reserve(&slot->pixels, &slot->size, row_bytes * height) != TEST_OK) {
+        return TEST_ERROR_MEMORY;
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(slot->pixels + (size_t)y * row_bytes, pixels + (size_t)y * stride, row_bytes);
+    }
+    slot->width = width;
+    slot->height = height;
+    slot->bpp = bpp;
+    slot->format = format;
+    slot->timestamp_us = timestamp_us;
+    slot->frame_version = frame_version;
+
+    REC_LOCK(&rec->lock);
+    memcpy(slot->command, rec->command, sizeof(slot->command));
+    REC_UNLOCK(&rec->lock);
+    return TEST_OK;
+}
+
+// Append rec_rect_header_t + data for each rectangle of the slot's frame to payload at *used.
+// Rectangles are gathered into scratch row by row, then LZ4-packed into the payload.
+static int rec_pack_rects(const rec_slot_t *slot, const screenshot_rect_t *rects, int count,
+                          uint8_t **payload, size_t *payload_size, uint8_t **scratch, size_t *scratch_size,
+                          size_t *used) {
+    uint32_t stride = slot->width * slot->bpp;
+    for (int i = 0; i < count; i++) {
+        const screenshot_rect_t *rect = &rects[i];
+        size_t row_bytes = (size_t)rect->w * slot->bpp;
+        size_t raw_len = row_bytes * (size_t)rect->h;
+        size_t bound = lz4_compress_bound(raw_len);
+        if (recorder_reserve(scratch, scratch_size, raw_len) != TEST_OK ||
+            recorder_reserve(payload, payload_size, *used + sizeof(rec_rect_header_t) + bound) != TEST_OK) {
+            return TEST_ERROR_MEMORY;
+        }
+
+        const uint8_t *src = slot->pixels + (size_t)rect->y * stride + (size_t)rect->x * slot->bpp;
+        for (int y = 0; y < rect->h; y++) {
+            memcpy(*scratch + (size_t)y * row_bytes, src + (size_t)y * stride, row_bytes);
+        }
+
+        uint8_t *data = *payload + *used + sizeof(rec_rect_header_t);
+        size_t len = lz4_compress_block(*scratch, raw_len, data, bound);
+        if (len == 0 || len >= raw_len) {
+            memcpy(data, *scratch, raw_len);
+            len = raw_len;
+        }
+
+        rec_rect_header_t header = { (uint16_t)rect->x, (uint16_t)rect->y, (uint16_t)rect->w, (uint16_t)rect->h,
+                                     (uint32_t)len, (uint32_t)raw_len };
+        memcpy(*payload + *used, &header, sizeof(header));
+        *used += sizeof(header) + len;
+    }
+    return TEST_OK;
+}
+
+static void rec_frame_header_init(rec_frame_header_t *header, const rec_slot_t *slot, uint32_t index,
+                                  size_t payload_len, int rect_count, size_t command_len, int keyframe) {
+    memset(header, 0, sizeof(*header));
+    header->magic = REC_FRAME_MAGIC;
+    header->index = index;
+    header->timestamp_us = slot->timestamp_us;
+    header->frame_version = slot->frame_version;
+    header->payload_len = (uint32_t)payload_len;
+    header->width = (uint16_t)slot->width;
+    header->height = (uint16_t)slot->height;
+    header->rect_count = (uint16_t)rect_count;
+    header->command_len = (uint16_t)command_len;
+    header->format = (uint8_t)slot->format;
+    header->flags = keyframe ? REC_FLAG_KEYFRAME : 0;
+}
+
+// Full-frame rectangle for keyframes
+static int rec_full_rect(screenshot_rect_t *rects, const rec_slot_t *slot) {
+    rects[0].x = 0;
+    rects[0].y = 0;
+    rects[0].w = (int)slot->width;
+    rects[0].h = (int)slot->height;
+    return 1;
+}
+
+static void recorder_count_drop(rec_recorder_t *rec) {
+    REC_LOCK(&rec->lock);
+    rec->dropped++;
+    REC_UNLOCK(&rec->lock);
+}
+
+static void recorder_write(rec_recorder_t *rec, const void *data, size_t len) {
+    if (!rec->write_failed && len > 0 && fwrite(data, 1, len, rec->file) != len) {
+        printf("Failed to write recording %s\n", rec->path);
+        rec->write_failed = 1;
+    }
+    rec->offset += len;
+}
+
+// Encode one copied frame as a keyframe or the rectangles changed since the previous frame
+static void recorder_encode(rec_recorder_t *rec, rec_slot_t *slot) {
+    uint32_t stride = slot->width * slot->bpp;
+    int keyframe = !rec->have_previous || rec->since_keyframe >= REC_KEYFRAME_INTERVAL ||
+                   rec->previous_width != slot->width || rec->previous_height != slot->height ||
+                   rec->previous_format != slot->format;
+    int count = keyframe ? -1 : screenshot_diff_tiles(slot->pixels, rec->previous, stride, slot->width,
+                                                      slot->height, slot->bpp, rec->rects, MAX_DELTA_RECTS);
+    if (count < 0) {
+        keyframe = 1;
+        count = rec_full_rect(rec->rects, slot);
+    }
+
+    size_t used = 0;
+    if (rec_pack_rects(slot, rec->rects, count, &rec->payload, &rec->payload_size,
+                       &rec->scratch, &rec->scratch_size, &used) != TEST_OK) {
+        printf("Out of memory encoding recording frame - frame skipped\n");
+        recorder_count_drop(rec);
+        return;
+    }
+
+    if (rec->index_count == rec->index_cap) {
+        uint32_t new_cap = rec->index_cap ? rec->index_cap * 2 : 256;
+        rec_index_entry_t *grown = realloc(rec->index, (size_t)new_cap * sizeof(*grown));
+        if (!grown) {
+            recorder_count_drop(rec);
+            return;
+        }
+        rec->index = grown;
+        rec->index_cap = new_cap;
+    }
+    rec_index_entry_t *entry = &rec->index[rec->index_count];
+    entry->offset = rec->offset;
+    entry->timestamp_us = slot->timestamp_us;
+    entry->flags = keyframe ? REC_FLAG_KEYFRAME : 0;
+    entry->frame_version = slot->frame_version;
+
+    size_t command_len = strlen(slot->command);
+    rec_frame_header_t header;
+    rec_frame_header_init(&header, slot, rec->index_count, used, count, command_len, keyframe);
+    recorder_write(rec, &header, sizeof(header));
+    recorder_write(rec, slot->command, command_len);
+    recorder_write(rec, rec->payload, used);
+    rec->index_count++;
+    rec->since_keyframe = keyframe ? 1 : rec->since_keyframe + 1;
+
+    // This frame is the next one's reference; its old buffer goes back to the slot
+    uint8_t *pixels = rec->previous;
+    size_t size = rec->previous_size;
+    rec->previous = slot->pixels;
+    rec->previous_size = slot->size;
+    rec->previous_width = slot->width;
+    rec->previous_height = slot->height;
+    rec->previous_format = slot->format;
+    rec->have_previous = 1;
+    slot->pixels = pixels;
+    slot->size = size;
+}
+
+#ifdef _WIN32
+static unsigned __stdcall recorder_writer_thread(void *arg) {
+#else
+static void *recorder_writer_thread(void *arg) {
+#endif
+    rec_recorder_t *rec = arg;
+
+    REC_LOCK(&rec->lock);
+    for (;;) {
+        while (rec->slot_count == 0 && !rec->stopping) {
+            REC_WAIT(&rec->frame_ready, &rec->lock);
+        }
+        if (rec->slot_count == 0) {
+            break; // stopping with every copied frame written
+        }
+
+        rec_slot_t *slot = &rec->slots[rec->slot_head];
+        REC_UNLOCK(&rec->lock);
+        recorder_encode(rec, slot);
+        REC_LOCK(&rec->lock);
+
+        rec->slot_head = (rec->slot_head + 1) % REC_MAX_PENDING;
+        rec->slot_count--;
+    }
+    REC_UNLOCK(&rec->lock);
+    return 0;
+}
+
+static void recorder_init(void) {
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        rec_recorder_t *rec = &recorders[i];
+        if (!rec->initialized) {
+            REC_MUTEX_INIT(&rec->lock);
+            REC_COND_INIT(&rec->frame_ready);
+            rec->initialized = 1;
+        }
+    }
+}
+
+// Start recording a session's display into <LVGL_RECORD_DIR>/<name>.lvrec. fps limits the
+// frame rate; 0 records every refresh that flushed pixels. path (optional) receives the file's path.
+int recorder_start(int session, const char *name, uint32_t fps, char *path, size_t path_len) {
+    if (!baseline_name_valid(name) || session < 0 || session >= MAX_SESSIONS) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    recorder_init();
+    rec_recorder_t *rec = &recorders[session];
+    if (rec->active || rec->writer_running) {
+        return TEST_ERROR_BUSY;
+    }
+
+    const char *dir = getenv("LVGL_RECORD_DIR");
+    if (!dir || !*dir) {
+        dir = REC_DIR_DEFAULT;
+    }
+    rec_mkdir(dir);   // fails harmlessly when it already exists
+    snprintf(rec->path, sizeof(rec->path), "%s/%s.lvrec", dir, name);
+
+    rec->file = fopen(rec->path, "wb");
+    if (!rec->file) {
+        printf("Failed to create recording %s\n", rec->path);
+        return TEST_ERROR_IO;
+    }
+
+    // Report an absolute path so clients in another working directory can open the file
+    char full[REC_PATH_MAX];
+    if (rec_fullpath(rec->path, full, sizeof(full))) {
+        memcpy(rec->path, full, sizeof(full));
+    }
+
+    rec->fps = fps;
+    rec->start_us = recorder_now_us();
+    rec->last_capture_us = 0;
+    rec->dropped = 0;
+    rec->offset = 0;
+    rec->write_failed = 0;
+    rec->index_count = 0;
+    rec->have_previous = 0;
+    rec->since_keyframe = 0;
+    rec->slot_head = 0;
+    rec->slot_count = 0;
+    rec->stopping = 0;
+
+    rec_file_header_t header = { REC_FILE_MAGIC, REC_VERSION, fps, REC_KEYFRAME_INTERVAL, rec->start_us, 0 };
+    recorder_write(rec, &header, sizeof(header));
+
+#ifdef _WIN32
+    rec->writer = (HANDLE)_beginthreadex(NULL, 0, recorder_writer_thread, rec, 0, NULL);
+    rec->writer_running = (rec->writer != 0);
+#else
+    rec->writer_running = (pthread_create(&rec->writer, NULL, recorder_writer_thread, rec) == 0);
+#endif
+    if (!rec->writer_running) {
+        printf("Failed to start recording writer thread\n");
+        fclose(rec->file);
+        rec->file = NULL;
+        remove(rec->path);
+        return TEST_ERROR_MEMORY;
+    }
+
+    rec->active = 1;
+    if (path && path_len > 0) {
+        snprintf(path, path_len, "%s", rec->path);
+    }
+    printf("Recording session %d to %s (%s)\n", session, rec->path, fps ? "fixed fps" : "every flushed frame");
+    return TEST_OK;
+}
+
+// Stop a session's recording: write out the queued frames, then the index and trailer
+int recorder_stop(int session, recorder_stats_t *stats) {
+    if (session < 0 || session >= MAX_SESSIONS) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    rec_recorder_t *rec = &recorders[session];
+    if (!rec->initialized || !rec->writer_running) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+
+    rec->active = 0;
+    REC_LOCK(&rec->lock);
+    rec->stopping = 1;
+    REC_SIGNAL(&rec->frame_ready);
+    REC_UNLOCK(&rec->lock);
+#ifdef _WIN32
+    WaitForSingleObject(rec->writer, INFINITE);
+    CloseHandle(rec->writer);
+#else
+    pthread_join(rec->writer, NULL);
+#endif
+    rec->writer_running = 0;
+
+    uint64_t index_offset = rec->offset;
+    uint32_t index_header[2] = { REC_INDEX_MAGIC, rec->index_count };
+    recorder_write(rec, index_header, sizeof(index_header));
+    recorder_write(rec, rec->index, (size_t)rec->index_count * sizeof(rec_index_entry_t));
+    rec_trailer_t trailer = { index_offset, rec->index_count, REC_TRAILER_MAGIC };
+    recorder_write(rec, &trailer, sizeof(trailer));
+    if (fclose(rec->file) != 0) {
+        rec->write_failed = 1;
+    }
+    rec->file = NULL;
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        snprintf(stats->path, sizeof(stats->path), "%s", rec->path);
+        stats->frames = rec->index_count;
+        REC_LOCK(&rec->lock);
+        stats->dropped = rec->dropped;
+        REC_UNLOCK(&rec->lock);
+        stats->bytes = rec->offset;
+        stats->duration_ms = (uint32_t)((recorder_now_us() - rec->start_us) / 1000u);
+    }
+    printf("Recording %s stopped: %u frames, %u dropped, %llu bytes\n", rec->path, rec->index_count,
+           rec->dropped, (unsigned long long)rec->offset);
+    return rec->write_failed ? TEST_ERROR_IO : TEST_OK;
+}
+
+int recorder_active(int session) {
+    return session >= 0 && session < MAX_SESSIONS && recorders[session].active;
+}
+
+// Remember the command line a session is processing; its frames are tagged with the latest one
+void recorder_note_command(int session, const char *command, size_t len) {
+    if (session < 0 || session >= MAX_SESSIONS) {
+        return;
+    }
+    rec_recorder_t *rec = &recorders[session];
+    if (!rec->initialized || (!rec->active && !histories.sessions[session].budget)) {
+        return;
+    }
+    if (len >= REC_COMMAND_MAX) {
+        len = REC_COMMAND_MAX - 1;
+    }
+    REC_LOCK(&rec->lock);
+    memcpy(rec->command, command, len);
+    rec->command[len] = '\0';
+    REC_UNLOCK(&rec->lock);
+}
+
+// Called on the LVGL thread after a refresh of the session's display flushed pixels: copy the
+// whole frame into a free slot for the writer. Frames arriving while every slot is taken are
+// dropped and counted.
+void recorder_capture(int session, const uint8_t *pixels, uint32_t stride, uint32_t width, uint32_t height,
+                      screenshot_format_t format, uint32_t frame_version) {
+    if (!recorder_active(session) || !pixels || width == 0 || height == 0) {
+        return;
+    }
+    rec_recorder_t *rec = &recorders[session];
+
+    uint64_t now = recorder_now_us();
+    if (rec->fps && rec->last_capture_us &&
+        now - rec->last_capture_us < 1000000u / rec->fps) {
+        return;
+    }
+
+    REC_LOCK(&rec->lock);
+    if (rec->slot_count == REC_MAX_PENDING) {
+        rec->dropped++;
+        REC_UNLOCK(&rec->lock);
+        return;
+    }
+    rec_slot_t *slot = &rec->slots[(rec->slot_head + rec->slot_count) % REC_MAX_PENDING];
+    REC_UNLOCK(&rec->lock);
+
+    // Only this thread adds slots, so the slot stays ours until it is published below
+    if (rec_copy_frame(rec, slot, pixels, stride, width, height, format, now - rec->start_us,
+                       frame_version) != TEST_OK) {
+        recorder_count_drop(rec);
+        return;
+    }
+    rec->last_capture_us = now;
+
+    REC_LOCK(&rec->lock);
+    if (!rec->stopping) {
+        rec->slot_count++;
+        REC_SIGNAL(&rec->frame_ready);
+    }
+    REC_UNLOCK(&rec->lock);
+}
+
+// Finish recordings left running at shutdown and release all buffers
+void recorder_cleanup(void) {
+    for (int session = 0; session < MAX_SESSIONS; session++) {
+        rec_recorder_t *rec = &recorders[session];
+        if (!rec->initialized) {
+            continue;
+        }
+        if (rec->writer_running) {
+            recorder_stop(session, NULL);
+        }
+
+        for (int i = 0; i < REC_MAX_PENDING; i++) {
+            free(rec->slots[i].pixels);
+        }
+        free(rec->previous);
+        free(rec->scratch);
+        free(rec->payload);
+        free(rec->index);
+        REC_COND_DESTROY(&rec->frame_ready);
+        REC_MUTEX_DESTROY(&rec->lock);
+        memset(rec, 0, sizeof(*rec));
+    }
+}
+
+// Evict the oldest frame; called with the history's lock held
+static void history_evict(rec_history_t *hist) {
+    hist->first = (hist->first + 1) % HISTORY_MAX_FRAMES;
+    hist->count--;
+    hist->evicted++;
+}
+
+// Store one encoded frame record, evicting the oldest frames to make room; called with the
+// history's lock held. A delta whose keyframe had to be evicted returns TEST_ERROR_NOT_FOUND
+// and must be re-encoded as a keyframe.
+static int history_insert(rec_history_t *hist, const uint8_t *record, size_t size, int keyframe, uint64_t unix_us) {
+    if (size > hist->budget) {
+        while (hist->count > 0) {
+            history_evict(hist);
+        }
+        return TEST_ERROR_MEMORY;
+    }
+
+    size_t offset = 0;
+    if (hist->count > 0) {
+        const rec_history_entry_t *newest = &hist->entries[(hist->first + hist->count - 1) % HISTORY_MAX_FRAMES];
+        offset = newest->offset + newest->size;
+        if (offset + size > hist->budget) {
+            // Wrap to the start; frames left past the newest one are from the previous lap
+            while (hist->entries[hist->first].offset > newest->offset) {
+                history_evict(hist);
+            }
+            offset = 0;
+        }
+    }
+
+    while (hist->count > 0) {
+        const rec_history_entry_t *oldest = &hist->entries[hist->first];
+        int overlaps = oldest->offset < offset + size && offset < oldest->offset + oldest->size;
+        if (!overlaps && hist->count < HISTORY_MAX_FRAMES) {
+            break;
+        }
+        history_evict(hist);
+    }
+    // Deltas left without their keyframe can no longer be decoded
+    while (hist->count > 0 && !hist->entries[hist->first].keyframe) {
+        history_evict(hist);
+    }
+    if (!keyframe && hist->count == 0) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+
+    memcpy(hist->ring + offset, record, size);
+    rec_history_entry_t *entry = &hist->entries[(hist->first + hist->count) % HISTORY_MAX_FRAMES];
+    entry->offset = offset;
+    entry->size = size;
+    entry->unix_us = unix_us;
+    entry->keyframe = keyframe;
+    hist->count++;
+    return TEST_OK;
+}
+
+// Encode a staged frame as a keyframe or the rectangles changed since the previous one
+static void history_encode_frame(rec_history_t *hist, rec_slot_t *slot) {
+    rec_slot_t *reference = &hist->reference;
+    uint32_t stride = slot->width * slot->bpp;
+    int keyframe = !hist->have_reference || hist->since_keyframe >= HISTORY_KEYFRAME_INTERVAL ||
+                   reference->width != slot->width || reference->height != slot->height ||
+                   reference->format != slot->format;
+    int count = keyframe ? -1 : screenshot_diff_tiles(slot->pixels, reference->pixels, stride, slot->width,
+                                                      slot->height, slot->bpp, hist->rects, MAX_DELTA_RECTS);
+    if (count == 0) {
+        return; // nothing visible changed
+    }
+
+    size_t command_len = strlen(slot->command);
+    for (;;) {
+        if (count < 0) {
+            keyframe = 1;
+            count = rec_full_rect(hist->rects, slot);
+        }
+
+        size_t used = sizeof(rec_frame_header_t) + command_len;
+        if (recorder_reserve(&hist->record, &hist->record_size, used) != TEST_OK ||
+            rec_pack_rects(slot, hist->rects, count, &hist->record, &hist->record_size,
+                           &hist->scratch, &hist->scratch_size, &used) != TEST_OK) {
+            hist->have_reference = 0;
+            return;
+        }
+        rec_frame_header_t header;
+        rec_frame_header_init(&header, slot, 0, used - sizeof(header) - command_len, count, command_len, keyframe);
+        memcpy(hist->record, &header, sizeof(header));
+        memcpy(hist->record + sizeof(header), slot->command, command_len);
+
+        REC_LOCK(&hist->lock);
+        int result = history_insert(hist, hist->record, used, keyframe, slot->timestamp_us);
+        REC_UNLOCK(&hist->lock);
+        if (result == TEST_ERROR_NOT_FOUND) {
+            count = -1;
+            continue;
+        }
+        if (result != TEST_OK) {
+            hist->have_reference = 0;  // frame larger than the whole budget
+            return;
+        }
+        break;
+    }
+    hist->since_keyframe = keyframe ? 1 : hist->since_keyframe + 1;
+
+    // This frame is the next one's reference; the old reference buffer goes back to the slot
+    uint8_t *pixels = reference->pixels;
+    size_t size = reference->size;
+    *reference = *slot;
+    slot->pixels = pixels;
+    slot->size = size;
+    hist->have_reference = 1;
+}
+
+// Worker task: encode the staged frame, then whatever frame arrived meanwhile
+static void history_encode_task(void *arg, int index) {
+    rec_history_t *hist = arg;
+    (void)index;
+
+    for (;;) {
+        history_encode_frame(hist, &hist->staging);
+
+        REC_LOCK(&hist->lock);
+        if (!hist->pending_valid) {
+            hist->encoding = 0;
+            REC_SIGNAL(&hist->idle);
+            REC_UNLOCK(&hist->lock);
+            return;
+        }
+        rec_slot_t next = hist->pending;
+        hist->pending = hist->staging;
+        hist->staging = next;
+        hist->pending_valid = 0;
+        REC_UNLOCK(&hist->lock);
+    }
+}
+
+// Size the flight recorder from LVGL_HISTORY_MB (0 disables it) and allocate the main session's
+// ring. Other rings are allocated when their session opens, so keeping history never allocates
+// while frames are being rendered.
+int history_init(void) {
+    recorder_init();
+    if (histories.initialized) {
+        return TEST_OK;
+    }
+
+    size_t mb = HISTORY_BUDGET_MB_DEFAULT;
+    const char *env = getenv("LVGL_HISTORY_MB");
+    if (env && *env) {
+        mb = (size_t)strtoul(env, NULL, 10);
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        REC_MUTEX_INIT(&histories.sessions[i].lock);
+        REC_COND_INIT(&histories.sessions[i].idle);
+    }
+    histories.initialized = 1;
+    histories.budget = mb * 1024 * 1024;
+    if (mb == 0) {
+        printf("Flight recorder disabled\n");
+        return TEST_OK;
+    }
+
+    int result = history_open(0);
+    if (result == TEST_OK) {
+        printf("Flight recorder keeping the last %zu MB of frames per session\n", mb);
+    }
+    return result;
+}
+
+// Allocate a session's ring; a failure leaves just that session without history
+int history_open(int session) {
+    if (!histories.initialized || !histories.budget || session < 0 || session >= MAX_SESSIONS) {
+        return TEST_OK;
+    }
+    rec_history_t *hist = &histories.sessions[session];
+    hist->ring = malloc(histories.budget);
+    if (!hist->ring) {
+        printf("Failed to allocate %zu MB flight recorder for session %d - disabled\n",
+               histories.budget / (1024 * 1024), session);
+        return TEST_ERROR_MEMORY;
+    }
+    hist->budget = histories.budget;
+    return TEST_OK;
+}
+
+// Wait for the session's encode in flight, then drop its frames and buffers. Called on the LVGL
+// thread, so no new frame of the session is captured meanwhile.
+void history_close(int session) {
+    if (!histories.initialized || session < 0 || session >= MAX_SESSIONS) {
+        return;
+    }
+    rec_history_t *hist = &histories.sessions[session];
+    REC_LOCK(&hist->lock);
+    while (hist->encoding) {
+        REC_WAIT(&hist->idle, &hist->lock);
+    }
+    hist->budget = 0;
+    hist->first = 0;
+    hist->count = 0;
+    hist->evicted = 0;
+    hist->coalesced = 0;
+    hist->pending_valid = 0;
+    REC_UNLOCK(&hist->lock);
+
+    free(hist->ring);
+    hist->ring = NULL;
+    hist->have_reference = 0;
+    hist->since_keyframe = 0;
+}
+
+int history_enabled(int session) {
+    return session >= 0 && session < MAX_SESSIONS && histories.sessions[session].budget != 0;
+}
+
+// Called on the LVGL thread after a refresh of the session's display flushed pixels. Only
+// copies the frame; encoding runs on the worker pool.
+void history_capture(int session, const uint8_t *pixels, uint32_t stride, uint32_t width, uint32_t height,
+                     screenshot_format_t format, uint32_t frame_version) {
+    if (!history_enabled(session) || !pixels || width == 0 || height == 0) {
+        return;
+    }
+    rec_history_t *hist = &histories.sessions[session];
+    rec_recorder_t *rec = &recorders[session];
+    uint64_t now = recorder_now_us();
+
+    REC_LOCK(&hist->lock);
+    if (hist->encoding) {
+        if (hist->pending_valid) {
+            hist->coalesced++;
+        }
+        hist->pending_valid = rec_copy_frame(rec, &hist->pending, pixels, stride, width, height, format,
+                                               now, frame_version) == TEST_OK;
+        REC_UNLOCK(&hist->lock);
+        return;
+    }
+    hist->encoding = 1;
+    REC_UNLOCK(&hist->lock);
+
+    // The encoder is idle, so the staging slot is ours until the task is submitted
+    if (rec_copy_frame(rec, &hist->staging, pixels, stride, width, height, format, now, frame_version) != TEST_OK) {
+        REC_LOCK(&hist->lock);
+        hist->encoding = 0;
+        REC_UNLOCK(&hist->lock);
+        return;
+    }
+    worker_pool_submit(history_encode_task, hist);
+}
+
+// Copy a session's history out as an .lvrec image without index or trailer (readable by
+// scanning). max_frames > 0 limits it to about the last max_frames frames, starting at a
+// keyframe; timestamps are relative to the first frame returned. *data is malloc'd, caller frees.
+int history_export(int session, uint32_t max_frames, int clear, uint8_t **data, size_t *len,
+                   history_stats_t *stats) {
+    *data = NULL;
+    *len = 0;
+    if (!history_enabled(session)) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    rec_history_t *hist = &histories.sessions[session];
+
+    REC_LOCK(&hist->lock);
+    uint32_t start = (max_frames > 0 && hist->count > max_frames) ? hist->count - max_frames : 0;
+    while (start > 0 && !hist->entries[(hist->first + start) % HISTORY_MAX_FRAMES].keyframe) {
+        start--;
+    }
+
+    size_t total = sizeof(rec_file_header_t);
+    for (uint32_t i = start; i < hist->count; i++) {
+        total += hist->entries[(hist->first + i) % HISTORY_MAX_FRAMES].size;
+    }
+    uint8_t *out = malloc(total);
+    if (!out) {
+        REC_UNLOCK(&hist->lock);
+        return TEST_ERROR_MEMORY;
+    }
+
+    uint64_t base_us = hist->count > start ? hist->entries[(hist->first + start) % HISTORY_MAX_FRAMES].unix_us : 0;
+    rec_file_header_t file_header = { REC_FILE_MAGIC, REC_VERSION, 0, HISTORY_KEYFRAME_INTERVAL, base_us, 0 };
+    memcpy(out, &file_header, sizeof(file_header));
+    size_t used = sizeof(file_header);
+    for (uint32_t i = start; i < hist->count; i++) {
+        const rec_history_entry_t *entry = &hist->entries[(hist->first + i) % HISTORY_MAX_FRAMES];
+        memcpy(out + used, hist->ring + entry->offset, entry->size);
+
+        rec_frame_header_t header;
+        memcpy(&header, out + used, sizeof(header));
+        header.index = i - start;
+        header.timestamp_us = entry->unix_us - base_us;
+        memcpy(out + used, &header, sizeof(header));
+        used += entry->size;
+    }
+
+    if (stats) {
+        stats->frames = hist->count - start;
+        stats->budget = hist->budget;
+        stats->used = 0;
+        for (uint32_t i = 0; i < hist->count; i++) {
+            stats->used += hist->entries[(hist->first + i) % HISTORY_MAX_FRAMES].size;
+        }
+        stats->evicted = hist->evicted;
+        stats->coalesced = hist->coalesced;
+    }
+    if (clear) {
+        // The next stored frame finds no keyframe and is encoded as one
+        hist->first = 0;
+        hist->count = 0;
+    }
+    REC_UNLOCK(&hist->lock);
+
+    *data = out;
+    *len = used;
+    return TEST_OK;
+}
+
+// Call once the worker pool has stopped, so no encode task is still running
+void history_cleanup(void) {
+    if (!histories.initialized) {
+        return;
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        rec_history_t *hist = &histories.sessions[i];
+        free(hist->ring);
+        free(hist->staging.pixels);
+        free(hist->pending.pixels);
+        free(hist->reference.pixels);
+        free(hist->scratch);
+        free(hist->record);
+        REC_COND_DESTROY(&hist->idle);
+        REC_MUTEX_DESTROY(&hist->lock);
+    }
+    memset(&histories, 0, sizeof(histories));
+}
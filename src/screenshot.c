@@ -2,10 +2,40 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #define usleep(x) Sleep((x)/1000)
+    typedef CRITICAL_SECTION shot_mutex_t;
+    typedef CONDITION_VARIABLE shot_cond_t;
+    #define SHOT_MUTEX_INIT(m) InitializeCriticalSection(m)
+    #define SHOT_MUTEX_DESTROY(m) DeleteCriticalSection(m)
+    #define SHOT_LOCK(m) EnterCriticalSection(m)
+    #define SHOT_UNLOCK(m) LeaveCriticalSection(m)
+    #define SHOT_COND_INIT(c) InitializeConditionVariable(c)
+    #define SHOT_COND_DESTROY(c) ((void)0)
+    #define SHOT_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+    #define SHOT_BROADCAST(c) WakeAllConditionVariable(c)
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    typedef pthread_mutex_t shot_mutex_t;
+    typedef pthread_cond_t shot_cond_t;
+    #define SHOT_MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+    #define SHOT_MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+    #define SHOT_LOCK(m) pthread_mutex_lock(m)
+    #define SHOT_UNLOCK(m) pthread_mutex_unlock(m)
+    #define SHOT_COND_INIT(c) pthread_cond_init(c, NULL)
+    #define SHOT_COND_DESTROY(c) pthread_cond_destroy(c)
+    #define SHOT_WAIT(c, m) pthread_cond_wait(c, m)
+    #define SHOT_BROADCAST(c) pthread_cond_broadcast(c)
+#endif
 
 // Check if we have LVGL available
 #ifdef HAVE_LVGL
     #include "lvgl/lvgl.h"
+    #include "lvgl/src/display/lv_display_private.h"
     #include "third_party/lvgl/src/others/snapshot/lv_snapshot.h"
 #else
     // Fallback stubs for initial build without LVGL
@@ -20,120 +50,1445 @@
     #define lv_color_to_32(c, opa) (0xFF0000FF)
 #endif
 
-// Include stb_image_write for PNG encoding (LVGL v9 compatible)
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "third_party/stb/stb_image_write.h"
-
 #include "test_harness.h"
 
-// Screenshot configuration - match display size
-#define SCREENSHOT_WIDTH 480
-#define SCREENSHOT_HEIGHT 480
+// Conversion buffer starts at one RGB frame of the display (this size if there is none yet)
+// and grows on demand for larger regions
+#define SCREENSHOT_DEFAULT_SIZE 480
 #define SCREENSHOT_CHANNELS 3  // RGB
 
+// Initial PNG arena size; grows to the encoder's high-water mark and then stays put
+#define SCREENSHOT_ARENA_INITIAL (2 * 1024 * 1024)
+#define SCREENSHOT_ARENA_ALIGN 16
+
+// Allocation that did not fit the arena during a capture - folded into the arena on next reset
+typedef struct arena_overflow {
+    struct arena_overflow *next;
+    size_t size;
+} arena_overflow_t;
+
+// Asynchronous capture job (see screenshot_submit)
+enum {
+    SCREENSHOT_JOB_FREE = 0,
+    SCREENSHOT_JOB_PENDING,
+    SCREENSHOT_JOB_DONE
+};
+
+// What the worker pool makes of the grabbed pixels
+enum {
+    SCREENSHOT_OP_ENCODE = 0,   // an image in the requested format
+    SCREENSHOT_OP_HASH,         // a frame hash (screenshot_hash_region)
+    SCREENSHOT_OP_PROBE_POINTS, // point colors, sampled by the grab stage itself
+    SCREENSHOT_OP_PROBE_REGION  // region statistics (screenshot_probe_region)
+};
+
+struct screenshot_job {
+    int state;                  // guarded by job_lock
+    int result;
+    int op;
+    int has_region;
+    int session;                // whose display to grab, fixed at submit time
+    screenshot_region_t region;
+    screenshot_options_t options;
+    
+    // Grab stage: the region's pixels in the display's native format, rows tightly packed.
+    // The buffer stays with the slot and only grows.
+    uint8_t *pixels;
+    size_t pixels_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+#ifdef HAVE_LVGL
+    lv_color_format_t cf;
+#endif
+    uint32_t version;
+    uint32_t grab_allocs;
+    
+    // Encode stage: private copy of the result, so later encodes can reuse the shared buffers
+    uint8_t *output;
+    size_t output_size;
+    screenshot_image_t image;
+    screenshot_stats_t stats;
+    screenshot_rect_t rects[MAX_DELTA_RECTS];
+    
+    // Analysis stage: results that replace the image
+    frame_hash_algo_t algo;
+    uint64_t hash;
+    probe_point_t *points;      // the waiting caller's array
+    int point_count;
+    int has_color;
+    uint8_t color[3];
+    uint8_t tolerance[3];
+    probe_stats_t probe;
+};
+
+// Widest display (in tiles) a delta capture diffs; wider frames always go out as keyframes
+#define SCREENSHOT_DELTA_MAX_COLS 256
+
+// Reference for one session's delta captures: the last delta frame sent to its connection,
+// swapped in from the job that produced it
+typedef struct {
+    uint8_t *pixels;
+    size_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+#ifdef HAVE_LVGL
+    lv_color_format_t cf;
+#endif
+    int valid;
+} delta_reference_t;
+
 // Global screenshot state
 static struct {
     uint8_t *rgb_buffer;
     size_t buffer_size;
     int initialized;
+    
+    // Persistent snapshot target, reshaped instead of recreated between captures
+    lv_draw_buf_t *draw_buf;
+    
+#ifdef HAVE_LVGL
+    // Shadow copy of the display, kept current by wrapping its flush callback
+    lv_display_t *shadow_disp;
+    lv_display_flush_cb_t shadow_orig_flush;
+    lv_color_format_t shadow_cf;
+#endif
+    uint8_t *shadow;
+    size_t shadow_size;
+    uint32_t shadow_width;
+    uint32_t shadow_height;
+    uint32_t shadow_stride;
+    volatile int shadow_valid;  // set once a refresh has covered the whole shadow
+    
+    // Bump arena backing the PNG encoder's and LZ4's allocations (reset per capture)
+    uint8_t *arena;
+    size_t arena_size;
+    size_t arena_used;
+    arena_overflow_t *overflow;
+    size_t overflow_bytes;
+    
+    // Last encoded PNG (lives in the arena) and the frame it was taken from
+    uint8_t *cached_png;
+    size_t cached_len;
+    uint32_t cached_width;
+    uint32_t cached_height;
+    uint32_t cached_version;
+    png_encode_options_t cached_options;
+    
+    // Bumped once per display refresh that actually flushed pixels
+    volatile uint32_t frame_version;
+    volatile int frame_flushed;
+    
+    // Start of the refresh in progress and how long the last flushing refresh took
+    uint64_t refr_start_us;
+    volatile uint32_t render_us;
+    
+    screenshot_stats_t stats;
+    
+    // Held while converting/encoding: guards the conversion buffer, the arena, the PNG cache
+    // and stats. The grab stage never takes it, so the LVGL thread can't stall behind an encode.
+    shot_mutex_t lock;
+    
+    // Snapshot buffer (re)allocations, counted by whichever thread renders (never concurrently)
+    volatile uint32_t snapshot_allocs;
+    
+    // Delta capture references, one per session (guarded by lock)
+    delta_reference_t delta[MAX_SESSIONS];
+    
+    // Job slots, a pool per session: a session's single client thread never holds more than
+    // MAX_SCREENSHOT_REGIONS at once, so sessions can't starve or deadlock each other
+    screenshot_job_t jobs[MAX_SESSIONS][MAX_SCREENSHOT_REGIONS];
+    shot_mutex_t job_lock;
+    shot_cond_t job_done;
 } screenshot_state = {0};
 
-// Capture screenshot - returns PNG data directly from main display
-int capture_screenshot(uint8_t **raw_data, size_t *raw_len) {
-    printf("Capturing screenshot directly from main display...\n");
+static void *screenshot_arena_alloc(size_t size) {
+    size = (size + SCREENSHOT_ARENA_ALIGN - 1) & ~(size_t)(SCREENSHOT_ARENA_ALIGN - 1);
     
-    if (!raw_data || !raw_len) {
-        printf("Invalid parameters: raw_data=%p, raw_len=%p\n", (void*)raw_data, (void*)raw_len);
+    if (screenshot_state.arena && screenshot_state.arena_used + size <= screenshot_state.arena_size) {
+        uint8_t *ptr = screenshot_state.arena + screenshot_state.arena_used;
+        screenshot_state.arena_used += size;
+        return ptr;
+    }
+    
+    // Arena exhausted mid-encode: live pointers pin it, so fall back to a heap block
+    size_t header = (sizeof(arena_overflow_t) + SCREENSHOT_ARENA_ALIGN - 1) & ~(size_t)(SCREENSHOT_ARENA_ALIGN - 1);
+    arena_overflow_t *block = malloc(header + size);
+    if (!block) {
+        return NULL;
+    }
+    screenshot_state.stats.allocs_total++;
+    screenshot_state.stats.allocs_last++;
+    
+    block->next = screenshot_state.overflow;
+    block->size = size;
+    screenshot_state.overflow = block;
+    screenshot_state.overflow_bytes += size;
+    return (uint8_t*)block + header;
+}
+
+static void *screenshot_png_alloc(void *ctx, size_t size) {
+    (void)ctx;
+    return screenshot_arena_alloc(size);
+}
+
+// Start a new capture: drop everything from the previous one and absorb any overflow
+static int screenshot_arena_reset(void) {
+    if (screenshot_state.overflow) {
+        size_t new_size = screenshot_state.arena_size + screenshot_state.overflow_bytes;
+        new_size += new_size / 4;
+        
+        while (screenshot_state.overflow) {
+            arena_overflow_t *next = screenshot_state.overflow->next;
+            free(screenshot_state.overflow);
+            screenshot_state.overflow = next;
+        }
+        screenshot_state.overflow_bytes = 0;
+        
+        uint8_t *grown = realloc(screenshot_state.arena, new_size);
+        if (!grown) {
+            return TEST_ERROR_MEMORY;
+        }
+        screenshot_state.arena = grown;
+        screenshot_state.arena_size = new_size;
+        screenshot_state.stats.allocs_total++;
+        screenshot_state.stats.allocs_last++;
+        printf("Screenshot arena grown to %zu bytes\n", new_size);
+    }
+    
+    screenshot_state.arena_used = 0;
+    return TEST_OK;
+}
+
+// Make sure the persistent RGB conversion buffer can hold size bytes
+static int screenshot_reserve_rgb(size_t size) {
+    if (size <= screenshot_state.buffer_size) {
+        return TEST_OK;
+    }
+    
+    uint8_t *grown = realloc(screenshot_state.rgb_buffer, size);
+    if (!grown) {
+        return TEST_ERROR_MEMORY;
+    }
+    screenshot_state.rgb_buffer = grown;
+    screenshot_state.buffer_size = size;
+    screenshot_state.stats.allocs_total++;
+    screenshot_state.stats.allocs_last++;
+    return TEST_OK;
+}
+
+void screenshot_get_stats(screenshot_stats_t *stats) {
+    if (stats) {
+        SHOT_LOCK(&screenshot_state.lock);
+        *stats = screenshot_state.stats;
+        stats->allocs_total += screenshot_state.snapshot_allocs;
+        stats->arena_bytes = screenshot_state.arena_size;
+        stats->render_us = screenshot_state.render_us;
+        SHOT_UNLOCK(&screenshot_state.lock);
+    }
+}
+
+// Frame counter of a session's display; the main display's is kept here
+static uint32_t screenshot_session_version(int session) {
+    return session == 0 ? screenshot_state.frame_version : session_frame_version(session);
+}
+
+uint32_t screenshot_frame_version(void) {
+    return screenshot_session_version(session_current());
+}
+
+// Resolution of the current session's display; leaves the outputs alone when there is none
+int screenshot_display_size(uint32_t *width, uint32_t *height) {
+#ifdef HAVE_LVGL
+    lv_display_t *disp = session_get_display(session_current());
+    if (disp) {
+        *width = (uint32_t)lv_display_get_horizontal_resolution(disp);
+        *height = (uint32_t)lv_display_get_vertical_resolution(disp);
+        return TEST_OK;
+    }
+#else
+    (void)width;
+    (void)height;
+#endif
+    return TEST_ERROR_SCREENSHOT;
+}
+
+#ifdef HAVE_LVGL
+static uint64_t screenshot_now_us(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Display events: note any flush during a refresh, then count the refresh as one new frame.
+// Refreshes with nothing invalidated never flush, so the version stays put.
+static void screenshot_display_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    
+    if (code == LV_EVENT_REFR_START) {
+        screenshot_state.refr_start_us = screenshot_now_us();
+    } else if (code == LV_EVENT_FLUSH_START) {
+        screenshot_state.frame_flushed = 1;
+    } else if (code == LV_EVENT_REFR_READY && screenshot_state.frame_flushed) {
+        screenshot_state.frame_flushed = 0;
+        screenshot_state.frame_version++;
+        screenshot_state.render_us = (uint32_t)(screenshot_now_us() - screenshot_state.refr_start_us);
+        // The first refresh after attaching/resizing redraws the whole screen
+        if (screenshot_state.shadow) {
+            screenshot_state.shadow_valid = 1;
+        }
+        
+        // The main session's recording and flight recorder take their copies of the finished frame here
+        if ((recorder_active(0) || history_enabled(0)) && screenshot_state.shadow_valid) {
+            lv_color_format_t cf = screenshot_state.shadow_cf;
+            if (cf == LV_COLOR_FORMAT_RGB565 || cf == LV_COLOR_FORMAT_ARGB8888 || cf == LV_COLOR_FORMAT_XRGB8888) {
+                screenshot_format_t format = cf == LV_COLOR_FORMAT_RGB565 ? SCREENSHOT_FORMAT_RGB565 : SCREENSHOT_FORMAT_ARGB8888;
+                recorder_capture(0, screenshot_state.shadow, screenshot_state.shadow_stride, screenshot_state.shadow_width,
+                                 screenshot_state.shadow_height, format, screenshot_state.frame_version);
+                history_capture(0, screenshot_state.shadow, screenshot_state.shadow_stride, screenshot_state.shadow_width,
+                                screenshot_state.shadow_height, format, screenshot_state.frame_version);
+            }
+        }
+    }
+}
+
+// Flush wrapper: copy each flushed area into the shadow, then hand it to the real driver.
+// DIRECT/FULL modes pass the whole frame buffer; PARTIAL passes an area-sized buffer.
+static void screenshot_shadow_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+    uint32_t hor_res = (uint32_t)lv_display_get_horizontal_resolution(disp);
+    uint32_t ver_res = (uint32_t)lv_display_get_vertical_resolution(disp);
+    lv_color_format_t cf = disp->color_format;
+    uint32_t px_size = lv_color_format_get_size(cf);
+    uint32_t stride = lv_draw_buf_width_to_stride(hor_res, cf);
+    size_t size = (size_t)stride * ver_res;
+    
+    // Display resized or changed format: start over, the next full refresh revalidates
+    if (size != screenshot_state.shadow_size || cf != screenshot_state.shadow_cf) {
+        uint8_t *grown = realloc(screenshot_state.shadow, size);
+        if (!grown) {
+            free(screenshot_state.shadow);
+            screenshot_state.shadow = NULL;
+            screenshot_state.shadow_size = 0;
+            screenshot_state.shadow_valid = 0;
+            screenshot_state.shadow_orig_flush(disp, area, px_map);
+            return;
+        }
+        screenshot_state.shadow = grown;
+        screenshot_state.shadow_size = size;
+        screenshot_state.shadow_cf = cf;
+        screenshot_state.shadow_valid = 0;
+    }
+    screenshot_state.shadow_width = hor_res;
+    screenshot_state.shadow_height = ver_res;
+    screenshot_state.shadow_stride = stride;
+    
+    lv_area_t clip = {0, 0, (int32_t)hor_res - 1, (int32_t)ver_res - 1};
+    lv_area_t dirty;
+    if (lv_area_intersect(&dirty, area, &clip)) {
+        uint32_t row_bytes = (uint32_t)lv_area_get_width(&dirty) * px_size;
+        const uint8_t *src;
+        uint32_t src_stride;
+        
+        if (disp->render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+            src_stride = lv_draw_buf_width_to_stride((uint32_t)lv_area_get_width(area), cf);
+            src = px_map + (size_t)(dirty.y1 - area->y1) * src_stride + (size_t)(dirty.x1 - area->x1) * px_size;
+        } else {
+            src_stride = stride;
+            src = px_map + (size_t)dirty.y1 * src_stride + (size_t)dirty.x1 * px_size;
+        }
+        
+        uint8_t *dst = screenshot_state.shadow + (size_t)dirty.y1 * stride + (size_t)dirty.x1 * px_size;
+        for (int32_t y = dirty.y1; y <= dirty.y2; y++) {
+            memcpy(dst, src, row_bytes);
+            src += src_stride;
+            dst += stride;
+        }
+    }
+    
+    screenshot_state.shadow_orig_flush(disp, area, px_map);
+}
+
+// Hook the display's flush callback and force a full redraw to seed the shadow
+static void screenshot_attach_shadow(lv_display_t *disp) {
+    if (!disp->flush_cb || disp->flush_cb == screenshot_shadow_flush_cb) {
+        return;
+    }
+    
+    screenshot_state.shadow_disp = disp;
+    screenshot_state.shadow_orig_flush = disp->flush_cb;
+    lv_display_set_flush_cb(disp, screenshot_shadow_flush_cb);
+    lv_obj_invalidate(lv_display_get_screen_active(disp));
+    printf("Screenshot shadow framebuffer attached to display flush\n");
+}
+
+static void screenshot_detach_shadow(void) {
+    if (screenshot_state.shadow_disp) {
+        lv_display_set_flush_cb(screenshot_state.shadow_disp, screenshot_state.shadow_orig_flush);
+        screenshot_state.shadow_disp = NULL;
+        screenshot_state.shadow_orig_flush = NULL;
+    }
+}
+#endif
+
+#ifdef HAVE_LVGL
+// Deepest widget nesting searched for hidden ancestors
+#define SCREENSHOT_MAX_HIDDEN 16
+
+// Clear LV_OBJ_FLAG_HIDDEN on obj and its hidden ancestors so a hidden container renders
+// offscreen; screenshot_rehide hides them again right after the snapshot. Both run on the
+// LVGL thread inside one grab, so no refresh ever shows them - the invalidations only cost
+// one redraw of the same pixels.
+static int screenshot_unhide(lv_obj_t *obj, lv_obj_t **hidden, int max) {
+    int count = 0;
+    for (lv_obj_t *o = obj; o && count < max; o = lv_obj_get_parent(o)) {
+        if (lv_obj_has_flag(o, LV_OBJ_FLAG_HIDDEN)) {
+            lv_obj_remove_flag(o, LV_OBJ_FLAG_HIDDEN);
+            hidden[count++] = o;
+        }
+    }
+    return count;
+}
+
+static void screenshot_rehide(lv_obj_t **hidden, int count) {
+    // Outermost first: lv_obj_add_flag invalidates before hiding, and inside an already hidden
+    // parent that invalidation is skipped
+    for (int i = count - 1; i >= 0; i--) {
+        lv_obj_add_flag(hidden[i], LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+// Render obj into the persistent draw buffer, creating or reshaping it only when the size changes.
+// Hidden widgets (e.g. the watch screens show_screen() is not showing) render like visible ones.
+static lv_draw_buf_t *screenshot_snapshot(lv_obj_t *obj, lv_color_format_t cf) {
+    // Settle pending layouts with the real flags first, so the render cannot lay out
+    // visible siblings around a container that is only unhidden for the snapshot
+    lv_obj_update_layout(obj);
+    lv_obj_t *hidden[SCREENSHOT_MAX_HIDDEN];
+    int hidden_count = screenshot_unhide(obj, hidden, SCREENSHOT_MAX_HIDDEN);
+    lv_draw_buf_t *result = NULL;
+    
+    if (screenshot_state.draw_buf &&
+        (screenshot_state.draw_buf->header.cf != cf ||
+         lv_snapshot_reshape_draw_buf(obj, screenshot_state.draw_buf) != LV_RESULT_OK)) {
+        lv_draw_buf_destroy(screenshot_state.draw_buf);
+        screenshot_state.draw_buf = NULL;
+    }
+    
+    if (!screenshot_state.draw_buf) {
+        screenshot_state.draw_buf = lv_snapshot_create_draw_buf(obj, cf);
+        if (screenshot_state.draw_buf) {
+            screenshot_state.snapshot_allocs++;
+        } else {
+            printf("Failed to create snapshot draw buffer\n");
+        }
+    }
+    
+    if (screenshot_state.draw_buf) {
+        if (lv_snapshot_take_to_draw_buf(obj, cf, screenshot_state.draw_buf) == LV_RESULT_OK) {
+            result = screenshot_state.draw_buf;
+        } else {
+            printf("Failed to take snapshot\n");
+        }
+    }
+    
+    screenshot_rehide(hidden, hidden_count);
+    return result;
+}
+#endif
+
+#ifdef HAVE_LVGL
+static int screenshot_cf_convertible(lv_color_format_t cf) {
+    return cf == LV_COLOR_FORMAT_RGB565 || cf == LV_COLOR_FORMAT_ARGB8888 || cf == LV_COLOR_FORMAT_XRGB8888;
+}
+
+// Locate the whole display's pixels: the shadow framebuffer once it is seeded (main display),
+// the framebuffer itself (session displays render in DIRECT mode), otherwise a fresh render
+// of the active screen into the draw buffer
+static int screenshot_acquire_screen(lv_display_t *disp, lv_color_format_t *cf, uint8_t **data,
+                                     uint32_t *width, uint32_t *height, uint32_t *stride) {
+    // The display's native format keeps conversion reads as small as possible
+    *cf = lv_display_get_color_format(disp);
+    
+    if (disp != screenshot_state.shadow_disp && disp->render_mode == LV_DISPLAY_RENDER_MODE_DIRECT &&
+        screenshot_cf_convertible(*cf)) {
+        lv_draw_buf_t *buf = lv_display_get_buf_active(disp);
+        if (buf && buf->data) {
+            *width = (uint32_t)lv_display_get_horizontal_resolution(disp);
+            *height = (uint32_t)lv_display_get_vertical_resolution(disp);
+            *stride = buf->header.stride;
+            *data = buf->data;
+            return TEST_OK;
+        }
+    }
+    
+    if (disp == screenshot_state.shadow_disp && screenshot_state.shadow_valid && screenshot_cf_convertible(*cf) &&
+        screenshot_state.shadow_cf == *cf) {
+        // Pixels LVGL already rendered and flushed - no extra render pass needed
+        *width = screenshot_state.shadow_width;
+        *height = screenshot_state.shadow_height;
+        *stride = screenshot_state.shadow_stride;
+        *data = screenshot_state.shadow;
+        printf("Using shadow framebuffer: %dx%d\n", *width, *height);
+        return TEST_OK;
+    }
+    
+    // No shadow yet (or an unusual format)
+    if (!screenshot_cf_convertible(*cf)) {
+        *cf = LV_COLOR_FORMAT_ARGB8888;
+    }
+    lv_draw_buf_t *snapshot_buf = screenshot_snapshot(lv_display_get_screen_active(disp), *cf);
+    if (!snapshot_buf) {
+        return TEST_ERROR_SCREENSHOT;
+    }
+    
+    *width = snapshot_buf->header.w;
+    *height = snapshot_buf->header.h;
+    *stride = snapshot_buf->header.stride;
+    *data = (uint8_t*)snapshot_buf->data;
+    printf("Snapshot size: %dx%d, data=%p\n", *width, *height, (void*)*data);
+    return TEST_OK;
+}
+
+static void copy_rgb565(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    memcpy(dst, src, pixels * 2);
+}
+
+static void copy_argb8888(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    memcpy(dst, src, pixels * 4);
+}
+
+// Bytes per pixel of the requested output (PNG and QOI go through RGB24)
+static uint32_t screenshot_format_bpp(screenshot_format_t format) {
+    switch (format) {
+        case SCREENSHOT_FORMAT_ARGB8888: return 4;
+        case SCREENSHOT_FORMAT_RGB565: return 2;
+        default: return 3;
+    }
+}
+
+// Pick the row converter from the source color format to the requested output
+static pixel_convert_fn screenshot_converter(lv_color_format_t cf, screenshot_format_t format) {
+    int src_565 = (cf == LV_COLOR_FORMAT_RGB565);
+    switch (format) {
+        case SCREENSHOT_FORMAT_RGB565: return src_565 ? copy_rgb565 : convert_argb8888_to_rgb565;
+        case SCREENSHOT_FORMAT_ARGB8888: return src_565 ? convert_rgb565_to_argb8888 : copy_argb8888;
+        default: return src_565 ? convert_rgb565_to_rgb24 : convert_argb8888_to_rgb24;
+    }
+}
+
+// PNG and QOI are self-describing images; everything else is raw pixels
+static int screenshot_format_is_image(screenshot_format_t format) {
+    return format == SCREENSHOT_FORMAT_PNG || format == SCREENSHOT_FORMAT_QOI;
+}
+
+// Convert width x height pixels starting at src to the requested format. PNG and QOI are
+// encoded into the arena; raw formats are returned from the conversion buffer, or
+// LZ4-compressed into the arena when asked to.
+static int screenshot_encode_pixels(const uint8_t *src, uint32_t stride, uint32_t width, uint32_t height,
+                                    lv_color_format_t cf, const screenshot_options_t *options,
+                                    screenshot_image_t *image) {
+    if (!src || width == 0 || height == 0) {
+        printf("Invalid snapshot data\n");
+        return TEST_ERROR_SCREENSHOT;
+    }
+    
+    screenshot_format_t format = options ? options->format : SCREENSHOT_FORMAT_PNG;
+    uint32_t out_bpp = screenshot_format_bpp(format);
+    size_t raw_len = (size_t)width * height * out_bpp;
+    pixel_convert_fn convert = screenshot_converter(cf, format);
+    
+    // Convert into the persistent conversion buffer
+    if (screenshot_reserve_rgb(raw_len) != TEST_OK) {
+        printf("Failed to allocate RGB buffer\n");
+        return TEST_ERROR_MEMORY;
+    }
+    uint8_t *rgb_buffer = screenshot_state.rgb_buffer;
+    
+    // Convert with the dispatched SIMD kernel, row by row (rows may be padded or cropped)
+    if (stride == width * lv_color_format_get_size(cf)) {
+        convert(src, rgb_buffer, (size_t)width * height);
+    } else {
+        for (uint32_t y = 0; y < height; y++) {
+            convert(src + (size_t)y * stride, rgb_buffer + (size_t)y * width * out_bpp, width);
+        }
+    }
+    
+    image->width = width;
+    image->height = height;
+    image->format = format;
+    image->raw_len = raw_len;
+    image->compressed = 0;
+    
+    if (!screenshot_format_is_image(format) && !(options && options->compress)) {
+        image->data = rgb_buffer;
+        image->len = raw_len;
+        return TEST_OK;
+    }
+    
+    // Everything else is produced in the arena, which invalidates the cached PNG
+    screenshot_state.cached_png = NULL;
+    if (screenshot_arena_reset() != TEST_OK) {
+        printf("Failed to grow screenshot arena\n");
+        return TEST_ERROR_MEMORY;
+    }
+    
+    if (format == SCREENSHOT_FORMAT_QOI) {
+        size_t bound = qoi_encode_bound(width, height, 3);
+        uint8_t *qoi = screenshot_arena_alloc(bound);
+        size_t qoi_len = qoi ? qoi_encode(rgb_buffer, width, height, 3, qoi, bound) : 0;
+        if (qoi_len == 0) {
+            printf("Failed to encode QOI\n");
+            return TEST_ERROR_SCREENSHOT;
+        }
+        image->data = qoi;
+        image->len = qoi_len;
+        return TEST_OK;
+    }
+    
+    if (format != SCREENSHOT_FORMAT_PNG) {
+        size_t bound = lz4_compress_bound(raw_len);
+        uint8_t *packed = screenshot_arena_alloc(bound);
+        size_t packed_len = packed ? lz4_compress_block(rgb_buffer, raw_len, packed, bound) : 0;
+        if (packed_len == 0) {
+            printf("Failed to compress raw screenshot\n");
+            return TEST_ERROR_SCREENSHOT;
+        }
+        image->data = packed;
+        image->len = packed_len;
+        image->compressed = 1;
+        return TEST_OK;
+    }
+    
+    // Encode to PNG; filter and deflate bands run on the worker pool, scratch comes from the arena
+    uint8_t *png_buffer = NULL;
+    size_t png_size = 0;
+    int result = png_encode_rgb24(rgb_buffer, width, height, options ? &options->png : NULL,
+                                  screenshot_png_alloc, NULL, &png_buffer, &png_size);
+    if (result != TEST_OK) {
+        printf("Failed to encode PNG\n");
+        return result == TEST_ERROR_MEMORY ? result : TEST_ERROR_SCREENSHOT;
+    }
+    
+    image->data = png_buffer;
+    image->len = png_size;
+    return TEST_OK;
+}
+
+static int screenshot_encode(const uint8_t *src, uint32_t stride, uint32_t width, uint32_t height,
+                             lv_color_format_t cf, const screenshot_options_t *options,
+                             screenshot_image_t *image) {
+    uint64_t start = screenshot_now_us();
+    int result = screenshot_encode_pixels(src, stride, width, height, cf, options, image);
+    screenshot_state.stats.encode_us = (uint32_t)(screenshot_now_us() - start);
+    return result;
+}
+
+// Resolve a region to pixels in the display's native format without copying: a widget is
+// rendered on its own into the snapshot buffer, a rectangle (clipped to the screen) or the
+// whole screen points into the shadow framebuffer
+static int screenshot_locate(lv_display_t *disp, const screenshot_region_t *region, lv_color_format_t *cf,
+                             const uint8_t **origin, uint32_t *width, uint32_t *height, uint32_t *stride) {
+    lv_obj_t *obj = region ? region->obj : NULL;
+    if (region && !obj && (region->handle != WIDGET_HANDLE_INVALID || region->id[0])) {
+        int ref = find_widget_ref(region->handle, region->id, NULL, &obj);
+        if (ref != TEST_OK) {
+            return ref;
+        }
+        if (!obj) {
+            return TEST_ERROR_INVALID_WIDGET;
+        }
+    }
+    
+    if (obj) {
+        // Widget capture: render just this object (and its children)
+        *cf = lv_display_get_color_format(disp);
+        if (!screenshot_cf_convertible(*cf)) {
+            *cf = LV_COLOR_FORMAT_ARGB8888;
+        }
+        lv_draw_buf_t *snapshot_buf = screenshot_snapshot(obj, *cf);
+        if (!snapshot_buf) {
+            return TEST_ERROR_SCREENSHOT;
+        }
+        *origin = snapshot_buf->data;
+        *width = snapshot_buf->header.w;
+        *height = snapshot_buf->header.h;
+        *stride = snapshot_buf->header.stride;
+        return TEST_OK;
+    }
+    
+    uint8_t *data;
+    uint32_t screen_w, screen_h;
+    int result = screenshot_acquire_screen(disp, cf, &data, &screen_w, &screen_h, stride);
+    if (result != TEST_OK) {
+        return result;
+    }
+    
+    // Clip the requested rectangle to the screen and crop in place
+    int32_t x1 = 0, y1 = 0, x2 = (int32_t)screen_w, y2 = (int32_t)screen_h;
+    if (region) {
+        if (region->w <= 0 || region->h <= 0) {
+            printf("Invalid screenshot region %dx%d\n", region->w, region->h);
+            return TEST_ERROR_INVALID_PARAM;
+        }
+        x1 = region->x > 0 ? region->x : 0;
+        y1 = region->y > 0 ? region->y : 0;
+        if (region->x + region->w < x2) x2 = region->x + region->w;
+        if (region->y + region->h < y2) y2 = region->y + region->h;
+        if (x1 >= x2 || y1 >= y2) {
+            printf("Screenshot region (%d,%d %dx%d) is off screen\n", region->x, region->y, region->w, region->h);
+            return TEST_ERROR_INVALID_PARAM;
+        }
+    }
+    
+    *origin = data + (size_t)y1 * *stride + (size_t)x1 * lv_color_format_get_size(*cf);
+    *width = (uint32_t)(x2 - x1);
+    *height = (uint32_t)(y2 - y1);
+    return TEST_OK;
+}
+
+// Encode located pixels of the given frame, or serve a whole-screen PNG from the cache when
+// nothing has been flushed since it was encoded at the same settings. Called with the lock held.
+static int screenshot_produce(const uint8_t *src, uint32_t stride, uint32_t width, uint32_t height,
+                              lv_color_format_t cf, int full_screen, const screenshot_options_t *options,
+                              uint32_t version, screenshot_image_t *image) {
+    screenshot_state.stats.frame_version = version;
+    
+    png_encode_options_t png_options = { PNG_LEVEL_DEFAULT, PNG_FILTER_ADAPTIVE, 0 };
+    if (options) {
+        png_options = options->png;
+    }
+    int full_png = full_screen && (!options || options->format == SCREENSHOT_FORMAT_PNG);
+    if (full_png && screenshot_state.cached_png && screenshot_state.cached_version == version &&
+        screenshot_state.cached_options.level == png_options.level &&
+        screenshot_state.cached_options.filter == png_options.filter) {
+        image->data = screenshot_state.cached_png;
+        image->len = screenshot_state.cached_len;
+        image->width = screenshot_state.cached_width;
+        image->height = screenshot_state.cached_height;
+        image->format = SCREENSHOT_FORMAT_PNG;
+        screenshot_state.stats.cache_hit = 1;
+        screenshot_state.stats.cache_hits++;
+        printf("Screenshot served from cache: %zu bytes (frame %u)\n", image->len, version);
+        return TEST_OK;
+    }
+    
+    int result = screenshot_encode(src, stride, width, height, cf, options, image);
+    if (result != TEST_OK) {
+        return result;
+    }
+    
+    if (full_png) {
+        screenshot_state.cached_png = image->data;
+        screenshot_state.cached_len = image->len;
+        screenshot_state.cached_width = image->width;
+        screenshot_state.cached_height = image->height;
+        screenshot_state.cached_version = version;
+        screenshot_state.cached_options = png_options;
+    }
+    
+    screenshot_state.stats.captures++;
+    printf("Screenshot captured successfully: %zu bytes %ux%u (%u heap allocations)\n",
+           image->len, image->width, image->height, screenshot_state.stats.allocs_last);
+    return TEST_OK;
+}
+#endif
+
+// Capture part of the current session's display: a screen rectangle, a single widget (rendered
+// on its own via lv_snapshot), or the whole screen when region is NULL. options selects PNG (NULL)
+// or a raw pixel format. The result is owned by the screenshot module and stays valid until
+// the next capture; callers must not free it. Renders on the calling thread, so it is for the
+// LVGL thread only (CMD_SCREENSHOT); everything else captures through screenshot_submit().
+int capture_screenshot_region(const screenshot_region_t *region, const screenshot_options_t *options,
+                              screenshot_image_t *image) {
+    printf("Capturing screenshot directly from the display...\n");
+    
+    if (!image) {
+        printf("Invalid parameters: image=%p\n", (void*)image);
         return TEST_ERROR_INVALID_PARAM;
     }
     
-    *raw_data = NULL;
-    *raw_len = 0;
+    memset(image, 0, sizeof(*image));
     
     if (!screenshot_state.initialized) {
         printf("Screenshot system not initialized\n");
         return TEST_ERROR_SCREENSHOT;
     }
+    
+    if (options && options->delta) {
+        printf("Delta screenshots need screenshot_submit()\n");
+        return TEST_ERROR_INVALID_PARAM;
+    }
 
 #ifdef HAVE_LVGL
-    // Get the main display directly (no test display needed)
-    lv_display_t *main_disp = lv_display_get_default();
-    if (!main_disp) {
-        printf("No main display found\n");
+    // Get the session's display directly (no test display needed)
+    int session = session_current();
+    lv_display_t *disp = session_get_display(session);
+    if (!disp) {
+        printf("No display found\n");
         return TEST_ERROR_SCREENSHOT;
     }
     
     // Force refresh to ensure current state is rendered
-    lv_refr_now(main_disp);
+    lv_refr_now(disp);
     
-    // Take snapshot directly from the active screen on main display
-    lv_draw_buf_t *snapshot_buf = lv_snapshot_take(lv_screen_active(), LV_COLOR_FORMAT_ARGB8888);
-    if (!snapshot_buf) {
-        printf("Failed to take snapshot\n");
-        return TEST_ERROR_SCREENSHOT;
+    SHOT_LOCK(&screenshot_state.lock);
+    screenshot_state.stats.allocs_last = 0;
+    screenshot_state.stats.cache_hit = 0;
+    screenshot_state.stats.encode_us = 0;
+    
+    uint32_t version = screenshot_session_version(session);
+    uint32_t snapshot_allocs = screenshot_state.snapshot_allocs;
+    lv_color_format_t cf;
+    const uint8_t *origin;
+    uint32_t width, height, stride;
+    int result = screenshot_locate(disp, region, &cf, &origin, &width, &height, &stride);
+    screenshot_state.stats.allocs_last += screenshot_state.snapshot_allocs - snapshot_allocs;
+    if (result == TEST_OK) {
+        // Only the main display's full frames go through the PNG cache
+        result = screenshot_produce(origin, stride, width, height, cf, region == NULL && session == 0,
+                                    options, version, image);
+    }
+    SHOT_UNLOCK(&screenshot_state.lock);
+    return result;
+#else
+    (void)region;
+    (void)options;
+    printf("LVGL not available\n");
+    return TEST_ERROR_SCREENSHOT;
+#endif
+}
+
+// Capture the whole screen - see capture_screenshot_region() for buffer ownership
+int capture_screenshot(uint8_t **raw_data, size_t *raw_len) {
+    if (!raw_data || !raw_len) {
+        printf("Invalid parameters: raw_data=%p, raw_len=%p\n", (void*)raw_data, (void*)raw_len);
+        return TEST_ERROR_INVALID_PARAM;
     }
     
-    printf("Snapshot taken successfully\n");
+    screenshot_image_t image;
+    int result = capture_screenshot_region(NULL, NULL, &image);
+    *raw_data = image.data;
+    *raw_len = image.len;
+    return result;
+}
+
+// Find what changed between two frames with the same layout: compare SCREENSHOT_DELTA_TILE
+// square tiles row by row, turn horizontal runs of changed tiles into rectangles and extend a
+// rectangle downwards while the band below changed over exactly the same columns.
+// Returns the rectangle count, or -1 when a full frame is cheaper (more than max_rects
+// rectangles or half the frame changed, or a frame too wide to diff).
+int screenshot_diff_tiles(const uint8_t *frame, const uint8_t *reference, uint32_t stride, uint32_t width,
+                          uint32_t height, uint32_t bpp, screenshot_rect_t *rects, int max_rects) {
+    const uint32_t tile = SCREENSHOT_DELTA_TILE;
+    uint32_t cols = (width + tile - 1) / tile;
+    uint8_t dirty[SCREENSHOT_DELTA_MAX_COLS];
+    int open_prev[SCREENSHOT_DELTA_MAX_COLS];
+    int open_cur[SCREENSHOT_DELTA_MAX_COLS];
+    size_t dirty_pixels = 0;
+    int count = 0;
     
-    // Get buffer dimensions and data
-    uint32_t buf_width = snapshot_buf->header.w;
-    uint32_t buf_height = snapshot_buf->header.h;
-    uint8_t *argb_data = (uint8_t*)snapshot_buf->data;
+    if (cols > SCREENSHOT_DELTA_MAX_COLS) {
+        return -1;
+    }
+    for (uint32_t tx = 0; tx < cols; tx++) {
+        open_prev[tx] = -1;
+    }
     
-    printf("Snapshot size: %dx%d, data=%p\n", buf_width, buf_height, (void*)argb_data);
+    for (uint32_t y0 = 0; y0 < height; y0 += tile) {
+        uint32_t band_h = height - y0 < tile ? height - y0 : tile;
+        
+        memset(dirty, 0, cols);
+        for (uint32_t y = y0; y < y0 + band_h; y++) {
+            const uint8_t *a = frame + (size_t)y * stride;
+            const uint8_t *b = reference + (size_t)y * stride;
+            for (uint32_t tx = 0; tx < cols; tx++) {
+                if (dirty[tx]) {
+                    continue;
+                }
+                uint32_t x = tx * tile;
+                uint32_t w = width - x < tile ? width - x : tile;
+                dirty[tx] = memcmp(a + (size_t)x * bpp, b + (size_t)x * bpp, (size_t)w * bpp) != 0;
+            }
+        }
+        
+        for (uint32_t tx = 0; tx < cols; tx++) {
+            open_cur[tx] = -1;
+        }
+        for (uint32_t tx = 0; tx < cols; ) {
+            if (!dirty[tx]) {
+                tx++;
+                continue;
+            }
+            uint32_t run = tx;
+            while (run < cols && dirty[run]) {
+                run++;
+            }
+            
+            int x = (int)(tx * tile);
+            int w = (int)((run * tile < width ? run * tile : width) - tx * tile);
+            int index = open_prev[tx];
+            if (index >= 0 && rects[index].w == w) {
+                rects[index].h += (int)band_h;
+            } else {
+                if (count == max_rects) {
+                    return -1;
+                }
+                index = count++;
+                rects[index].x = x;
+                rects[index].y = (int)y0;
+                rects[index].w = w;
+                rects[index].h = (int)band_h;
+            }
+            open_cur[tx] = index;
+            dirty_pixels += (size_t)w * band_h;
+            tx = run;
+        }
+        memcpy(open_prev, open_cur, sizeof(int) * cols);
+    }
     
-    if (!argb_data || buf_width == 0 || buf_height == 0) {
-        printf("Invalid snapshot data\n");
-        lv_draw_buf_destroy(snapshot_buf);
-        return TEST_ERROR_SCREENSHOT;
+    // Past half the frame, per-rectangle overhead outweighs what is saved
+    if (dirty_pixels * 2 > (size_t)width * height) {
+        return -1;
+    }
+    return count;
+}
+
+#ifdef HAVE_LVGL
+// Make room for size bytes of encoded output in the job
+static int screenshot_job_reserve_output(screenshot_job_t *job, size_t size) {
+    if (size <= job->output_size) {
+        return TEST_OK;
     }
     
-    // Convert ARGB to RGB for PNG encoding
-    size_t rgb_size = buf_width * buf_height * 3;
-    uint8_t *rgb_buffer = malloc(rgb_size);
-    if (!rgb_buffer) {
-        printf("Failed to allocate RGB buffer\n");
-        lv_draw_buf_destroy(snapshot_buf);
+    uint8_t *grown = realloc(job->output, size);
+    if (!grown) {
         return TEST_ERROR_MEMORY;
     }
+    job->output = grown;
+    job->output_size = size;
+    screenshot_state.stats.allocs_total++;
+    screenshot_state.stats.allocs_last++;
+    return TEST_OK;
+}
+
+// Delta encode stage: encode each changed rectangle of the job's frame separately into the
+// job's output, then make the frame its session's new reference. Called with the lock held.
+static int screenshot_produce_delta(screenshot_job_t *job, screenshot_image_t *image) {
+    uint64_t start = screenshot_now_us();
+    delta_reference_t *reference = &screenshot_state.delta[job->session];
+    int keyframe = !reference->valid ||
+                   reference->width != job->width ||
+                   reference->height != job->height ||
+                   reference->cf != job->cf;
+    int count = keyframe ? -1 : screenshot_diff_tiles(job->pixels, reference->pixels, job->stride,
+                                                      job->width, job->height,
+                                                      lv_color_format_get_size(job->cf),
+                                                      job->rects, MAX_DELTA_RECTS);
+    if (count < 0) {
+        keyframe = 1;
+        count = 1;
+        job->rects[0].x = 0;
+        job->rects[0].y = 0;
+        job->rects[0].w = (int)job->width;
+        job->rects[0].h = (int)job->height;
+    }
     
-    // Convert ARGB8888 to RGB24
-    for (uint32_t i = 0; i < buf_width * buf_height; i++) {
-        uint32_t argb = ((uint32_t*)argb_data)[i];
-        rgb_buffer[i*3 + 0] = (argb >> 16) & 0xFF; // Red
-        rgb_buffer[i*3 + 1] = (argb >> 8) & 0xFF;  // Green  
-        rgb_buffer[i*3 + 2] = argb & 0xFF;         // Blue
+    uint32_t bpp = lv_color_format_get_size(job->cf);
+    size_t used = 0, raw_total = 0;
+    for (int i = 0; i < count; i++) {
+        screenshot_rect_t *rect = &job->rects[i];
+        screenshot_image_t part;
+        const uint8_t *src = job->pixels + (size_t)rect->y * job->stride + (size_t)rect->x * bpp;
+        int result = screenshot_encode(src, job->stride, (uint32_t)rect->w, (uint32_t)rect->h, job->cf,
+                                       &job->options, &part);
+        if (result == TEST_OK) {
+            result = screenshot_job_reserve_output(job, used + part.len);
+        }
+        if (result != TEST_OK) {
+            // Keep the old reference: the client never sees this frame
+            return result;
+        }
+        memcpy(job->output + used, part.data, part.len);
+        rect->len = part.len;
+        rect->raw_len = part.raw_len;
+        used += part.len;
+        raw_total += part.raw_len;
+        image->compressed = part.compressed;
     }
     
-    // Encode to PNG using stb_image_write
-    int png_size;
-    unsigned char *png_buffer = stbi_write_png_to_mem(rgb_buffer, buf_width * 3, buf_width, buf_height, 3, &png_size);
+    // The job's frame becomes the reference; the old reference buffer goes back to the job
+    uint8_t *pixels = reference->pixels;
+    size_t size = reference->size;
+    reference->pixels = job->pixels;
+    reference->size = job->pixels_size;
+    reference->width = job->width;
+    reference->height = job->height;
+    reference->stride = job->stride;
+    reference->cf = job->cf;
+    reference->valid = 1;
+    job->pixels = pixels;
+    job->pixels_size = size;
     
-    free(rgb_buffer);
-    lv_draw_buf_destroy(snapshot_buf);
+    image->data = job->output;
+    image->len = used;
+    image->raw_len = raw_total;
+    image->width = job->width;
+    image->height = job->height;
+    image->format = job->options.format;
+    image->rects = job->rects;
+    image->rect_count = count;
+    image->keyframe = keyframe;
     
-    if (!png_buffer || png_size <= 0) {
-        printf("Failed to encode PNG\n");
+    screenshot_state.stats.frame_version = job->version;
+    screenshot_state.stats.encode_us = (uint32_t)(screenshot_now_us() - start);
+    screenshot_state.stats.captures++;
+    printf("Delta screenshot: %d rect(s)%s, %zu bytes (frame %u)\n", count, keyframe ? " (keyframe)" : "",
+           used, job->version);
+    return TEST_OK;
+}
+#endif
+
+static void screenshot_job_complete(screenshot_job_t *job, int result) {
+    SHOT_LOCK(&screenshot_state.job_lock);
+    job->result = result;
+    job->state = SCREENSHOT_JOB_DONE;
+    SHOT_BROADCAST(&screenshot_state.job_done);
+    SHOT_UNLOCK(&screenshot_state.job_lock);
+}
+
+#ifdef HAVE_LVGL
+// Encode stage (worker pool): convert and encode the grabbed pixels, then keep a copy of the
+// result in the job's own buffer
+static void screenshot_job_encode(void *arg, int index) {
+    screenshot_job_t *job = (screenshot_job_t*)arg;
+    (void)index;
+    
+    SHOT_LOCK(&screenshot_state.lock);
+    screenshot_state.stats.allocs_last = job->grab_allocs;
+    screenshot_state.stats.cache_hit = 0;
+    screenshot_state.stats.encode_us = 0;
+    
+    screenshot_image_t image;
+    memset(&image, 0, sizeof(image));
+    int result;
+    if (job->options.delta) {
+        result = screenshot_produce_delta(job, &image);
+    } else {
+        result = screenshot_produce(job->pixels, job->stride, job->width, job->height, job->cf,
+                                    !job->has_region && job->session == 0, &job->options, job->version, &image);
+        if (result == TEST_OK) {
+            result = screenshot_job_reserve_output(job, image.len);
+        }
+        if (result == TEST_OK) {
+            memcpy(job->output, image.data, image.len);
+            image.data = job->output;
+        }
+    }
+    if (result == TEST_OK) {
+        job->image = image;
+    }
+    
+    job->stats = screenshot_state.stats;
+    job->stats.allocs_total += screenshot_state.snapshot_allocs;
+    job->stats.arena_bytes = screenshot_state.arena_size;
+    SHOT_UNLOCK(&screenshot_state.lock);
+    
+    screenshot_job_complete(job, result);
+}
+
+// FRAME_HASH_XXH64 and FRAME_HASH_CRC32C chain the native rows, FRAME_HASH_DHASH works on RGB24
+// rows converted one at a time into the job's output buffer. Called with the lock held.
+static int screenshot_job_hash(screenshot_job_t *job) {
+    if (job->algo == FRAME_HASH_DHASH) {
+        int result = screenshot_job_reserve_output(job, (size_t)job->width * 3);
+        if (result != TEST_OK) {
+            return result;
+        }
+        pixel_convert_fn convert = screenshot_converter(job->cf, SCREENSHOT_FORMAT_RGB24);
+        dhash_state_t state;
+        dhash_init(&state, job->width, job->height);
+        for (uint32_t y = 0; y < job->height; y++) {
+            convert(job->pixels + (size_t)y * job->stride, job->output, job->width);
+            dhash_add_row(&state, job->output, y);
+        }
+        job->hash = dhash_finish(&state);
+        return TEST_OK;
+    }
+    
+    if (job->algo == FRAME_HASH_CRC32C) {
+        uint32_t crc = 0;
+        for (uint32_t y = 0; y < job->height; y++) {
+            crc = hash_crc32c(crc, job->pixels + (size_t)y * job->stride, job->stride);
+        }
+        job->hash = crc;
+        return TEST_OK;
+    }
+    
+    // Chained per row so cropped rectangles hash the same as contiguous frames
+    uint64_t value = ((uint64_t)job->width << 32) | job->height;
+    for (uint32_t y = 0; y < job->height; y++) {
+        value = hash_xxh64(job->pixels + (size_t)y * job->stride, job->stride, value);
+    }
+    job->hash = value;
+    return TEST_OK;
+}
+
+// Mean, min/max, histograms and color matches of the grabbed pixels, converted to RGB24 one
+// row at a time into the job's output buffer. Called with the lock held.
+static int screenshot_job_probe(screenshot_job_t *job) {
+    int result = screenshot_job_reserve_output(job, (size_t)job->width * 3);
+    if (result != TEST_OK) {
+        return result;
+    }
+    
+    probe_stats_t *stats = &job->probe;
+    memset(stats, 0, sizeof(*stats));
+    stats->width = job->width;
+    stats->height = job->height;
+    memset(stats->min, 0xFF, sizeof(stats->min));
+    
+    pixel_convert_fn convert = screenshot_converter(job->cf, SCREENSHOT_FORMAT_RGB24);
+    uint64_t sum[3] = { 0, 0, 0 };
+    for (uint32_t y = 0; y < job->height; y++) {
+        const uint8_t *rgb = job->output;
+        convert(job->pixels + (size_t)y * job->stride, job->output, job->width);
+        for (uint32_t x = 0; x < job->width; x++, rgb += 3) {
+            int match = job->has_color;
+            for (int c = 0; c < 3; c++) {
+                uint8_t v = rgb[c];
+                sum[c] += v;
+                if (v < stats->min[c]) stats->min[c] = v;
+                if (v > stats->max[c]) stats->max[c] = v;
+                stats->hist[c][v / (256 / PROBE_HIST_BINS)]++;
+                if (match && abs((int)v - (int)job->color[c]) > job->tolerance[c]) {
+                    match = 0;
+                }
+            }
+            stats->matches += (uint32_t)match;
+        }
+    }
+    
+    uint64_t pixels = (uint64_t)job->width * job->height;
+    for (int c = 0; c < 3; c++) {
+        stats->mean[c] = pixels ? (float)((double)sum[c] / (double)pixels) : 0.0f;
+    }
+    return TEST_OK;
+}
+
+// Analysis stage (worker pool): hash or measure the grabbed pixels instead of encoding them
+static void screenshot_job_analyze(void *arg, int index) {
+    screenshot_job_t *job = (screenshot_job_t*)arg;
+    (void)index;
+    
+    SHOT_LOCK(&screenshot_state.lock);
+    screenshot_state.stats.frame_version = job->version;
+    int result = job->op == SCREENSHOT_OP_HASH ? screenshot_job_hash(job) : screenshot_job_probe(job);
+    SHOT_UNLOCK(&screenshot_state.lock);
+    
+    screenshot_job_complete(job, result);
+}
+
+// Grab stage of a point probe: read each point's color straight from the frame, so a few
+// pixels never cost a copy of the whole screen. Points off screen come back invalid.
+static void screenshot_job_sample(screenshot_job_t *job, const uint8_t *origin, uint32_t stride) {
+    pixel_convert_fn convert = screenshot_converter(job->cf, SCREENSHOT_FORMAT_RGB24);
+    uint32_t bpp = lv_color_format_get_size(job->cf);
+    for (int i = 0; i < job->point_count; i++) {
+        probe_point_t *point = &job->points[i];
+        point->valid = point->x >= 0 && point->y >= 0 &&
+                       (uint32_t)point->x < job->width && (uint32_t)point->y < job->height;
+        if (point->valid) {
+            convert(origin + (size_t)point->y * stride + (size_t)point->x * bpp, point->rgb, 1);
+        }
+    }
+}
+#endif
+
+// Take a free slot from the current session's pool and fill in what every job needs. While
+// all of them are in use, wait on job_done until screenshot_job_release() frees one.
+static screenshot_job_t *screenshot_job_acquire(const screenshot_region_t *region,
+                                                const screenshot_options_t *options, int op) {
+    int session = session_current();
+    screenshot_job_t *jobs = screenshot_state.jobs[session];
+    screenshot_job_t *slot = NULL;
+    
+    SHOT_LOCK(&screenshot_state.job_lock);
+    while (!slot) {
+        for (int i = 0; i < MAX_SCREENSHOT_REGIONS; i++) {
+            if (jobs[i].state == SCREENSHOT_JOB_FREE) {
+                slot = &jobs[i];
+                slot->state = SCREENSHOT_JOB_PENDING;
+                break;
+            }
+        }
+        if (!slot) {
+            SHOT_WAIT(&screenshot_state.job_done, &screenshot_state.job_lock);
+        }
+    }
+    SHOT_UNLOCK(&screenshot_state.job_lock);
+    
+    slot->result = TEST_OK;
+    slot->op = op;
+    slot->has_region = (region != NULL);
+    slot->session = session;
+    if (region) {
+        slot->region = *region;
+    }
+    if (options) {
+        slot->options = *options;
+    } else {
+        memset(&slot->options, 0, sizeof(slot->options));
+        slot->options.format = SCREENSHOT_FORMAT_PNG;
+        slot->options.png.level = PNG_LEVEL_DEFAULT;
+        slot->options.png.filter = PNG_FILTER_ADAPTIVE;
+    }
+    memset(&slot->image, 0, sizeof(slot->image));
+    return slot;
+}
+
+// Hand the job's grab stage to the LVGL thread, backing off while the command queue is full
+static void screenshot_job_queue(screenshot_job_t *job) {
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_CAPTURE;
+    cmd.session = job->session;
+    cmd.params.capture.job = job;
+    while (command_queue_push(&cmd) != TEST_OK) {
+        usleep(1000);
+    }
+}
+
+// Start an asynchronous capture of a region (NULL = whole screen). The grab is queued for the
+// LVGL thread, backing off while the command queue is full - it never runs on the calling
+// thread. Every submitted job must be finished with screenshot_job_wait() and screenshot_job_release().
+int screenshot_submit(const screenshot_region_t *region, const screenshot_options_t *options,
+                      screenshot_job_t **job) {
+    if (!job) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    *job = NULL;
+    
+    if (!screenshot_state.initialized) {
+        printf("Screenshot system not initialized\n");
         return TEST_ERROR_SCREENSHOT;
     }
     
-    *raw_data = png_buffer;
-    *raw_len = png_size;
+    if (region && options && options->delta) {
+        printf("Delta screenshots cover the whole screen\n");
+        return TEST_ERROR_INVALID_PARAM;
+    }
     
-    printf("Screenshot captured successfully: %d bytes\n", png_size);
+    screenshot_job_t *slot = screenshot_job_acquire(region, options, SCREENSHOT_OP_ENCODE);
+    screenshot_job_queue(slot);
+    *job = slot;
     return TEST_OK;
+}
+
+// Grab stage (LVGL thread): render if needed and copy the region's pixels into the job's
+// pooled buffer, then hand the job to the worker pool to encode or analyze
+void screenshot_job_grab(screenshot_job_t *job) {
+    if (!job) {
+        return;
+    }
+    
+#ifdef HAVE_LVGL
+    lv_display_t *disp = session_get_display(job->session);
+    if (!disp) {
+        printf("No display found\n");
+        screenshot_job_complete(job, TEST_ERROR_SCREENSHOT);
+        return;
+    }
+    
+    lv_refr_now(disp);
+    job->version = screenshot_session_version(job->session);
+    
+    uint32_t snapshot_allocs = screenshot_state.snapshot_allocs;
+    const uint8_t *origin;
+    uint32_t stride;
+    int result = screenshot_locate(disp, job->has_region ? &job->region : NULL, &job->cf, &origin,
+                                   &job->width, &job->height, &stride);
+    if (result != TEST_OK) {
+        screenshot_job_complete(job, result);
+        return;
+    }
+    job->grab_allocs = screenshot_state.snapshot_allocs - snapshot_allocs;
+    
+    if (job->op == SCREENSHOT_OP_PROBE_POINTS) {
+        screenshot_job_sample(job, origin, stride);
+        screenshot_job_complete(job, TEST_OK);
+        return;
+    }
+    
+    job->stride = job->width * lv_color_format_get_size(job->cf);
+    size_t size = (size_t)job->stride * job->height;
+    if (size > job->pixels_size) {
+        uint8_t *grown = realloc(job->pixels, size);
+        if (!grown) {
+            screenshot_job_complete(job, TEST_ERROR_MEMORY);
+            return;
+        }
+        job->pixels = grown;
+        job->pixels_size = size;
+        job->grab_allocs++;
+    }
+    
+    for (uint32_t y = 0; y < job->height; y++) {
+        memcpy(job->pixels + (size_t)y * job->stride, origin + (size_t)y * stride, job->stride);
+    }
+    
+    worker_pool_submit(job->op == SCREENSHOT_OP_ENCODE ? screenshot_job_encode : screenshot_job_analyze, job);
 #else
     printf("LVGL not available\n");
-    return TEST_ERROR_SCREENSHOT;
+    screenshot_job_complete(job, TEST_ERROR_SCREENSHOT);
 #endif
 }
 
+// Block until the job has been encoded. image points into the job and stays valid until the
+// job is released; stats (optional) describe this capture.
+int screenshot_job_wait(screenshot_job_t *job, screenshot_image_t *image, screenshot_stats_t *stats) {
+    if (!job) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    
+    SHOT_LOCK(&screenshot_state.job_lock);
+    while (job->state == SCREENSHOT_JOB_PENDING) {
+        SHOT_WAIT(&screenshot_state.job_done, &screenshot_state.job_lock);
+    }
+    SHOT_UNLOCK(&screenshot_state.job_lock);
+    
+    if (image) {
+        if (job->result == TEST_OK) {
+            *image = job->image;
+        } else {
+            memset(image, 0, sizeof(*image));
+        }
+    }
+    if (stats) {
+        *stats = job->stats;
+    }
+    return job->result;
+}
+
+// Return the job's slot (and its buffers) to the pool; waits for the job if it is still running
+void screenshot_job_release(screenshot_job_t *job) {
+    if (!job) {
+        return;
+    }
+    
+    screenshot_job_wait(job, NULL, NULL);
+    SHOT_LOCK(&screenshot_state.job_lock);
+    job->state = SCREENSHOT_JOB_FREE;
+    SHOT_BROADCAST(&screenshot_state.job_done);    // wakes screenshot_job_acquire
+    SHOT_UNLOCK(&screenshot_state.job_lock);
+}
+
+// Forget a session's delta reference so its next delta capture is a keyframe (new connection,
+// or a client that lost track of its frame)
+void screenshot_delta_reset(int session) {
+    if (!screenshot_state.initialized || session < 0 || session >= MAX_SESSIONS) {
+        return;
+    }
+    SHOT_LOCK(&screenshot_state.lock);
+    screenshot_state.delta[session].valid = 0;
+    SHOT_UNLOCK(&screenshot_state.lock);
+}
+
+// Hash a region (NULL = whole screen) without conversion to an output format or any encoding.
+// The LVGL thread grabs the pixels and the worker pool hashes them while the caller waits.
+// FRAME_HASH_XXH64 hashes the display's native pixels row by row, so it only matches hashes
+// taken from the same display format; FRAME_HASH_CRC32C does the same with a 32-bit CRC that uses
+// the CPU's crc32 instruction when there is one. FRAME_HASH_DHASH is a 64-bit difference hash of
+// a 9x8 luma grid that ignores small, scattered changes such as anti-aliasing noise.
+int screenshot_hash_region(const screenshot_region_t *region, frame_hash_algo_t algo, uint64_t *hash,
+                           uint32_t *width, uint32_t *height) {
+    if (!hash) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    
+    if (!screenshot_state.initialized) {
+        printf("Screenshot system not initialized\n");
+        return TEST_ERROR_SCREENSHOT;
+    }
+    
+    screenshot_job_t *job = screenshot_job_acquire(region, NULL, SCREENSHOT_OP_HASH);
+    job->algo = algo;
+    screenshot_job_queue(job);
+    
+    int result = screenshot_job_wait(job, NULL, NULL);
+    if (result == TEST_OK) {
+        *hash = job->hash;
+        if (width) *width = job->width;
+        if (height) *height = job->height;
+    }
+    screenshot_job_release(job);
+    return result;
+}
+
+// Read the color of each point from the frame; points off screen come back invalid. The LVGL
+// thread samples them during its grab, the caller only waits for the values.
+int screenshot_probe_points(probe_point_t *points, int count) {
+    if (!points || count <= 0) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    
+    if (!screenshot_state.initialized) {
+        printf("Screenshot system not initialized\n");
+        return TEST_ERROR_SCREENSHOT;
+    }
+    
+    screenshot_job_t *job = screenshot_job_acquire(NULL, NULL, SCREENSHOT_OP_PROBE_POINTS);
+    job->points = points;
+    job->point_count = count;
+    screenshot_job_queue(job);
+    
+    int result = screenshot_job_wait(job, NULL, NULL);
+    screenshot_job_release(job);
+    return result;
+}
+
+// Mean, min/max and per-channel histograms of a region (the screen when NULL). With color set,
+// also counts the pixels within tolerance of it on every channel. The region is grabbed like a
+// capture and measured on the worker pool.
+int screenshot_probe_region(const screenshot_region_t *region, const uint8_t *color, const uint8_t tolerance[3],
+                            probe_stats_t *stats) {
+    if (!stats) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    
+    if (!screenshot_state.initialized) {
+        printf("Screenshot system not initialized\n");
+        return TEST_ERROR_SCREENSHOT;
+    }
+    
+    screenshot_job_t *job = screenshot_job_acquire(region, NULL, SCREENSHOT_OP_PROBE_REGION);
+    job->has_color = color != NULL;
+    if (color) {
+        memcpy(job->color, color, sizeof(job->color));
+    }
+    if (tolerance) {
+        memcpy(job->tolerance, tolerance, sizeof(job->tolerance));
+    } else {
+        memset(job->tolerance, 0, sizeof(job->tolerance));
+    }
+    screenshot_job_queue(job);
+    
+    int result = screenshot_job_wait(job, NULL, NULL);
+    if (result == TEST_OK) {
+        *stats = job->probe;
+    }
+    screenshot_job_release(job);
+    return result;
+}
+
 // Initialize screenshot system
 int screenshot_init(void) {
     printf("Initializing screenshot system...\n");
     
     // Allocate RGB buffer for conversions
-    screenshot_state.buffer_size = SCREENSHOT_WIDTH * SCREENSHOT_HEIGHT * SCREENSHOT_CHANNELS;
+    uint32_t width = SCREENSHOT_DEFAULT_SIZE, height = SCREENSHOT_DEFAULT_SIZE;
+    screenshot_display_size(&width, &height);
+    screenshot_state.buffer_size = (size_t)width * height * SCREENSHOT_CHANNELS;
     screenshot_state.rgb_buffer = malloc(screenshot_state.buffer_size);
     
     if (!screenshot_state.rgb_buffer) {
@@ -141,10 +1496,39 @@ int screenshot_init(void) {
         return TEST_ERROR_MEMORY;
     }
     
+    // Preallocate the PNG arena so the first captures don't have to grow it
+    screenshot_state.arena_size = SCREENSHOT_ARENA_INITIAL;
+    screenshot_state.arena = malloc(screenshot_state.arena_size);
+    if (!screenshot_state.arena) {
+        printf("Failed to allocate screenshot arena\n");
+        free(screenshot_state.rgb_buffer);
+        screenshot_state.rgb_buffer = NULL;
+        return TEST_ERROR_MEMORY;
+    }
+    
+    // Pick the SIMD conversion kernels for this CPU once, up front
+    pixel_convert_init();
+    
+    SHOT_MUTEX_INIT(&screenshot_state.lock);
+    SHOT_MUTEX_INIT(&screenshot_state.job_lock);
+    SHOT_COND_INIT(&screenshot_state.job_done);
+    
+    // Threads for parallel PNG encoding (one per spare core) and the asynchronous encode stage
+    worker_pool_init(0);
+    
     screenshot_state.initialized = 1;
     
 #ifdef HAVE_LVGL
-    printf("Screenshot system initialized with LVGL + stb_image_write support\n");
+    // Track frame versions from the main display's refresh cycle
+    lv_display_t *main_disp = lv_display_get_default();
+    if (main_disp) {
+        lv_display_add_event_cb(main_disp, screenshot_display_event_cb, LV_EVENT_REFR_START, NULL);
+        lv_display_add_event_cb(main_disp, screenshot_display_event_cb, LV_EVENT_FLUSH_START, NULL);
+        lv_display_add_event_cb(main_disp, screenshot_display_event_cb, LV_EVENT_REFR_READY, NULL);
+        screenshot_attach_shadow(main_disp);
+    }
+    
+    printf("Screenshot system initialized with LVGL + parallel PNG encoder\n");
 #else
     printf("Screenshot system initialized in stub mode (no LVGL)\n");
 #endif
@@ -156,11 +1540,50 @@ int screenshot_init(void) {
 void screenshot_cleanup(void) {
     printf("Cleaning up screenshot system...\n");
     
+    // Finishes any queued encode stage before the buffers go away
+    worker_pool_cleanup();
+    
     if (screenshot_state.rgb_buffer) {
         free(screenshot_state.rgb_buffer);
         screenshot_state.rgb_buffer = NULL;
     }
     
+#ifdef HAVE_LVGL
+    if (screenshot_state.draw_buf) {
+        lv_draw_buf_destroy(screenshot_state.draw_buf);
+        screenshot_state.draw_buf = NULL;
+    }
+    screenshot_detach_shadow();
+#endif
+    
+    free(screenshot_state.shadow);
+    screenshot_state.shadow = NULL;
+    screenshot_state.shadow_size = 0;
+    screenshot_state.shadow_valid = 0;
+    
+    screenshot_state.cached_png = NULL;
+    screenshot_state.cached_len = 0;
+    
+    for (int s = 0; s < MAX_SESSIONS; s++) {
+        for (int i = 0; i < MAX_SCREENSHOT_REGIONS; i++) {
+            free(screenshot_state.jobs[s][i].pixels);
+            free(screenshot_state.jobs[s][i].output);
+        }
+    }
+    memset(screenshot_state.jobs, 0, sizeof(screenshot_state.jobs));
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        free(screenshot_state.delta[i].pixels);
+    }
+    memset(screenshot_state.delta, 0, sizeof(screenshot_state.delta));
+    SHOT_COND_DESTROY(&screenshot_state.job_done);
+    SHOT_MUTEX_DESTROY(&screenshot_state.job_lock);
+    SHOT_MUTEX_DESTROY(&screenshot_state.lock);
+    
+    screenshot_arena_reset();
+    free(screenshot_state.arena);
+    screenshot_state.arena = NULL;
+    screenshot_state.arena_size = 0;
+    
     screenshot_state.initialized = 0;
     screenshot_state.buffer_size = 0;
     
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+// Check if we have LVGL available
+#ifdef HAVE_LVGL
+    #include "lvgl/lvgl.h"
+#endif
+
+#include "test_harness.h"
+
+#ifdef _MSC_VER
+    #define SESSION_THREAD_LOCAL __declspec(thread)
+#else
+    #define SESSION_THREAD_LOCAL __thread
+#endif
+
+// Session slots; 0 is the main display and always open
+enum {
+    SESSION_FREE = 0,
+    SESSION_STARTING,
+    SESSION_OPEN,
+    SESSION_STOPPING
+};
+
+typedef struct {
+    volatile int state;         // set by the LVGL thread; read back once command_queue_run returns
+#ifdef HAVE_LVGL
+    lv_display_t *display;
+    lv_group_t *group;          // focus group the session's keys go to
+    lv_indev_t *keypad;         // keypad on the session's display, feeding group
+    uint32_t key;               // what the keypad reports while session_send_key presses it
+    int key_pressed;
+#endif
+    uint8_t *framebuffer;
+    volatile uint32_t frame_version;
+    int frame_flushed;
+    uint32_t reset_us;          // last reset's time on the LVGL thread
+} session_t;
+
+// Sessions are opened by the TCP accept loop and closed by the client thread that owns them
+static struct {
+    session_t sessions[MAX_SESSIONS];
+} session_state = {0};
+
+// The session this thread acts on: a client thread's own, or on the LVGL thread the session
+// of the command being carried out
+static SESSION_THREAD_LOCAL int session_selected = 0;
+
+#ifdef HAVE_LVGL
+static uint64_t session_now_us(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// The pixels are already in the framebuffer, so a flush only has to report completion
+static void headless_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+    (void)area;
+    (void)px_map;
+    lv_display_flush_ready(disp);
+}
+
+// In-memory display: LVGL renders straight into a malloc'd framebuffer (DIRECT mode), no window.
+// The caller frees *framebuffer after deleting the display.
+lv_display_t *headless_display_create(int32_t width, int32_t height, uint8_t **framebuffer) {
+    *framebuffer = NULL;
+
+    lv_display_t *disp = lv_display_create(width, height);
+    if (disp == NULL) {
+        printf("Failed to create headless display\n");
+        return NULL;
+    }
+
+    lv_color_format_t cf = lv_display_get_color_format(disp);
+    uint32_t size = lv_draw_buf_width_to_stride((uint32_t)width, cf) * (uint32_t)height;
+    *framebuffer = malloc(size);
+    if (*framebuffer == NULL) {
+        printf("Failed to allocate headless framebuffer (%u bytes)\n", (unsigned)size);
+        lv_display_delete(disp);
+        return NULL;
+    }
+    memset(*framebuffer, 0, size);
+
+    lv_display_set_flush_cb(disp, headless_flush_cb);
+    lv_display_set_buffers(disp, *framebuffer, NULL, size, LV_DISPLAY_RENDER_MODE_DIRECT);
+
+    printf("Headless display created: %dx%d, %u byte framebuffer\n", (int)width, (int)height, (unsigned)size);
+    return disp;
+}
+
+// Same frame counting as the screenshot module does for the main display. The framebuffer
+// holds the whole finished frame, so the session's recording and flight recorder copy it directly.
+static void session_display_event_cb(lv_event_t *e) {
+    session_t *session = lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_FLUSH_START) {
+        session->frame_flushed = 1;
+    } else if (code == LV_EVENT_REFR_READY && session->frame_flushed) {
+        session->frame_flushed = 0;
+        session->frame_version++;
+
+        int index = (int)(session - session_state.sessions);
+        if (recorder_active(index) || history_enabled(index)) {
+            lv_color_format_t cf = lv_display_get_color_format(session->display);
+            if (cf == LV_COLOR_FORMAT_RGB565 || cf == LV_COLOR_FORMAT_ARGB8888 || cf == LV_COLOR_FORMAT_XRGB8888) {
+                screenshot_format_t format = cf == LV_COLOR_FORMAT_RGB565 ? SCREENSHOT_FORMAT_RGB565 : SCREENSHOT_FORMAT_ARGB8888;
+                uint32_t width = (uint32_t)lv_display_get_horizontal_resolution(session->display);
+                uint32_t height = (uint32_t)lv_display_get_vertical_resolution(session->display);
+                uint32_t stride = lv_draw_buf_width_to_stride(width, cf);
+                recorder_capture(index, session->framebuffer, stride, width, height, format, session->frame_version);
+                history_capture(index, session->framebuffer, stride, width, height, format, session->frame_version);
+            }
+        }
+    }
+}
+
+lv_display_t *session_get_display(int session) {
+    if (session <= 0 || session >= MAX_SESSIONS) {
+        return lv_display_get_default();
+    }
+    return session_state.sessions[session].display;
+}
+
+static void session_keypad_read_cb(lv_indev_t *indev, lv_indev_data_t *data) {
+    session_t *session = lv_indev_get_user_data(indev);
+    data->key = session->key;
+    data->state = session->key_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+// LVGL thread: the session's focus group, created on first use along with a keypad on the
+// session's display that feeds it. ui_watch_create makes it the default group while it builds,
+// so focusable widgets join their own session's group and keys never reach another session.
+lv_group_t *session_get_group(int index) {
+    if (index < 0 || index >= MAX_SESSIONS) {
+        return NULL;
+    }
+    
+    session_t *session = &session_state.sessions[index];
+    if (!session->group) {
+        session->group = lv_group_create();
+        session->keypad = lv_indev_create();
+        lv_indev_set_type(session->keypad, LV_INDEV_TYPE_KEYPAD);
+        lv_indev_set_read_cb(session->keypad, session_keypad_read_cb);
+        lv_indev_set_user_data(session->keypad, session);
+        lv_indev_set_display(session->keypad, session_get_display(index));
+        lv_indev_set_group(session->keypad, session->group);
+    }
+    return session->group;
+}
+
+// LVGL thread: press and release key on the session's keypad, so the focused widget of its
+// group gets the same events a real key would give it
+int session_send_key(int index, uint32_t key) {
+    if (!session_get_group(index)) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    
+    session_t *session = &session_state.sessions[index];
+    session->key = key;
+    session->key_pressed = 1;
+    lv_indev_read(session->keypad);
+    session->key_pressed = 0;
+    lv_indev_read(session->keypad);
+    return TEST_OK;
+}
+
+static void session_input_delete(session_t *session) {
+    if (session->keypad) {
+        lv_indev_delete(session->keypad);
+        session->keypad = NULL;
+    }
+    if (session->group) {
+        lv_group_delete(session->group);
+        session->group = NULL;
+    }
+    session->key_pressed = 0;
+}
+#endif
+
+// Queue a start/stop for the LVGL thread and wait until it has been carried out
+static void session_run(command_type_t type, int index) {
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = type;
+    cmd.session = index;
+    cmd.params.session.index = index;
+    command_queue_run(&cmd);
+}
+
+// Create a session with its own display and UI; returns its index, TEST_ERROR_BUSY when all
+// slots are taken or TEST_ERROR_MEMORY when the display could not be created
+int session_open(void) {
+#ifdef HAVE_LVGL
+    int index = -1;
+    for (int i = 1; i < MAX_SESSIONS; i++) {
+        if (session_state.sessions[i].state == SESSION_FREE) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        printf("No free session slot (%d sessions open)\n", MAX_SESSIONS);
+        return TEST_ERROR_BUSY;
+    }
+
+    session_state.sessions[index].state = SESSION_STARTING;
+    session_run(CMD_SESSION_OPEN, index);
+    if (session_state.sessions[index].state != SESSION_OPEN) {
+        return TEST_ERROR_MEMORY;
+    }
+    printf("Session %d opened\n", index);
+    return index;
+#else
+    printf("Sessions not available (no LVGL)\n");
+    return TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// Tear down a session's UI and display; the main session (0) stays
+void session_close(int session) {
+    if (session <= 0 || session >= MAX_SESSIONS || session_state.sessions[session].state != SESSION_OPEN) {
+        return;
+    }
+
+    recorder_stop(session, NULL);    // finish a recording the client left running
+    session_state.sessions[session].state = SESSION_STOPPING;
+    session_run(CMD_SESSION_CLOSE, session);
+    if (session_selected == session) {
+        session_selected = 0;
+    }
+    printf("Session %d closed\n", session);
+}
+
+void session_select(int session) {
+    if (session >= 0 && session < MAX_SESSIONS) {
+        session_selected = session;
+    }
+}
+
+int session_current(void) {
+    return session_selected;
+}
+
+// Open sessions, the main one included
+int session_count(void) {
+    int count = 1;
+    for (int i = 1; i < MAX_SESSIONS; i++) {
+        count += session_state.sessions[i].state == SESSION_OPEN;
+    }
+    return count;
+}
+
+uint32_t session_frame_version(int session) {
+    if (session <= 0 || session >= MAX_SESSIONS) {
+        return screenshot_frame_version();
+    }
+    return session_state.sessions[session].frame_version;
+}
+
+// Put the current session's UI back to its startup state without restarting anything.
+// elapsed_us gets the time the LVGL thread spent on it.
+int session_reset(int reseed, uint32_t seed, uint32_t *elapsed_us) {
+#ifdef HAVE_LVGL
+    int index = session_selected;
+    session_t *session = &session_state.sessions[index];
+    
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SESSION_RESET;
+    cmd.session = index;
+    cmd.params.session.index = index;
+    cmd.params.session.reseed = reseed;
+    cmd.params.session.seed = seed;
+    command_queue_run(&cmd);
+    
+    if (elapsed_us) {
+        *elapsed_us = session->reset_us;
+    }
+    return TEST_OK;
+#else
+    (void)reseed;
+    (void)seed;
+    (void)elapsed_us;
+    printf("Reset not available (no LVGL)\n");
+    return TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// LVGL thread, with the session selected: create its display at the main display's resolution
+// and build the UI on it
+void session_start(int index) {
+    session_t *session = &session_state.sessions[index];
+
+#ifdef HAVE_LVGL
+    lv_display_t *main_disp = lv_display_get_default();
+    if (main_disp) {
+        session->display = headless_display_create(lv_display_get_horizontal_resolution(main_disp),
+                                                   lv_display_get_vertical_resolution(main_disp),
+                                                   &session->framebuffer);
+    }
+    if (!session->display) {
+        session->state = SESSION_FREE;
+        return;
+    }
+
+    session->frame_version = 0;
+    session->frame_flushed = 0;
+    history_open(index);
+    lv_display_add_event_cb(session->display, session_display_event_cb, LV_EVENT_FLUSH_START, session);
+    lv_display_add_event_cb(session->display, session_display_event_cb, LV_EVENT_REFR_READY, session);
+
+    ui_watch_create();
+    lv_refr_now(session->display);
+
+    session->state = SESSION_OPEN;
+#else
+    session->state = SESSION_FREE;
+#endif
+}
+
+// LVGL thread, with the session selected: delete its UI, display and widget registry
+void session_stop(int index) {
+    session_t *session = &session_state.sessions[index];
+
+#ifdef HAVE_LVGL
+    ui_watch_destroy();
+    session_input_delete(session);
+    if (session->display) {
+        lv_display_delete(session->display);
+        session->display = NULL;
+    }
+    cleanup_registry();
+    ui_tree_reset(index);
+    history_close(index);
+#endif
+
+    free(session->framebuffer);
+    session->framebuffer = NULL;
+    session->state = SESSION_FREE;
+}
+
+// LVGL thread, with the session selected: drop its UI, input state and widget registry and build
+// them again. The data model starts over at its defaults; reseed makes later random readings repeatable.
+void session_rebuild(int index, int reseed, uint32_t seed) {
+#ifdef HAVE_LVGL
+    session_t *session = &session_state.sessions[index];
+    uint64_t start = session_now_us();
+    lv_display_t *disp = session_get_display(index);
+    
+    // Forget any press, long press or gesture in progress on this display
+    for (lv_indev_t *indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        if (lv_indev_get_display(indev) == disp) {
+            lv_indev_reset(indev, NULL);
+        }
+    }
+    
+    ui_watch_destroy();     // the UI's objects and its update timer
+    cleanup_registry();     // outstanding handles turn stale
+    ui_watch_create();
+    if (reseed) {
+        ui_watch_seed(seed);
+    }
+    lv_refr_now(disp);
+    
+    session->reset_us = (uint32_t)(session_now_us() - start);
+    printf("Session %d reset in %u us\n", index, (unsigned)session->reset_us);
+#else
+    (void)index;
+    (void)reseed;
+    (void)seed;
+#endif
+}
+
+// Shutdown: the LVGL thread is gone, so no commands are queued for it
+void session_cleanup(void) {
+    for (int i = 1; i < MAX_SESSIONS; i++) {
+        if (session_state.sessions[i].state != SESSION_FREE) {
+            session_selected = i;
+            session_stop(i);
+        }
+    }
+    session_selected = 0;
+}
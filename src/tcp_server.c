@@ -2,17 +2,33 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #ifdef _WIN32
     #include <winsock2.h>
     #include <ws2tcpip.h>
+    #include <process.h>
     #pragma comment(lib, "ws2_32.lib")
     #define close closesocket
     #define ssize_t int
     #define usleep(x) Sleep((x)/1000)
+    #define SHUT_RDWR SD_BOTH
+    #define strtok_r strtok_s
+    static CRITICAL_SECTION clients_mutex;
+    #define CLIENTS_INIT() InitializeCriticalSection(&clients_mutex)
+    #define CLIENTS_LOCK() EnterCriticalSection(&clients_mutex)
+    #define CLIENTS_UNLOCK() LeaveCriticalSection(&clients_mutex)
 #else
+    #include <pthread.h>
+    static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+    #define CLIENTS_INIT() ((void)0)
+    #define CLIENTS_LOCK() pthread_mutex_lock(&clients_mutex)
+    #define CLIENTS_UNLOCK() pthread_mutex_unlock(&clients_mutex)
     #include <unistd.h>
+    #include <signal.h>
+    #include <sys/types.h>
     #include <sys/socket.h>
+    #include <sys/select.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #define INVALID_SOCKET -1
@@ -25,16 +41,31 @@
 // JSON parsing (simple implementation for this prototype)
 #include <ctype.h>
 
+// One connected client and the session (display) its commands act on
+typedef struct {
+    SOCKET socket;
+    int session;
+} tcp_client_t;
+
 // Server state
 static struct {
     SOCKET server_socket;
-    SOCKET client_socket;
+    tcp_client_t clients[MAX_SESSIONS];     // guarded by clients_mutex once client threads run
+    int client_count;
     struct sockaddr_in server_addr;
     int port;
     volatile int running;
-    volatile int client_connected;
+    
+    // Zygote children serve one test: they stop once their clients are gone, or when nobody
+    // connects before the deadline
+    int exit_when_idle;
+    int served;
+    time_t idle_deadline;
 } tcp_server = {0};
 
+// How long a spawned child waits for its first connection
+#define SPAWN_CONNECT_TIMEOUT_S 30
+
 // JSON parsing helpers
 typedef struct {
     char *data;
@@ -92,6 +123,71 @@ static int parse_int(json_parser_t *parser) {
     return value;
 }
 
+static int parse_uint(json_parser_t *parser, uint32_t *out) {
+    skip_whitespace(parser);
+    if (parser->pos >= parser->len || !isdigit(parser->data[parser->pos])) {
+        return -1;
+    }
+    
+    uint32_t value = 0;
+    while (parser->pos < parser->len && isdigit(parser->data[parser->pos])) {
+        value = value * 10 + (uint32_t)(parser->data[parser->pos] - '0');
+        parser->pos++;
+    }
+    
+    *out = value;
+    return 0;
+}
+
+// true for a literal true, false for anything else
+static int parse_bool(json_parser_t *parser) {
+    skip_whitespace(parser);
+    return parser->pos + 4 <= parser->len && strncmp(parser->data + parser->pos, "true", 4) == 0;
+}
+
+// Skip one value of any type; arrays and objects are skipped with their nested contents
+static void skip_value(json_parser_t *parser) {
+    skip_whitespace(parser);
+    if (parser->pos >= parser->len) {
+        return;
+    }
+    
+    char c = parser->data[parser->pos];
+    if (c == '"') {
+        // Skip string value
+        parser->pos++;
+        while (parser->pos < parser->len && parser->data[parser->pos] != '"') {
+            if (parser->data[parser->pos] == '\\') parser->pos++;
+            parser->pos++;
+        }
+        parser->pos++;
+    } else if (c == '[' || c == '{') {
+        // Skip container, tracking depth outside of strings
+        int depth = 0;
+        int in_string = 0;
+        while (parser->pos < parser->len) {
+            char ch = parser->data[parser->pos++];
+            if (in_string) {
+                if (ch == '\\') parser->pos++;
+                else if (ch == '"') in_string = 0;
+            } else if (ch == '"') {
+                in_string = 1;
+            } else if (ch == '[' || ch == '{') {
+                depth++;
+            } else if ((ch == ']' || ch == '}') && --depth == 0) {
+                break;
+            }
+        }
+    } else {
+        // Number, true, false or null
+        while (parser->pos < parser->len && parser->data[parser->pos] != ',' &&
+               parser->data[parser->pos] != '}' && parser->data[parser->pos] != ']' &&
+               !isspace(parser->data[parser->pos])) {
+            parser->pos++;
+        }
+    }
+}
+
 static int find_key(json_parser_t *parser, const char *key) {
     char current_key[64];
     
@@ -127,22 +223,7 @@ static int find_key(json_parser_t *parser, const char *key) {
             return 0; // found key, parser is positioned at value
         }
         
-        // Skip value (simple implementation)
-        skip_whitespace(parser);
-        if (parser->data[parser->pos] == '"') {
-            // Skip string value
-            parser->pos++;
-            while (parser->pos < parser->len && parser->data[parser->pos] != '"') {
-                parser->pos++;
-            }
-            parser->pos++;
-        } else if (isdigit(parser->data[parser->pos]) || parser->data[parser->pos] == '-') {
-            // Skip number value
-            if (parser->data[parser->pos] == '-') parser->pos++;
-            while (parser->pos < parser->len && (isdigit(parser->data[parser->pos]) || parser->data[parser->pos] == '.')) {
-                parser->pos++;
-            }
-        }
+        skip_value(parser);
         
         // Skip comma
         skip_whitespace(parser);
@@ -161,20 +242,605 @@ static void send_response(SOCKET client, const char *response) {
     if (sent != (ssize_t)len) {
         printf("Failed to send complete response\n");
     }
-    printf("Sent response: %s\n", response);
-}
-
-static void send_error_response(SOCKET client, const char *cmd, const char *error) {
-    char response[256];
-    snprintf(response, sizeof(response), 
-             "{\"status\":\"error\",\"cmd\":\"%s\",\"error\":\"%s\"}\n", 
-             cmd ? cmd : "unknown", error);
-    send_response(client, response);
-}
-
-static void send_ok_response(SOCKET client, const char *cmd) {
-    char response[128];
-    snprintf(response, sizeof(response), "{\"status\":\"ok\",\"cmd\":\"%s\"}\n", cmd);
+    printf("Sent response: %s\n", response);
+}
+
+static void send_error_response(SOCKET client, const char *cmd, const char *error) {
+    char response[256];
+    snprintf(response, sizeof(response), 
+             "{\"status\":\"error\",\"cmd\":\"%s\",\"error\":\"%s\"}\n", 
+             cmd ? cmd : "unknown", error);
+    send_response(client, response);
+}
+
+static void send_ok_response(SOCKET client, const char *cmd) {
+    char response[128];
+    snprintf(response, sizeof(response), "{\"status\":\"ok\",\"cmd\":\"%s\"}\n", cmd);
+    send_response(client, response);
+}
+
+// Parse the widget a command targets: a numeric "h" from resolve, or an "id" string. Neither is
+// looked up here; the LVGL thread does that (find_widget_ref) when it carries the command out,
+// against the session's registry as it is then.
+static int parse_widget_ref(json_parser_t *parser, widget_handle_t *handle, char *id_buf, size_t id_len) {
+    *handle = WIDGET_HANDLE_INVALID;
+    if (find_key(parser, "h") == 0 && parse_uint(parser, handle) == 0) {
+        return *handle != WIDGET_HANDLE_INVALID ? TEST_OK : TEST_ERROR_NOT_FOUND;
+    }
+    
+    if (find_key(parser, "id") != 0 || parse_string(parser, id_buf, id_len) != 0) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    return TEST_OK;
+}
+
+static void send_widget_ref_error(SOCKET client, const char *cmd, int result) {
+    if (result == TEST_ERROR_STALE_HANDLE) {
+        send_error_response(client, cmd, "stale_handle");
+    } else if (result == TEST_ERROR_NOT_FOUND) {
+        send_error_response(client, cmd, "invalid_handle");
+    } else {
+        send_error_response(client, cmd, "missing_id");
+    }
+}
+
+// Queue a command for the LVGL thread, on this client's session, and wait for it
+static int run_command(command_t *cmd) {
+    cmd->session = session_current();
+    command_queue_run(cmd);
+    return cmd->result;
+}
+
+// Report a widget command that failed: a bad handle as such, anything else as an unknown widget
+static void send_widget_error(SOCKET client, const char *name, const command_t *cmd) {
+    if (cmd->result == TEST_ERROR_STALE_HANDLE ||
+        (cmd->handle != WIDGET_HANDLE_INVALID && cmd->result == TEST_ERROR_NOT_FOUND)) {
+        send_widget_ref_error(client, name, cmd->result);
+    } else {
+        send_error_response(client, name, "widget_not_found");
+    }
+}
+
+// Parse an array of exactly count (possibly negative) integers at the current position
+static int parse_int_array(json_parser_t *parser, int *values, int count) {
+    skip_whitespace(parser);
+    if (parser->pos >= parser->len || parser->data[parser->pos] != '[') {
+        return -1;
+    }
+    parser->pos++;
+    
+    for (int i = 0; i < count; i++) {
+        skip_whitespace(parser);
+        int negative = 0;
+        if (parser->pos < parser->len && parser->data[parser->pos] == '-') {
+            negative = 1;
+            parser->pos++;
+        }
+        int value = parse_int(parser);
+        if (value < 0) {
+            return -1;
+        }
+        values[i] = negative ? -value : value;
+        
+        skip_whitespace(parser);
+        char expected = (i < count - 1) ? ',' : ']';
+        if (parser->pos >= parser->len || parser->data[parser->pos] != expected) {
+            return -1;
+        }
+        parser->pos++;
+    }
+    return 0;
+}
+
+// Parse "[x,y,w,h]" at the current position
+static int parse_rect(json_parser_t *parser, screenshot_region_t *region) {
+    int values[4];
+    if (parse_int_array(parser, values, 4) != 0) {
+        return -1;
+    }
+    
+    region->x = values[0];
+    region->y = values[1];
+    region->w = values[2];
+    region->h = values[3];
+    return 0;
+}
+
+// Fill a capture region from "rect":[x,y,w,h] or a widget reference ("h"/"id").
+// Returns 1 when a region was given, 0 for the whole screen, or a TEST_ERROR_* code.
+static int parse_screenshot_region(json_parser_t *parser, screenshot_region_t *region) {
+    memset(region, 0, sizeof(*region));
+    
+    if (find_key(parser, "rect") == 0) {
+        return parse_rect(parser, region) == 0 ? 1 : TEST_ERROR_INVALID_PARAM;
+    }
+    
+    if (find_key(parser, "h") == 0 || find_key(parser, "id") == 0) {
+        int ref = parse_widget_ref(parser, &region->handle, region->id, sizeof(region->id));
+        return ref == TEST_OK ? 1 : ref;
+    }
+    
+    return 0;
+}
+
+static const char *screenshot_error_name(int result) {
+    switch (result) {
+        case TEST_ERROR_STALE_HANDLE: return "stale_handle";
+        case TEST_ERROR_NOT_FOUND: return "invalid_handle";
+        case TEST_ERROR_INVALID_WIDGET: return "widget_not_found";
+        case TEST_ERROR_INVALID_PARAM: return "invalid_region";
+        default: return "screenshot_failed";
+    }
+}
+
+static const char *screenshot_format_names[] = { "png", "rgb24", "argb8888", "rgb565", "qoi" };
+
+static const char *png_filter_names[] = { "none", "sub", "up", "avg", "paeth" };
+
+// "format":"png"|"rgb24"|"argb8888"|"rgb565"|"qoi" and "compress":"lz4" (raw formats only)
+static int parse_screenshot_options(json_parser_t *parser, screenshot_options_t *options) {
+    char value[16];
+    uint32_t number;
+    
+    memset(options, 0, sizeof(*options));
+    options->png.level = PNG_LEVEL_DEFAULT;
+    options->png.filter = PNG_FILTER_ADAPTIVE;
+    
+    if (find_key(parser, "format") == 0) {
+        if (parse_string(parser, value, sizeof(value)) != 0) {
+            return -1;
+        }
+        int found = (strcmp(value, "PNG") == 0);
+        for (int i = 0; i < (int)(sizeof(screenshot_format_names) / sizeof(screenshot_format_names[0])); i++) {
+            if (strcmp(value, screenshot_format_names[i]) == 0) {
+                options->format = (screenshot_format_t)i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return -1;
+        }
+    }
+    
+    if (find_key(parser, "compress") == 0) {
+        if (parse_string(parser, value, sizeof(value)) != 0) {
+            return -1;
+        }
+        if (strcmp(value, "lz4") == 0) {
+            options->compress = 1;
+        } else if (strcmp(value, "none") != 0) {
+            return -1;
+        }
+    }
+    
+    // PNG tuning: "level" 0 (store) .. 9, "filter" adaptive/none/sub/up/avg/paeth, "threads" bands
+    if (find_key(parser, "level") == 0) {
+        if (parse_uint(parser, &number) != 0 || number > 9) {
+            return -1;
+        }
+        options->png.level = (int)number;
+    }
+    
+    if (find_key(parser, "filter") == 0) {
+        if (parse_string(parser, value, sizeof(value)) != 0) {
+            return -1;
+        }
+        int found = (strcmp(value, "adaptive") == 0);
+        for (int i = 0; i < (int)(sizeof(png_filter_names) / sizeof(png_filter_names[0])); i++) {
+            if (strcmp(value, png_filter_names[i]) == 0) {
+                options->png.filter = i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return -1;
+        }
+    }
+    
+    if (find_key(parser, "threads") == 0) {
+        if (parse_uint(parser, &number) != 0 || number > 64) {
+            return -1;
+        }
+        options->png.bands = (int)number;
+    }
+    
+    // Delta capture: only the areas changed since the previous delta frame on this connection
+    if (find_key(parser, "delta") == 0) {
+        options->delta = parse_bool(parser);
+    }
+    
+    return 0;
+}
+
+// "tolerance": one value for all channels or [r,g,b], each 0..255
+static int parse_tolerance(json_parser_t *parser, uint8_t tolerance[3]) {
+    uint32_t value;
+    
+    skip_whitespace(parser);
+    if (parser->pos < parser->len && parser->data[parser->pos] != '[') {
+        if (parse_uint(parser, &value) != 0 || value > 255) {
+            return -1;
+        }
+        tolerance[0] = tolerance[1] = tolerance[2] = (uint8_t)value;
+        return 0;
+    }
+    parser->pos++;
+    
+    for (int i = 0; i < 3; i++) {
+        skip_whitespace(parser);
+        if (parse_uint(parser, &value) != 0 || value > 255) {
+            return -1;
+        }
+        tolerance[i] = (uint8_t)value;
+        
+        skip_whitespace(parser);
+        char expected = (i < 2) ? ',' : ']';
+        if (parser->pos >= parser->len || parser->data[parser->pos] != expected) {
+            return -1;
+        }
+        parser->pos++;
+    }
+    return 0;
+}
+
+static const char *compare_error_name(int result) {
+    switch (result) {
+        case TEST_ERROR_SIZE_MISMATCH: return "size_mismatch";
+        case TEST_ERROR_MEMORY: return "out_of_memory";
+        default: return screenshot_error_name(result);
+    }
+}
+
+// Header line plus payload; index >= 0 tags replies that belong to a multi-region capture
+static void send_screenshot(SOCKET client, const screenshot_image_t *image, const screenshot_stats_t *stats,
+                            int index) {
+    char index_field[24] = "";
+    if (index >= 0) {
+        snprintf(index_field, sizeof(index_field), ",\"index\":%d", index);
+    }
+    
+    char header[384];
+    if (image->format == SCREENSHOT_FORMAT_PNG || image->format == SCREENSHOT_FORMAT_QOI) {
+        snprintf(header, sizeof(header), 
+                 "{\"status\":\"ok\",\"type\":\"screenshot\",\"width\":%u,\"height\":%u,\"format\":\"%s\",\"len\":%zu,\"allocs\":%u,\"encode_us\":%u,\"frame_version\":%u,\"cached\":%s%s}\n", 
+                 image->width, image->height, image->format == SCREENSHOT_FORMAT_QOI ? "QOI" : "PNG",
+                 image->len, stats->allocs_last, stats->encode_us, stats->frame_version,
+                 stats->cache_hit ? "true" : "false", index_field);
+    } else {
+        // Raw pixels, tightly packed rows
+        snprintf(header, sizeof(header),
+                 "{\"status\":\"ok\",\"type\":\"screenshot_raw\",\"width\":%u,\"height\":%u,\"format\":\"%s\",\"stride\":%zu,\"compression\":\"%s\",\"raw_len\":%zu,\"len\":%zu,\"allocs\":%u,\"encode_us\":%u,\"frame_version\":%u%s}\n",
+                 image->width, image->height, screenshot_format_names[image->format],
+                 image->raw_len / image->height, image->compressed ? "lz4" : "none",
+                 image->raw_len, image->len, stats->allocs_last, stats->encode_us, stats->frame_version, index_field);
+    }
+    send_response(client, header);
+    
+    // Send image data
+    ssize_t sent = send(client, (char*)image->data, (int)image->len, 0);
+    if (sent != (ssize_t)image->len) {
+        printf("Failed to send complete screenshot data\n");
+    } else {
+        printf("Screenshot sent: %zu bytes %s (%ux%u)\n", image->len,
+               screenshot_format_names[image->format], image->width, image->height);
+    }
+    
+    // Image data belongs to the capture job and is reused once the job is released
+}
+
+// Delta capture reply: header line listing [x,y,w,h,len,raw_len] per changed rectangle, then
+// the rectangles' encodings back to back. No rectangles means the frame is unchanged.
+static void send_screenshot_delta(SOCKET client, const screenshot_image_t *image, const screenshot_stats_t *stats) {
+    char header[384 + MAX_DELTA_RECTS * 64];
+    int used = snprintf(header, sizeof(header),
+                        "{\"status\":\"ok\",\"type\":\"screenshot_delta\",\"width\":%u,\"height\":%u,\"format\":\"%s\",\"compression\":\"%s\",\"keyframe\":%s,\"len\":%zu,\"allocs\":%u,\"encode_us\":%u,\"frame_version\":%u,\"rects\":[",
+                        image->width, image->height, screenshot_format_names[image->format],
+                        image->compressed ? "lz4" : "none", image->keyframe ? "true" : "false",
+                        image->len, stats->allocs_last, stats->encode_us, stats->frame_version);
+    for (int i = 0; i < image->rect_count && used < (int)sizeof(header) - 64; i++) {
+        const screenshot_rect_t *rect = &image->rects[i];
+        used += snprintf(header + used, sizeof(header) - (size_t)used, "%s[%d,%d,%d,%d,%zu,%zu]",
+                         i ? "," : "", rect->x, rect->y, rect->w, rect->h, rect->len, rect->raw_len);
+    }
+    snprintf(header + used, sizeof(header) - (size_t)used, "]}\n");
+    send_response(client, header);
+    
+    if (image->len > 0) {
+        ssize_t sent = send(client, (char*)image->data, (int)image->len, 0);
+        if (sent != (ssize_t)image->len) {
+            printf("Failed to send complete delta screenshot\n");
+            return;
+        }
+    }
+    printf("Delta screenshot sent: %d rect(s), %zu bytes\n", image->rect_count, image->len);
+}
+
+// Split "regions":[{...},...] at the current position into one sub-parser per region.
+// Returns NULL on success, otherwise the error name to report.
+static const char *parse_region_list(json_parser_t *parser, json_parser_t items[MAX_SCREENSHOT_REGIONS], int *count) {
+    *count = 0;
+    
+    skip_whitespace(parser);
+    if (parser->pos >= parser->len || parser->data[parser->pos] != '[') {
+        return "invalid_regions";
+    }
+    parser->pos++;
+    
+    while (parser->pos < parser->len) {
+        skip_whitespace(parser);
+        char c = parser->data[parser->pos];
+        if (c == ']') {
+            break;
+        }
+        if (c == ',') {
+            parser->pos++;
+            continue;
+        }
+        if (c != '{' || *count >= MAX_SCREENSHOT_REGIONS) {
+            return c != '{' ? "invalid_regions" : "too_many_regions";
+        }
+        
+        size_t start = parser->pos;
+        skip_value(parser);
+        items[*count].data = parser->data + start;
+        items[*count].pos = 0;
+        items[*count].len = parser->pos - start;
+        (*count)++;
+    }
+    
+    return *count > 0 ? NULL : "invalid_regions";
+}
+
+// "regions":[{...},...] - one summary line, then one screenshot reply per region in order.
+// All regions are submitted up front so they are grabbed from the same frame; each reply goes
+// out as soon as its encode finishes while the later ones are still encoding.
+static void process_screenshot_regions(SOCKET client, json_parser_t *parser, const screenshot_options_t *options) {
+    json_parser_t items[MAX_SCREENSHOT_REGIONS];
+    int count = 0;
+    
+    const char *error = parse_region_list(parser, items, &count);
+    if (error) {
+        send_error_response(client, "screenshot", error);
+        return;
+    }
+    
+    char summary[96];
+    snprintf(summary, sizeof(summary), "{\"status\":\"ok\",\"type\":\"screenshot_multi\",\"count\":%d}\n", count);
+    send_response(client, summary);
+    
+    screenshot_job_t *jobs[MAX_SCREENSHOT_REGIONS];
+    int results[MAX_SCREENSHOT_REGIONS];
+    for (int i = 0; i < count; i++) {
+        screenshot_region_t region;
+        jobs[i] = NULL;
+        results[i] = parse_screenshot_region(&items[i], &region);
+        if (results[i] >= 0) {
+            results[i] = screenshot_submit(results[i] ? &region : NULL, options, &jobs[i]);
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        screenshot_image_t image;
+        screenshot_stats_t stats;
+        int result = results[i];
+        if (jobs[i]) {
+            result = screenshot_job_wait(jobs[i], &image, &stats);
+        }
+        
+        if (result == TEST_OK) {
+            send_screenshot(client, &image, &stats, i);
+        } else {
+            char response[160];
+            snprintf(response, sizeof(response),
+                     "{\"status\":\"error\",\"type\":\"screenshot\",\"index\":%d,\"error\":\"%s\"}\n",
+                     i, screenshot_error_name(result));
+            send_response(client, response);
+        }
+        screenshot_job_release(jobs[i]);
+    }
+}
+
+static const char *frame_hash_algo_names[] = { "xxh64", "dhash", "crc32c" };
+
+// frame_hash: 64-bit hashes of the screen, one region, or a "regions" list, in a single reply line
+static void process_frame_hash(SOCKET client, json_parser_t *parser) {
+    frame_hash_algo_t algo = FRAME_HASH_XXH64;
+    if (find_key(parser, "algo") == 0) {
+        char value[16];
+        if (parse_string(parser, value, sizeof(value)) != 0) {
+            send_error_response(client, "frame_hash", "invalid_algo");
+            return;
+        }
+        int found = 0;
+        for (int i = 0; i < (int)(sizeof(frame_hash_algo_names) / sizeof(frame_hash_algo_names[0])); i++) {
+            if (strcmp(value, frame_hash_algo_names[i]) == 0) {
+                algo = (frame_hash_algo_t)i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            send_error_response(client, "frame_hash", "invalid_algo");
+            return;
+        }
+    }
+    
+    char response[768];
+    
+    if (find_key(parser, "regions") == 0) {
+        json_parser_t items[MAX_SCREENSHOT_REGIONS];
+        int count = 0;
+        const char *error = parse_region_list(parser, items, &count);
+        if (error) {
+            send_error_response(client, "frame_hash", error);
+            return;
+        }
+        
+        // Failed regions report null in their slot
+        int len = snprintf(response, sizeof(response), "{\"status\":\"ok\",\"type\":\"frame_hash\",\"algo\":\"%s\",\"hashes\":[",
+                           frame_hash_algo_names[algo]);
+        for (int i = 0; i < count; i++) {
+            screenshot_region_t region;
+            uint64_t hash = 0;
+            int result = parse_screenshot_region(&items[i], &region);
+            if (result >= 0) {
+                result = screenshot_hash_region(result ? &region : NULL, algo, &hash, NULL, NULL);
+            }
+            if (result == TEST_OK) {
+                len += snprintf(response + len, sizeof(response) - (size_t)len, "%s\"%016llx\"",
+                                i ? "," : "", (unsigned long long)hash);
+            } else {
+                len += snprintf(response + len, sizeof(response) - (size_t)len, "%snull", i ? "," : "");
+            }
+        }
+        snprintf(response + len, sizeof(response) - (size_t)len, "],\"frame_version\":%u}\n",
+                 screenshot_frame_version());
+        send_response(client, response);
+        return;
+    }
+    
+    screenshot_region_t region;
+    int has_region = parse_screenshot_region(parser, &region);
+    if (has_region < 0) {
+        send_error_response(client, "frame_hash", screenshot_error_name(has_region));
+        return;
+    }
+    
+    uint64_t hash = 0;
+    uint32_t width = 0, height = 0;
+    int result = screenshot_hash_region(has_region ? &region : NULL, algo, &hash, &width, &height);
+    if (result != TEST_OK) {
+        send_error_response(client, "frame_hash", screenshot_error_name(result));
+        return;
+    }
+    
+    snprintf(response, sizeof(response),
+             "{\"status\":\"ok\",\"type\":\"frame_hash\",\"algo\":\"%s\",\"hash\":\"%016llx\",\"width\":%u,\"height\":%u,\"frame_version\":%u}\n",
+             frame_hash_algo_names[algo], (unsigned long long)hash, width, height, screenshot_frame_version());
+    send_response(client, response);
+}
+
+// "points":[[x,y],...] at the current position
+static int parse_point_list(json_parser_t *parser, probe_point_t *points, int *count) {
+    *count = 0;
+    
+    skip_whitespace(parser);
+    if (parser->pos >= parser->len || parser->data[parser->pos] != '[') {
+        return -1;
+    }
+    parser->pos++;
+    
+    while (parser->pos < parser->len) {
+        skip_whitespace(parser);
+        char c = parser->data[parser->pos];
+        if (c == ']') {
+            break;
+        }
+        if (c == ',') {
+            parser->pos++;
+            continue;
+        }
+        
+        int xy[2];
+        if (*count >= MAX_PROBE_POINTS || parse_int_array(parser, xy, 2) != 0) {
+            return -1;
+        }
+        points[*count].x = xy[0];
+        points[*count].y = xy[1];
+        (*count)++;
+    }
+    
+    return *count > 0 ? 0 : -1;
+}
+
+// probe: colors at "points" and statistics for "regions", read from the frame in one reply line.
+// "color" (+ "tolerance") also counts the matching pixels of each region.
+static void process_probe(SOCKET client, json_parser_t *parser) {
+    probe_point_t points[MAX_PROBE_POINTS];
+    int point_count = 0;
+    if (find_key(parser, "points") == 0 && parse_point_list(parser, points, &point_count) != 0) {
+        send_error_response(client, "probe", "invalid_points");
+        return;
+    }
+    
+    json_parser_t items[MAX_SCREENSHOT_REGIONS];
+    int region_count = 0;
+    if (find_key(parser, "regions") == 0) {
+        const char *error = parse_region_list(parser, items, &region_count);
+        if (error) {
+            send_error_response(client, "probe", error);
+            return;
+        }
+    }
+    
+    if (point_count == 0 && region_count == 0) {
+        send_error_response(client, "probe", "invalid_probe");
+        return;
+    }
+    
+    uint8_t color[3];
+    uint8_t tolerance[3] = { 0, 0, 0 };
+    int has_color = find_key(parser, "color") == 0;
+    if ((has_color && parse_tolerance(parser, color) != 0) ||
+        (find_key(parser, "tolerance") == 0 && parse_tolerance(parser, tolerance) != 0)) {
+        send_error_response(client, "probe", "invalid_color");
+        return;
+    }
+    
+    if (point_count > 0) {
+        int result = screenshot_probe_points(points, point_count);
+        if (result != TEST_OK) {
+            send_error_response(client, "probe", screenshot_error_name(result));
+            return;
+        }
+    }
+    
+    // Worst case: ~600 bytes per region with full histograms, ~16 per point
+    char response[12288];
+    int len = snprintf(response, sizeof(response), "{\"status\":\"ok\",\"type\":\"probe\",\"points\":[");
+    for (int i = 0; i < point_count; i++) {
+        const probe_point_t *point = &points[i];
+        if (point->valid) {
+            len += snprintf(response + len, sizeof(response) - (size_t)len, "%s[%u,%u,%u]", i ? "," : "",
+                            point->rgb[0], point->rgb[1], point->rgb[2]);
+        } else {
+            len += snprintf(response + len, sizeof(response) - (size_t)len, "%snull", i ? "," : "");
+        }
+    }
+    len += snprintf(response + len, sizeof(response) - (size_t)len, "],\"regions\":[");
+    
+    // Failed regions report their error in their slot
+    for (int i = 0; i < region_count; i++) {
+        screenshot_region_t region;
+        probe_stats_t stats;
+        int result = parse_screenshot_region(&items[i], &region);
+        if (result >= 0) {
+            result = screenshot_probe_region(result ? &region : NULL, has_color ? color : NULL, tolerance, &stats);
+        }
+        if (result != TEST_OK) {
+            len += snprintf(response + len, sizeof(response) - (size_t)len, "%s{\"error\":\"%s\"}",
+                            i ? "," : "", screenshot_error_name(result));
+            continue;
+        }
+        
+        len += snprintf(response + len, sizeof(response) - (size_t)len,
+                        "%s{\"width\":%u,\"height\":%u,\"mean\":[%.2f,%.2f,%.2f],\"min\":[%u,%u,%u],\"max\":[%u,%u,%u],\"hist\":[",
+                        i ? "," : "", stats.width, stats.height, stats.mean[0], stats.mean[1], stats.mean[2],
+                        stats.min[0], stats.min[1], stats.min[2], stats.max[0], stats.max[1], stats.max[2]);
+        for (int c = 0; c < 3; c++) {
+            for (int b = 0; b < PROBE_HIST_BINS; b++) {
+                len += snprintf(response + len, sizeof(response) - (size_t)len, "%s%u",
+                                b ? "," : (c ? ",[" : "["), stats.hist[c][b]);
+            }
+            len += snprintf(response + len, sizeof(response) - (size_t)len, "]");
+        }
+        len += snprintf(response + len, sizeof(response) - (size_t)len, "]");
+        if (has_color) {
+            len += snprintf(response + len, sizeof(response) - (size_t)len, ",\"matches\":%u", stats.matches);
+        }
+        len += snprintf(response + len, sizeof(response) - (size_t)len, "}");
+    }
+    snprintf(response + len, sizeof(response) - (size_t)len, "],\"frame_version\":%u}\n",
+             screenshot_frame_version());
     send_response(client, response);
 }
 
@@ -192,25 +858,29 @@ static void process_command(SOCKET client, const char *json_cmd) {
         return;
     }
     
+    // Recorded frames are tagged with the command that preceded them
+    recorder_note_command(session_current(), json_cmd, parser.len);
+    
     // Process different command types - direct calls for now
     if (strcmp(cmd, "click") == 0) {
-        char id[64] = {0};
-        if (find_key(&parser, "id") != 0 || parse_string(&parser, id, sizeof(id)) != 0) {
-            send_error_response(client, cmd, "missing_id");
+        command_t click = { .type = CMD_CLICK };
+        int ref = parse_widget_ref(&parser, &click.handle, click.widget_id, sizeof(click.widget_id));
+        if (ref != TEST_OK) {
+            send_widget_ref_error(client, cmd, ref);
             return;
         }
         
-        int result = test_click(id);
-        if (result == TEST_OK) {
+        if (run_command(&click) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
-            send_error_response(client, cmd, "widget_not_found");
+            send_widget_error(client, cmd, &click);
         }
         
     } else if (strcmp(cmd, "longpress") == 0) {
-        char id[64] = {0};
-        if (find_key(&parser, "id") != 0 || parse_string(&parser, id, sizeof(id)) != 0) {
-            send_error_response(client, cmd, "missing_id");
+        command_t press = { .type = CMD_LONGPRESS };
+        int ref = parse_widget_ref(&parser, &press.handle, press.widget_id, sizeof(press.widget_id));
+        if (ref != TEST_OK) {
+            send_widget_ref_error(client, cmd, ref);
             return;
         }
         
@@ -219,12 +889,12 @@ static void process_command(SOCKET client, const char *json_cmd) {
             ms = parse_int(&parser);
             if (ms <= 0) ms = 1000;
         }
+        press.params.longpress.ms = (uint32_t)ms;
         
-        int result = test_longpress(id, ms);
-        if (result == TEST_OK) {
+        if (run_command(&press) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
-            send_error_response(client, cmd, "widget_not_found");
+            send_widget_error(client, cmd, &press);
         }
         
     } else if (strcmp(cmd, "swipe") == 0) {
@@ -238,8 +908,8 @@ static void process_command(SOCKET client, const char *json_cmd) {
             return;
         }
         
-        int result = test_swipe(x1, y1, x2, y2);
-        if (result == TEST_OK) {
+        command_t swipe = { .type = CMD_SWIPE, .params.swipe = { x1, y1, x2, y2 } };
+        if (run_command(&swipe) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
             send_error_response(client, cmd, "swipe_failed");
@@ -252,21 +922,22 @@ static void process_command(SOCKET client, const char *json_cmd) {
             return;
         }
         
-        int result = test_key_event(code);
-        if (result == TEST_OK) {
+        command_t key = { .type = CMD_KEY_EVENT, .params.key.code = code };
+        if (run_command(&key) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
             send_error_response(client, cmd, "key_event_failed");
         }
         
     } else if (strcmp(cmd, "get_state") == 0) {
-        char id[64] = {0};
-        if (find_key(&parser, "id") != 0 || parse_string(&parser, id, sizeof(id)) != 0) {
-            send_error_response(client, cmd, "missing_id");
+        command_t get = { .type = CMD_GET_TEXT };
+        int ref = parse_widget_ref(&parser, &get.handle, get.widget_id, sizeof(get.widget_id));
+        if (ref != TEST_OK) {
+            send_widget_ref_error(client, cmd, ref);
             return;
         }
         
-        char *text = test_get_text(id);
+        char *text = run_command(&get) == TEST_OK ? get.response_text : NULL;
         if (text) {
             char response[512];
             snprintf(response, sizeof(response), 
@@ -275,53 +946,365 @@ static void process_command(SOCKET client, const char *json_cmd) {
             send_response(client, response);
             free(text);
         } else {
-            send_error_response(client, cmd, "widget_not_found");
+            send_widget_error(client, cmd, &get);
         }
         
     } else if (strcmp(cmd, "set_text") == 0) {
-        char id[64] = {0};
-        char text[256] = {0};
+        command_t set = { .type = CMD_SET_TEXT };
         
-        if (find_key(&parser, "id") != 0 || parse_string(&parser, id, sizeof(id)) != 0 ||
-            find_key(&parser, "text") != 0 || parse_string(&parser, text, sizeof(text)) != 0) {
+        int ref = parse_widget_ref(&parser, &set.handle, set.widget_id, sizeof(set.widget_id));
+        if (ref != TEST_OK ||
+            find_key(&parser, "text") != 0 ||
+            parse_string(&parser, set.params.set_text.text, sizeof(set.params.set_text.text)) != 0) {
             send_error_response(client, cmd, "missing_parameters");
             return;
         }
         
-        int result = test_set_text(id, text);
-        if (result == TEST_OK) {
+        if (run_command(&set) == TEST_OK) {
             send_ok_response(client, cmd);
+        } else {
+            send_widget_error(client, cmd, &set);
+        }
+        
+    } else if (strcmp(cmd, "resolve") == 0) {
+        char id[64] = {0};
+        if (find_key(&parser, "id") != 0 || parse_string(&parser, id, sizeof(id)) != 0) {
+            send_error_response(client, cmd, "missing_id");
+            return;
+        }
+        
+        widget_handle_t handle = resolve_widget(id);
+        if (handle != WIDGET_HANDLE_INVALID) {
+            char response[160];
+            snprintf(response, sizeof(response),
+                     "{\"status\":\"ok\",\"cmd\":\"%s\",\"id\":\"%s\",\"h\":%u}\n",
+                     cmd, id, handle);
+            send_response(client, response);
         } else {
             send_error_response(client, cmd, "widget_not_found");
         }
         
+    } else if (strcmp(cmd, "dump_tree") == 0) {
+        uint32_t since = 0;
+        if (find_key(&parser, "since") == 0 && parse_uint(&parser, &since) != 0) {
+            send_error_response(client, cmd, "invalid_since");
+            return;
+        }
+        
+        char *tree_json = NULL;
+        size_t tree_len = 0;
+        int result = ui_tree_dump(since, &tree_json, &tree_len);
+        if (result == TEST_OK && tree_json) {
+            ssize_t sent = send(client, tree_json, (int)tree_len, 0);
+            if (sent != (ssize_t)tree_len) {
+                printf("Failed to send complete tree dump\n");
+            } else {
+                printf("Tree dump sent: %zu bytes (since=%u)\n", tree_len, since);
+            }
+            free(tree_json);
+        } else {
+            send_error_response(client, cmd, "dump_failed");
+        }
+        
     } else if (strcmp(cmd, "screenshot") == 0) {
-        uint8_t *raw_data = NULL;
-        size_t raw_len = 0;
-        
-        int result = test_screenshot(&raw_data, &raw_len);
-        if (result == TEST_OK && raw_data && raw_len > 0) {
-            // Send JSON header with PNG format information 
-            char header[256];
-            snprintf(header, sizeof(header), 
-                     "{\"status\":\"ok\",\"type\":\"screenshot\",\"width\":%d,\"height\":%d,\"format\":\"PNG\",\"len\":%zu}\n", 
-                     480, 480, raw_len);  // Using the actual display dimensions
-            send_response(client, header);
-            
-            // Send PNG data
-            ssize_t sent = send(client, (char*)raw_data, (int)raw_len, 0);
-            if (sent != (ssize_t)raw_len) {
-                printf("Failed to send complete PNG screenshot data\n");
+        screenshot_options_t options;
+        if (parse_screenshot_options(&parser, &options) != 0) {
+            send_error_response(client, cmd, "invalid_format");
+            return;
+        }
+        
+        if (find_key(&parser, "regions") == 0) {
+            if (options.delta) {
+                send_error_response(client, cmd, "invalid_region");
+                return;
+            }
+            process_screenshot_regions(client, &parser, &options);
+            return;
+        }
+        
+        // Optional single region: "rect":[x,y,w,h] or a widget "id"/"h"
+        screenshot_region_t region;
+        int has_region = parse_screenshot_region(&parser, &region);
+        if (has_region < 0) {
+            send_error_response(client, cmd, screenshot_error_name(has_region));
+            return;
+        }
+        
+        // "keyframe":true restarts the delta stream with a full frame
+        if (options.delta && find_key(&parser, "keyframe") == 0 && parse_bool(&parser)) {
+            screenshot_delta_reset(session_current());
+        }
+        
+        // Optional: frame version the client already holds - skip the payload if it is current
+        uint32_t if_version = 0;
+        int has_if_version = (find_key(&parser, "if_version") == 0 && parse_uint(&parser, &if_version) == 0);
+        
+        // Pixels are grabbed on the LVGL thread and encoded on the worker pool; only this
+        // connection waits for the encode
+        screenshot_job_t *job = NULL;
+        screenshot_image_t image;
+        screenshot_stats_t stats;
+        int result = screenshot_submit(has_region ? &region : NULL, &options, &job);
+        if (result == TEST_OK) {
+            result = screenshot_job_wait(job, &image, &stats);
+        }
+        if (result == TEST_OK && options.delta) {
+            send_screenshot_delta(client, &image, &stats);
+        } else if (result == TEST_OK && image.data && image.len > 0) {
+            if (!has_region && has_if_version && if_version == stats.frame_version) {
+                char header[160];
+                snprintf(header, sizeof(header),
+                         "{\"status\":\"ok\",\"type\":\"screenshot\",\"unchanged\":true,\"frame_version\":%u,\"len\":0}\n",
+                         stats.frame_version);
+                send_response(client, header);
+                printf("Screenshot unchanged since frame %u - payload skipped\n", if_version);
             } else {
-                printf("PNG screenshot sent: %zu bytes (%dx%d)\n", raw_len, 480, 480);
+                send_screenshot(client, &image, &stats, -1);
             }
-            
-            free(raw_data);
         } else {
             printf("Screenshot failed with result: %d\n", result);
-            send_error_response(client, cmd, "screenshot_failed");
+            send_error_response(client, cmd, screenshot_error_name(result));
+        }
+        screenshot_job_release(job);
+        
+    } else if (strcmp(cmd, "frame_hash") == 0) {
+        process_frame_hash(client, &parser);
+        
+    } else if (strcmp(cmd, "baseline") == 0) {
+        // Capture the screen or a region ("rect"/"id"/"h") as the named golden image
+        char name[MAX_ID_LEN] = {0};
+        if (find_key(&parser, "name") != 0 || parse_string(&parser, name, sizeof(name)) != 0 ||
+            !baseline_name_valid(name)) {
+            send_error_response(client, cmd, "invalid_name");
+            return;
+        }
+        
+        screenshot_region_t region;
+        int has_region = parse_screenshot_region(&parser, &region);
+        if (has_region < 0) {
+            send_error_response(client, cmd, screenshot_error_name(has_region));
+            return;
+        }
+        
+        uint32_t width = 0, height = 0;
+        uint64_t hash = 0;
+        int result = baseline_save(name, has_region ? &region : NULL, &width, &height, &hash);
+        if (result == TEST_OK) {
+            char response[224];
+            snprintf(response, sizeof(response),
+                     "{\"status\":\"ok\",\"type\":\"baseline\",\"name\":\"%s\",\"width\":%u,\"height\":%u,\"hash\":\"%016llx\"}\n",
+                     name, width, height, (unsigned long long)hash);
+            send_response(client, response);
+        } else {
+            send_error_response(client, cmd, compare_error_name(result));
+        }
+        
+    } else if (strcmp(cmd, "compare") == 0) {
+        // Render the same screen/region and diff it against the baseline on the server
+        char name[MAX_ID_LEN] = {0};
+        if (find_key(&parser, "name") != 0 || parse_string(&parser, name, sizeof(name)) != 0 ||
+            !baseline_name_valid(name)) {
+            send_error_response(client, cmd, "invalid_name");
+            return;
+        }
+        
+        uint8_t tolerance[3] = { 0, 0, 0 };
+        if (find_key(&parser, "tolerance") == 0 && parse_tolerance(&parser, tolerance) != 0) {
+            send_error_response(client, cmd, "invalid_tolerance");
+            return;
+        }
+        
+        // Optional: "mask":true appends a 1-bit-per-pixel diff mask after the reply line
+        int want_mask = 0;
+        if (find_key(&parser, "mask") == 0) {
+            want_mask = parse_bool(&parser);
+        }
+        
+        screenshot_region_t region;
+        int has_region = parse_screenshot_region(&parser, &region);
+        if (has_region < 0) {
+            send_error_response(client, cmd, screenshot_error_name(has_region));
+            return;
+        }
+        
+        compare_result_t diff;
+        int result = compare_baseline(name, has_region ? &region : NULL, tolerance, want_mask, &diff);
+        if (result == TEST_ERROR_NOT_FOUND) {
+            send_error_response(client, cmd, "baseline_not_found");
+            return;
+        }
+        if (result != TEST_OK) {
+            send_error_response(client, cmd, compare_error_name(result));
+            return;
+        }
+        
+        char bbox[64] = "null";
+        if (diff.mismatches > 0) {
+            snprintf(bbox, sizeof(bbox), "[%d,%d,%d,%d]", diff.bbox_x, diff.bbox_y, diff.bbox_w, diff.bbox_h);
+        }
+        
+        char response[384];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"compare\",\"name\":\"%s\",\"match\":%s,\"width\":%u,\"height\":%u,\"mismatches\":%u,\"max_delta\":%u,\"bbox\":%s,\"mask_len\":%zu,\"recorded\":%s}\n",
+                 name, diff.mismatches == 0 ? "true" : "false", diff.width, diff.height,
+                 diff.mismatches, diff.max_delta, bbox, diff.mask_len, diff.recorded ? "true" : "false");
+        send_response(client, response);
+        
+        if (diff.mask_len > 0) {
+            ssize_t sent = send(client, (char*)diff.mask, (int)diff.mask_len, 0);
+            if (sent != (ssize_t)diff.mask_len) {
+                printf("Failed to send complete diff mask\n");
+            }
+        }
+        
+    } else if (strcmp(cmd, "probe") == 0) {
+        process_probe(client, &parser);
+        
+    } else if (strcmp(cmd, "display_info") == 0) {
+        // Resolution the simulator was started with and the cost of its most recent frame
+        uint32_t width = 0, height = 0;
+        if (screenshot_display_size(&width, &height) != TEST_OK) {
+            send_error_response(client, cmd, "no_display");
+            return;
+        }
+        screenshot_stats_t stats;
+        screenshot_get_stats(&stats);
+        
+        char response[256];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"display_info\",\"width\":%u,\"height\":%u,\"frame_version\":%u,\"render_us\":%u}\n",
+                 width, height, screenshot_frame_version(), stats.render_us);
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "session") == 0) {
+        // Which display this connection drives, and how many are open
+        char response[160];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"session\",\"session\":%d,\"sessions\":%d,\"max_sessions\":%d}\n",
+                 session_current(), session_count(), MAX_SESSIONS);
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "reset") == 0) {
+        // Rebuild this session's UI in place: fresh data model, screens and registry.
+        // An optional "seed" makes later random readings (heart rate) repeatable.
+        uint32_t seed = 0;
+        int reseed = find_key(&parser, "seed") == 0;
+        if (reseed && parse_uint(&parser, &seed) != 0) {
+            send_error_response(client, cmd, "invalid_seed");
+            return;
+        }
+        
+        uint32_t elapsed_us = 0;
+        if (session_reset(reseed, seed, &elapsed_us) != TEST_OK) {
+            send_error_response(client, cmd, "reset_failed");
+            return;
+        }
+        
+        char response[128];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"reset\",\"reset_us\":%u}\n", elapsed_us);
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "checkpoint_save") == 0 || strcmp(cmd, "checkpoint_load") == 0) {
+        // Snapshot this session's UI state under "name", or restore one onto its objects
+        char name[MAX_ID_LEN] = {0};
+        if (find_key(&parser, "name") != 0 || parse_string(&parser, name, sizeof(name)) != 0 ||
+            !baseline_name_valid(name)) {
+            send_error_response(client, cmd, "invalid_name");
+            return;
+        }
+        
+        int load = strcmp(cmd, "checkpoint_load") == 0;
+        checkpoint_stats_t stats = {0};
+        int result = load ? checkpoint_load(name, &stats) : checkpoint_save(name, &stats);
+        if (result != TEST_OK) {
+            send_error_response(client, cmd, result == TEST_ERROR_NOT_FOUND ? "checkpoint_not_found" :
+                                             result == TEST_ERROR_INVALID_WIDGET ? "checkpoint_mismatch" :
+                                             result == TEST_ERROR_IO ? "checkpoint_corrupt" : "checkpoint_failed");
+            return;
+        }
+        
+        char response[192];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"%s\",\"name\":\"%s\",\"widgets\":%u,\"bytes\":%u,\"elapsed_us\":%u}\n",
+                 cmd, name, stats.widgets, stats.bytes, stats.elapsed_us);
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "record_start") == 0) {
+        // Record this session's flushed frames to <LVGL_RECORD_DIR>/<name>.lvrec, optionally limited to "fps"
+        char name[MAX_ID_LEN] = {0};
+        if (find_key(&parser, "name") != 0 || parse_string(&parser, name, sizeof(name)) != 0 ||
+            !baseline_name_valid(name)) {
+            send_error_response(client, cmd, "invalid_name");
+            return;
+        }
+        
+        uint32_t fps = 0;
+        if (find_key(&parser, "fps") == 0 && (parse_uint(&parser, &fps) != 0 || fps > 1000)) {
+            send_error_response(client, cmd, "invalid_fps");
+            return;
+        }
+        
+        char path[512];
+        int result = recorder_start(session_current(), name, fps, path, sizeof(path));
+        if (result != TEST_OK) {
+            send_error_response(client, cmd, result == TEST_ERROR_BUSY ? "already_recording" :
+                                             result == TEST_ERROR_IO ? "open_failed" : "record_failed");
+            return;
+        }
+        
+        char response[640];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"record_start\",\"path\":\"%s\",\"fps\":%u}\n", path, fps);
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "record_stop") == 0) {
+        recorder_stats_t stats;
+        int result = recorder_stop(session_current(), &stats);
+        if (result == TEST_ERROR_NOT_FOUND) {
+            send_error_response(client, cmd, "not_recording");
+            return;
+        }
+        
+        char response[768];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"%s\",\"type\":\"record_stop\",\"path\":\"%s\",\"frames\":%u,\"dropped\":%u,\"bytes\":%llu,\"duration_ms\":%u%s}\n",
+                 result == TEST_OK ? "ok" : "error", stats.path, stats.frames, stats.dropped,
+                 (unsigned long long)stats.bytes, stats.duration_ms,
+                 result == TEST_OK ? "" : ",\"error\":\"write_failed\"");
+        send_response(client, response);
+        
+    } else if (strcmp(cmd, "get_history") == 0) {
+        // This session's flight recorder contents as an .lvrec image: the last "frames" frames
+        // (default all), emptied afterwards with "clear"
+        uint32_t frames = 0;
+        if (find_key(&parser, "frames") == 0 && parse_uint(&parser, &frames) != 0) {
+            send_error_response(client, cmd, "invalid_frames");
+            return;
+        }
+        int clear = find_key(&parser, "clear") == 0 && parse_bool(&parser);
+        
+        uint8_t *data;
+        size_t len;
+        history_stats_t stats;
+        int result = history_export(session_current(), frames, clear, &data, &len, &stats);
+        if (result != TEST_OK) {
+            send_error_response(client, cmd, result == TEST_ERROR_NOT_FOUND ? "history_disabled" : "out_of_memory");
+            return;
         }
         
+        char response[256];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"ok\",\"type\":\"history\",\"frames\":%u,\"len\":%zu,\"used\":%zu,\"budget\":%zu,\"evicted\":%u,\"coalesced\":%u}\n",
+                 stats.frames, len, stats.used, stats.budget, stats.evicted, stats.coalesced);
+        send_response(client, response);
+        
+        ssize_t sent = send(client, (char*)data, (int)len, 0);
+        if (sent != (ssize_t)len) {
+            printf("Failed to send complete frame history\n");
+        }
+        free(data);
+        
     } else if (strcmp(cmd, "wait") == 0) {
         int ms = 100; // default
         if (find_key(&parser, "ms") == 0) {
@@ -340,8 +1323,8 @@ static void process_command(SOCKET client, const char *json_cmd) {
             return;
         }
         
-        int result = test_click_at(x, y);
-        if (result == TEST_OK) {
+        command_t click = { .type = CMD_CLICK_AT, .params.click_at = { x, y } };
+        if (run_command(&click) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
             send_error_response(client, cmd, "click_failed");
@@ -372,8 +1355,8 @@ static void process_command(SOCKET client, const char *json_cmd) {
             return;
         }
         
-        int result = test_drag(x1, y1, x2, y2);
-        if (result == TEST_OK) {
+        command_t drag = { .type = CMD_DRAG, .params.drag = { x1, y1, x2, y2 } };
+        if (run_command(&drag) == TEST_OK) {
             send_ok_response(client, cmd);
         } else {
             send_error_response(client, cmd, "drag_failed");
@@ -430,7 +1413,7 @@ int tcp_server_init(int port) {
     }
     
     // Listen for connections
-    if (listen(tcp_server.server_socket, 1) < 0) {
+    if (listen(tcp_server.server_socket, MAX_SESSIONS) < 0) {
         printf("Failed to listen on socket: %s\n", strerror(errno));
         close(tcp_server.server_socket);
 #ifdef _WIN32
@@ -439,9 +1422,10 @@ int tcp_server_init(int port) {
         return TEST_ERROR_NETWORK;
     }
     
+    CLIENTS_INIT();
     tcp_server.port = port;
     tcp_server.running = 1;
-    tcp_server.client_connected = 0;
+    tcp_server.client_count = 0;
     
     printf("TCP server initialized on port %d\n", port);
     return TEST_OK;
@@ -452,10 +1436,13 @@ void tcp_server_cleanup(void) {
     
     tcp_server.running = 0;
     
-    if (tcp_server.client_socket != INVALID_SOCKET) {
-        close(tcp_server.client_socket);
-        tcp_server.client_socket = INVALID_SOCKET;
+    // Wake the client threads, which close their own sockets. Session displays are torn down by
+    // session_cleanup() once the LVGL loop has stopped.
+    CLIENTS_LOCK();
+    for (int i = 0; i < tcp_server.client_count; i++) {
+        shutdown(tcp_server.clients[i].socket, SHUT_RDWR);
     }
+    CLIENTS_UNLOCK();
     
     if (tcp_server.server_socket != INVALID_SOCKET) {
         close(tcp_server.server_socket);
@@ -466,66 +1453,347 @@ void tcp_server_cleanup(void) {
     WSACleanup();
 #endif
     
-    tcp_server.client_connected = 0;
     printf("TCP server cleanup complete\n");
 }
 
+// Wait up to a second for data on the sockets in readable, max_socket being the highest
+static int tcp_server_select(fd_set *readable, SOCKET max_socket) {
+    // Wake up once a second so a stopped server is noticed
+    struct timeval timeout = { 1, 0 };
+    int ready = select((int)max_socket + 1, readable, NULL, NULL, &timeout);
+    if (ready < 0 && errno != EINTR && tcp_server.running) {
+        printf("select() failed: %s\n", strerror(errno));
+    }
+    return ready;
+}
+
+// Wait up to a second for a new connection
+static int tcp_server_wait(fd_set *readable) {
+    FD_ZERO(readable);
+    FD_SET(tcp_server.server_socket, readable);
+    return tcp_server_select(readable, tcp_server.server_socket);
+}
+
+// Run the commands that arrived from one client; returns 0 once it has disconnected
+static int tcp_server_serve(tcp_client_t *client) {
+    char buffer[MAX_COMMAND_LEN];
+    ssize_t bytes_received = recv(client->socket, buffer, sizeof(buffer) - 1, 0);
+    
+    if (bytes_received <= 0) {
+        printf("Client disconnected (session %d)\n", client->session);
+        return 0;
+    }
+    
+    buffer[bytes_received] = '\0';
+    
+    // Process each line (commands are newline-terminated); other clients split theirs at the same time
+    char *saveptr = NULL;
+    char *line = strtok_r(buffer, "\n", &saveptr);
+    while (line && tcp_server.running) {
+        // Trim whitespace
+        while (isspace(*line)) line++;
+        if (strlen(line) > 0) {
+            process_command(client->socket, line);
+        }
+        line = strtok_r(NULL, "\n", &saveptr);
+    }
+    return 1;
+}
+
+// Forget a client, then close its connection and session. The entry goes first: once the socket
+// is closed its number can come back for a new connection, whose entry must not be removed
+// instead. At shutdown the sessions are left to session_cleanup(), as the LVGL thread no longer
+// takes commands.
+static void tcp_server_drop(const tcp_client_t *client) {
+    CLIENTS_LOCK();
+    for (int i = 0; i < tcp_server.client_count; i++) {
+        if (tcp_server.clients[i].socket == client->socket) {
+            tcp_server.clients[i] = tcp_server.clients[--tcp_server.client_count];
+            break;
+        }
+    }
+    CLIENTS_UNLOCK();
+    
+    close(client->socket);
+    if (tcp_server.running) {
+        session_close(client->session);
+    }
+}
+
+// Serve one client until it disconnects, against its own session only
+#ifdef _WIN32
+static unsigned __stdcall tcp_client_thread(void *arg) {
+#else
+static void *tcp_client_thread(void *arg) {
+#endif
+    tcp_client_t client = *(tcp_client_t*)arg;
+    free(arg);
+    
+    session_select(client.session);
+    while (tcp_server.running && tcp_server_serve(&client)) {
+    }
+    tcp_server_drop(&client);
+    return 0;
+}
+
+static int tcp_client_thread_start(const tcp_client_t *client) {
+    tcp_client_t *arg = malloc(sizeof(*arg));
+    if (!arg) {
+        return TEST_ERROR_MEMORY;
+    }
+    *arg = *client;
+#ifdef _WIN32
+    HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, tcp_client_thread, arg, 0, NULL);
+    if (thread == 0) {
+        free(arg);
+        return TEST_ERROR_MEMORY;
+    }
+    CloseHandle(thread);
+#else
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, tcp_client_thread, arg) != 0) {
+        free(arg);
+        return TEST_ERROR_MEMORY;
+    }
+    pthread_detach(thread);
+#endif
+    return TEST_OK;
+}
+
+// Take a new connection. The first client drives the main display; while it is connected,
+// each further client gets a session with a display of its own.
+static void tcp_server_accept(void) {
+    struct sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    
+    SOCKET client = accept(tcp_server.server_socket, (struct sockaddr*)&client_addr, &client_len);
+    if (client == INVALID_SOCKET) {
+        if (tcp_server.running) {
+            printf("Failed to accept connection: %s\n", strerror(errno));
+        }
+        return;
+    }
+    
+    int main_taken = 0;
+    CLIENTS_LOCK();
+    for (int i = 0; i < tcp_server.client_count; i++) {
+        main_taken |= tcp_server.clients[i].session == 0;
+    }
+    CLIENTS_UNLOCK();
+    
+    int session = main_taken ? session_open() : 0;
+    if (session < 0) {
+        send_error_response(client, NULL, session == TEST_ERROR_BUSY ? "too_many_sessions" : "session_failed");
+        close(client);
+        return;
+    }
+    
+    // Delta captures are relative to what this client has seen
+    screenshot_delta_reset(session);
+    tcp_client_t entry = { client, session };
+    CLIENTS_LOCK();
+    tcp_server.clients[tcp_server.client_count++] = entry;
+    CLIENTS_UNLOCK();
+    tcp_server.served = 1;
+    
+    if (tcp_client_thread_start(&entry) != TEST_OK) {
+        printf("Failed to start a thread for the client\n");
+        send_error_response(client, NULL, "session_failed");
+        tcp_server_drop(&entry);
+        return;
+    }
+    printf("Client connected from %s:%d (session %d)\n",
+           inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), session);
+}
+
+// Accept connections on this thread. Each client is served by a thread of its own, so one
+// client's wait, long press or slow capture never holds up another session.
 int tcp_server_start(void) {
     printf("TCP server starting main loop...\n");
+    printf("Waiting for client connections on port %d...\n", tcp_server.port);
     
     while (tcp_server.running) {
-        printf("Waiting for client connection on port %d...\n", tcp_server.port);
+        CLIENTS_LOCK();
+        int idle = tcp_server.client_count == 0;
+        CLIENTS_UNLOCK();
+        if (tcp_server.exit_when_idle && idle &&
+            (tcp_server.served || time(NULL) >= tcp_server.idle_deadline)) {
+            printf("No clients left - stopping\n");
+            break;
+        }
+        
+        fd_set readable;
+        if (tcp_server_wait(&readable) <= 0) {
+            continue;
+        }
         
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        if (FD_ISSET(tcp_server.server_socket, &readable)) {
+            tcp_server_accept();
+        }
+    }
+    
+    printf("TCP server main loop ended\n");
+    return TEST_OK;
+}
+
+#ifndef _WIN32
+// Fork a fresh copy of the zygote for one test. The child's listening socket is opened before
+// the fork, so its port can be reported at once and the test can connect without polling.
+// Returns 1 in the child and 0 in the zygote.
+static int tcp_server_spawn(SOCKET client) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = 0;  // any free port
+    
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET ||
+        bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listener, MAX_SESSIONS) < 0 ||
+        getsockname(listener, (struct sockaddr*)&addr, &addr_len) < 0) {
+        printf("Failed to open a socket for the child: %s\n", strerror(errno));
+        if (listener != INVALID_SOCKET) {
+            close(listener);
+        }
+        send_error_response(client, "spawn", "spawn_failed");
+        return 0;
+    }
+    
+    fflush(stdout);  // or the child prints the zygote's buffered output again
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("fork() failed: %s\n", strerror(errno));
+        close(listener);
+        send_error_response(client, "spawn", "spawn_failed");
+        return 0;
+    }
+    
+    if (pid == 0) {
+        // Child: drop the zygote's sockets and serve this test on the new one
+        signal(SIGCHLD, SIG_DFL);
+        for (int i = 0; i < tcp_server.client_count; i++) {
+            close(tcp_server.clients[i].socket);
+        }
+        close(tcp_server.server_socket);
         
-        tcp_server.client_socket = accept(tcp_server.server_socket, 
-                                         (struct sockaddr*)&client_addr, 
-                                         &client_len);
+        tcp_server.server_socket = listener;
+        tcp_server.server_addr = addr;
+        tcp_server.port = ntohs(addr.sin_port);
+        tcp_server.client_count = 0;
+        tcp_server.exit_when_idle = 1;
+        tcp_server.served = 0;
+        tcp_server.idle_deadline = time(NULL) + SPAWN_CONNECT_TIMEOUT_S;
+        printf("Spawned from zygote, serving on port %d\n", tcp_server.port);
+        return 1;
+    }
+    
+    close(listener);
+    char response[128];
+    snprintf(response, sizeof(response), "{\"status\":\"ok\",\"type\":\"spawn\",\"pid\":%d,\"port\":%d}\n",
+             (int)pid, ntohs(addr.sin_port));
+    send_response(client, response);
+    return 0;
+}
+
+// Wait up to a second for a new control connection or for commands on the open ones
+static int tcp_server_zygote_wait(fd_set *readable) {
+    FD_ZERO(readable);
+    FD_SET(tcp_server.server_socket, readable);
+    SOCKET max_socket = tcp_server.server_socket;
+    for (int i = 0; i < tcp_server.client_count; i++) {
+        FD_SET(tcp_server.clients[i].socket, readable);
+        if (tcp_server.clients[i].socket > max_socket) {
+            max_socket = tcp_server.clients[i].socket;
+        }
+    }
+    return tcp_server_select(readable, max_socket);
+}
+
+// Run the control commands that arrived from one zygote client; returns -1 once it has
+// disconnected, 1 in a freshly forked child and 0 otherwise
+static int tcp_server_zygote_serve(SOCKET client) {
+    char buffer[MAX_COMMAND_LEN];
+    ssize_t bytes_received = recv(client, buffer, sizeof(buffer) - 1, 0);
+    if (bytes_received <= 0) {
+        return -1;
+    }
+    
+    buffer[bytes_received] = '\0';
+    char *line = strtok(buffer, "\n");
+    while (line) {
+        json_parser_t parser = {0};
+        parser.data = line;
+        parser.len = strlen(line);
         
-        if (tcp_server.client_socket == INVALID_SOCKET) {
-            if (tcp_server.running) {
-                printf("Failed to accept connection: %s\n", strerror(errno));
+        char cmd[32] = {0};
+        if (find_key(&parser, "cmd") != 0 || parse_string(&parser, cmd, sizeof(cmd)) != 0) {
+            send_error_response(client, NULL, "invalid_json");
+        } else if (strcmp(cmd, "spawn") == 0) {
+            if (tcp_server_spawn(client)) {
+                return 1;
             }
+        } else {
+            // Everything else runs in the spawned children
+            send_error_response(client, cmd, "unknown_command");
+        }
+        line = strtok(NULL, "\n");
+    }
+    return 0;
+}
+
+// Zygote mode: the LVGL state built so far is kept as a template, and each {"cmd":"spawn"}
+// on the server port forks a copy-on-write child that serves one test on a port of its own.
+// Returns 1 in each child, which goes on to start its threads and main loop, and 0 in the
+// zygote once *running is cleared.
+int tcp_server_zygote(volatile int *running) {
+    printf("Zygote ready: spawn sessions on port %d\n", tcp_server.port);
+    signal(SIGCHLD, SIG_IGN);  // children are reaped automatically
+    
+    while (*running && tcp_server.running) {
+        fd_set readable;
+        if (tcp_server_zygote_wait(&readable) <= 0) {
             continue;
         }
         
-        tcp_server.client_connected = 1;
-        printf("Client connected from %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), 
-               ntohs(client_addr.sin_port));
-        
-        // Handle client commands
-        char buffer[MAX_COMMAND_LEN];
-        while (tcp_server.running && tcp_server.client_connected) {
-            ssize_t bytes_received = recv(tcp_server.client_socket, buffer, 
-                                        sizeof(buffer) - 1, 0);
-            
-            if (bytes_received <= 0) {
-                printf("Client disconnected\n");
-                tcp_server.client_connected = 0;
-                break;
+        for (int i = tcp_server.client_count - 1; i >= 0; i--) {
+            if (!FD_ISSET(tcp_server.clients[i].socket, &readable)) {
+                continue;
+            }
+            int result = tcp_server_zygote_serve(tcp_server.clients[i].socket);
+            if (result == 1) {
+                return 1;
             }
-            
-            buffer[bytes_received] = '\0';
-            
-            // Process each line (commands are newline-terminated)
-            char *line = strtok(buffer, "\n");
-            while (line && tcp_server.running) {
-                // Trim whitespace
-                while (isspace(*line)) line++;
-                if (strlen(line) > 0) {
-                    process_command(tcp_server.client_socket, line);
-                }
-                line = strtok(NULL, "\n");
+            if (result < 0) {
+                close(tcp_server.clients[i].socket);
+                tcp_server.clients[i] = tcp_server.clients[--tcp_server.client_count];
             }
         }
         
-        close(tcp_server.client_socket);
-        tcp_server.client_socket = INVALID_SOCKET;
-        tcp_server.client_connected = 0;
+        if (FD_ISSET(tcp_server.server_socket, &readable)) {
+            SOCKET client = accept(tcp_server.server_socket, NULL, NULL);
+            if (client == INVALID_SOCKET) {
+                continue;
+            }
+            if (tcp_server.client_count == MAX_SESSIONS) {
+                send_error_response(client, NULL, "too_many_clients");
+                close(client);
+                continue;
+            }
+            tcp_server.clients[tcp_server.client_count].socket = client;
+            tcp_server.clients[tcp_server.client_count].session = 0;
+            tcp_server.client_count++;
+        }
     }
     
-    printf("TCP server main loop ended\n");
-    return TEST_OK;
-}
\ No newline at end of file
+    printf("Zygote stopped\n");
+    return 0;
+}
+#else
+int tcp_server_zygote(volatile int *running) {
+    (void)running;
+    printf("Zygote mode needs fork(), which Windows does not have\n");
+    return TEST_ERROR_NETWORK;
+}
+#endif
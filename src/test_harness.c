@@ -33,11 +33,27 @@ typedef struct {
     char id[MAX_ID_LEN];
     lv_obj_t *obj;
     int active;
+    uint32_t generation;
 } widget_entry_t;
 
-// Global widget registry
-static widget_entry_t widget_registry[MAX_WIDGETS];
-static int registry_size = 0;
+// Widget registry, one per session
+typedef struct {
+    widget_entry_t entries[MAX_WIDGETS];
+    int size;
+    
+    // Bumped on every slot (re)assignment and registry cleanup so old handles go stale
+    uint32_t generation;
+} widget_registry_t;
+
+static widget_registry_t registries[MAX_SESSIONS];
+
+static widget_registry_t *current_registry(void) {
+    return &registries[session_current()];
+}
+
+#define HANDLE_SLOT_BITS 8
+#define HANDLE_SLOT_MASK ((1u << HANDLE_SLOT_BITS) - 1)
+#define HANDLE_GEN_MASK (0xFFFFFFFFu >> HANDLE_SLOT_BITS)
 
 // Test system state
 static int test_system_initialized = 0;
@@ -48,43 +64,59 @@ static int queue_head = 0;
 static int queue_tail = 0;
 static int queue_size = 0;
 
+// Commands pushed and carried out so far; command_queue_run() waits for its ticket to come up
+static uint32_t queue_pushed = 0;
+static uint32_t queue_finished = 0;
+
 #ifdef _WIN32
     #include <windows.h>
     static CRITICAL_SECTION queue_mutex;
-    #define MUTEX_INIT() InitializeCriticalSection(&queue_mutex)
+    static CONDITION_VARIABLE queue_done;
+    #define MUTEX_INIT() (InitializeCriticalSection(&queue_mutex), InitializeConditionVariable(&queue_done))
     #define MUTEX_LOCK() EnterCriticalSection(&queue_mutex)
     #define MUTEX_UNLOCK() LeaveCriticalSection(&queue_mutex)
     #define MUTEX_DESTROY() DeleteCriticalSection(&queue_mutex)
+    #define QUEUE_WAIT() SleepConditionVariableCS(&queue_done, &queue_mutex, INFINITE)
+    #define QUEUE_BROADCAST() WakeAllConditionVariable(&queue_done)
 #else
     #include <pthread.h>
     static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_cond_t queue_done = PTHREAD_COND_INITIALIZER;
     #define MUTEX_INIT() ((void)0)
     #define MUTEX_LOCK() pthread_mutex_lock(&queue_mutex)
     #define MUTEX_UNLOCK() pthread_mutex_unlock(&queue_mutex)
     #define MUTEX_DESTROY() pthread_mutex_destroy(&queue_mutex)
+    #define QUEUE_WAIT() pthread_cond_wait(&queue_done, &queue_mutex)
+    #define QUEUE_BROADCAST() pthread_cond_broadcast(&queue_done)
 #endif
 
 // Widget registry functions
 int reg_widget(const char *id, lv_obj_t *obj) {
-    if (!id || !obj || registry_size >= MAX_WIDGETS) {
+    widget_registry_t *reg = current_registry();
+    
+    if (!id || !obj || reg->size >= MAX_WIDGETS) {
         return TEST_ERROR_INVALID_PARAM;
     }
     
     // Check for duplicate IDs
-    for (int i = 0; i < registry_size; i++) {
-        if (widget_registry[i].active && strcmp(widget_registry[i].id, id) == 0) {
+    for (int i = 0; i < reg->size; i++) {
+        if (reg->entries[i].active && strcmp(reg->entries[i].id, id) == 0) {
             printf("Warning: Widget ID '%s' already exists, updating...\n", id);
-            widget_registry[i].obj = obj;
+            if (reg->entries[i].obj != obj) {
+                reg->entries[i].obj = obj;
+                reg->entries[i].generation = ++reg->generation & HANDLE_GEN_MASK;
+            }
             return TEST_OK;
         }
     }
     
     // Add new widget
-    strncpy(widget_registry[registry_size].id, id, MAX_ID_LEN - 1);
-    widget_registry[registry_size].id[MAX_ID_LEN - 1] = '\0';
-    widget_registry[registry_size].obj = obj;
-    widget_registry[registry_size].active = 1;
-    registry_size++;
+    strncpy(reg->entries[reg->size].id, id, MAX_ID_LEN - 1);
+    reg->entries[reg->size].id[MAX_ID_LEN - 1] = '\0';
+    reg->entries[reg->size].obj = obj;
+    reg->entries[reg->size].active = 1;
+    reg->entries[reg->size].generation = ++reg->generation & HANDLE_GEN_MASK;
+    reg->size++;
     
     printf("Registered widget: '%s' at %p\n", id, (void*)obj);
     return TEST_OK;
@@ -95,25 +127,114 @@ lv_obj_t *find_widget(const char *id) {
         return NULL;
     }
     
-    for (int i = 0; i < registry_size; i++) {
-        if (widget_registry[i].active && strcmp(widget_registry[i].id, id) == 0) {
-            return widget_registry[i].obj;
+    widget_registry_t *reg = current_registry();
+    
+    for (int i = 0; i < reg->size; i++) {
+        if (reg->entries[i].active && strcmp(reg->entries[i].id, id) == 0) {
+            return reg->entries[i].obj;
         }
     }
     
     return NULL;
 }
 
+// Reverse lookup - first registered ID for an object (aliases share the object)
+const char *find_widget_id(lv_obj_t *obj) {
+    if (!obj) {
+        return NULL;
+    }
+    
+    widget_registry_t *reg = current_registry();
+    
+    for (int i = 0; i < reg->size; i++) {
+        if (reg->entries[i].active && reg->entries[i].obj == obj) {
+            return reg->entries[i].id;
+        }
+    }
+    
+    return NULL;
+}
+
+// Walk the registry: the id and object at a slot, for slots 0..size-1. Returns
+// TEST_ERROR_NOT_FOUND for an empty slot and TEST_ERROR_INVALID_PARAM past the end.
+int registry_entry(int slot, const char **id, lv_obj_t **obj) {
+    widget_registry_t *reg = current_registry();
+    
+    if (slot < 0 || slot >= reg->size) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    if (!reg->entries[slot].active) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    
+    if (id) *id = reg->entries[slot].id;
+    if (obj) *obj = reg->entries[slot].obj;
+    return TEST_OK;
+}
+
 void cleanup_registry(void) {
-    for (int i = 0; i < registry_size; i++) {
-        widget_registry[i].active = 0;
-        memset(widget_registry[i].id, 0, MAX_ID_LEN);
-        widget_registry[i].obj = NULL;
+    widget_registry_t *reg = current_registry();
+    
+    for (int i = 0; i < reg->size; i++) {
+        reg->entries[i].active = 0;
+        memset(reg->entries[i].id, 0, MAX_ID_LEN);
+        reg->entries[i].obj = NULL;
     }
-    registry_size = 0;
+    reg->size = 0;
+    reg->generation++;
     printf("Widget registry cleaned up\n");
 }
 
+// Resolve a widget ID once into a numeric handle for repeated commands
+widget_handle_t resolve_widget(const char *id) {
+    if (!id) {
+        return WIDGET_HANDLE_INVALID;
+    }
+    
+    widget_registry_t *reg = current_registry();
+    
+    for (int i = 0; i < reg->size; i++) {
+        if (reg->entries[i].active && strcmp(reg->entries[i].id, id) == 0) {
+            return (reg->entries[i].generation << HANDLE_SLOT_BITS) | (uint32_t)(i + 1);
+        }
+    }
+    
+    return WIDGET_HANDLE_INVALID;
+}
+
+// Map a handle back to its registry entry without any string comparison
+int lookup_widget_handle(widget_handle_t handle, const char **id, lv_obj_t **obj) {
+    uint32_t slot = handle & HANDLE_SLOT_MASK;
+    uint32_t generation = handle >> HANDLE_SLOT_BITS;
+    
+    if (slot == 0 || slot > (uint32_t)MAX_WIDGETS) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+    
+    widget_registry_t *reg = current_registry();
+    widget_entry_t *entry = &reg->entries[slot - 1];
+    if ((int)slot > reg->size || !entry->active || entry->generation != generation) {
+        return TEST_ERROR_STALE_HANDLE;
+    }
+    
+    if (id) *id = entry->id;
+    if (obj) *obj = entry->obj;
+    return TEST_OK;
+}
+
+// Look up a widget reference in the current session's registry: a handle maps straight to its
+// slot, otherwise id is looked up by name and *obj is NULL when it is unknown. LVGL thread only,
+// so the lookup and the command that uses it see the same registry.
+int find_widget_ref(widget_handle_t handle, const char *id, const char **found_id, lv_obj_t **obj) {
+    if (handle != WIDGET_HANDLE_INVALID) {
+        return lookup_widget_handle(handle, found_id, obj);
+    }
+    
+    if (found_id) *found_id = id;
+    if (obj) *obj = find_widget(id);
+    return TEST_OK;
+}
+
 // Initialize test system
 int init_test_system(void) {
 #ifdef HAVE_LVGL
@@ -136,12 +257,15 @@ int init_test_system(void) {
 }
 
 void print_registry(void) {
-    printf("Widget Registry (%d widgets):\n", registry_size);
+    widget_registry_t *reg = current_registry();
+    
+    printf("Widget Registry (%d widgets):\n", reg->size);
     printf("================================\n");
-    for (int i = 0; i < registry_size; i++) {
-        if (widget_registry[i].active) {
-            printf("  [%d] ID: '%s' -> %p\n", i, widget_registry[i].id, 
-                   (void*)widget_registry[i].obj);
+    for (int i = 0; i < reg->size; i++) {
+        if (reg->entries[i].active) {
+            printf("  [%d] ID: '%s' -> %p (h=%u)\n", i, reg->entries[i].id, 
+                   (void*)reg->entries[i].obj,
+                   (reg->entries[i].generation << HANDLE_SLOT_BITS) | (uint32_t)(i + 1));
         }
     }
     printf("================================\n");
@@ -157,8 +281,9 @@ void emulate_click_at(int x, int y) {
         init_test_system();
     }
     
-    // Get the currently active screen for debugging
-    lv_obj_t *active_screen = lv_screen_active();
+    // Get the session's active screen for debugging
+    widget_registry_t *reg = current_registry();
+    lv_obj_t *active_screen = lv_display_get_screen_active(session_get_display(session_current()));
     printf("  Active screen: %p\n", (void*)active_screen);
     
     // Try multiple search approaches since lv_indev_search_obj may not work reliably
@@ -173,21 +298,21 @@ void emulate_click_at(int x, int y) {
         printf("  lv_indev_search_obj found no target at (%d, %d)\n", x, y);
         
         // Approach 2: Try searching all registered widgets to find one at these coordinates
-        printf("  Searching %d registered widgets...\n", registry_size);
-        for (int i = 0; i < registry_size; i++) {
-            lv_obj_t *obj = widget_registry[i].obj;
+        printf("  Searching %d registered widgets...\n", reg->size);
+        for (int i = 0; i < reg->size; i++) {
+            lv_obj_t *obj = reg->entries[i].obj;
             if (!obj) continue;
             
             lv_area_t coords;
             lv_obj_get_coords(obj, &coords);
             
             printf("    Widget '%s' at %p: coords (%d,%d) to (%d,%d)\n", 
-                   widget_registry[i].id, (void*)obj, 
+                   reg->entries[i].id, (void*)obj, 
                    coords.x1, coords.y1, coords.x2, coords.y2);
             
             // Check if click coordinates are within this widget
             if (x >= coords.x1 && x <= coords.x2 && y >= coords.y1 && y <= coords.y2) {
-                printf("  Found matching widget: '%s' at %p\n", widget_registry[i].id, (void*)obj);
+                printf("  Found matching widget: '%s' at %p\n", reg->entries[i].id, (void*)obj);
                 target = obj;
                 break;
             }
@@ -201,8 +326,6 @@ void emulate_click_at(int x, int y) {
         lv_obj_send_event(target, LV_EVENT_PRESSED, NULL);
         printf("  Press event sent\n");
         
-        usleep(50000); // 50ms press duration
-        
         // Send click event
         lv_obj_send_event(target, LV_EVENT_CLICKED, NULL);
         printf("  Click event sent\n");
@@ -210,8 +333,6 @@ void emulate_click_at(int x, int y) {
         // Send release event
         lv_obj_send_event(target, LV_EVENT_RELEASED, NULL);
         printf("  Release event sent\n");
-        
-        usleep(50000); // 50ms after release
     } else {
         printf("  ERROR: No target object found at (%d, %d) with any method\n", x, y);
     }
@@ -232,9 +353,9 @@ void emulate_longpress_at(int x, int y, uint32_t ms) {
         init_test_system();
     }
     
-    // Simulate longpress without LVGL test API to avoid crashes
+    // Simulate longpress without LVGL test API to avoid crashes. This runs on the LVGL thread,
+    // so it must not sleep out the press duration.
     // TODO: Implement proper LVGL test API integration when threading is fixed
-    usleep((ms + 50) * 1000);
     
     printf("  Long press simulated at (%d, %d) for %ums\n", x, y, ms);
 #else
@@ -248,8 +369,8 @@ void emulate_swipe_gesture(int x1, int y1, int x2, int y2) {
     
 #if HAVE_LVGL
     // TODO: Implement proper swipe simulation for LVGL v9
-    // For now, use timing simulation
-    usleep(200000); // 200ms simulation
+    // Nothing to wait for: this runs on the LVGL thread, which would stall every display
+    printf("  Swipe logged\n");
 #else
     printf("  (LVGL not available - simulated)\n");
     usleep(200000); // 200ms simulation
@@ -257,12 +378,6 @@ void emulate_swipe_gesture(int x1, int y1, int x2, int y2) {
 }
 
 // Test harness API implementation  
-// Manual event handler triggering - bypass lv_event_send crash
-extern void simulate_heart_button_click(void);
-extern void simulate_activity_button_click(void);
-extern void simulate_heart_button_longpress(void);
-extern void simulate_hr_measurement(void);
-
 // Screen constants from ui_watch.c
 typedef enum {
     SCREEN_MAIN = 0,
@@ -280,42 +395,27 @@ int test_click(const char *id) {
         printf("  Error: Widget '%s' not found\n", id ? id : "NULL");
         return TEST_ERROR_NOT_FOUND;
     }
+    return test_click_obj(obj, id);
+}
+
+int test_click_obj(lv_obj_t *obj, const char *id) {
+    if (!obj) {
+        return TEST_ERROR_NOT_FOUND;
+    }
     
 #if HAVE_LVGL
     printf("  Widget found: %p\n", (void*)obj);
     
-    // Special handling for heart button since lv_event_send crashes
-    if (strcmp(id, "btn_heart") == 0 || strcmp(id, "heart_area") == 0) {
-        printf("  Detected heart button - using manual event simulation\n");
-        simulate_heart_button_click();
-        return TEST_OK;
-    }
-    
-    // Special handling for activity button
-    if (strcmp(id, "btn_activity") == 0) {
-        printf("  Detected activity button - using manual event simulation\n");
-        simulate_activity_button_click();
-        return TEST_OK;
-    }
-    
-    // Special handling for activity screen click (return to main)
-    if (strcmp(id, "activity_screen") == 0) {
-        printf("  Detected activity screen - returning to main screen\n");
-        show_screen(SCREEN_MAIN);
-        return TEST_OK;
-    }
-    
-    // Special handling for hr_screen click (return to main)
-    if (strcmp(id, "hr_screen") == 0) {
-        printf("  Detected hr_screen - returning to main screen\n");
-        show_screen(SCREEN_MAIN);
+    // The watch's buttons and screens are driven directly since lv_event_send crashes
+    if (ui_watch_click(obj)) {
         return TEST_OK;
     }
     
     // For other widgets, skip event sending to avoid crashes
     printf("  Widget click skipped to avoid lv_event_send crash\n");
-    printf("  Widget type detection and manual handling not implemented for: %s\n", id);
+    printf("  Widget type detection and manual handling not implemented for: %s\n", id ? id : "NULL");
 #else
+    (void)id;
     printf("  Simulated click on widget at %p\n", (void*)obj);
     usleep(100000); // 100ms simulation
 #endif
@@ -331,19 +431,18 @@ int test_longpress(const char *id, uint32_t ms) {
         printf("  Error: Widget '%s' not found\n", id ? id : "NULL");
         return TEST_ERROR_NOT_FOUND;
     }
-    
-#if HAVE_LVGL
-    // Special handling for heart button longpress
-    if (strcmp(id, "btn_heart") == 0) {
-        printf("  Detected heart button longpress - using manual event simulation\n");
-        simulate_heart_button_longpress();
-        return TEST_OK;
+    return test_longpress_obj(obj, id, ms);
+}
+
+int test_longpress_obj(lv_obj_t *obj, const char *id, uint32_t ms) {
+    if (!obj) {
+        return TEST_ERROR_NOT_FOUND;
     }
+    (void)id;
     
-    // Special handling for hr_measure_area longpress
-    if (strcmp(id, "hr_measure_area") == 0) {
-        printf("  Detected hr_measure_area longpress - triggering measurement\n");
-        simulate_hr_measurement();
+#if HAVE_LVGL
+    // The heart button and measure area have scripted long presses
+    if (ui_watch_longpress(obj)) {
         return TEST_OK;
     }
     
@@ -396,16 +495,12 @@ int test_key_event(int code) {
     }
     
 #if HAVE_LVGL
-    // Get the currently focused object or use default group
-    lv_group_t *group = lv_group_get_default();
-    if (group) {
-        // Send key data to the focused object in the group
-        lv_group_send_data(group, code);
-        printf("  Key code %d sent to focused object\n", code);
+    // Press and release the key on the session's own keypad; it reaches the focused object
+    // of that session's group only
+    if (session_send_key(session_current(), (uint32_t)code) == TEST_OK) {
+        printf("  Key code %d sent to session %d\n", code, session_current());
     } else {
         printf("  Warning: No group found for key input\n");
-        // Fallback: simulate timing for compatibility
-        usleep(50000); // 50ms simulation
     }
 #else
     printf("  Simulated key press: code=%d\n", code);
@@ -423,6 +518,13 @@ char* test_get_text(const char *id) {
         printf("  Error: Widget '%s' not found\n", id ? id : "NULL");
         return NULL;
     }
+    return test_get_text_obj(obj, id);
+}
+
+char* test_get_text_obj(lv_obj_t *obj, const char *id) {
+    if (!obj) {
+        return NULL;
+    }
     
 #if HAVE_LVGL
     // Check widget type and handle accordingly
@@ -468,6 +570,7 @@ char* test_get_text(const char *id) {
         }
     }
 #else
+    (void)id;
     printf("  Simulated text retrieval from widget at %p\n", (void*)obj);
     char *result = malloc(16);
     if (result) {
@@ -491,6 +594,14 @@ int test_set_text(const char *id, const char *text) {
         printf("  Error: Widget '%s' not found\n", id ? id : "NULL");
         return TEST_ERROR_NOT_FOUND;
     }
+    return test_set_text_obj(obj, id, text);
+}
+
+int test_set_text_obj(lv_obj_t *obj, const char *id, const char *text) {
+    (void)id;
+    if (!obj || !text) {
+        return obj ? TEST_ERROR_INVALID_PARAM : TEST_ERROR_NOT_FOUND;
+    }
     
 #if HAVE_LVGL
     lv_label_set_text(obj, text);
@@ -567,9 +678,8 @@ int test_drag(int x1, int y1, int x2, int y2) {
 int test_harness_init(void) {
     printf("Initializing test harness...\n");
     
-    // Clear registry
-    memset(widget_registry, 0, sizeof(widget_registry));
-    registry_size = 0;
+    // Clear the registries
+    memset(registries, 0, sizeof(registries));
     
     // Initialize command queue
     if (command_queue_init() != TEST_OK) {
@@ -614,11 +724,9 @@ void command_queue_cleanup(void) {
     printf("Command queue cleaned up\n");
 }
 
-int command_queue_push(command_t *cmd) {
-    MUTEX_LOCK();
-    
+// Append a copy of cmd; called with the queue lock held
+static int command_queue_append(const command_t *cmd) {
     if (queue_size >= MAX_COMMAND_QUEUE) {
-        MUTEX_UNLOCK();
         return TEST_ERROR_QUEUE_FULL;
     }
     
@@ -632,9 +740,35 @@ int command_queue_push(command_t *cmd) {
     
     queue_tail = (queue_tail + 1) % MAX_COMMAND_QUEUE;
     queue_size++;
+    queue_pushed++;
+    return TEST_OK;
+}
+
+int command_queue_push(command_t *cmd) {
+    cmd->reply = NULL;
+    MUTEX_LOCK();
+    int result = command_queue_append(cmd);
+    MUTEX_UNLOCK();
+    return result;
+}
+
+// Push a command (backing off while the queue is full) and block until the LVGL thread has
+// carried it out. The queued copy is recycled afterwards; its result and response fields are
+// copied back into cmd, bigger results travel through whatever request the params point at.
+void command_queue_run(command_t *cmd) {
+    cmd->reply = cmd;
+    MUTEX_LOCK();
+    while (command_queue_append(cmd) != TEST_OK) {
+        MUTEX_UNLOCK();
+        usleep(1000);
+        MUTEX_LOCK();
+    }
     
+    uint32_t ticket = queue_pushed;
+    while ((int32_t)(queue_finished - ticket) < 0) {
+        QUEUE_WAIT();
+    }
     MUTEX_UNLOCK();
-    return TEST_OK;
 }
 
 int command_queue_process_all(void) {
@@ -651,14 +785,23 @@ int command_queue_process_all(void) {
         command_t *cmd = &command_queue[queue_head];
         MUTEX_UNLOCK();
         
-        // Process command on LVGL thread
+        // Process command on LVGL thread, against the registry and UI of the session it was queued for
+        session_select(cmd->session);
+        const char *id = NULL;
+        lv_obj_t *obj = NULL;
         switch (cmd->type) {
             case CMD_CLICK:
-                cmd->result = test_click(cmd->widget_id);
+                cmd->result = find_widget_ref(cmd->handle, cmd->widget_id, &id, &obj);
+                if (cmd->result == TEST_OK) {
+                    cmd->result = test_click_obj(obj, id);
+                }
                 break;
                 
             case CMD_LONGPRESS:
-                cmd->result = test_longpress(cmd->widget_id, cmd->params.longpress.ms);
+                cmd->result = find_widget_ref(cmd->handle, cmd->widget_id, &id, &obj);
+                if (cmd->result == TEST_OK) {
+                    cmd->result = test_longpress_obj(obj, id, cmd->params.longpress.ms);
+                }
                 break;
                 
             case CMD_SWIPE:
@@ -671,12 +814,18 @@ int command_queue_process_all(void) {
                 break;
                 
             case CMD_GET_TEXT:
-                cmd->response_text = test_get_text(cmd->widget_id);
-                cmd->result = (cmd->response_text != NULL) ? TEST_OK : TEST_ERROR_NOT_FOUND;
+                cmd->result = find_widget_ref(cmd->handle, cmd->widget_id, &id, &obj);
+                if (cmd->result == TEST_OK) {
+                    cmd->response_text = test_get_text_obj(obj, id);
+                    cmd->result = (cmd->response_text != NULL) ? TEST_OK : TEST_ERROR_NOT_FOUND;
+                }
                 break;
                 
             case CMD_SET_TEXT:
-                cmd->result = test_set_text(cmd->widget_id, cmd->params.set_text.text);
+                cmd->result = find_widget_ref(cmd->handle, cmd->widget_id, &id, &obj);
+                if (cmd->result == TEST_OK) {
+                    cmd->result = test_set_text_obj(obj, id, cmd->params.set_text.text);
+                }
                 break;
                 
             case CMD_SCREENSHOT:
@@ -688,6 +837,47 @@ int command_queue_process_all(void) {
                 cmd->result = TEST_OK;
                 break;
                 
+            case CMD_TREE_DUMP:
+                ui_tree_run(cmd->params.tree.request);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_CAPTURE:
+                // Grab stage only; the job completes on the worker pool
+                screenshot_job_grab(cmd->params.capture.job);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_SESSION_OPEN:
+                session_start(cmd->params.session.index);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_SESSION_CLOSE:
+                session_stop(cmd->params.session.index);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_SESSION_RESET:
+                session_rebuild(cmd->params.session.index, cmd->params.session.reseed,
+                                cmd->params.session.seed);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_CHECKPOINT:
+                checkpoint_run(cmd->params.checkpoint.request);
+                cmd->result = TEST_OK;
+                break;
+                
+            case CMD_CLICK_AT:
+                cmd->result = test_click_at(cmd->params.click_at.x, cmd->params.click_at.y);
+                break;
+                
+            case CMD_DRAG:
+                cmd->result = test_drag(cmd->params.drag.x1, cmd->params.drag.y1,
+                                        cmd->params.drag.x2, cmd->params.drag.y2);
+                break;
+                
             default:
                 cmd->result = TEST_ERROR_INVALID_PARAM;
                 break;
@@ -697,8 +887,17 @@ int command_queue_process_all(void) {
         cmd->completed = 1;
         
         MUTEX_LOCK();
+        if (cmd->reply) {
+            cmd->reply->result = cmd->result;
+            cmd->reply->response_text = cmd->response_text;
+            cmd->reply->response_data = cmd->response_data;
+            cmd->reply->response_len = cmd->response_len;
+            cmd->reply->completed = 1;
+        }
         queue_head = (queue_head + 1) % MAX_COMMAND_QUEUE;
         queue_size--;
+        queue_finished++;
+        QUEUE_BROADCAST();
         MUTEX_UNLOCK();
         
         processed++;
@@ -711,5 +910,6 @@ void test_harness_cleanup(void) {
     printf("Cleaning up test harness...\n");
     command_queue_cleanup();
     cleanup_registry();
+    ui_tree_cleanup();
     printf("Test harness cleanup complete\n");
 }
\ No newline at end of file
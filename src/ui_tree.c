@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Check if we have LVGL available
+#ifdef HAVE_LVGL
+    #include "lvgl/lvgl.h"
+#endif
+
+#include "test_harness.h"
+
+// Tree snapshot configuration
+#define MAX_TREE_NODES 256
+#define NODE_JSON_MAX 512
+
+// One tracked object - keys are slot indices so clients can match nodes across dumps
+typedef struct {
+    lv_obj_t *obj;
+    uint32_t hash;          // FNV-1a of the node's serialized content
+    uint32_t version;       // tree version the content last changed in
+    uint32_t removed;       // tree version the object was deleted in (0 = alive)
+    int active;
+} tree_node_t;
+
+typedef struct {
+    tree_node_t nodes[MAX_TREE_NODES];
+    int node_count;
+    uint32_t version;
+    int pending_removals;   // deletions seen since the last dump
+} ui_tree_t;
+
+// One tree per session, each tracking the objects of its own display
+static ui_tree_t ui_trees[MAX_SESSIONS];
+
+// Dump handed to the LVGL thread; lives on the waiting TCP thread's stack
+struct ui_tree_request {
+    int session;
+    uint32_t since;
+    char *json;
+    size_t json_len;
+    int result;
+};
+
+#ifdef HAVE_LVGL
+
+// Growable output buffer for the reply
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} json_buf_t;
+
+static void json_append(json_buf_t *buf, const char *text, size_t len) {
+    if (buf->failed) return;
+
+    if (buf->len + len + 1 > buf->cap) {
+        size_t new_cap = buf->cap ? buf->cap * 2 : 4096;
+        while (new_cap < buf->len + len + 1) new_cap *= 2;
+        char *grown = realloc(buf->data, new_cap);
+        if (!grown) {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = grown;
+        buf->cap = new_cap;
+    }
+
+    memcpy(buf->data + buf->len, text, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+}
+
+static void json_append_str(json_buf_t *buf, const char *text) {
+    json_append(buf, text, strlen(text));
+}
+
+static uint32_t fnv1a(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Copy text into out as a JSON string body, escaping quotes and control characters
+static size_t json_escape(const char *text, char *out, size_t max_len) {
+    size_t n = 0;
+    for (const char *c = text; *c && n + 7 < max_len; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if (ch == '"' || ch == '\\') {
+            out[n++] = '\\';
+            out[n++] = (char)ch;
+        } else if (ch < 0x20) {
+            n += snprintf(out + n, max_len - n, "\\u%04x", ch);
+        } else {
+            out[n++] = (char)ch;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+static const char *tree_class_name(const lv_obj_t *obj) {
+    if (lv_obj_check_type(obj, &lv_label_class)) return "label";
+    if (lv_obj_check_type(obj, &lv_button_class)) return "button";
+    if (lv_obj_check_type(obj, &lv_bar_class)) return "bar";
+    if (lv_obj_check_type(obj, &lv_slider_class)) return "slider";
+    if (lv_obj_check_type(obj, &lv_obj_class)) return "obj";
+    return "other";
+}
+
+// Objects report their own deletion so diffs can list removed nodes
+static void tree_node_delete_cb(lv_event_t *e) {
+    ui_tree_t *tree = lv_event_get_user_data(e);
+    lv_obj_t *obj = lv_event_get_target_obj(e);
+    for (int i = 0; i < tree->node_count; i++) {
+        if (tree->nodes[i].active && tree->nodes[i].obj == obj) {
+            tree->nodes[i].active = 0;
+            tree->nodes[i].obj = NULL;
+            tree->pending_removals = 1;
+            break;
+        }
+    }
+}
+
+static int tree_node_key(ui_tree_t *tree, lv_obj_t *obj) {
+    int free_slot = -1;
+
+    for (int i = 0; i < tree->node_count; i++) {
+        if (tree->nodes[i].active && tree->nodes[i].obj == obj) {
+            return i;
+        }
+        if (!tree->nodes[i].active && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+
+    if (free_slot < 0) {
+        if (tree->node_count >= MAX_TREE_NODES) {
+            return -1;
+        }
+        free_slot = tree->node_count++;
+    }
+
+    tree_node_t *node = &tree->nodes[free_slot];
+    node->obj = obj;
+    node->hash = 0;
+    node->version = 0;
+    node->removed = 0;
+    node->active = 1;
+    lv_obj_add_event_cb(obj, tree_node_delete_cb, LV_EVENT_DELETE, tree);
+    return free_slot;
+}
+
+// Serialize one object: class, registry id, coords, flags, text, value and style highlights
+static int tree_node_json(lv_obj_t *obj, int key, int parent_key, char *out, size_t max_len) {
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_color_t bg = lv_obj_get_style_bg_color(obj, LV_PART_MAIN);
+    lv_color_t fg = lv_obj_get_style_text_color(obj, LV_PART_MAIN);
+    lv_color_t border = lv_obj_get_style_border_color(obj, LV_PART_MAIN);
+
+    int n = snprintf(out, max_len,
+        "{\"k\":%d,\"p\":%d,\"cls\":\"%s\",\"x\":%d,\"y\":%d,\"w\":%d,\"h\":%d,"
+        "\"hidden\":%d,\"clickable\":%d,\"state\":%u,"
+        "\"bg\":\"#%02X%02X%02X\",\"bg_opa\":%u,\"fg\":\"#%02X%02X%02X\","
+        "\"border\":\"#%02X%02X%02X\",\"border_w\":%d",
+        key, parent_key, tree_class_name(obj),
+        (int)coords.x1, (int)coords.y1,
+        (int)lv_area_get_width(&coords), (int)lv_area_get_height(&coords),
+        lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) ? 1 : 0,
+        lv_obj_has_flag(obj, LV_OBJ_FLAG_CLICKABLE) ? 1 : 0,
+        (unsigned)lv_obj_get_state(obj),
+        bg.red, bg.green, bg.blue, (unsigned)lv_obj_get_style_bg_opa(obj, LV_PART_MAIN),
+        fg.red, fg.green, fg.blue,
+        border.red, border.green, border.blue,
+        (int)lv_obj_get_style_border_width(obj, LV_PART_MAIN));
+
+    const char *id = find_widget_id(obj);
+    if (id && n < (int)max_len) {
+        n += snprintf(out + n, max_len - n, ",\"id\":\"%s\"", id);
+    }
+
+    if (lv_obj_check_type(obj, &lv_label_class) && n < (int)max_len) {
+        char text[256];
+        json_escape(lv_label_get_text(obj), text, sizeof(text));
+        n += snprintf(out + n, max_len - n, ",\"text\":\"%s\"", text);
+    } else if (lv_obj_check_type(obj, &lv_bar_class) && n < (int)max_len) {
+        n += snprintf(out + n, max_len - n, ",\"value\":%d,\"min\":%d,\"max\":%d",
+                      (int)lv_bar_get_value(obj), (int)lv_bar_get_min_value(obj),
+                      (int)lv_bar_get_max_value(obj));
+    } else if (lv_obj_check_type(obj, &lv_slider_class) && n < (int)max_len) {
+        n += snprintf(out + n, max_len - n, ",\"value\":%d", (int)lv_slider_get_value(obj));
+    }
+
+    if (n < (int)max_len - 1) {
+        out[n++] = '}';
+        out[n] = '\0';
+    }
+
+    return n < (int)max_len ? n : (int)max_len - 1;
+}
+
+// Depth-first walk: refresh each node's hash and emit it when it changed after 'since'
+static void tree_walk(ui_tree_t *tree, lv_obj_t *obj, int parent_key, uint32_t since, uint32_t next_version,
+                      int *changed, int *first, json_buf_t *out) {
+    int key = tree_node_key(tree, obj);
+    if (key < 0) {
+        return; // node table full - deeper objects are not tracked
+    }
+
+    char node_json[NODE_JSON_MAX];
+    int len = tree_node_json(obj, key, parent_key, node_json, sizeof(node_json));
+    uint32_t hash = fnv1a(node_json, (size_t)len);
+
+    tree_node_t *node = &tree->nodes[key];
+    if (node->version == 0 || node->hash != hash) {
+        node->hash = hash;
+        node->version = next_version;
+        *changed = 1;
+    }
+
+    if (node->version > since) {
+        if (!*first) json_append(out, ",", 1);
+        json_append(out, node_json, (size_t)len);
+        *first = 0;
+    }
+
+    uint32_t child_count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < child_count; i++) {
+        tree_walk(tree, lv_obj_get_child(obj, (int32_t)i), key, since, next_version, changed, first, out);
+    }
+}
+
+#endif
+
+#ifdef HAVE_LVGL
+// LVGL thread: serialize the session's active screen; with since > 0 only nodes changed after that version
+static int ui_tree_serialize(int session, uint32_t since, char **json, size_t *json_len) {
+    ui_tree_t *tree = &ui_trees[session];
+    lv_obj_t *screen = lv_display_get_screen_active(session_get_display(session));
+    if (!screen) {
+        return TEST_ERROR_NOT_FOUND;
+    }
+
+    json_buf_t out = {0};
+    json_append_str(&out, "{\"status\":\"ok\",\"cmd\":\"dump_tree\",\"nodes\":[");
+
+    uint32_t next_version = tree->version + 1;
+    int changed = 0;
+    int first = 1;
+    tree_walk(tree, screen, -1, since, next_version, &changed, &first, &out);
+
+    // Deletions since the last dump belong to the new version as well
+    if (tree->pending_removals) {
+        for (int i = 0; i < tree->node_count; i++) {
+            if (!tree->nodes[i].active && tree->nodes[i].removed == 0 && tree->nodes[i].version) {
+                tree->nodes[i].removed = next_version;
+                changed = 1;
+            }
+        }
+        tree->pending_removals = 0;
+    }
+
+    if (changed) {
+        tree->version = next_version;
+    }
+
+    json_append_str(&out, "],\"removed\":[");
+    first = 1;
+    for (int i = 0; i < tree->node_count; i++) {
+        if (!tree->nodes[i].active && tree->nodes[i].removed > since) {
+            char key[16];
+            snprintf(key, sizeof(key), first ? "%d" : ",%d", i);
+            json_append_str(&out, key);
+            first = 0;
+        }
+    }
+
+    char tail[96];
+    snprintf(tail, sizeof(tail), "],\"version\":%u,\"since\":%u,\"full\":%s}\n",
+             tree->version, since, since == 0 ? "true" : "false");
+    json_append_str(&out, tail);
+
+    if (out.failed) {
+        free(out.data);
+        return TEST_ERROR_MEMORY;
+    }
+
+    *json = out.data;
+    *json_len = out.len;
+    return TEST_OK;
+}
+#endif
+
+// LVGL thread: carry out a queued dump
+void ui_tree_run(ui_tree_request_t *request) {
+#ifdef HAVE_LVGL
+    request->result = ui_tree_serialize(request->session, request->since, &request->json, &request->json_len);
+#else
+    request->result = TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// Serialize the current session's active screen; with since > 0 only nodes changed after that
+// version. The walk is queued for the LVGL thread; the caller owns (and frees) the returned JSON.
+int ui_tree_dump(uint32_t since, char **json, size_t *json_len) {
+    if (!json || !json_len) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+
+    *json = NULL;
+    *json_len = 0;
+
+#ifdef HAVE_LVGL
+    ui_tree_request_t request;
+    memset(&request, 0, sizeof(request));
+    request.session = session_current();
+    request.since = since;
+
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_TREE_DUMP;
+    cmd.session = request.session;
+    cmd.params.tree.request = &request;
+    command_queue_run(&cmd);
+
+    *json = request.json;
+    *json_len = request.json_len;
+    return request.result;
+#else
+    (void)since;
+    printf("UI tree dump not available (no LVGL)\n");
+    return TEST_ERROR_NOT_FOUND;
+#endif
+}
+
+// Forget a session's nodes once its objects are gone
+void ui_tree_reset(int session) {
+    if (session >= 0 && session < MAX_SESSIONS) {
+        memset(&ui_trees[session], 0, sizeof(ui_trees[session]));
+    }
+}
+
+void ui_tree_cleanup(void) {
+    memset(ui_trees, 0, sizeof(ui_trees));
+}
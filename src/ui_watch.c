@@ -41,7 +41,8 @@ typedef enum {
     SCREEN_ACTIVITY = 2
 } screen_t;
 
-static struct {
+// One copy of the UI per session
+typedef struct {
     // Screen management
     screen_t current_screen;
     lv_obj_t *screen_container;
@@ -54,6 +55,7 @@ static struct {
     lv_obj_t *lbl_steps_main;
     lv_obj_t *heart_area;
     lv_obj_t *lbl_heart_bpm;
+    lv_obj_t *btn_activity;
     
     // Heart rate screen objects  
     lv_obj_t *hr_bg;
@@ -77,30 +79,80 @@ static struct {
     int is_measuring_heart;
     time_t last_update;
     time_t measurement_start;
-} watch_ui = {0};
+    int step_counter;
+    uint32_t rng;               // random readings, per session (see watch_rand)
+    
+#if HAVE_LVGL
+    lv_timer_t *update_timer;
+    
+    // Activity screen panning
+    lv_coord_t activity_press_x;
+    lv_coord_t activity_press_y;
+    bool activity_is_pressed;
+    lv_coord_t activity_start_pos;
+#endif
+} watch_ui_t;
+
+static watch_ui_t watch_uis[MAX_SESSIONS];
+
+static watch_ui_t *watch_ui_current(void) {
+    return &watch_uis[session_current()];
+}
 
 #if HAVE_LVGL
 
+// The layout is designed for a 480x480 display and scales with the shorter side of the real one
+#define UI_DESIGN_SIZE 480
+static int32_t ui_side = UI_DESIGN_SIZE;
+
+static int32_t ui_px(int32_t v) {
+    return v * ui_side / UI_DESIGN_SIZE;
+}
+
+// Largest enabled Montserrat size that fits the scaled 14 px design font
+static const lv_font_t *ui_font(void) {
+    int32_t size = ui_px(14);
+#if LV_FONT_MONTSERRAT_48
+    if (size >= 48) return &lv_font_montserrat_48;
+#endif
+#if LV_FONT_MONTSERRAT_32
+    if (size >= 32) return &lv_font_montserrat_32;
+#endif
+#if LV_FONT_MONTSERRAT_28
+    if (size >= 28) return &lv_font_montserrat_28;
+#endif
+#if LV_FONT_MONTSERRAT_20
+    if (size >= 20) return &lv_font_montserrat_20;
+#endif
+#if LV_FONT_MONTSERRAT_18
+    if (size >= 18) return &lv_font_montserrat_18;
+#endif
+    return LV_FONT_DEFAULT;
+}
+
 // Forward declarations
-void show_screen(screen_t screen);
-static void create_main_screen(void);
-static void create_heart_rate_screen(void); 
-static void create_activity_screen(void);
+static void watch_show_screen(watch_ui_t *ui, screen_t screen);
+static void create_main_screen(watch_ui_t *ui);
+static void create_heart_rate_screen(watch_ui_t *ui); 
+static void create_activity_screen(watch_ui_t *ui);
+static void watch_ui_update(watch_ui_t *ui);
 
 // Event handlers - Following LVGL best practices from documentation
 static void activity_button_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     if (code == LV_EVENT_CLICKED) {
         printf("Activity button clicked - switching to activity screen\n");
-        show_screen(SCREEN_ACTIVITY);
+        watch_show_screen(ui, SCREEN_ACTIVITY);
     }
 }
 
 static void heart_area_event_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     
     // Safety check: only process events if we're on the main screen
-    if (watch_ui.current_screen != SCREEN_MAIN) {
+    if (ui->current_screen != SCREEN_MAIN) {
         return;
     }
     
@@ -115,31 +167,32 @@ static void heart_area_event_handler(lv_event_t *e) {
         }
         
         // Navigate to heart rate screen
-        show_screen(SCREEN_HEART_RATE);
-        if (watch_ui.lbl_hr_instruction) {
-            lv_label_set_text(watch_ui.lbl_hr_instruction, "Long press to measure");
+        watch_show_screen(ui, SCREEN_HEART_RATE);
+        if (ui->lbl_hr_instruction) {
+            lv_label_set_text(ui->lbl_hr_instruction, "Long press to measure");
         }
     }
 }
 
 static void hr_measure_event_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     
     // Safety check: only process events if we're on the heart rate screen
-    if (watch_ui.current_screen != SCREEN_HEART_RATE) {
+    if (ui->current_screen != SCREEN_HEART_RATE) {
         return;
     }
     
     if (code == LV_EVENT_LONG_PRESSED) {
         printf("Heart rate measurement started via longpress\n");
-        watch_ui.is_measuring_heart = 1;
-        watch_ui.measurement_start = time(NULL);
-        lv_label_set_text(watch_ui.lbl_hr_value, "Measuring...");
-        lv_label_set_text(watch_ui.lbl_hr_instruction, "Hold still... measuring");
+        ui->is_measuring_heart = 1;
+        ui->measurement_start = time(NULL);
+        lv_label_set_text(ui->lbl_hr_value, "Measuring...");
+        lv_label_set_text(ui->lbl_hr_instruction, "Hold still... measuring");
         
         // Update steps to show activity during measurement
-        if (watch_ui.lbl_steps_main) {
-            lv_label_set_text(watch_ui.lbl_steps_main, "STEPS: 2500 (MEASURING!)");
+        if (ui->lbl_steps_main) {
+            lv_label_set_text(ui->lbl_steps_main, "STEPS: 2500 (MEASURING!)");
         }
         
         // Force LVGL to refresh and invalidate all displays immediately
@@ -149,8 +202,10 @@ static void hr_measure_event_handler(lv_event_t *e) {
 
 // Function to manually trigger heart rate measurement for automation testing
 void simulate_hr_measurement(void) {
+    watch_ui_t *ui = watch_ui_current();
+    
     // Safety check: only process if we're on the heart rate screen
-    if (watch_ui.current_screen != SCREEN_HEART_RATE) {
+    if (ui->current_screen != SCREEN_HEART_RATE) {
         printf("HR measurement simulation ignored - not on heart rate screen\n");
         return;
     }
@@ -158,34 +213,36 @@ void simulate_hr_measurement(void) {
     printf("Automation heart rate measurement - showing measuring state\n");
     
     // First show the measuring state for screenshot capture
-    lv_label_set_text(watch_ui.lbl_hr_value, "Measuring...");
-    lv_label_set_text(watch_ui.lbl_hr_instruction, "Hold still... measuring");
+    lv_label_set_text(ui->lbl_hr_value, "Measuring...");
+    lv_label_set_text(ui->lbl_hr_instruction, "Hold still... measuring");
     
     // Set measurement state for visual feedback
-    watch_ui.is_measuring_heart = 1;
-    watch_ui.measurement_start = time(NULL);
+    ui->is_measuring_heart = 1;
+    ui->measurement_start = time(NULL);
     
     printf("Measuring state displayed - ready for screenshot\n");
 }
 
 
 static void hr_screen_click_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     
     // Safety check: only process events if we're on the heart rate screen
-    if (watch_ui.current_screen != SCREEN_HEART_RATE) {
+    if (ui->current_screen != SCREEN_HEART_RATE) {
         return;
     }
     
     if (code == LV_EVENT_CLICKED) {
         printf("Heart rate screen clicked - returning to main\n");
-        show_screen(SCREEN_MAIN);
+        watch_show_screen(ui, SCREEN_MAIN);
     }
 }
 
 // activity_screen_event_handler removed - using activity_screen_gesture_handler instead
 
 static void main_screen_gesture_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     
     if (code == LV_EVENT_GESTURE) {
@@ -197,21 +254,22 @@ static void main_screen_gesture_handler(lv_event_t *e) {
         // Handle all swipe directions for full navigation
         if (dir == LV_DIR_LEFT) {
             printf("Left swipe detected - switching to activity screen\n");
-            show_screen(SCREEN_ACTIVITY);
+            watch_show_screen(ui, SCREEN_ACTIVITY);
         } else if (dir == LV_DIR_RIGHT) {
             printf("Right swipe detected - switching to heart rate screen\n");
-            show_screen(SCREEN_HEART_RATE);
+            watch_show_screen(ui, SCREEN_HEART_RATE);
         } else if (dir == 4) { // Up direction
             printf("Up swipe detected - cycling to next screen\n");
-            show_screen(SCREEN_HEART_RATE); // Up goes to heart rate
+            watch_show_screen(ui, SCREEN_HEART_RATE); // Up goes to heart rate
         } else if (dir == 8) { // Down direction
             printf("Down swipe detected - cycling to previous screen\n");
-            show_screen(SCREEN_ACTIVITY); // Down goes to activity
+            watch_show_screen(ui, SCREEN_ACTIVITY); // Down goes to activity
         }
     }
 }
 
 static void hr_screen_gesture_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     
     if (code == LV_EVENT_GESTURE) {
@@ -221,79 +279,75 @@ static void hr_screen_gesture_handler(lv_event_t *e) {
         printf("Gesture on heart rate screen, direction: %d\n", dir);
         if (dir == LV_DIR_LEFT) {
             printf("Left swipe - going to activity screen\n");
-            show_screen(SCREEN_ACTIVITY);
+            watch_show_screen(ui, SCREEN_ACTIVITY);
         } else if (dir == LV_DIR_RIGHT) {
             printf("Right swipe - returning to main screen\n");
-            show_screen(SCREEN_MAIN);
+            watch_show_screen(ui, SCREEN_MAIN);
         } else if (dir == 4 || dir == 8) { // Up or Down direction
             printf("Up/Down swipe - returning to main screen\n");
-            show_screen(SCREEN_MAIN);
+            watch_show_screen(ui, SCREEN_MAIN);
         }
     }
 }
 
 // Smooth panning with real-time visual feedback
-static lv_coord_t activity_press_x = 0;
-static lv_coord_t activity_press_y = 0; 
-static bool activity_is_pressed = false;
-static lv_coord_t activity_start_pos = 0;
-
 static void activity_screen_gesture_handler(lv_event_t *e) {
+    watch_ui_t *ui = lv_event_get_user_data(e);
     lv_event_code_t code = lv_event_get_code(e);
     lv_indev_t *indev = lv_indev_active();
     
     if (code == LV_EVENT_PRESSED) {
         lv_point_t point;
         lv_indev_get_point(indev, &point);
-        activity_press_x = point.x;
-        activity_press_y = point.y;
-        activity_is_pressed = true;
-        activity_start_pos = lv_obj_get_x(watch_ui.activity_bg);
-        printf("Activity screen press at (%d, %d), start_pos=%d\n", point.x, point.y, activity_start_pos);
+        ui->activity_press_x = point.x;
+        ui->activity_press_y = point.y;
+        ui->activity_is_pressed = true;
+        ui->activity_start_pos = lv_obj_get_x(ui->activity_bg);
+        printf("Activity screen press at (%d, %d), start_pos=%d\n", point.x, point.y, ui->activity_start_pos);
     } else if (code == LV_EVENT_PRESSING) {
-        if (activity_is_pressed) {
+        if (ui->activity_is_pressed) {
             lv_point_t point;
             lv_indev_get_point(indev, &point);
-            lv_coord_t dx = point.x - activity_press_x;
+            lv_coord_t dx = point.x - ui->activity_press_x;
             
             // Only allow horizontal panning for activity screen
             if (abs(dx) > 5) { // Small threshold to avoid jitter
-                lv_coord_t new_x = activity_start_pos + dx;
+                lv_coord_t new_x = ui->activity_start_pos + dx;
                 // Limit panning range (don't go too far)
-                if (new_x > -200 && new_x < 200) {
-                    lv_obj_set_x(watch_ui.activity_bg, new_x);
+                if (new_x > -ui_px(200) && new_x < ui_px(200)) {
+                    lv_obj_set_x(ui->activity_bg, new_x);
                     printf("Panning activity screen to x=%d (dx=%d)\n", new_x, dx);
                 }
             }
         }
     } else if (code == LV_EVENT_RELEASED) {
-        if (activity_is_pressed) {
+        if (ui->activity_is_pressed) {
             lv_point_t point;
             lv_indev_get_point(indev, &point);
-            lv_coord_t dx = point.x - activity_press_x;
+            lv_coord_t dx = point.x - ui->activity_press_x;
             
             printf("Activity screen release at (%d, %d), dx=%d\n", point.x, point.y, dx);
             
             // Snap to nearest screen based on drag distance
-            if (abs(dx) > 80) {
+            if (abs(dx) > ui_px(80)) {
                 if (dx > 0) {
                     printf("Swipe right completed - going to heart rate screen\n");
-                    show_screen(SCREEN_HEART_RATE);
+                    watch_show_screen(ui, SCREEN_HEART_RATE);
                 } else {
                     printf("Swipe left completed - going to main screen\n");
-                    show_screen(SCREEN_MAIN);
+                    watch_show_screen(ui, SCREEN_MAIN);
                 }
             } else {
                 // Small movement or insufficient swipe - snap back to center
                 printf("Insufficient swipe - staying on activity screen\n");
-                lv_obj_set_x(watch_ui.activity_bg, 0);
+                lv_obj_set_x(ui->activity_bg, 0);
                 if (abs(dx) < 10) {
                     // Very small movement = tap
                     printf("Activity screen tapped - going to main screen\n");
-                    show_screen(SCREEN_MAIN);
+                    watch_show_screen(ui, SCREEN_MAIN);
                 }
             }
-            activity_is_pressed = false;
+            ui->activity_is_pressed = false;
         }
     }
 }
@@ -301,98 +355,103 @@ static void activity_screen_gesture_handler(lv_event_t *e) {
 // Removed keyboard shortcuts - keeping only click, longpress, swipe
 
 // Screen management functions
-void show_screen(screen_t screen) {
+static void watch_show_screen(watch_ui_t *ui, screen_t screen) {
     // Hide all screens
-    if (watch_ui.main_bg) lv_obj_add_flag(watch_ui.main_bg, LV_OBJ_FLAG_HIDDEN);
-    if (watch_ui.hr_bg) lv_obj_add_flag(watch_ui.hr_bg, LV_OBJ_FLAG_HIDDEN);
-    if (watch_ui.activity_bg) lv_obj_add_flag(watch_ui.activity_bg, LV_OBJ_FLAG_HIDDEN);
+    if (ui->main_bg) lv_obj_add_flag(ui->main_bg, LV_OBJ_FLAG_HIDDEN);
+    if (ui->hr_bg) lv_obj_add_flag(ui->hr_bg, LV_OBJ_FLAG_HIDDEN);
+    if (ui->activity_bg) lv_obj_add_flag(ui->activity_bg, LV_OBJ_FLAG_HIDDEN);
     
     // Show requested screen
-    watch_ui.current_screen = screen;
+    ui->current_screen = screen;
     switch (screen) {
         case SCREEN_MAIN:
-            if (watch_ui.main_bg) lv_obj_clear_flag(watch_ui.main_bg, LV_OBJ_FLAG_HIDDEN);
+            if (ui->main_bg) lv_obj_clear_flag(ui->main_bg, LV_OBJ_FLAG_HIDDEN);
             printf("Switched to main screen\n");
             break;
         case SCREEN_HEART_RATE:
-            if (watch_ui.hr_bg) lv_obj_clear_flag(watch_ui.hr_bg, LV_OBJ_FLAG_HIDDEN);
+            if (ui->hr_bg) lv_obj_clear_flag(ui->hr_bg, LV_OBJ_FLAG_HIDDEN);
             printf("Switched to heart rate screen\n");
             break;
         case SCREEN_ACTIVITY:
-            if (watch_ui.activity_bg) {
-                lv_obj_clear_flag(watch_ui.activity_bg, LV_OBJ_FLAG_HIDDEN);
+            if (ui->activity_bg) {
+                lv_obj_clear_flag(ui->activity_bg, LV_OBJ_FLAG_HIDDEN);
                 // Reset position to center when navigating back to activity screen
-                lv_obj_set_x(watch_ui.activity_bg, 0);
+                lv_obj_set_x(ui->activity_bg, 0);
                 printf("Switched to activity screen (position reset to center)\n");
             }
             break;
     }
 }
 
-static void create_main_screen(void) {
-    const int32_t w = 400, h = 400;
+// Show a screen of the current session's UI
+void show_screen(screen_t screen) {
+    watch_show_screen(watch_ui_current(), screen);
+}
+
+static void create_main_screen(watch_ui_t *ui) {
+    const int32_t w = ui_px(400), h = ui_px(400);
     
     // Main circular background
-    watch_ui.main_bg = lv_obj_create(watch_ui.screen_container);
-    lv_obj_set_size(watch_ui.main_bg, w, h);
-    lv_obj_center(watch_ui.main_bg);
-    lv_obj_set_style_radius(watch_ui.main_bg, w/2, 0);
-    lv_obj_set_style_bg_color(watch_ui.main_bg, lv_color_hex(0x001122), 0);
-    lv_obj_set_style_border_width(watch_ui.main_bg, 2, 0);
-    lv_obj_set_style_border_color(watch_ui.main_bg, lv_color_hex(0x333333), 0);
+    ui->main_bg = lv_obj_create(ui->screen_container);
+    lv_obj_set_size(ui->main_bg, w, h);
+    lv_obj_center(ui->main_bg);
+    lv_obj_set_style_radius(ui->main_bg, w/2, 0);
+    lv_obj_set_style_bg_color(ui->main_bg, lv_color_hex(0x001122), 0);
+    lv_obj_set_style_border_width(ui->main_bg, 2, 0);
+    lv_obj_set_style_border_color(ui->main_bg, lv_color_hex(0x333333), 0);
     
     // Large time display (center)
-    watch_ui.lbl_time = lv_label_create(watch_ui.main_bg);
-    lv_obj_set_style_text_color(watch_ui.lbl_time, lv_color_white(), 0);
-    lv_obj_align(watch_ui.lbl_time, LV_ALIGN_CENTER, 0, -30);
+    ui->lbl_time = lv_label_create(ui->main_bg);
+    lv_obj_set_style_text_color(ui->lbl_time, lv_color_white(), 0);
+    lv_obj_align(ui->lbl_time, LV_ALIGN_CENTER, 0, ui_px(-30));
     
     // Date display (above time)
-    watch_ui.lbl_date = lv_label_create(watch_ui.main_bg);
-    lv_label_set_text(watch_ui.lbl_date, "MON, SEP 8");
-    lv_obj_set_style_text_color(watch_ui.lbl_date, lv_color_hex(0xAAAAAA), 0);
-    lv_obj_align(watch_ui.lbl_date, LV_ALIGN_CENTER, 0, -80);
+    ui->lbl_date = lv_label_create(ui->main_bg);
+    lv_label_set_text(ui->lbl_date, "MON, SEP 8");
+    lv_obj_set_style_text_color(ui->lbl_date, lv_color_hex(0xAAAAAA), 0);
+    lv_obj_align(ui->lbl_date, LV_ALIGN_CENTER, 0, ui_px(-80));
     
     // Battery indicator (inside circle, top right)
-    watch_ui.lbl_battery = lv_label_create(watch_ui.main_bg);
-    lv_label_set_text(watch_ui.lbl_battery, "85%");
-    lv_obj_set_style_text_color(watch_ui.lbl_battery, lv_color_hex(0x00FF00), 0);
-    lv_obj_align(watch_ui.lbl_battery, LV_ALIGN_TOP_RIGHT, -40, 40); // Move further inside circle
+    ui->lbl_battery = lv_label_create(ui->main_bg);
+    lv_label_set_text(ui->lbl_battery, "85%");
+    lv_obj_set_style_text_color(ui->lbl_battery, lv_color_hex(0x00FF00), 0);
+    lv_obj_align(ui->lbl_battery, LV_ALIGN_TOP_RIGHT, ui_px(-40), ui_px(40)); // Move further inside circle
     
     // Steps display above heart rate  
-    watch_ui.lbl_steps_main = lv_label_create(watch_ui.main_bg);
-    lv_label_set_text(watch_ui.lbl_steps_main, "STEPS: 1254");
-    lv_obj_set_style_text_color(watch_ui.lbl_steps_main, lv_color_hex(0x44FF44), 0);
-    lv_obj_align(watch_ui.lbl_steps_main, LV_ALIGN_CENTER, 0, 10);
+    ui->lbl_steps_main = lv_label_create(ui->main_bg);
+    lv_label_set_text(ui->lbl_steps_main, "STEPS: 1254");
+    lv_obj_set_style_text_color(ui->lbl_steps_main, lv_color_hex(0x44FF44), 0);
+    lv_obj_align(ui->lbl_steps_main, LV_ALIGN_CENTER, 0, ui_px(10));
     
     // Heart rate area (clickable, inside circle) - Following LVGL best practices
-    watch_ui.heart_area = lv_btn_create(watch_ui.main_bg);
-    lv_obj_set_size(watch_ui.heart_area, 140, 50);
-    lv_obj_align(watch_ui.heart_area, LV_ALIGN_BOTTOM_MID, 0, -40);
+    ui->heart_area = lv_btn_create(ui->main_bg);
+    lv_obj_set_size(ui->heart_area, ui_px(140), ui_px(50));
+    lv_obj_align(ui->heart_area, LV_ALIGN_BOTTOM_MID, 0, ui_px(-40));
     
     // Style the button properly
-    lv_obj_set_style_bg_color(watch_ui.heart_area, lv_color_hex(0x330000), LV_PART_MAIN);
-    lv_obj_set_style_border_color(watch_ui.heart_area, lv_color_hex(0xFF4444), LV_PART_MAIN);
-    lv_obj_set_style_border_width(watch_ui.heart_area, 2, LV_PART_MAIN);
-    lv_obj_set_style_radius(watch_ui.heart_area, 10, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(ui->heart_area, lv_color_hex(0x330000), LV_PART_MAIN);
+    lv_obj_set_style_border_color(ui->heart_area, lv_color_hex(0xFF4444), LV_PART_MAIN);
+    lv_obj_set_style_border_width(ui->heart_area, 2, LV_PART_MAIN);
+    lv_obj_set_style_radius(ui->heart_area, ui_px(10), LV_PART_MAIN);
     
     // Heart button - CLICK ONLY for navigation
-    lv_obj_add_event_cb(watch_ui.heart_area, heart_area_event_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(ui->heart_area, heart_area_event_handler, LV_EVENT_CLICKED, ui);
     
     // Enable clickable flag explicitly
-    lv_obj_add_flag(watch_ui.heart_area, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(ui->heart_area, LV_OBJ_FLAG_CLICKABLE);
     
     // Heart rate label - create as child of button
-    watch_ui.lbl_heart_bpm = lv_label_create(watch_ui.heart_area);
-    lv_label_set_text(watch_ui.lbl_heart_bpm, "HEART 72 BPM");
-    lv_obj_set_style_text_color(watch_ui.lbl_heart_bpm, lv_color_white(), LV_PART_MAIN);
-    lv_obj_center(watch_ui.lbl_heart_bpm);
+    ui->lbl_heart_bpm = lv_label_create(ui->heart_area);
+    lv_label_set_text(ui->lbl_heart_bpm, "HEART 72 BPM");
+    lv_obj_set_style_text_color(ui->lbl_heart_bpm, lv_color_white(), LV_PART_MAIN);
+    lv_obj_center(ui->lbl_heart_bpm);
     
     printf("Heart button created with proper event handling\n");
     
     // Add activity button for easy access
-    lv_obj_t *btn_activity = lv_btn_create(watch_ui.main_bg);
-    lv_obj_set_size(btn_activity, 80, 30);
-    lv_obj_align(btn_activity, LV_ALIGN_TOP_LEFT, 20, 40);
+    lv_obj_t *btn_activity = lv_btn_create(ui->main_bg);
+    lv_obj_set_size(btn_activity, ui_px(80), ui_px(30));
+    lv_obj_align(btn_activity, LV_ALIGN_TOP_LEFT, ui_px(20), ui_px(40));
     lv_obj_set_style_bg_color(btn_activity, lv_color_hex(0x003300), LV_PART_MAIN);
     lv_obj_set_style_border_color(btn_activity, lv_color_hex(0x44FF44), LV_PART_MAIN);
     lv_obj_set_style_border_width(btn_activity, 1, LV_PART_MAIN);
@@ -403,183 +462,202 @@ static void create_main_screen(void) {
     lv_obj_center(lbl_activity);
     
     // Activity button event handler
-    lv_obj_add_event_cb(btn_activity, activity_button_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(btn_activity, activity_button_handler, LV_EVENT_CLICKED, ui);
     
     // Enable gesture detection on main screen background
-    lv_obj_add_flag(watch_ui.main_bg, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(ui->main_bg, LV_OBJ_FLAG_CLICKABLE);
     
     // Add gesture support to main screen background for swipe navigation
-    lv_obj_add_event_cb(watch_ui.main_bg, main_screen_gesture_handler, LV_EVENT_GESTURE, NULL);
+    lv_obj_add_event_cb(ui->main_bg, main_screen_gesture_handler, LV_EVENT_GESTURE, ui);
     
     // Force LVGL to recalculate coordinates (expert guidance)
-    lv_obj_update_layout(watch_ui.main_bg);
+    lv_obj_update_layout(ui->main_bg);
     
     // Removed keyboard shortcuts - keeping UI simple and robust
     
     // Register activity button
+    ui->btn_activity = btn_activity;
     reg_widget("btn_activity", btn_activity);
     
     // Register widgets with test automation IDs
-    reg_widget("main_screen", watch_ui.main_bg);
-    reg_widget("lbl_time", watch_ui.lbl_time);
-    reg_widget("lbl_date", watch_ui.lbl_date);
-    reg_widget("lbl_battery", watch_ui.lbl_battery);
-    reg_widget("lbl_steps_main", watch_ui.lbl_steps_main);
-    reg_widget("heart_area", watch_ui.heart_area);
-    reg_widget("lbl_heart_bpm", watch_ui.lbl_heart_bpm);
+    reg_widget("main_screen", ui->main_bg);
+    reg_widget("lbl_time", ui->lbl_time);
+    reg_widget("lbl_date", ui->lbl_date);
+    reg_widget("lbl_battery", ui->lbl_battery);
+    reg_widget("lbl_steps_main", ui->lbl_steps_main);
+    reg_widget("heart_area", ui->heart_area);
+    reg_widget("lbl_heart_bpm", ui->lbl_heart_bpm);
     // Aliases for pytest compatibility
-    reg_widget("btn_heart", watch_ui.heart_area);
-    reg_widget("lbl_bpm", watch_ui.lbl_heart_bpm);
+    reg_widget("btn_heart", ui->heart_area);
+    reg_widget("lbl_bpm", ui->lbl_heart_bpm);
 }
 
-static void create_heart_rate_screen(void) {
-    const int32_t w = 400, h = 400;
+static void create_heart_rate_screen(watch_ui_t *ui) {
+    const int32_t w = ui_px(400), h = ui_px(400);
     
     // Heart rate circular background  
-    watch_ui.hr_bg = lv_obj_create(watch_ui.screen_container);
-    lv_obj_set_size(watch_ui.hr_bg, w, h);
-    lv_obj_center(watch_ui.hr_bg);
-    lv_obj_set_style_radius(watch_ui.hr_bg, w/2, 0);
-    lv_obj_set_style_bg_color(watch_ui.hr_bg, lv_color_hex(0x220000), 0);
-    lv_obj_set_style_border_width(watch_ui.hr_bg, 2, 0);
-    lv_obj_set_style_border_color(watch_ui.hr_bg, lv_color_hex(0xFF4444), 0);
+    ui->hr_bg = lv_obj_create(ui->screen_container);
+    lv_obj_set_size(ui->hr_bg, w, h);
+    lv_obj_center(ui->hr_bg);
+    lv_obj_set_style_radius(ui->hr_bg, w/2, 0);
+    lv_obj_set_style_bg_color(ui->hr_bg, lv_color_hex(0x220000), 0);
+    lv_obj_set_style_border_width(ui->hr_bg, 2, 0);
+    lv_obj_set_style_border_color(ui->hr_bg, lv_color_hex(0xFF4444), 0);
     
     // Large heart text
-    watch_ui.lbl_hr_icon = lv_label_create(watch_ui.hr_bg);
-    lv_label_set_text(watch_ui.lbl_hr_icon, "HEART RATE");
-    lv_obj_set_style_text_color(watch_ui.lbl_hr_icon, lv_color_hex(0xFF4444), 0);
-    lv_obj_align(watch_ui.lbl_hr_icon, LV_ALIGN_CENTER, 0, -40);
+    ui->lbl_hr_icon = lv_label_create(ui->hr_bg);
+    lv_label_set_text(ui->lbl_hr_icon, "HEART RATE");
+    lv_obj_set_style_text_color(ui->lbl_hr_icon, lv_color_hex(0xFF4444), 0);
+    lv_obj_align(ui->lbl_hr_icon, LV_ALIGN_CENTER, 0, ui_px(-40));
     
     // Heart rate value
-    watch_ui.lbl_hr_value = lv_label_create(watch_ui.hr_bg);
-    lv_label_set_text(watch_ui.lbl_hr_value, "72 BPM");
-    lv_obj_set_style_text_color(watch_ui.lbl_hr_value, lv_color_white(), 0);
-    lv_obj_align(watch_ui.lbl_hr_value, LV_ALIGN_CENTER, 0, 20);
+    ui->lbl_hr_value = lv_label_create(ui->hr_bg);
+    lv_label_set_text(ui->lbl_hr_value, "72 BPM");
+    lv_obj_set_style_text_color(ui->lbl_hr_value, lv_color_white(), 0);
+    lv_obj_align(ui->lbl_hr_value, LV_ALIGN_CENTER, 0, ui_px(20));
     
     // Instruction text
-    watch_ui.lbl_hr_instruction = lv_label_create(watch_ui.hr_bg);
-    lv_label_set_text(watch_ui.lbl_hr_instruction, "Hold to measure");
-    lv_obj_set_style_text_color(watch_ui.lbl_hr_instruction, lv_color_hex(0xAAAAAA), 0);
-    lv_obj_align(watch_ui.lbl_hr_instruction, LV_ALIGN_BOTTOM_MID, 0, -30);
+    ui->lbl_hr_instruction = lv_label_create(ui->hr_bg);
+    lv_label_set_text(ui->lbl_hr_instruction, "Hold to measure");
+    lv_obj_set_style_text_color(ui->lbl_hr_instruction, lv_color_hex(0xAAAAAA), 0);
+    lv_obj_align(ui->lbl_hr_instruction, LV_ALIGN_BOTTOM_MID, 0, ui_px(-30));
     
     // HR screen background - CLICK ONLY for navigation back to main
-    lv_obj_add_event_cb(watch_ui.hr_bg, hr_screen_click_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(ui->hr_bg, hr_screen_click_handler, LV_EVENT_CLICKED, ui);
     
     // Small dedicated longpress area in center - LONGPRESS ONLY for measurements
-    watch_ui.hr_measure_area = lv_btn_create(watch_ui.hr_bg);
-    lv_obj_set_size(watch_ui.hr_measure_area, 120, 120);
-    lv_obj_center(watch_ui.hr_measure_area);
-    lv_obj_set_style_bg_opa(watch_ui.hr_measure_area, LV_OPA_10, 0);  // Slight visible hint
-    lv_obj_set_style_bg_color(watch_ui.hr_measure_area, lv_color_hex(0xFF4444), 0);
-    lv_obj_set_style_border_opa(watch_ui.hr_measure_area, LV_OPA_30, 0);
-    lv_obj_set_style_border_color(watch_ui.hr_measure_area, lv_color_hex(0xFF4444), 0);
-    lv_obj_set_style_border_width(watch_ui.hr_measure_area, 1, 0);
-    lv_obj_set_style_radius(watch_ui.hr_measure_area, 60, 0);
+    ui->hr_measure_area = lv_btn_create(ui->hr_bg);
+    lv_obj_set_size(ui->hr_measure_area, ui_px(120), ui_px(120));
+    lv_obj_center(ui->hr_measure_area);
+    lv_obj_set_style_bg_opa(ui->hr_measure_area, LV_OPA_10, 0);  // Slight visible hint
+    lv_obj_set_style_bg_color(ui->hr_measure_area, lv_color_hex(0xFF4444), 0);
+    lv_obj_set_style_border_opa(ui->hr_measure_area, LV_OPA_30, 0);
+    lv_obj_set_style_border_color(ui->hr_measure_area, lv_color_hex(0xFF4444), 0);
+    lv_obj_set_style_border_width(ui->hr_measure_area, 1, 0);
+    lv_obj_set_style_radius(ui->hr_measure_area, ui_px(60), 0);
     // LONGPRESS ONLY - no click handler 
-    lv_obj_add_event_cb(watch_ui.hr_measure_area, hr_measure_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+    lv_obj_add_event_cb(ui->hr_measure_area, hr_measure_event_handler, LV_EVENT_LONG_PRESSED, ui);
     
     // Enable gesture detection on heart rate screen background
-    lv_obj_add_flag(watch_ui.hr_bg, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(ui->hr_bg, LV_OBJ_FLAG_CLICKABLE);
     
     // Add gesture detection for navigation  
-    lv_obj_add_event_cb(watch_ui.hr_bg, hr_screen_gesture_handler, LV_EVENT_GESTURE, NULL);
+    lv_obj_add_event_cb(ui->hr_bg, hr_screen_gesture_handler, LV_EVENT_GESTURE, ui);
     
     // Register widgets
-    reg_widget("hr_screen", watch_ui.hr_bg);
-    reg_widget("lbl_hr_value", watch_ui.lbl_hr_value);
-    reg_widget("lbl_hr_instruction", watch_ui.lbl_hr_instruction);
-    reg_widget("hr_measure_area", watch_ui.hr_measure_area);
+    reg_widget("hr_screen", ui->hr_bg);
+    reg_widget("lbl_hr_value", ui->lbl_hr_value);
+    reg_widget("lbl_hr_instruction", ui->lbl_hr_instruction);
+    reg_widget("hr_measure_area", ui->hr_measure_area);
 }
 
-static void create_activity_screen(void) {
-    const int32_t w = 400, h = 400;
+static void create_activity_screen(watch_ui_t *ui) {
+    const int32_t w = ui_px(400), h = ui_px(400);
     
     // Activity circular background
-    watch_ui.activity_bg = lv_obj_create(watch_ui.screen_container);
-    lv_obj_set_size(watch_ui.activity_bg, w, h);
-    lv_obj_center(watch_ui.activity_bg);
-    lv_obj_set_style_radius(watch_ui.activity_bg, w/2, 0);
-    lv_obj_set_style_bg_color(watch_ui.activity_bg, lv_color_hex(0x002200), 0);
-    lv_obj_set_style_border_width(watch_ui.activity_bg, 2, 0);
-    lv_obj_set_style_border_color(watch_ui.activity_bg, lv_color_hex(0x44FF44), 0);
+    ui->activity_bg = lv_obj_create(ui->screen_container);
+    lv_obj_set_size(ui->activity_bg, w, h);
+    lv_obj_center(ui->activity_bg);
+    lv_obj_set_style_radius(ui->activity_bg, w/2, 0);
+    lv_obj_set_style_bg_color(ui->activity_bg, lv_color_hex(0x002200), 0);
+    lv_obj_set_style_border_width(ui->activity_bg, 2, 0);
+    lv_obj_set_style_border_color(ui->activity_bg, lv_color_hex(0x44FF44), 0);
     
     // Steps title
-    watch_ui.lbl_steps_icon = lv_label_create(watch_ui.activity_bg);
-    lv_label_set_text(watch_ui.lbl_steps_icon, "STEPS");
-    lv_obj_set_style_text_color(watch_ui.lbl_steps_icon, lv_color_hex(0x44FF44), 0);
-    lv_obj_align(watch_ui.lbl_steps_icon, LV_ALIGN_CENTER, 0, -60);
+    ui->lbl_steps_icon = lv_label_create(ui->activity_bg);
+    lv_label_set_text(ui->lbl_steps_icon, "STEPS");
+    lv_obj_set_style_text_color(ui->lbl_steps_icon, lv_color_hex(0x44FF44), 0);
+    lv_obj_align(ui->lbl_steps_icon, LV_ALIGN_CENTER, 0, ui_px(-60));
     
     // Steps count
-    watch_ui.lbl_steps_count = lv_label_create(watch_ui.activity_bg);
-    lv_label_set_text(watch_ui.lbl_steps_count, "1,234");
-    lv_obj_set_style_text_color(watch_ui.lbl_steps_count, lv_color_white(), 0);
-    lv_obj_align(watch_ui.lbl_steps_count, LV_ALIGN_CENTER, 0, -20);
+    ui->lbl_steps_count = lv_label_create(ui->activity_bg);
+    lv_label_set_text(ui->lbl_steps_count, "1,234");
+    lv_obj_set_style_text_color(ui->lbl_steps_count, lv_color_white(), 0);
+    lv_obj_align(ui->lbl_steps_count, LV_ALIGN_CENTER, 0, ui_px(-20));
     
     // Progress bar (goal progress)
-    watch_ui.progress_bar = lv_bar_create(watch_ui.activity_bg);
-    lv_obj_set_size(watch_ui.progress_bar, 200, 10);
-    lv_obj_align(watch_ui.progress_bar, LV_ALIGN_CENTER, 0, 20);
-    lv_bar_set_value(watch_ui.progress_bar, 62, LV_ANIM_OFF);
-    lv_obj_set_style_bg_color(watch_ui.progress_bar, lv_color_hex(0x44FF44), LV_PART_INDICATOR);
+    ui->progress_bar = lv_bar_create(ui->activity_bg);
+    lv_obj_set_size(ui->progress_bar, ui_px(200), ui_px(10));
+    lv_obj_align(ui->progress_bar, LV_ALIGN_CENTER, 0, ui_px(20));
+    lv_bar_set_value(ui->progress_bar, 62, LV_ANIM_OFF);
+    lv_obj_set_style_bg_color(ui->progress_bar, lv_color_hex(0x44FF44), LV_PART_INDICATOR);
     
     // Calories
-    watch_ui.lbl_calories = lv_label_create(watch_ui.activity_bg);
-    lv_label_set_text(watch_ui.lbl_calories, "245 cal");
-    lv_obj_set_style_text_color(watch_ui.lbl_calories, lv_color_hex(0x44FF44), 0);
-    lv_obj_align(watch_ui.lbl_calories, LV_ALIGN_BOTTOM_MID, 0, -30);
+    ui->lbl_calories = lv_label_create(ui->activity_bg);
+    lv_label_set_text(ui->lbl_calories, "245 cal");
+    lv_obj_set_style_text_color(ui->lbl_calories, lv_color_hex(0x44FF44), 0);
+    lv_obj_align(ui->lbl_calories, LV_ALIGN_BOTTOM_MID, 0, ui_px(-30));
     
     // Activity screen background - Use press/pressing/release for smooth panning
-    lv_obj_add_flag(watch_ui.activity_bg, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(ui->activity_bg, LV_OBJ_FLAG_CLICKABLE);
     
     // Handle press, pressing, and release events for smooth panning
-    lv_obj_add_event_cb(watch_ui.activity_bg, activity_screen_gesture_handler, LV_EVENT_PRESSED, NULL);
-    lv_obj_add_event_cb(watch_ui.activity_bg, activity_screen_gesture_handler, LV_EVENT_PRESSING, NULL);
-    lv_obj_add_event_cb(watch_ui.activity_bg, activity_screen_gesture_handler, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(ui->activity_bg, activity_screen_gesture_handler, LV_EVENT_PRESSED, ui);
+    lv_obj_add_event_cb(ui->activity_bg, activity_screen_gesture_handler, LV_EVENT_PRESSING, ui);
+    lv_obj_add_event_cb(ui->activity_bg, activity_screen_gesture_handler, LV_EVENT_RELEASED, ui);
     
     // Register widgets
-    reg_widget("activity_screen", watch_ui.activity_bg);
-    reg_widget("lbl_steps_count", watch_ui.lbl_steps_count);
-    reg_widget("lbl_calories", watch_ui.lbl_calories);
+    reg_widget("activity_screen", ui->activity_bg);
+    reg_widget("lbl_steps_count", ui->lbl_steps_count);
+    reg_widget("lbl_calories", ui->lbl_calories);
     // Aliases for pytest compatibility  
-    reg_widget("lbl_steps", watch_ui.lbl_steps_count);
+    reg_widget("lbl_steps", ui->lbl_steps_count);
+}
+
+// Each session's UI refreshes on its own timer
+static void ui_watch_timer_cb(lv_timer_t *timer) {
+    watch_ui_update(lv_timer_get_user_data(timer));
 }
 
 #endif
 
+// Build the UI on the current session's display
 void ui_watch_create(void) {
 #if HAVE_LVGL
     printf("Creating 3-screen smartwatch UI with proper UX/UI...\n");
     
+    watch_ui_t *ui = watch_ui_current();
+    lv_display_t *disp = session_get_display(session_current());
+    
     // Initialize data
-    watch_ui.current_screen = SCREEN_MAIN;
-    watch_ui.heart_rate = 72;
-    watch_ui.steps = 1234;
-    watch_ui.calories = 245;
-    watch_ui.battery_percent = 85;
-    watch_ui.is_measuring_heart = 0;
-    watch_ui.last_update = time(NULL);
+    ui->current_screen = SCREEN_MAIN;
+    ui->heart_rate = 72;
+    ui->steps = 1234;
+    ui->calories = 245;
+    ui->battery_percent = 85;
+    ui->is_measuring_heart = 0;
+    ui->last_update = time(NULL);
+    ui->rng = 1;    // same readings as an unseeded rand() until ui_watch_seed
+    
+    // Scale the layout to the display
+    int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+    int32_t ver_res = lv_display_get_vertical_resolution(disp);
+    ui_side = hor_res < ver_res ? hor_res : ver_res;
     
     // Create screen container
-    watch_ui.screen_container = lv_obj_create(lv_screen_active());
-    lv_obj_set_size(watch_ui.screen_container, 480, 480);
-    lv_obj_center(watch_ui.screen_container);
-    lv_obj_set_style_bg_opa(watch_ui.screen_container, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(watch_ui.screen_container, 0, 0);
+    ui->screen_container = lv_obj_create(lv_display_get_screen_active(disp));
+    lv_obj_set_size(ui->screen_container, hor_res, ver_res);
+    lv_obj_set_style_text_font(ui->screen_container, ui_font(), 0);  // inherited by every label
+    lv_obj_center(ui->screen_container);
+    lv_obj_set_style_bg_opa(ui->screen_container, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(ui->screen_container, 0, 0);
     
     // Enable gesture detection on main screen container for global swipe support
-    lv_obj_add_flag(watch_ui.screen_container, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(ui->screen_container, LV_OBJ_FLAG_CLICKABLE);
     printf("Screen container configured with gesture support\n");
     
-    // Create all screens
-    create_main_screen();
-    create_heart_rate_screen();  
-    create_activity_screen();
+    // Create all screens; focusable widgets join the session's own group (keys go there)
+    lv_group_set_default(session_get_group(session_current()));
+    create_main_screen(ui);
+    create_heart_rate_screen(ui);  
+    create_activity_screen(ui);
+    lv_group_set_default(NULL);
     
     // Show main screen initially
-    show_screen(SCREEN_MAIN);
+    watch_show_screen(ui, SCREEN_MAIN);
     
     // Start timer for updates
-    lv_timer_create((lv_timer_cb_t)ui_watch_update, 1000, NULL);
+    ui->update_timer = lv_timer_create(ui_watch_timer_cb, 1000, ui);
     
     printf("3-screen smartwatch UI created successfully\n");
     
@@ -597,7 +675,36 @@ void ui_watch_create(void) {
 #endif
 }
 
-void ui_watch_update(void) {
+// Remove the current session's UI: its update timer and all of its objects. The widget
+// registry still points at them, so the caller cleans it up as well.
+void ui_watch_destroy(void) {
+#if HAVE_LVGL
+    watch_ui_t *ui = watch_ui_current();
+    if (ui->update_timer) {
+        lv_timer_delete(ui->update_timer);
+    }
+    if (ui->screen_container) {
+        lv_obj_delete(ui->screen_container);
+    }
+    memset(ui, 0, sizeof(*ui));
+#endif
+}
+
+// Reseed the current session's random readings, so later ones repeat (reset with a seed)
+void ui_watch_seed(uint32_t seed) {
+    watch_ui_current()->rng = seed;
+}
+
+#if HAVE_LVGL
+// Per-session LCG: a seed or a reading in one session never shifts another's, unlike the
+// process-wide rand()
+static uint32_t watch_rand(watch_ui_t *ui) {
+    ui->rng = ui->rng * 1103515245u + 12345u;
+    return (ui->rng >> 16) & 0x7fff;
+}
+#endif
+
+static void watch_ui_update(watch_ui_t *ui) {
 #if HAVE_LVGL
     // Update time - YOUR reference pattern exactly
     time_t now = time(NULL);
@@ -608,88 +715,131 @@ void ui_watch_update(void) {
     strftime(time_buf, sizeof(time_buf), "%H:%M", t);
     strftime(date_buf, sizeof(date_buf), "%a, %b %d", t);
     
-    if (watch_ui.lbl_time) {
-        lv_label_set_text(watch_ui.lbl_time, time_buf);
+    if (ui->lbl_time) {
+        lv_label_set_text(ui->lbl_time, time_buf);
     }
-    if (watch_ui.lbl_date) {
-        lv_label_set_text(watch_ui.lbl_date, date_buf);
+    if (ui->lbl_date) {
+        lv_label_set_text(ui->lbl_date, date_buf);
     }
     
     // Update battery display
-    if (watch_ui.lbl_battery) {
+    if (ui->lbl_battery) {
         char battery_buf[32];
-        snprintf(battery_buf, sizeof(battery_buf), "Battery %d%%", watch_ui.battery_percent);
-        lv_label_set_text(watch_ui.lbl_battery, battery_buf);
+        snprintf(battery_buf, sizeof(battery_buf), "Battery %d%%", ui->battery_percent);
+        lv_label_set_text(ui->lbl_battery, battery_buf);
     }
     
     // Handle heart rate measurement
-    if (watch_ui.is_measuring_heart && watch_ui.lbl_hr_value) {
-        time_t elapsed = now - watch_ui.measurement_start;
+    if (ui->is_measuring_heart && ui->lbl_hr_value) {
+        time_t elapsed = now - ui->measurement_start;
         if (elapsed >= 3) { // 3 second measurement
-            watch_ui.heart_rate = 65 + (rand() % 30); // 65-95 BPM
+            ui->heart_rate = 65 + (int)(watch_rand(ui) % 30); // 65-95 BPM
             char hr_buf[16];
-            snprintf(hr_buf, sizeof(hr_buf), "%d BPM", watch_ui.heart_rate);
-            lv_label_set_text(watch_ui.lbl_hr_value, hr_buf);
-            lv_label_set_text(watch_ui.lbl_hr_instruction, "Tap to go back");
-            watch_ui.is_measuring_heart = 0;
-            printf("Heart rate measured: %d BPM\n", watch_ui.heart_rate);
+            snprintf(hr_buf, sizeof(hr_buf), "%d BPM", ui->heart_rate);
+            lv_label_set_text(ui->lbl_hr_value, hr_buf);
+            lv_label_set_text(ui->lbl_hr_instruction, "Tap to go back");
+            ui->is_measuring_heart = 0;
+            printf("Heart rate measured: %d BPM\n", ui->heart_rate);
         }
     }
     
     // Update heart rate in main screen
-    if (watch_ui.lbl_heart_bpm) {
+    if (ui->lbl_heart_bpm) {
         char hr_buf[32];
-        snprintf(hr_buf, sizeof(hr_buf), "HEART %d BPM", watch_ui.heart_rate);
-        lv_label_set_text(watch_ui.lbl_heart_bpm, hr_buf);
+        snprintf(hr_buf, sizeof(hr_buf), "HEART %d BPM", ui->heart_rate);
+        lv_label_set_text(ui->lbl_heart_bpm, hr_buf);
     }
     
     // Simulate step counting
-    static int step_counter = 0;
-    step_counter++;
-    if (step_counter % 10 == 0) { // Every 10 seconds
-        watch_ui.steps += 5;
-        watch_ui.calories = watch_ui.steps / 20; // Rough calories calculation
+    ui->step_counter++;
+    if (ui->step_counter % 10 == 0) { // Every 10 seconds
+        ui->steps += 5;
+        ui->calories = ui->steps / 20; // Rough calories calculation
         
-        if (watch_ui.lbl_steps_count) {
+        if (ui->lbl_steps_count) {
             char steps_buf[16];
-            snprintf(steps_buf, sizeof(steps_buf), "%d", watch_ui.steps);
-            lv_label_set_text(watch_ui.lbl_steps_count, steps_buf);
+            snprintf(steps_buf, sizeof(steps_buf), "%d", ui->steps);
+            lv_label_set_text(ui->lbl_steps_count, steps_buf);
         }
         
-        if (watch_ui.lbl_calories) {
+        if (ui->lbl_calories) {
             char cal_buf[16];
-            snprintf(cal_buf, sizeof(cal_buf), "%d cal", watch_ui.calories);
-            lv_label_set_text(watch_ui.lbl_calories, cal_buf);
+            snprintf(cal_buf, sizeof(cal_buf), "%d cal", ui->calories);
+            lv_label_set_text(ui->lbl_calories, cal_buf);
         }
         
         // Update progress bar (goal: 10,000 steps)
-        if (watch_ui.progress_bar) {
-            int progress = (watch_ui.steps * 100) / 10000;
+        if (ui->progress_bar) {
+            int progress = (ui->steps * 100) / 10000;
             if (progress > 100) progress = 100;
-            lv_bar_set_value(watch_ui.progress_bar, progress, LV_ANIM_OFF);
+            lv_bar_set_value(ui->progress_bar, progress, LV_ANIM_OFF);
         }
     }
+#else
+    (void)ui;
 #endif
 }
 
+void ui_watch_update(void) {
+    watch_ui_update(watch_ui_current());
+}
+
+void ui_watch_get_model(watch_model_t *model) {
+    watch_ui_t *ui = watch_ui_current();
+    
+    memset(model, 0, sizeof(*model));
+    model->screen = ui->current_screen;
+    model->heart_rate = ui->heart_rate;
+    model->steps = ui->steps;
+    model->calories = ui->calories;
+    model->battery_percent = ui->battery_percent;
+    model->is_measuring_heart = ui->is_measuring_heart;
+    if (ui->is_measuring_heart) {
+        model->measuring_s = (int32_t)(time(NULL) - ui->measurement_start);
+    }
+    model->step_counter = ui->step_counter;
+}
+
+// Put the data model back and show its screen. Labels are left alone: they are restored
+// from the checkpoint along with the other widgets.
+int ui_watch_set_model(const watch_model_t *model) {
+    if (model->screen < SCREEN_MAIN || model->screen > SCREEN_ACTIVITY) {
+        return TEST_ERROR_INVALID_PARAM;
+    }
+    
+    watch_ui_t *ui = watch_ui_current();
+    ui->heart_rate = model->heart_rate;
+    ui->steps = model->steps;
+    ui->calories = model->calories;
+    ui->battery_percent = model->battery_percent;
+    ui->is_measuring_heart = model->is_measuring_heart;
+    ui->measurement_start = time(NULL) - model->measuring_s;
+    ui->step_counter = model->step_counter;
+#if HAVE_LVGL
+    watch_show_screen(ui, (screen_t)model->screen);
+#endif
+    return TEST_OK;
+}
+
 // Manual heart button click simulation - bypass lv_event_send crash
 void simulate_heart_button_click(void) {
     printf("Heart button automation click - using same logic as manual\n");
+    watch_ui_t *ui = watch_ui_current();
     
     // Safety check: only process if we're on the main screen
-    if (watch_ui.current_screen != SCREEN_MAIN) {
+    if (ui->current_screen != SCREEN_MAIN) {
         printf("  WARNING: Not on main screen, ignoring click\n");
         return;
     }
     
-    if (!watch_ui.heart_area) {
+    if (!ui->heart_area) {
         printf("  ERROR: Heart button widget not found\n");
         return;
     }
     
     // Use the exact same logic as heart_area_event_handler()
     printf("  Simple click feedback\n");
-    lv_obj_t * label = lv_obj_get_child(watch_ui.heart_area, 0);
+    lv_obj_t * label = lv_obj_get_child(ui->heart_area, 0);
     if (label) {
         lv_label_set_text(label, "OPENING...");
     }
@@ -697,8 +847,8 @@ void simulate_heart_button_click(void) {
     // Navigate to heart rate screen
     printf("  Navigating to heart rate screen\n");
     show_screen(SCREEN_HEART_RATE);
-    if (watch_ui.lbl_hr_instruction) {
-        lv_label_set_text(watch_ui.lbl_hr_instruction, "Long press to measure");
+    if (ui->lbl_hr_instruction) {
+        lv_label_set_text(ui->lbl_hr_instruction, "Long press to measure");
     }
     
     printf("Heart button automation click completed\n");
@@ -706,14 +856,15 @@ void simulate_heart_button_click(void) {
 
 void simulate_activity_button_click(void) {
     printf("Manual activity button click simulation starting\n");
+    watch_ui_t *ui = watch_ui_current();
     
     // Manually perform the activity button click actions without using lv_event_send
     printf("  Switching to activity screen\n");
     show_screen(SCREEN_ACTIVITY);
     
     // Update steps display if available
-    if (watch_ui.lbl_steps_count) {
-        lv_label_set_text(watch_ui.lbl_steps_count, "2847");
+    if (ui->lbl_steps_count) {
+        lv_label_set_text(ui->lbl_steps_count, "2847");
         printf("  Activity screen steps updated to 2847\n");
     }
     
@@ -722,8 +873,9 @@ void simulate_activity_button_click(void) {
 
 void simulate_heart_button_longpress(void) {
     printf("Manual heart button longpress simulation starting\n");
+    watch_ui_t *ui = watch_ui_current();
     
-    if (!watch_ui.heart_area) {
+    if (!ui->heart_area) {
         printf("  ERROR: Heart button widget not found\n");
         return;
     }
@@ -732,23 +884,69 @@ void simulate_heart_button_longpress(void) {
     printf("  Changing heart button to MEASURING state...\n");
     
     // Get the first child of the button which is the label and update it
-    lv_obj_t * label = lv_obj_get_child(watch_ui.heart_area, 0);
+    lv_obj_t * label = lv_obj_get_child(ui->heart_area, 0);
     if (label) {
         lv_label_set_text(label, "MEASURING...");
         printf("  Heart button label changed to MEASURING...\n");
     }
     
     // Update steps display to show measurement state
-    if (watch_ui.lbl_steps_main) {
-        lv_label_set_text(watch_ui.lbl_steps_main, "STEPS: 2500 (UPDATED!)");
+    if (ui->lbl_steps_main) {
+        lv_label_set_text(ui->lbl_steps_main, "STEPS: 2500 (UPDATED!)");
         printf("  Steps display updated to show measurement feedback\n");
     }
     
     // Update heart rate value in current screen
-    if (watch_ui.lbl_hr_value) {
-        lv_label_set_text(watch_ui.lbl_hr_value, "95 BPM");
+    if (ui->lbl_hr_value) {
+        lv_label_set_text(ui->lbl_hr_value, "95 BPM");
         printf("  Heart rate value updated to 95 BPM\n");
     }
     
     printf("Manual heart button longpress simulation completed\n");
-}
\ No newline at end of file
+}
+
+// Automation click on one of the watch's own widgets, matched by object so aliases such as
+// btn_heart/heart_area act alike. Returns 0 for widgets without a scripted action.
+int ui_watch_click(lv_obj_t *obj) {
+#if HAVE_LVGL
+    watch_ui_t *ui = watch_ui_current();
+    
+    if (obj == ui->heart_area) {
+        printf("  Detected heart button - using manual event simulation\n");
+        simulate_heart_button_click();
+    } else if (obj == ui->btn_activity) {
+        printf("  Detected activity button - using manual event simulation\n");
+        simulate_activity_button_click();
+    } else if (obj == ui->activity_bg || obj == ui->hr_bg) {
+        printf("  Detected secondary screen - returning to main screen\n");
+        show_screen(SCREEN_MAIN);
+    } else {
+        return 0;
+    }
+    return 1;
+#else
+    (void)obj;
+    return 0;
+#endif
+}
+
+// Automation long press, matched by object like ui_watch_click()
+int ui_watch_longpress(lv_obj_t *obj) {
+#if HAVE_LVGL
+    watch_ui_t *ui = watch_ui_current();
+    
+    if (obj == ui->heart_area) {
+        printf("  Detected heart button longpress - using manual event simulation\n");
+        simulate_heart_button_longpress();
+    } else if (obj == ui->hr_measure_area) {
+        printf("  Detected hr_measure_area longpress - triggering measurement\n");
+        simulate_hr_measurement();
+    } else {
+        return 0;
+    }
+    return 1;
+#else
+    (void)obj;
+    return 0;
+#endif
+}
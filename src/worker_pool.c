@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+    typedef CRITICAL_SECTION pool_mutex_t;
+    typedef CONDITION_VARIABLE pool_cond_t;
+    typedef HANDLE pool_thread_t;
+    #define POOL_MUTEX_INIT(m) InitializeCriticalSection(m)
+    #define POOL_MUTEX_DESTROY(m) DeleteCriticalSection(m)
+    #define POOL_LOCK(m) EnterCriticalSection(m)
+    #define POOL_UNLOCK(m) LeaveCriticalSection(m)
+    #define POOL_COND_INIT(c) InitializeConditionVariable(c)
+    #define POOL_COND_DESTROY(c) ((void)0)
+    #define POOL_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+    #define POOL_SIGNAL(c) WakeConditionVariable(c)
+    #define POOL_BROADCAST(c) WakeAllConditionVariable(c)
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    typedef pthread_mutex_t pool_mutex_t;
+    typedef pthread_cond_t pool_cond_t;
+    typedef pthread_t pool_thread_t;
+    #define POOL_MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+    #define POOL_MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+    #define POOL_LOCK(m) pthread_mutex_lock(m)
+    #define POOL_UNLOCK(m) pthread_mutex_unlock(m)
+    #define POOL_COND_INIT(c) pthread_cond_init(c, NULL)
+    #define POOL_COND_DESTROY(c) pthread_cond_destroy(c)
+    #define POOL_WAIT(c, m) pthread_cond_wait(c, m)
+    #define POOL_SIGNAL(c) pthread_cond_signal(c)
+    #define POOL_BROADCAST(c) pthread_cond_broadcast(c)
+#endif
+
+#include "test_harness.h"
+
+#define WORKER_POOL_MAX_THREADS 15
+#define WORKER_POOL_MAX_TASKS 32
+
+// Fixed set of worker threads executing one parallel-for job at a time.
+// The thread calling worker_pool_run() takes indices too, so a pool of N workers runs N+1 wide.
+// Between parallel-for jobs the workers also run fire-and-forget tasks from worker_pool_submit().
+static struct {
+    pool_thread_t threads[WORKER_POOL_MAX_THREADS];
+    int thread_count;
+    int initialized;
+    int shutdown;
+
+    pool_mutex_t lock;
+    pool_cond_t work_ready;
+    pool_cond_t work_done;
+    pool_mutex_t run_lock;      // serializes concurrent worker_pool_run() callers
+
+    // Current job
+    worker_task_fn fn;
+    void *arg;
+    int count;
+    int next;
+    int done;
+
+    // Queued background tasks (ring buffer)
+    struct {
+        worker_task_fn fn;
+        void *arg;
+    } tasks[WORKER_POOL_MAX_TASKS];
+    int task_head;
+    int task_count;
+} worker_pool = {0};
+
+static int worker_pool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Claim and run job indices until none are left; called with the lock held, returns with it held
+static void worker_pool_drain(void) {
+    while (worker_pool.fn && worker_pool.next < worker_pool.count) {
+        int index = worker_pool.next++;
+        worker_task_fn fn = worker_pool.fn;
+        void *arg = worker_pool.arg;
+
+        POOL_UNLOCK(&worker_pool.lock);
+        fn(arg, index);
+        POOL_LOCK(&worker_pool.lock);
+
+        if (++worker_pool.done == worker_pool.count) {
+            POOL_BROADCAST(&worker_pool.work_done);
+        }
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall worker_pool_thread(void *unused) {
+#else
+static void *worker_pool_thread(void *unused) {
+#endif
+    (void)unused;
+
+    POOL_LOCK(&worker_pool.lock);
+    // Parallel-for indices first (their caller is blocked on them), then background tasks.
+    // Queued tasks still run after shutdown is requested so nobody waits on a dropped one.
+    while (!worker_pool.shutdown || worker_pool.task_count > 0) {
+        if (worker_pool.fn && worker_pool.next < worker_pool.count) {
+            worker_pool_drain();
+        } else if (worker_pool.task_count > 0) {
+            worker_task_fn fn = worker_pool.tasks[worker_pool.task_head].fn;
+            void *arg = worker_pool.tasks[worker_pool.task_head].arg;
+            worker_pool.task_head = (worker_pool.task_head + 1) % WORKER_POOL_MAX_TASKS;
+            worker_pool.task_count--;
+
+            POOL_UNLOCK(&worker_pool.lock);
+            fn(arg, 0);
+            POOL_LOCK(&worker_pool.lock);
+        } else {
+            POOL_WAIT(&worker_pool.work_ready, &worker_pool.lock);
+        }
+    }
+    POOL_UNLOCK(&worker_pool.lock);
+    return 0;
+}
+
+// Start the pool; threads <= 0 picks one worker per extra CPU core, and at least one so
+// submitted tasks never run on the submitting thread
+int worker_pool_init(int threads) {
+    if (worker_pool.initialized) {
+        return TEST_OK;
+    }
+
+    if (threads <= 0) {
+        threads = worker_pool_cpu_count() - 1;
+        if (threads < 1) {
+            threads = 1;
+        }
+    }
+    if (threads > WORKER_POOL_MAX_THREADS) {
+        threads = WORKER_POOL_MAX_THREADS;
+    }
+
+    POOL_MUTEX_INIT(&worker_pool.lock);
+    POOL_MUTEX_INIT(&worker_pool.run_lock);
+    POOL_COND_INIT(&worker_pool.work_ready);
+    POOL_COND_INIT(&worker_pool.work_done);
+    worker_pool.shutdown = 0;
+    worker_pool.thread_count = 0;
+
+    for (int i = 0; i < threads; i++) {
+#ifdef _WIN32
+        pool_thread_t thread = (HANDLE)_beginthreadex(NULL, 0, worker_pool_thread, NULL, 0, NULL);
+        if (thread == 0) {
+#else
+        pool_thread_t thread;
+        if (pthread_create(&thread, NULL, worker_pool_thread, NULL) != 0) {
+#endif
+            printf("Failed to start worker thread %d - continuing with %d\n", i, worker_pool.thread_count);
+            break;
+        }
+        worker_pool.threads[worker_pool.thread_count++] = thread;
+    }
+
+    worker_pool.initialized = 1;
+    printf("Worker pool started with %d threads\n", worker_pool.thread_count);
+    return TEST_OK;
+}
+
+void worker_pool_cleanup(void) {
+    if (!worker_pool.initialized) {
+        return;
+    }
+
+    POOL_LOCK(&worker_pool.lock);
+    worker_pool.shutdown = 1;
+    POOL_BROADCAST(&worker_pool.work_ready);
+    POOL_UNLOCK(&worker_pool.lock);
+
+    for (int i = 0; i < worker_pool.thread_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(worker_pool.threads[i], INFINITE);
+        CloseHandle(worker_pool.threads[i]);
+#else
+        pthread_join(worker_pool.threads[i], NULL);
+#endif
+    }
+
+    POOL_COND_DESTROY(&worker_pool.work_ready);
+    POOL_COND_DESTROY(&worker_pool.work_done);
+    POOL_MUTEX_DESTROY(&worker_pool.run_lock);
+    POOL_MUTEX_DESTROY(&worker_pool.lock);
+    memset(&worker_pool, 0, sizeof(worker_pool));
+}
+
+// Parallelism available to worker_pool_run(): the workers plus the calling thread
+int worker_pool_size(void) {
+    return worker_pool.thread_count + 1;
+}
+
+// Run fn(arg, i) for every i in [0, count) and return once all calls have finished.
+// Without a started pool (or for a single task) everything runs on the calling thread.
+void worker_pool_run(worker_task_fn fn, void *arg, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (!worker_pool.initialized || worker_pool.thread_count == 0 || count == 1) {
+        for (int i = 0; i < count; i++) {
+            fn(arg, i);
+        }
+        return;
+    }
+
+    POOL_LOCK(&worker_pool.run_lock);
+    POOL_LOCK(&worker_pool.lock);
+
+    worker_pool.fn = fn;
+    worker_pool.arg = arg;
+    worker_pool.count = count;
+    worker_pool.next = 0;
+    worker_pool.done = 0;
+    POOL_BROADCAST(&worker_pool.work_ready);
+
+    // Help out instead of idling, then wait for stragglers
+    worker_pool_drain();
+    while (worker_pool.done < worker_pool.count) {
+        POOL_WAIT(&worker_pool.work_done, &worker_pool.lock);
+    }
+
+    worker_pool.fn = NULL;
+    worker_pool.arg = NULL;
+    worker_pool.count = 0;
+
+    POOL_UNLOCK(&worker_pool.lock);
+    POOL_UNLOCK(&worker_pool.run_lock);
+}
+
+// Queue fn(arg, 0) to run on a worker thread and return immediately. Without worker threads,
+// or when the queue is full, the task runs on the calling thread before this returns.
+void worker_pool_submit(worker_task_fn fn, void *arg) {
+    if (worker_pool.initialized && worker_pool.thread_count > 0) {
+        POOL_LOCK(&worker_pool.lock);
+        if (!worker_pool.shutdown && worker_pool.task_count < WORKER_POOL_MAX_TASKS) {
+            int slot = (worker_pool.task_head + worker_pool.task_count) % WORKER_POOL_MAX_TASKS;
+            worker_pool.tasks[slot].fn = fn;
+            worker_pool.tasks[slot].arg = arg;
+            worker_pool.task_count++;
+            POOL_SIGNAL(&worker_pool.work_ready);
+            POOL_UNLOCK(&worker_pool.lock);
+            return;
+        }
+        POOL_UNLOCK(&worker_pool.lock);
+    }
+
+    fn(arg, 0);
+}